@@ -12,21 +12,53 @@ import AppNavigator from './src/navigation/AppNavigator';
 import { useSettingsStore } from './src/store/useSettingsStore';
 import { useDockerStore } from './src/store/useDockerStore';
 import { useQemuStore } from './src/store/useQemuStore';
+import StorageService from './src/services/StorageService';
 import { ErrorBoundary, LoadingSpinner } from './src/components';
 import { ColorTokens } from './src/theme';
 
+// Startup timing: bundle evaluated to settings in the stores
+const bundleLoadedAt = performance.now();
+
+const logSettingsReady = (path) => {
+  console.log(`Settings ready in ${(performance.now() - bundleLoadedAt).toFixed(1)} ms (${path})`);
+};
+
+/**
+ * Fill the stores from the native settings store before the first render
+ * @returns {Object|null} the settings, null when only the async path works
+ */
+const hydrateStoresSync = () => {
+  const settings = StorageService.getSettingsSync();
+  if (settings) {
+    useSettingsStore.getState().hydrate(settings);
+    useQemuStore.getState().hydrate(settings);
+    // Applies the settings before its first await; the connection test
+    // goes on in the background
+    useDockerStore.getState().initialize(settings).catch((error) => {
+      console.error('Initialization error:', error);
+    });
+    logSettingsReady('sync');
+  }
+  return settings;
+};
+
 const AppInitializer = ({ children }) => {
-  const [isInitialized, setIsInitialized] = useState(false);
+  // With the settings read synchronously there is no loading screen
+  const [syncSettings] = useState(hydrateStoresSync);
+  const [isInitialized, setIsInitialized] = useState(syncSettings !== null);
   const loadSettings = useSettingsStore((state) => state.loadSettings);
   const initializeDocker = useDockerStore((state) => state.initialize);
   const loadQemuSettings = useQemuStore((state) => state.loadSettings);
 
   useEffect(() => {
+    if (syncSettings) return;
+
     const initialize = async () => {
       try {
         await loadSettings();
         await initializeDocker();
         await loadQemuSettings();
+        logSettingsReady('async');
       } catch (error) {
         console.error('Initialization error:', error);
       } finally {
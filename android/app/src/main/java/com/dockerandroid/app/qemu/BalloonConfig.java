@@ -0,0 +1,102 @@
+package com.dockerandroid.app.qemu;
+
+import org.json.JSONObject;
+
+import java.io.File;
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * BalloonConfig - virtio-balloon device and reclaim policy settings
+ * Read from the "balloon" section of qemu-config.json:
+ *
+ *   "balloon": { "enabled": true, "freePageReporting": true, "deflateOnOom": true,
+ *                "floorMB": 512, "headroomMB": 256, "minChangeMB": 64,
+ *                "pollSec": 10, "relaxSec": 120 }
+ *
+ * freePageReporting lets the guest hand pages it frees back to Android
+ * without inflating the balloon. The policy (BalloonPolicy) inflates on
+ * Android memory pressure, but never below floorMB or below the guest's
+ * working set plus headroomMB, so running containers keep their memory.
+ * Changes smaller than minChangeMB are skipped, and a pressure level only
+ * relaxes after relaxSec without a new trim signal.
+ */
+public class BalloonConfig {
+    public static final String DEVICE_ID = "balloon0";
+
+    public boolean enabled = true;
+    public boolean freePageReporting = true;
+    public boolean deflateOnOom = true;
+    public int floorMB = 512;
+    public int headroomMB = 256;
+    public int minChangeMB = 64;
+    public int pollSec = 10;
+    public int relaxSec = 120;
+
+    /**
+     * Load balloon settings; missing or invalid values keep their defaults
+     */
+    public static BalloonConfig load(File configFile) {
+        return fromJson(QemuCommand.readConfig(configFile));
+    }
+
+    /**
+     * Read the "balloon" section of an already parsed qemu-config.json
+     */
+    public static BalloonConfig fromJson(JSONObject root) {
+        BalloonConfig config = new BalloonConfig();
+        JSONObject balloon = root.optJSONObject("balloon");
+        if (balloon != null) {
+            config.enabled = balloon.optBoolean("enabled", config.enabled);
+            config.freePageReporting = balloon.optBoolean("freePageReporting", config.freePageReporting);
+            config.deflateOnOom = balloon.optBoolean("deflateOnOom", config.deflateOnOom);
+            config.floorMB = balloon.optInt("floorMB", config.floorMB);
+            config.headroomMB = balloon.optInt("headroomMB", config.headroomMB);
+            config.minChangeMB = balloon.optInt("minChangeMB", config.minChangeMB);
+            config.pollSec = balloon.optInt("pollSec", config.pollSec);
+            config.relaxSec = balloon.optInt("relaxSec", config.relaxSec);
+        }
+        config.validate();
+        return config;
+    }
+
+    private void validate() {
+        BalloonConfig defaults = new BalloonConfig();
+        if (floorMB < 128) {
+            floorMB = defaults.floorMB;
+        }
+        if (headroomMB < 0) {
+            headroomMB = defaults.headroomMB;
+        }
+        if (minChangeMB < 4) {
+            minChangeMB = defaults.minChangeMB;
+        }
+        if (pollSec < 1 || pollSec > 3600) {
+            pollSec = defaults.pollSec;
+        }
+        if (relaxSec < pollSec) {
+            relaxSec = Math.max(pollSec, defaults.relaxSec);
+        }
+    }
+
+    /**
+     * Build the -device arguments (empty when the balloon is disabled)
+     */
+    public List<String> toArgs(BootConfig bootConfig) {
+        List<String> args = new ArrayList<>();
+        if (!enabled) {
+            return args;
+        }
+        args.add("-device");
+        args.add(bootConfig.virtioDevice("virtio-balloon") + ",id=" + DEVICE_ID +
+                 ",free-page-reporting=" + (freePageReporting ? "on" : "off") +
+                 ",deflate-on-oom=" + (deflateOnOom ? "on" : "off"));
+        return args;
+    }
+
+    @Override
+    public String toString() {
+        return "enabled=" + enabled + " freePageReporting=" + freePageReporting +
+               " floorMB=" + floorMB + " headroomMB=" + headroomMB;
+    }
+}
@@ -0,0 +1,187 @@
+package com.dockerandroid.app.qemu;
+
+import android.content.ComponentCallbacks2;
+import android.util.Log;
+
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.IOException;
+
+/**
+ * BalloonPolicy - Sizes the virtio-balloon from Android memory pressure
+ *
+ * Android's trim levels raise a pressure level; the balloon is inflated so
+ * the guest gives up a share of its slack (memory above the floor):
+ *
+ *   none      keeps all of it (balloon deflated)
+ *   moderate  keeps 3/4       (TRIM_MEMORY_RUNNING_MODERATE, BACKGROUND)
+ *   low       keeps 1/2       (TRIM_MEMORY_RUNNING_LOW, MODERATE)
+ *   critical  keeps none      (TRIM_MEMORY_RUNNING_CRITICAL, COMPLETE)
+ *
+ * The floor is the configured floorMB or the guest's working set plus
+ * headroomMB, whichever is higher, so containers are never squeezed into
+ * swapping or the guest OOM killer. A guest that grows into its headroom
+ * gets memory back right away. Hysteresis: the level drops one step per
+ * relaxSec without a new trim signal, and changes below minChangeMB are
+ * not sent to QEMU.
+ */
+public class BalloonPolicy implements Runnable {
+    private static final String TAG = "BalloonPolicy";
+
+    public static final int PRESSURE_NONE = 0;
+    public static final int PRESSURE_MODERATE = 1;
+    public static final int PRESSURE_LOW = 2;
+    public static final int PRESSURE_CRITICAL = 3;
+    private static final String[] PRESSURE_NAMES = {"none", "moderate", "low", "critical"};
+    private static final double[] SLACK_KEPT = {1.0, 0.75, 0.5, 0.0};
+
+    private static final long MB = 1024 * 1024;
+
+    /**
+     * Last decision, read by QemuModule.getStatus (the service and the
+     * React module share the app process)
+     */
+    public static class Status {
+        public long ramMB;
+        public long actualMB;
+        public long targetMB;
+        public long floorMB;
+        public long workingSetMB;
+        public String pressure;
+        public long updatedAt;
+    }
+
+    private static volatile Status lastStatus;
+
+    private final BalloonConfig config;
+    private final QmpClient qmp;
+    private final int ramMB;
+
+    private int pressure = PRESSURE_NONE;
+    private long pressureTime = 0;
+    private boolean pollingEnabled = false;
+
+    public BalloonPolicy(BalloonConfig config, QmpClient qmp, int ramMB) {
+        this.config = config;
+        this.qmp = qmp;
+        this.ramMB = ramMB;
+        lastStatus = null;
+    }
+
+    public static Status getLastStatus() {
+        return lastStatus;
+    }
+
+    public static void clearStatus() {
+        lastStatus = null;
+    }
+
+    /**
+     * Record an Android trim level; returns true when the pressure rose
+     * and the balloon should be re-evaluated now
+     */
+    public synchronized boolean onTrimMemory(int level) {
+        int newPressure = pressureForTrimLevel(level);
+        if (newPressure == PRESSURE_NONE) {
+            return false;
+        }
+        boolean rose = newPressure > pressure;
+        if (newPressure >= pressure) {
+            pressure = newPressure;
+            pressureTime = System.currentTimeMillis();
+        }
+        return rose;
+    }
+
+    static int pressureForTrimLevel(int level) {
+        switch (level) {
+            case ComponentCallbacks2.TRIM_MEMORY_RUNNING_MODERATE:
+            case ComponentCallbacks2.TRIM_MEMORY_BACKGROUND:
+                return PRESSURE_MODERATE;
+            case ComponentCallbacks2.TRIM_MEMORY_RUNNING_LOW:
+            case ComponentCallbacks2.TRIM_MEMORY_MODERATE:
+                return PRESSURE_LOW;
+            case ComponentCallbacks2.TRIM_MEMORY_RUNNING_CRITICAL:
+            case ComponentCallbacks2.TRIM_MEMORY_COMPLETE:
+                return PRESSURE_CRITICAL;
+            default:
+                // UI_HIDDEN says nothing about memory
+                return PRESSURE_NONE;
+        }
+    }
+
+    /**
+     * One policy step: read the balloon and guest stats, pick a target and
+     * resize the balloon. Runs on QemuService's maintenance executor.
+     */
+    @Override
+    public void run() {
+        try {
+            if (!pollingEnabled) {
+                BalloonStats.enablePolling(qmp, config.pollSec);
+                pollingEnabled = true;
+            }
+            step(BalloonStats.query(qmp));
+        } catch (IOException e) {
+            // QMP not up yet, or the VM is shutting down
+            Log.d(TAG, "Balloon step skipped: " + e.getMessage());
+        }
+    }
+
+    private void step(BalloonStats stats) throws IOException {
+        long now = System.currentTimeMillis();
+        int level = relaxedPressure(now);
+
+        long workingSet = stats.workingSetMB(ramMB);
+        long floor = config.floorMB;
+        if (workingSet >= 0) {
+            floor = Math.max(floor, workingSet + config.headroomMB);
+        } else {
+            // No guest stats yet: nothing tells how much the containers
+            // need, so never inflate past the current size
+            floor = Math.max(floor, stats.actualMB);
+        }
+        floor = Math.min(floor, ramMB);
+
+        long target = floor + Math.round((ramMB - floor) * SLACK_KEPT[level]);
+        long change = target - stats.actualMB;
+        // Small changes are noise; a full deflate and a guest under its
+        // floor are always applied
+        boolean apply = Math.abs(change) >= config.minChangeMB ||
+            (change != 0 && (target == ramMB || stats.actualMB < floor));
+        if (apply) {
+            Log.d(TAG, "Balloon " + stats.actualMB + "MB -> " + target + "MB (pressure " +
+                PRESSURE_NAMES[level] + ", working set " + workingSet + "MB, floor " + floor + "MB)");
+            try {
+                qmp.execute("balloon", new JSONObject().put("value", target * MB));
+            } catch (JSONException e) {
+                throw new IOException("Invalid QMP message: " + e.getMessage(), e);
+            }
+        }
+
+        Status status = new Status();
+        status.ramMB = ramMB;
+        status.actualMB = stats.actualMB;
+        status.targetMB = apply ? target : stats.actualMB;
+        status.floorMB = floor;
+        status.workingSetMB = workingSet;
+        status.pressure = PRESSURE_NAMES[level];
+        status.updatedAt = now;
+        lastStatus = status;
+        VmStatus.publish();
+    }
+
+    /**
+     * Current pressure after relaxing one level per relaxSec without a
+     * new trim signal
+     */
+    private synchronized int relaxedPressure(long now) {
+        long relaxMs = config.relaxSec * 1000L;
+        while (pressure > PRESSURE_NONE && now - pressureTime >= relaxMs) {
+            pressure--;
+            pressureTime += relaxMs;
+        }
+        return pressure;
+    }
+}
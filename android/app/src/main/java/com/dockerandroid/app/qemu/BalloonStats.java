@@ -0,0 +1,95 @@
+package com.dockerandroid.app.qemu;
+
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.IOException;
+
+/**
+ * BalloonStats - Balloon size and guest memory from the virtio-balloon device
+ * "actual" comes from query-balloon; the guest's own counters come from the
+ * device's guest-stats property, which the guest driver refreshes every
+ * guest-stats-polling-interval seconds once polling is enabled.
+ */
+public class BalloonStats {
+    private static final int QUERY_TIMEOUT_MS = 1000;
+    private static final String DEVICE_PATH = "/machine/peripheral/" + BalloonConfig.DEVICE_ID;
+    private static final long MB = 1024 * 1024;
+
+    public long actualMB = -1;          // memory the guest may use
+    public long guestTotalMB = -1;
+    public long guestAvailableMB = -1;
+    public long guestFreeMB = -1;
+    public long guestCachesMB = -1;
+    public long lastUpdate = 0;         // guest time of the last stats refresh, 0 = never
+
+    /**
+     * Ask the guest driver to refresh its statistics every intervalSec
+     */
+    public static void enablePolling(QmpClient qmp, int intervalSec) throws IOException {
+        try {
+            qmp.execute("qom-set", new JSONObject()
+                .put("path", DEVICE_PATH)
+                .put("property", "guest-stats-polling-interval")
+                .put("value", intervalSec), QUERY_TIMEOUT_MS);
+        } catch (JSONException e) {
+            throw new IOException("Invalid QMP message: " + e.getMessage(), e);
+        }
+    }
+
+    /**
+     * Query the running VM; guest counters stay -1 until the guest driver
+     * has reported them
+     */
+    public static BalloonStats query(QmpClient qmp) throws IOException {
+        BalloonStats stats = new BalloonStats();
+        Object balloon = qmp.execute("query-balloon", null, QUERY_TIMEOUT_MS);
+        if (!(balloon instanceof JSONObject)) {
+            throw new IOException("Unexpected query-balloon reply");
+        }
+        stats.actualMB = ((JSONObject) balloon).optLong("actual", -1) / MB;
+
+        try {
+            Object result = qmp.execute("qom-get", new JSONObject()
+                .put("path", DEVICE_PATH)
+                .put("property", "guest-stats"), QUERY_TIMEOUT_MS);
+            if (result instanceof JSONObject) {
+                JSONObject guest = ((JSONObject) result).optJSONObject("stats");
+                stats.lastUpdate = ((JSONObject) result).optLong("last-update", 0);
+                if (guest != null && stats.lastUpdate > 0) {
+                    stats.guestTotalMB = toMB(guest.optLong("stat-total-memory", -1));
+                    stats.guestAvailableMB = toMB(guest.optLong("stat-available-memory", -1));
+                    stats.guestFreeMB = toMB(guest.optLong("stat-free-memory", -1));
+                    stats.guestCachesMB = toMB(guest.optLong("stat-disk-caches", -1));
+                }
+            }
+        } catch (JSONException e) {
+            throw new IOException("Invalid QMP message: " + e.getMessage(), e);
+        }
+        return stats;
+    }
+
+    /**
+     * Whether the guest driver has reported its memory counters
+     */
+    public boolean hasGuestStats() {
+        return guestAvailableMB >= 0;
+    }
+
+    /**
+     * Memory the guest is actually using (not free and not reclaimable
+     * cache), excluding pages held by the balloon. Uses the balloon size
+     * rather than the guest's total, which only shrinks with the balloon
+     * when deflate-on-oom is off.
+     */
+    public long workingSetMB(int ramMB) {
+        if (!hasGuestStats() || actualMB < 0) {
+            return -1;
+        }
+        return Math.max(0, Math.min(actualMB, ramMB) - guestAvailableMB);
+    }
+
+    private static long toMB(long bytes) {
+        return bytes < 0 ? -1 : bytes / MB;
+    }
+}
@@ -0,0 +1,106 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import org.json.JSONObject;
+
+import java.io.File;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+
+/**
+ * BlockConfig - Block I/O settings for the VM disk
+ * Read from the "block" section of qemu-config.json:
+ *
+ *   "block": { "iothread": true, "aio": "threads", "cache": "writeback", "queues": 2 }
+ *
+ * With an iothread, virtio-blk requests are served off QEMU's main loop,
+ * which the TCG vCPU threads otherwise compete for.
+ */
+public class BlockConfig {
+    private static final String TAG = "BlockConfig";
+
+    public static final List<String> AIO_MODES = Arrays.asList("threads", "io_uring", "native");
+    public static final List<String> CACHE_MODES =
+        Arrays.asList("none", "writeback", "writethrough", "directsync", "unsafe");
+    private static final int MAX_QUEUES = 8;
+
+    public boolean iothread = true;
+    public String aio = "threads";
+    public String cache = "writeback";
+    public int queues = 0;          // 0 = one per vCPU
+
+    /**
+     * Load block settings; missing or invalid values keep their defaults
+     */
+    public static BlockConfig load(File configFile) {
+        return fromJson(QemuCommand.readConfig(configFile));
+    }
+
+    /**
+     * Read the "block" section of an already parsed qemu-config.json
+     */
+    public static BlockConfig fromJson(JSONObject root) {
+        BlockConfig config = new BlockConfig();
+        JSONObject block = root.optJSONObject("block");
+        if (block != null) {
+            config.iothread = block.optBoolean("iothread", config.iothread);
+            config.aio = block.optString("aio", config.aio);
+            config.cache = block.optString("cache", config.cache);
+            config.queues = block.optInt("queues", config.queues);
+        }
+        config.validate();
+        return config;
+    }
+
+    private void validate() {
+        if (!AIO_MODES.contains(aio)) {
+            Log.w(TAG, "Unknown aio mode " + aio + ", using threads");
+            aio = "threads";
+        }
+        if (!CACHE_MODES.contains(cache)) {
+            Log.w(TAG, "Unknown cache mode " + cache + ", using writeback");
+            cache = "writeback";
+        }
+        // Linux native AIO is only asynchronous with O_DIRECT
+        if (aio.equals("native") && !cache.equals("none") && !cache.equals("directsync")) {
+            Log.w(TAG, "aio=native needs cache=none or directsync, using threads");
+            aio = "threads";
+        }
+        if (queues < 0 || queues > MAX_QUEUES) {
+            queues = 0;
+        }
+    }
+
+    /**
+     * Build the QEMU arguments attaching the disk as virtio-blk
+     */
+    public List<String> toArgs(File diskFile, int cpuCores, BootConfig bootConfig) {
+        List<String> args = new ArrayList<>();
+        int numQueues = queues > 0 ? queues : Math.max(1, Math.min(cpuCores, MAX_QUEUES));
+
+        if (iothread) {
+            args.add("-object");
+            args.add("iothread,id=iothread0");
+        }
+
+        args.add("-drive");
+        args.add("file=" + diskFile.getAbsolutePath() +
+                 ",if=none,id=disk0,format=qcow2" +
+                 ",cache=" + cache +
+                 ",aio=" + aio +
+                 ",discard=unmap,detect-zeroes=unmap");  // Freed guest blocks shrink the overlay
+
+        args.add("-device");
+        args.add(bootConfig.virtioDevice("virtio-blk") + ",drive=disk0,num-queues=" + numQueues +
+                 (iothread ? ",iothread=iothread0" : ""));
+
+        return args;
+    }
+
+    @Override
+    public String toString() {
+        return "iothread=" + iothread + " aio=" + aio + " cache=" + cache + " queues=" + queues;
+    }
+}
@@ -0,0 +1,142 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import org.json.JSONObject;
+
+import java.io.File;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+
+/**
+ * BootConfig - How the VM boots
+ * Read from the "boot" section of qemu-config.json:
+ *
+ *   "boot": { "mode": "auto" }
+ *
+ * Modes:
+ *   firmware - q35 with SeaBIOS, then extlinux from the disk (or the ISO)
+ *   kernel   - -kernel/-initrd/-append on a q35 without legacy devices
+ *   microvm  - -kernel/-initrd/-append on microvm, virtio-mmio devices only
+ *   auto     - kernel when the disk image supports it, otherwise firmware
+ *
+ * Under TCG the firmware and bootloader alone take seconds, and every
+ * emulated legacy device adds probing time to the guest kernel.
+ */
+public class BootConfig {
+    private static final String TAG = "BootConfig";
+
+    public static final String MODE_AUTO = "auto";
+    public static final String MODE_FIRMWARE = "firmware";
+    public static final String MODE_KERNEL = "kernel";
+    public static final String MODE_MICROVM = "microvm";
+    public static final List<String> MODES =
+        Arrays.asList(MODE_AUTO, MODE_FIRMWARE, MODE_KERNEL, MODE_MICROVM);
+
+    public String mode = MODE_AUTO;
+
+    /**
+     * Load boot settings; missing or invalid values keep their defaults
+     */
+    public static BootConfig load(File configFile) {
+        return fromJson(QemuCommand.readConfig(configFile));
+    }
+
+    /**
+     * Read the "boot" section of an already parsed qemu-config.json
+     */
+    public static BootConfig fromJson(JSONObject root) {
+        BootConfig config = new BootConfig();
+        JSONObject boot = root.optJSONObject("boot");
+        if (boot != null) {
+            config.mode = boot.optString("mode", config.mode);
+        }
+        if (!MODES.contains(config.mode)) {
+            Log.w(TAG, "Unknown boot mode " + config.mode + ", using auto");
+            config.mode = MODE_AUTO;
+        }
+        return config;
+    }
+
+    /**
+     * Settle "auto" and fall back to firmware when the disk has no
+     * packaged kernel (unprovisioned or legacy images)
+     */
+    public void resolve(DiskManager diskManager) {
+        boolean kernelAvailable = diskManager.canBootKernel();
+        if (mode.equals(MODE_AUTO)) {
+            mode = kernelAvailable ? MODE_KERNEL : MODE_FIRMWARE;
+        } else if (!mode.equals(MODE_FIRMWARE) && !kernelAvailable) {
+            Log.w(TAG, "No kernel for " + mode + " boot, using firmware");
+            mode = MODE_FIRMWARE;
+        }
+    }
+
+    public boolean isKernelBoot() {
+        return mode.equals(MODE_KERNEL) || mode.equals(MODE_MICROVM);
+    }
+
+    /**
+     * Name of a virtio device on this machine's transport,
+     * e.g. virtio-blk -> virtio-blk-pci or virtio-blk-device (mmio)
+     */
+    public String virtioDevice(String name) {
+        return name + (mode.equals(MODE_MICROVM) ? "-device" : "-pci");
+    }
+
+    /**
+     * Build the -machine arguments (the accelerator comes from TcgConfig)
+     * @param memoryBackend id of the guest RAM backend object, or null
+     */
+    public List<String> machineArgs(String memoryBackend) {
+        List<String> args = new ArrayList<>();
+        String machine;
+        switch (mode) {
+            case MODE_MICROVM:
+                // No ACPI: QEMU passes the virtio-mmio devices on the kernel
+                // command line. The PIT stays, TCG guests calibrate the TSC on it.
+                machine = "microvm,acpi=off,x-option-roms=off,pic=off,rtc=off,isa-serial=on";
+                break;
+            case MODE_KERNEL:
+                machine = "q35,sata=off,smbus=off,vmport=off,smm=off,graphics=off";
+                break;
+            default:
+                machine = "q35";
+                break;
+        }
+        if (memoryBackend != null) {
+            machine += ",memory-backend=" + memoryBackend;
+        }
+        args.add("-machine");
+        args.add(machine);
+        if (isKernelBoot()) {
+            // No default VGA, floppy, CD-ROM, parallel port or NIC
+            args.add("-nodefaults");
+            args.add("-no-user-config");
+        }
+        return args;
+    }
+
+    /**
+     * Build the -kernel/-initrd/-append arguments (empty for firmware boot)
+     */
+    public List<String> kernelArgs(DiskManager diskManager) {
+        List<String> args = new ArrayList<>();
+        if (!isKernelBoot()) {
+            return args;
+        }
+        args.add("-kernel");
+        args.add(diskManager.getKernel().getAbsolutePath());
+        args.add("-initrd");
+        args.add(diskManager.getInitrd().getAbsolutePath());
+        args.add("-append");
+        args.add(diskManager.getKernelCmdline());
+        return args;
+    }
+
+    @Override
+    public String toString() {
+        return "mode=" + mode;
+    }
+}
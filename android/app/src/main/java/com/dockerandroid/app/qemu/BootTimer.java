@@ -0,0 +1,154 @@
+package com.dockerandroid.app.qemu;
+
+import android.net.LocalSocket;
+import android.net.LocalSocketAddress;
+import android.util.Log;
+
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.File;
+import java.io.FileOutputStream;
+import java.io.IOException;
+import java.net.InetSocketAddress;
+import java.net.Socket;
+import java.nio.charset.StandardCharsets;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+/**
+ * BootTimer - Breaks a VM boot down into phases
+ *
+ *   qemu      process start -> QMP socket accepts connections
+ *   firmware  QMP ready -> guest kernel entry (BIOS, bootloader, kernel load)
+ *   kernel    kernel entry -> "Run /init" in the guest's dmesg
+ *   userspace /init -> guest agent answers (initramfs, OpenRC)
+ *   docker    guest agent -> Docker API accepts connections
+ *
+ * Kernel entry is derived from the guest's /proc/uptime at the moment the
+ * agent answers, so it needs no console output (the kernel boots quiet).
+ * The result is written to qemu/boot-timings.json.
+ */
+public class BootTimer implements Runnable {
+    private static final String TAG = "BootTimer";
+
+    public static final String TIMINGS_FILE = "boot-timings.json";
+
+    private static final long POLL_MS = 100;
+    private static final int AGENT_PING_TIMEOUT_MS = 500;
+    private static final long BOOT_TIMEOUT_MS = 10 * 60 * 1000;
+    private static final Pattern INIT_PATTERN = Pattern.compile("\\[\\s*(\\d+\\.\\d+)\\] Run /init");
+
+    private final File qemuDir;
+    private final String mode;
+    private final long startTime;
+    private final int dockerPort;
+
+    /**
+     * @param dockerPort QEMU's own Docker port forward; the idle proxy on
+     *                   the public port accepts before the guest is up
+     */
+    public BootTimer(File qemuDir, String mode, long startTime, int dockerPort) {
+        this.qemuDir = qemuDir;
+        this.mode = mode;
+        this.startTime = startTime;
+        this.dockerPort = dockerPort;
+    }
+
+    @Override
+    public void run() {
+        long deadline = startTime + BOOT_TIMEOUT_MS;
+        try {
+            long qmpReady = waitFor(deadline, this::qmpAccepting);
+
+            GuestAgent agent = new GuestAgent(qemuDir);
+            long agentReady = waitFor(deadline, () -> agent.ping(AGENT_PING_TIMEOUT_MS));
+            long uptimeMs = guestUptimeMs(agent);
+            long kernelEntry = Math.max(qmpReady, agentReady - uptimeMs);
+            long kernelMs = guestInitMs(agent);
+
+            long dockerReady = waitFor(deadline, this::dockerAccepting);
+
+            JSONObject timings = new JSONObject()
+                .put("mode", mode)
+                .put("startedAt", startTime)
+                .put("qemuMs", qmpReady - startTime)
+                .put("firmwareMs", kernelEntry - qmpReady)
+                .put("kernelMs", kernelMs)
+                .put("userspaceMs", kernelMs >= 0 ? agentReady - kernelEntry - kernelMs : -1)
+                .put("guestMs", agentReady - kernelEntry)
+                .put("dockerMs", dockerReady - agentReady)
+                .put("totalMs", dockerReady - startTime);
+            Log.d(TAG, "Boot (" + mode + "): " + timings);
+
+            try (FileOutputStream fos = new FileOutputStream(new File(qemuDir, TIMINGS_FILE))) {
+                fos.write(timings.toString(2).getBytes(StandardCharsets.UTF_8));
+            }
+        } catch (InterruptedException e) {
+            Log.d(TAG, "Boot timing cancelled");
+        } catch (IOException | JSONException e) {
+            Log.w(TAG, "Boot timing failed: " + e.getMessage());
+        }
+    }
+
+    private interface Probe {
+        boolean ready();
+    }
+
+    /**
+     * Poll until the probe succeeds; returns the time it first did
+     */
+    private static long waitFor(long deadline, Probe probe) throws IOException, InterruptedException {
+        while (System.currentTimeMillis() < deadline) {
+            if (probe.ready()) {
+                return System.currentTimeMillis();
+            }
+            if (Thread.interrupted()) {
+                throw new InterruptedException();
+            }
+            Thread.sleep(POLL_MS);
+        }
+        throw new IOException("VM did not finish booting");
+    }
+
+    private boolean qmpAccepting() {
+        File qmpSocket = new File(qemuDir, QmpClient.SOCKET_NAME);
+        try (LocalSocket socket = new LocalSocket()) {
+            socket.connect(new LocalSocketAddress(qmpSocket.getAbsolutePath(),
+                LocalSocketAddress.Namespace.FILESYSTEM));
+            return true;
+        } catch (IOException e) {
+            return false;
+        }
+    }
+
+    private boolean dockerAccepting() {
+        try (Socket socket = new Socket()) {
+            socket.connect(new InetSocketAddress("127.0.0.1", dockerPort), (int) POLL_MS);
+            return true;
+        } catch (IOException e) {
+            return false;
+        }
+    }
+
+    private static long guestUptimeMs(GuestAgent agent) throws IOException {
+        String uptime = agent.exec("/bin/cat", "/proc/uptime").trim();
+        try {
+            return (long) (Double.parseDouble(uptime.split("\\s+")[0]) * 1000);
+        } catch (NumberFormatException e) {
+            throw new IOException("Unexpected /proc/uptime: " + uptime);
+        }
+    }
+
+    /**
+     * Kernel time until it starts /init, from the dmesg timestamp;
+     * -1 when the kernel has no printk timestamps
+     */
+    private static long guestInitMs(GuestAgent agent) throws IOException {
+        Matcher matcher = INIT_PATTERN.matcher(agent.exec("/bin/dmesg"));
+        if (!matcher.find()) {
+            return -1;
+        }
+        return (long) (Double.parseDouble(matcher.group(1)) * 1000);
+    }
+}
@@ -0,0 +1,332 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import com.dockerandroid.app.utils.FileUtils;
+
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.File;
+import java.text.SimpleDateFormat;
+import java.util.ArrayDeque;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Date;
+import java.util.List;
+import java.util.Locale;
+
+/**
+ * CrashSupervisor - Decides what happens when the QEMU process dies
+ *
+ * QemuService reports every exit it did not ask for. The supervisor
+ * writes a crash record (exit code or signal, a likely cause, the tail of
+ * the serial console and of QEMU's stderr) to qemu/crashes/ and answers
+ * with the delay before the next boot, or -1 to leave the VM down:
+ *
+ *   - exit code 0 is a guest poweroff and is not restarted
+ *   - the delay doubles per crash (backoffMs .. maxBackoffMs) and starts
+ *     over once a VM stayed up stableSec
+ *   - more than maxRestarts crashes within windowSec trips the crash loop
+ *     breaker until the VM is started by hand
+ */
+public class CrashSupervisor {
+    private static final String TAG = "CrashSupervisor";
+
+    public static final String CRASH_DIR = "crashes";
+
+    public static final String STATE_RUNNING = "running";
+    public static final String STATE_RESTARTING = "restarting";
+    public static final String STATE_CRASH_LOOP = "crash-loop";
+    public static final String STATE_STOPPED = "stopped";
+
+    // Java reports a process killed by signal N as exit value 128 + N
+    private static final int SIGNAL_EXIT_BASE = 128;
+
+    /**
+     * One unexpected exit
+     */
+    public static class Crash {
+        public long time;
+        public long uptimeMs;
+        public int exitCode = -1;
+        public int signal = -1;
+        public String reason;
+        public String recordFile;
+    }
+
+    /**
+     * Supervisor state, read by QemuModule.getStatus (the service and the
+     * React module share the app process)
+     */
+    public static class Status {
+        public String state;
+        public long restarts;
+        public int recentCrashes;
+        public long nextRestartAt;
+        public Crash lastCrash;
+    }
+
+    private static volatile Status lastStatus;
+
+    private final File crashDir;
+    private SupervisorConfig config = new SupervisorConfig();
+
+    // Guarded by this
+    private final ArrayDeque<Long> crashTimes = new ArrayDeque<>();
+    private String state = STATE_STOPPED;
+    private int backoffStep = 0;
+    private long restarts = 0;
+    private long nextRestartAt = 0;
+    private Crash lastCrash;
+    private int ramMB;
+    private int cpuCores;
+    private String bootMode;
+
+    public CrashSupervisor(File qemuDir) {
+        this.crashDir = new File(qemuDir, CRASH_DIR);
+    }
+
+    public static Status getLastStatus() {
+        return lastStatus;
+    }
+
+    /**
+     * A boot started by the user: forget earlier crashes and the breaker
+     */
+    public synchronized void reset() {
+        crashTimes.clear();
+        backoffStep = 0;
+        if (state.equals(STATE_CRASH_LOOP)) {
+            state = STATE_STOPPED;
+        }
+        publish();
+    }
+
+    /**
+     * A QEMU process was spawned with these settings
+     */
+    public synchronized void vmStarted(SupervisorConfig config, int ramMB, int cpuCores, String bootMode) {
+        this.config = config;
+        this.ramMB = ramMB;
+        this.cpuCores = cpuCores;
+        this.bootMode = bootMode;
+        state = STATE_RUNNING;
+        nextRestartAt = 0;
+        publish();
+    }
+
+    /**
+     * The VM was stopped on purpose; a pending restart is dropped
+     */
+    public synchronized void vmStopped() {
+        if (!state.equals(STATE_CRASH_LOOP)) {
+            state = STATE_STOPPED;
+        }
+        nextRestartAt = 0;
+        publish();
+    }
+
+    public synchronized boolean isCrashLoop() {
+        return state.equals(STATE_CRASH_LOOP);
+    }
+
+    /**
+     * Record an exit QemuService did not ask for
+     * @param exitValue Process exit value (128 + N when killed by signal N)
+     * @return milliseconds until the restart, -1 to leave the VM down
+     */
+    public synchronized long onExit(int exitValue, long uptimeMs, String serialTail, String stderrTail) {
+        long now = System.currentTimeMillis();
+        Crash crash = new Crash();
+        crash.time = now;
+        crash.uptimeMs = uptimeMs;
+        if (exitValue > SIGNAL_EXIT_BASE && exitValue < SIGNAL_EXIT_BASE + 65) {
+            crash.signal = exitValue - SIGNAL_EXIT_BASE;
+        } else {
+            crash.exitCode = exitValue;
+        }
+        crash.reason = describe(crash, stderrTail);
+
+        if (crash.exitCode == 0) {
+            Log.i(TAG, "QEMU exited cleanly after " + uptimeMs / 1000 + "s (" + crash.reason + ")");
+            state = STATE_STOPPED;
+            nextRestartAt = 0;
+            publish();
+            return -1;
+        }
+
+        // A VM that stayed up long enough was not part of a crash loop
+        if (uptimeMs >= config.stableSec * 1000L) {
+            backoffStep = 0;
+        }
+        crashTimes.addLast(now);
+        while (!crashTimes.isEmpty() && now - crashTimes.peekFirst() > config.windowSec * 1000L) {
+            crashTimes.removeFirst();
+        }
+
+        long delay;
+        String action;
+        if (!config.restartOnFailure()) {
+            delay = -1;
+            state = STATE_STOPPED;
+            action = "not restarted (restart=never)";
+        } else if (crashTimes.size() > config.maxRestarts) {
+            delay = -1;
+            state = STATE_CRASH_LOOP;
+            action = "crash loop: " + crashTimes.size() + " crashes in " + config.windowSec +
+                "s, not restarted";
+        } else {
+            delay = Math.min(config.maxBackoffMs, config.backoffMs << Math.min(backoffStep, 20));
+            backoffStep++;
+            restarts++;
+            state = STATE_RESTARTING;
+            action = "restart in " + delay + " ms";
+        }
+        nextRestartAt = delay >= 0 ? now + delay : 0;
+
+        crash.recordFile = writeRecord(crash, action, serialTail, stderrTail);
+        lastCrash = crash;
+        Log.e(TAG, "QEMU died after " + uptimeMs / 1000 + "s: " + crash.reason + "; " + action);
+        publish();
+        return delay;
+    }
+
+    /**
+     * Most likely cause from the exit code, signal and QEMU's last words
+     */
+    private static String describe(Crash crash, String stderrTail) {
+        String reason;
+        if (crash.signal > 0) {
+            switch (crash.signal) {
+                case 9:
+                    reason = "killed (SIGKILL), usually Android's low memory killer";
+                    break;
+                case 6:
+                    reason = "aborted (SIGABRT), usually a QEMU assertion";
+                    break;
+                case 11:
+                    reason = "segmentation fault (SIGSEGV)";
+                    break;
+                case 7:
+                    reason = "bus error (SIGBUS)";
+                    break;
+                case 15:
+                    reason = "terminated (SIGTERM)";
+                    break;
+                default:
+                    reason = "killed by signal " + crash.signal;
+                    break;
+            }
+        } else if (crash.exitCode == 0) {
+            reason = "guest powered off";
+        } else {
+            reason = "exited with code " + crash.exitCode;
+        }
+
+        String lastLine = lastLine(stderrTail);
+        if (lastLine != null && crash.exitCode != 0) {
+            reason += ": " + lastLine;
+        }
+        return reason;
+    }
+
+    private static String lastLine(String text) {
+        if (text == null) {
+            return null;
+        }
+        String[] lines = text.trim().split("\n");
+        String last = lines[lines.length - 1].trim();
+        return last.isEmpty() ? null : last;
+    }
+
+    /**
+     * Write the crash record and prune the oldest beyond keepRecords
+     * Returns: record file name, null if it could not be written
+     */
+    private String writeRecord(Crash crash, String action, String serialTail, String stderrTail) {
+        if (!crashDir.exists() && !crashDir.mkdirs()) {
+            Log.e(TAG, "Failed to create " + crashDir);
+            return null;
+        }
+        String name = "crash-" +
+            new SimpleDateFormat("yyyyMMdd-HHmmss-SSS", Locale.US).format(new Date(crash.time)) + ".json";
+        try {
+            JSONObject record = new JSONObject()
+                .put("time", crash.time)
+                .put("uptimeMs", crash.uptimeMs)
+                .put("exitCode", crash.exitCode)
+                .put("signal", crash.signal)
+                .put("reason", crash.reason)
+                .put("action", action)
+                .put("recentCrashes", crashTimes.size())
+                .put("ramMB", ramMB)
+                .put("cpuCores", cpuCores)
+                .put("bootMode", bootMode)
+                .put("serialTail", tail(serialTail, config.crashLogKB * 1024))
+                .put("stderrTail", tail(stderrTail, config.crashLogKB * 1024));
+            if (!FileUtils.writeFile(new File(crashDir, name), record.toString(2))) {
+                return null;
+            }
+        } catch (JSONException e) {
+            Log.e(TAG, "Failed to build crash record: " + e.getMessage());
+            return null;
+        }
+
+        File[] records = listRecordFiles(crashDir);
+        for (int i = config.keepRecords; i < records.length; i++) {
+            records[i].delete();
+        }
+        return name;
+    }
+
+    private static String tail(String text, int maxChars) {
+        if (text == null) {
+            return "";
+        }
+        return text.length() > maxChars ? text.substring(text.length() - maxChars) : text;
+    }
+
+    /**
+     * Crash records, newest first
+     */
+    public static List<JSONObject> listRecords(File qemuDir, int limit) {
+        List<JSONObject> result = new ArrayList<>();
+        for (File file : listRecordFiles(new File(qemuDir, CRASH_DIR))) {
+            if (result.size() >= limit) {
+                break;
+            }
+            String json = FileUtils.readFile(file);
+            if (json == null) {
+                continue;
+            }
+            try {
+                result.add(new JSONObject(json).put("file", file.getName()));
+            } catch (JSONException e) {
+                Log.w(TAG, "Skipping unreadable crash record " + file.getName());
+            }
+        }
+        return result;
+    }
+
+    private static File[] listRecordFiles(File dir) {
+        File[] files = dir.listFiles((d, name) -> name.startsWith("crash-") && name.endsWith(".json"));
+        if (files == null) {
+            return new File[0];
+        }
+        // Names sort by time
+        Arrays.sort(files, (a, b) -> b.getName().compareTo(a.getName()));
+        return files;
+    }
+
+    private void publish() {
+        Status status = new Status();
+        status.state = state;
+        status.restarts = restarts;
+        status.recentCrashes = crashTimes.size();
+        status.nextRestartAt = nextRestartAt;
+        status.lastCrash = lastCrash;
+        lastStatus = status;
+        VmStatus.publish();
+    }
+}
@@ -0,0 +1,357 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import com.dockerandroid.app.utils.FileUtils;
+
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.File;
+import java.io.IOException;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+import java.util.regex.Pattern;
+
+/**
+ * DiskManager - Layered VM disks
+ * A read-only base image (alpine-base.qcow2) is shared by thin copy-on-write
+ * overlays in qemu/overlays/. QEMU only ever writes to an overlay, so a VM
+ * can be reset or cloned in milliseconds without touching the base.
+ */
+public class DiskManager {
+    private static final String TAG = "DiskManager";
+
+    public static final String BASE_IMAGE = "alpine-base.qcow2";
+    public static final String BASE_MANIFEST = "alpine-base.json";
+    public static final String DEFAULT_OVERLAY = "default";
+    public static final String KERNEL_IMAGE = "vmlinuz-virt";
+    public static final String INITRD_IMAGE = "initramfs-virt";
+
+    private static final String OVERLAY_DIR = "overlays";
+    private static final String OVERLAY_EXT = ".qcow2";
+    private static final String LEGACY_DISK = "alpine-disk.qcow2";
+    private static final long DEFAULT_DISK_SIZE = 10L * 1024 * 1024 * 1024; // 10GB
+    private static final long PLACEHOLDER_MAX_SIZE = 4096;
+    private static final Pattern NAME_PATTERN = Pattern.compile("[A-Za-z0-9_-]{1,64}");
+
+    // Native qcow2 operations (implemented in disk_layers.c)
+    // Return 0 (or a size) on success, < 0 = -errno
+    private static native int nativeCreateImage(String path, long sizeBytes,
+                                                String backingPath, String backingFormat);
+    private static native long nativeGetVirtualSize(String path);
+    private static native int nativeRewriteImage(String srcPath, String destPath,
+                                                 boolean keepBacking, long[] stats,
+                                                 FileUtils.ProgressListener listener);
+    private static native int nativeCompactImage(String srcPath, String destPath, long[] stats,
+                                                 FileUtils.ProgressListener listener);
+
+    static {
+        try {
+            System.loadLibrary("qemu-jni");
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Failed to load native library qemu-jni: " + e.getMessage());
+        }
+    }
+
+    private final File qemuDir;
+    private final File overlayDir;
+
+    public DiskManager(File qemuDir) {
+        this.qemuDir = qemuDir;
+        this.overlayDir = new File(qemuDir, OVERLAY_DIR);
+    }
+
+    public File getBaseImage() {
+        return new File(qemuDir, BASE_IMAGE);
+    }
+
+    public File getOverlay(String name) {
+        return new File(overlayDir, name + OVERLAY_EXT);
+    }
+    
+    /**
+     * Manifest written by scripts/build-alpine-image.sh, extracted with the base image
+     */
+    public File getBaseManifest() {
+        return new File(qemuDir, BASE_MANIFEST);
+    }
+    
+    /**
+     * Whether the base image has Alpine and Docker preinstalled, so the VM
+     * boots from disk without the installer ISO
+     */
+    public boolean isProvisioned() {
+        JSONObject manifest = readManifest();
+        return manifest != null && manifest.optBoolean("provisioned", false);
+    }
+    
+    /**
+     * Kernel packaged with a provisioned image for direct kernel boot
+     */
+    public File getKernel() {
+        return new File(qemuDir, KERNEL_IMAGE);
+    }
+    
+    public File getInitrd() {
+        return new File(qemuDir, INITRD_IMAGE);
+    }
+    
+    /**
+     * Kernel command line recorded when the image was built (it names the
+     * root filesystem); null when the image does not support kernel boot
+     */
+    public String getKernelCmdline() {
+        JSONObject manifest = readManifest();
+        if (manifest == null || !manifest.optBoolean("provisioned", false)) {
+            return null;
+        }
+        String cmdline = manifest.optString("cmdline", "");
+        return cmdline.isEmpty() ? null : cmdline;
+    }
+    
+    /**
+     * Whether the VM can boot with -kernel/-initrd instead of firmware
+     */
+    public boolean canBootKernel() {
+        return getKernelCmdline() != null && getKernel().exists() && getInitrd().exists();
+    }
+    
+    private JSONObject readManifest() {
+        File manifest = getBaseManifest();
+        String json = manifest.exists() ? FileUtils.readFile(manifest) : null;
+        if (json == null) {
+            return null;
+        }
+        try {
+            return new JSONObject(json);
+        } catch (JSONException e) {
+            Log.e(TAG, "Invalid " + BASE_MANIFEST + ": " + e.getMessage());
+            return null;
+        }
+    }
+
+    /**
+     * Make sure the base image and the default overlay exist.
+     * Disks from older releases (a single writable alpine-disk.qcow2)
+     * become the new base image.
+     * @param baseSource supplies the base image when it is missing
+     */
+    public void ensureLayout(BaseImageSource baseSource) throws IOException {
+        if (!overlayDir.exists() && !overlayDir.mkdirs()) {
+            throw new IOException("Failed to create overlay directory");
+        }
+
+        File base = getBaseImage();
+        File legacy = new File(qemuDir, LEGACY_DISK);
+        if (!base.exists() && legacy.exists()) {
+            if (legacy.length() < PLACEHOLDER_MAX_SIZE) {
+                // Old releases wrote a header-only placeholder, not a real disk
+                Log.d(TAG, "Discarding placeholder disk " + legacy.getAbsolutePath());
+                legacy.delete();
+            } else if (legacy.renameTo(base)) {
+                Log.d(TAG, "Migrated " + LEGACY_DISK + " to base image");
+                getBaseManifest().delete();
+            }
+        }
+
+        if (!base.exists()) {
+            if (!baseSource.provide(base)) {
+                Log.d(TAG, "No packaged disk image, creating empty base image");
+                getBaseManifest().delete();
+                createImage(base, DEFAULT_DISK_SIZE, null);
+            }
+        }
+        base.setReadOnly();
+
+        if (!getOverlay(DEFAULT_OVERLAY).exists()) {
+            createOverlay(DEFAULT_OVERLAY);
+        }
+    }
+
+    /**
+     * Supplies the base image, e.g. by extracting it from the APK,
+     * together with its manifest (getBaseManifest) when there is one
+     */
+    public interface BaseImageSource {
+        boolean provide(File dest) throws IOException;
+    }
+
+    /**
+     * List overlay names, sorted
+     */
+    public List<String> listOverlays() {
+        List<String> names = new ArrayList<>();
+        File[] files = overlayDir.listFiles();
+        if (files == null) {
+            return names;
+        }
+        Arrays.sort(files);
+        for (File file : files) {
+            String fileName = file.getName();
+            if (fileName.endsWith(OVERLAY_EXT)) {
+                names.add(fileName.substring(0, fileName.length() - OVERLAY_EXT.length()));
+            }
+        }
+        return names;
+    }
+
+    /**
+     * Create an empty overlay on top of the base image
+     */
+    public File createOverlay(String name) throws IOException {
+        File overlay = getOverlay(checkName(name));
+        if (overlay.exists()) {
+            throw new IOException("Overlay already exists: " + name);
+        }
+        createOverlayAt(overlay);
+        return overlay;
+    }
+
+    /**
+     * Throw away everything the guest wrote to an overlay
+     */
+    public void resetOverlay(String name) throws IOException {
+        File overlay = getOverlay(checkName(name));
+        File tmp = new File(overlayDir, name + OVERLAY_EXT + ".tmp");
+        createOverlayAt(tmp);
+        if (!tmp.renameTo(overlay)) {
+            tmp.delete();
+            throw new IOException("Failed to reset overlay " + name);
+        }
+        Log.d(TAG, "Reset overlay " + name);
+    }
+
+    /**
+     * Copy an overlay; the copy shares the base image
+     */
+    public File cloneOverlay(String source, String name) throws IOException {
+        File src = getOverlay(checkName(source));
+        File dest = getOverlay(checkName(name));
+        if (!src.exists()) {
+            throw new IOException("No such overlay: " + source);
+        }
+        if (dest.exists()) {
+            throw new IOException("Overlay already exists: " + name);
+        }
+
+        File tmp = new File(overlayDir, name + OVERLAY_EXT + ".tmp");
+        int result = nativeRewriteImage(src.getAbsolutePath(), tmp.getAbsolutePath(), true, null, null);
+        if (result < 0 || !tmp.renameTo(dest)) {
+            tmp.delete();
+            throw new IOException("Failed to clone overlay " + source + " (errno " + -result + ")");
+        }
+        Log.d(TAG, "Cloned overlay " + source + " -> " + name);
+        return dest;
+    }
+
+    /**
+     * Delete an overlay
+     */
+    public void deleteOverlay(String name) throws IOException {
+        File overlay = getOverlay(checkName(name));
+        if (overlay.exists() && !overlay.delete()) {
+            throw new IOException("Failed to delete overlay " + name);
+        }
+    }
+
+    /**
+     * Merge an overlay into the base image and reset the overlay.
+     * Only allowed while it is the only overlay, since the others were
+     * written against the old base.
+     * @return {overlayBytes, baseBytes} allocated size of the overlay and new base
+     */
+    public long[] commitOverlay(String name, FileUtils.ProgressListener listener) throws IOException {
+        File overlay = getOverlay(checkName(name));
+        if (!overlay.exists()) {
+            throw new IOException("No such overlay: " + name);
+        }
+        List<String> overlays = listOverlays();
+        if (overlays.size() > 1) {
+            throw new IOException("Cannot commit while other overlays exist: " + overlays);
+        }
+
+        File base = getBaseImage();
+        File tmp = new File(qemuDir, BASE_IMAGE + ".tmp");
+        long[] stats = new long[2];
+        int result = nativeRewriteImage(overlay.getAbsolutePath(), tmp.getAbsolutePath(), false,
+            stats, listener);
+        if (result < 0) {
+            tmp.delete();
+            throw new IOException("Failed to commit overlay " + name + " (errno " + -result + ")");
+        }
+
+        if (!tmp.renameTo(base)) {
+            tmp.delete();
+            throw new IOException("Failed to replace base image");
+        }
+        base.setReadOnly();
+        resetOverlay(name);
+
+        Log.d(TAG, "Committed overlay " + name + " into base image");
+        return stats;
+    }
+
+    /**
+     * Rewrite an overlay without its zero and unallocated clusters.
+     * Space the guest freed (fstrim, deleted images) is only returned to
+     * the phone by this; runs at idle I/O priority on the calling thread.
+     * @return {bytesBefore, bytesAfter} allocated size of the overlay
+     */
+    public long[] compactOverlay(String name, FileUtils.ProgressListener listener) throws IOException {
+        File overlay = getOverlay(checkName(name));
+        if (!overlay.exists()) {
+            throw new IOException("No such overlay: " + name);
+        }
+
+        File tmp = new File(overlayDir, name + OVERLAY_EXT + ".tmp");
+        long[] stats = new long[2];
+        int result = nativeCompactImage(overlay.getAbsolutePath(), tmp.getAbsolutePath(), stats, listener);
+        if (result < 0 || !tmp.renameTo(overlay)) {
+            tmp.delete();
+            throw new IOException("Failed to compact overlay " + name + " (errno " + -result + ")");
+        }
+
+        Log.d(TAG, "Compacted overlay " + name + ": " + FileUtils.formatFileSize(stats[0]) +
+            " -> " + FileUtils.formatFileSize(stats[1]));
+        return stats;
+    }
+
+    /**
+     * Virtual size of an overlay in bytes
+     */
+    public long getVirtualSize(String name) throws IOException {
+        long size = nativeGetVirtualSize(getOverlay(checkName(name)).getAbsolutePath());
+        if (size < 0) {
+            throw new IOException("Failed to read overlay " + name + " (errno " + -size + ")");
+        }
+        return size;
+    }
+
+    private void createOverlayAt(File overlay) throws IOException {
+        File base = getBaseImage();
+        long size = nativeGetVirtualSize(base.getAbsolutePath());
+        if (size < 0) {
+            throw new IOException("Failed to read base image (errno " + -size + ")");
+        }
+
+        // Relative backing path so the qemu directory can be moved
+        createImage(overlay, size, "../" + BASE_IMAGE);
+    }
+
+    private static void createImage(File image, long sizeBytes, String backing) throws IOException {
+        int result = nativeCreateImage(image.getAbsolutePath(), sizeBytes, backing,
+            backing != null ? "qcow2" : null);
+        if (result < 0) {
+            throw new IOException("Failed to create " + image.getName() + " (errno " + -result + ")");
+        }
+    }
+
+    private static String checkName(String name) {
+        if (name == null || !NAME_PATTERN.matcher(name).matches()) {
+            throw new IllegalArgumentException("Invalid overlay name: " + name);
+        }
+        return name;
+    }
+}
@@ -0,0 +1,222 @@
+package com.dockerandroid.app.qemu;
+
+import android.net.LocalSocket;
+import android.net.LocalSocketAddress;
+import android.util.Base64;
+import android.util.Log;
+
+import org.json.JSONArray;
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStreamReader;
+import java.io.OutputStream;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * GuestAgent - Client for the QEMU guest agent (qemu-ga) in the Alpine VM
+ * Talks JSON over the virtio-serial channel exposed as qemu/qga.sock
+ */
+public class GuestAgent {
+    private static final String TAG = "GuestAgent";
+
+    public static final String SOCKET_NAME = "qga.sock";
+    public static final String CHANNEL_NAME = "org.qemu.guest_agent.0";
+
+    private static final int DEFAULT_TIMEOUT_MS = 10 * 1000;
+    private static final int FSTRIM_TIMEOUT_MS = 10 * 60 * 1000;
+    private static final long EXEC_POLL_MS = 50;
+
+    private final File socketFile;
+
+    public GuestAgent(File qemuDir) {
+        this.socketFile = new File(qemuDir, SOCKET_NAME);
+    }
+
+    /**
+     * Check that the agent is running in the guest
+     */
+    public boolean ping() {
+        return ping(DEFAULT_TIMEOUT_MS);
+    }
+
+    public boolean ping(int timeoutMs) {
+        try {
+            execute("guest-ping", null, timeoutMs);
+            return true;
+        } catch (IOException e) {
+            return false;
+        }
+    }
+
+    /**
+     * Discard unused blocks on all guest filesystems.
+     * With discard=unmap on the drive the freed clusters are released
+     * from the overlay file on the phone.
+     * @return bytes trimmed as reported by the guest
+     */
+    public long fstrim() throws IOException {
+        long start = System.currentTimeMillis();
+        JSONObject result = execute("guest-fstrim", null, FSTRIM_TIMEOUT_MS);
+
+        long trimmed = 0;
+        JSONArray paths = result.optJSONArray("paths");
+        if (paths != null) {
+            for (int i = 0; i < paths.length(); i++) {
+                JSONObject path = paths.optJSONObject(i);
+                if (path == null) {
+                    continue;
+                }
+                if (path.has("error")) {
+                    Log.w(TAG, "fstrim " + path.optString("path") + ": " + path.optString("error"));
+                }
+                trimmed += path.optLong("trimmed", 0);
+            }
+        }
+
+        Log.d(TAG, "fstrim released " + trimmed + " bytes in " +
+            (System.currentTimeMillis() - start) + " ms");
+        return trimmed;
+    }
+
+    /**
+     * Run a program in the guest and return its standard output
+     */
+    public String exec(String path, String... args) throws IOException {
+        try {
+            JSONArray argList = new JSONArray();
+            for (String arg : args) {
+                argList.put(arg);
+            }
+            JSONObject started = execute("guest-exec", new JSONObject()
+                .put("path", path)
+                .put("arguments", argList)
+                .put("capture-output", true), DEFAULT_TIMEOUT_MS);
+            JSONObject pid = new JSONObject().put("pid", started.getLong("pid"));
+
+            long deadline = System.currentTimeMillis() + DEFAULT_TIMEOUT_MS;
+            while (System.currentTimeMillis() < deadline) {
+                JSONObject status = execute("guest-exec-status", pid, DEFAULT_TIMEOUT_MS);
+                if (status.optBoolean("exited", false)) {
+                    String out = status.optString("out-data", "");
+                    return new String(Base64.decode(out, Base64.DEFAULT), StandardCharsets.UTF_8);
+                }
+                Thread.sleep(EXEC_POLL_MS);
+            }
+            throw new IOException(path + " did not exit in time");
+        } catch (JSONException e) {
+            throw new IOException("Invalid guest agent message: " + e.getMessage(), e);
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+            throw new IOException("Interrupted waiting for " + path);
+        }
+    }
+
+    /**
+     * Run an agent command and return its "return" object
+     */
+    public JSONObject execute(String command, JSONObject arguments, int timeoutMs) throws IOException {
+        Object ret = call(command, arguments, timeoutMs);
+        return ret instanceof JSONObject ? (JSONObject) ret : new JSONObject();
+    }
+
+    /**
+     * Bytes received and sent by the guest's interfaces other than
+     * loopback, from guest-network-get-interfaces
+     * @return {rxBytes, txBytes}
+     */
+    public long[] networkBytes(int timeoutMs) throws IOException {
+        Object ret = call("guest-network-get-interfaces", null, timeoutMs);
+        if (!(ret instanceof JSONArray)) {
+            throw new IOException("guest-network-get-interfaces returned no list");
+        }
+        JSONArray interfaces = (JSONArray) ret;
+        long[] bytes = new long[2];
+        for (int i = 0; i < interfaces.length(); i++) {
+            JSONObject iface = interfaces.optJSONObject(i);
+            if (iface == null || "lo".equals(iface.optString("name"))) {
+                continue;
+            }
+            JSONObject stats = iface.optJSONObject("statistics");
+            if (stats != null) {
+                bytes[0] += stats.optLong("rx-bytes", 0);
+                bytes[1] += stats.optLong("tx-bytes", 0);
+            }
+        }
+        return bytes;
+    }
+
+    /**
+     * Run an agent command and return its "return" value (object, array
+     * or number).
+     * Every call resynchronises first with guest-sync, so stale replies
+     * from an earlier timed-out command are skipped.
+     */
+    private Object call(String command, JSONObject arguments, int timeoutMs) throws IOException {
+        try (LocalSocket socket = new LocalSocket()) {
+            socket.connect(new LocalSocketAddress(socketFile.getAbsolutePath(),
+                LocalSocketAddress.Namespace.FILESYSTEM));
+            socket.setSoTimeout(timeoutMs);
+
+            OutputStream out = socket.getOutputStream();
+            BufferedReader in = new BufferedReader(
+                new InputStreamReader(socket.getInputStream(), StandardCharsets.UTF_8));
+
+            long syncId = System.nanoTime() & 0x7fffffffL;
+            JSONObject sync = new JSONObject()
+                .put("execute", "guest-sync")
+                .put("arguments", new JSONObject().put("id", syncId));
+            send(out, sync);
+
+            String line;
+            while ((line = in.readLine()) != null) {
+                JSONObject reply = parse(line);
+                if (reply != null && reply.optLong("return", -1) == syncId) {
+                    break;
+                }
+            }
+            if (line == null) {
+                throw new IOException("Guest agent closed the connection");
+            }
+
+            JSONObject request = new JSONObject().put("execute", command);
+            if (arguments != null) {
+                request.put("arguments", arguments);
+            }
+            send(out, request);
+
+            while ((line = in.readLine()) != null) {
+                JSONObject reply = parse(line);
+                if (reply == null) {
+                    continue;
+                }
+                if (reply.has("error")) {
+                    JSONObject error = reply.getJSONObject("error");
+                    throw new IOException(command + " failed: " + error.optString("desc"));
+                }
+                if (reply.has("return")) {
+                    return reply.get("return");
+                }
+            }
+            throw new IOException("Guest agent closed the connection");
+        } catch (JSONException e) {
+            throw new IOException("Invalid guest agent message: " + e.getMessage(), e);
+        }
+    }
+
+    private static void send(OutputStream out, JSONObject message) throws IOException {
+        out.write((message.toString() + "\n").getBytes(StandardCharsets.UTF_8));
+        out.flush();
+    }
+
+    private static JSONObject parse(String line) {
+        try {
+            return new JSONObject(line.trim());
+        } catch (JSONException e) {
+            return null;
+        }
+    }
+}
@@ -0,0 +1,96 @@
+package com.dockerandroid.app.qemu;
+
+import org.json.JSONObject;
+
+import java.io.File;
+
+/**
+ * IdleConfig - Idle auto-suspend settings
+ * Read from the "idle" section of qemu-config.json:
+ *
+ *   "idle": { "autoSuspend": true, "idleSec": 300, "checkSec": 30,
+ *             "keepAwakeWithContainers": true,
+ *             "socketActivation": true, "activationTimeoutSec": 300 }
+ *
+ * With autoSuspend or socketActivation the app owns the forwarded Docker
+ * and SSH ports and proxies them to QEMU's hostfwd on loopback-only
+ * internal ports, so it sees every connection (see IdleGovernor and
+ * VmActivator). Without either QEMU forwards the ports itself, as before.
+ */
+public class IdleConfig {
+    public static final int DOCKER_PORT = 2375;
+    public static final int SSH_PORT = 2222;
+    // QEMU's hostfwd listens on port + offset when the proxy is in front
+    private static final int INTERNAL_PORT_OFFSET = 10000;
+
+    public boolean autoSuspend = true;
+    public int idleSec = 300;
+    public int checkSec = 30;
+    public boolean keepAwakeWithContainers = true;
+    public boolean socketActivation = true;
+    public int activationTimeoutSec = 300;
+
+    /**
+     * Load idle settings; missing or invalid values keep their defaults
+     */
+    public static IdleConfig load(File configFile) {
+        return fromJson(QemuCommand.readConfig(configFile));
+    }
+
+    /**
+     * Read the "idle" section of an already parsed qemu-config.json
+     */
+    public static IdleConfig fromJson(JSONObject root) {
+        IdleConfig config = new IdleConfig();
+        JSONObject idle = root.optJSONObject("idle");
+        if (idle != null) {
+            config.autoSuspend = idle.optBoolean("autoSuspend", config.autoSuspend);
+            config.idleSec = idle.optInt("idleSec", config.idleSec);
+            config.checkSec = idle.optInt("checkSec", config.checkSec);
+            config.keepAwakeWithContainers =
+                idle.optBoolean("keepAwakeWithContainers", config.keepAwakeWithContainers);
+            config.socketActivation = idle.optBoolean("socketActivation", config.socketActivation);
+            config.activationTimeoutSec = idle.optInt("activationTimeoutSec", config.activationTimeoutSec);
+        }
+        if (config.idleSec < 30) {
+            config.idleSec = 30;
+        }
+        if (config.checkSec < 5 || config.checkSec > config.idleSec) {
+            config.checkSec = Math.min(30, config.idleSec);
+        }
+        if (config.activationTimeoutSec < 30) {
+            config.activationTimeoutSec = 300;
+        }
+        return config;
+    }
+
+    /**
+     * Whether the app proxies the Docker and SSH ports
+     */
+    public boolean proxied() {
+        return autoSuspend || socketActivation;
+    }
+
+    /**
+     * Port QEMU listens on for a forwarded host port
+     */
+    public int qemuPort(int hostPort) {
+        return proxied() ? hostPort + INTERNAL_PORT_OFFSET : hostPort;
+    }
+
+    /**
+     * hostfwd rule for a port that may sit behind the proxy; the internal
+     * port is bound to loopback only
+     */
+    public String hostfwd(int hostPort, int guestPort) {
+        String bind = proxied() ? "127.0.0.1" : "";
+        return "hostfwd=tcp:" + bind + ":" + qemuPort(hostPort) + "-:" + guestPort;
+    }
+
+    @Override
+    public String toString() {
+        return "autoSuspend=" + autoSuspend + " idleSec=" + idleSec +
+               " keepAwakeWithContainers=" + keepAwakeWithContainers +
+               " socketActivation=" + socketActivation;
+    }
+}
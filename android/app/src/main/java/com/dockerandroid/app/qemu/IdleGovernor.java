@@ -0,0 +1,183 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import org.json.JSONArray;
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.net.HttpURLConnection;
+import java.net.URL;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * IdleGovernor - Pauses an idle VM and resumes it on the next connection
+ *
+ * Checked every checkSec on QemuService's maintenance executor: after
+ * idleSec without proxied traffic (see PortProxy) and with no container
+ * running, the vCPUs are stopped with QMP "stop" and the service drops its
+ * wake lock. A stopped TCG guest costs no CPU; QEMU's main loop only
+ * wakes for timers and I/O. The next byte sent to a forwarded port runs
+ * QMP "cont" first, which takes milliseconds.
+ *
+ * The guest clock stands still while stopped, so the guest agent sets it
+ * to the host time after every resume.
+ */
+public class IdleGovernor implements Runnable {
+    private static final String TAG = "IdleGovernor";
+
+    private static final int DOCKER_TIMEOUT_MS = 2000;
+    private static final int TIME_SYNC_TIMEOUT_MS = 5000;
+
+    /**
+     * Told when the VM stops and runs again, on the thread that caused it
+     */
+    public interface Listener {
+        void onSuspended();
+        void onResumed();
+    }
+
+    // Read by QemuModule.getStatus (the service and the React module
+    // share the app process)
+    private static volatile boolean vmSuspended = false;
+
+    private final IdleConfig config;
+    private final QmpClient qmp;
+    private final GuestAgent agent;
+    private final Listener listener;
+
+    private volatile boolean suspended = false;
+    private volatile long lastActivity = System.currentTimeMillis();
+
+    public IdleGovernor(IdleConfig config, QmpClient qmp, GuestAgent agent, Listener listener) {
+        this.config = config;
+        this.qmp = qmp;
+        this.agent = agent;
+        this.listener = listener;
+        vmSuspended = false;
+    }
+
+    public static boolean isVmSuspended() {
+        return vmSuspended;
+    }
+
+    public boolean isSuspended() {
+        return suspended;
+    }
+
+    /**
+     * Record traffic on a forwarded port
+     */
+    public void touch() {
+        lastActivity = System.currentTimeMillis();
+    }
+
+    /**
+     * Make sure the VM runs before traffic is passed to it
+     */
+    public void resume() {
+        touch();
+        if (!suspended) {
+            return;
+        }
+        synchronized (this) {
+            if (!suspended) {
+                return;
+            }
+            long start = System.currentTimeMillis();
+            try {
+                qmp.execute("cont", null);
+            } catch (IOException e) {
+                // Let the connection through anyway; it fails at the guest
+                Log.e(TAG, "Failed to resume VM: " + e.getMessage());
+                return;
+            }
+            suspended = false;
+            vmSuspended = false;
+            VmStatus.publish();
+            Log.d(TAG, "VM resumed in " + (System.currentTimeMillis() - start) + " ms");
+        }
+        listener.onResumed();
+        new Thread(this::syncGuestClock, "guest-clock").start();
+    }
+
+    /**
+     * Idle check; suspends the VM when it has been quiet for idleSec
+     */
+    @Override
+    public void run() {
+        if (suspended || System.currentTimeMillis() - lastActivity < config.idleSec * 1000L) {
+            return;
+        }
+        if (config.keepAwakeWithContainers) {
+            int running = runningContainers();
+            if (running != 0) {
+                // Containers at work, or Docker not up yet
+                touch();
+                return;
+            }
+        }
+
+        synchronized (this) {
+            if (suspended || System.currentTimeMillis() - lastActivity < config.idleSec * 1000L) {
+                return;
+            }
+            try {
+                qmp.execute("stop", null);
+            } catch (IOException e) {
+                Log.w(TAG, "Failed to suspend VM: " + e.getMessage());
+                return;
+            }
+            suspended = true;
+            vmSuspended = true;
+            VmStatus.publish();
+        }
+        Log.d(TAG, "VM suspended after " + config.idleSec + "s idle");
+        listener.onSuspended();
+    }
+
+    /**
+     * Number of running containers from the Docker API on QEMU's internal
+     * port (not counted as traffic); -1 when Docker does not answer
+     */
+    private int runningContainers() {
+        HttpURLConnection connection = null;
+        try {
+            URL url = new URL("http://127.0.0.1:" + config.qemuPort(IdleConfig.DOCKER_PORT) +
+                "/containers/json");
+            connection = (HttpURLConnection) url.openConnection();
+            connection.setConnectTimeout(DOCKER_TIMEOUT_MS);
+            connection.setReadTimeout(DOCKER_TIMEOUT_MS);
+            if (connection.getResponseCode() != HttpURLConnection.HTTP_OK) {
+                return -1;
+            }
+            ByteArrayOutputStream body = new ByteArrayOutputStream();
+            try (InputStream in = connection.getInputStream()) {
+                byte[] buffer = new byte[8192];
+                int n;
+                while ((n = in.read(buffer)) >= 0) {
+                    body.write(buffer, 0, n);
+                }
+            }
+            return new JSONArray(body.toString(StandardCharsets.UTF_8.name())).length();
+        } catch (IOException | JSONException e) {
+            return -1;
+        } finally {
+            if (connection != null) {
+                connection.disconnect();
+            }
+        }
+    }
+
+    private void syncGuestClock() {
+        try {
+            agent.execute("guest-set-time",
+                new JSONObject().put("time", System.currentTimeMillis() * 1000000L), TIME_SYNC_TIMEOUT_MS);
+        } catch (IOException | JSONException e) {
+            Log.w(TAG, "Guest clock not synced after resume: " + e.getMessage());
+        }
+    }
+}
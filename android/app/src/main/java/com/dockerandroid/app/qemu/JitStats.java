@@ -0,0 +1,101 @@
+package com.dockerandroid.app.qemu;
+
+import java.io.IOException;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+/**
+ * JitStats - TCG translation cache counters from the HMP "info jit" command
+ * A TB flush count that keeps climbing means the cache (tb-size) is too
+ * small for the guest workload and code is translated over and over.
+ *
+ * The query blocks on QMP, so Sampler runs it every SAMPLE_SEC on
+ * QemuService's maintenance executor and getStatus reads the last sample.
+ */
+public class JitStats {
+    public static final int SAMPLE_SEC = 30;
+    private static final int QUERY_TIMEOUT_MS = 1000;
+
+    private static final Pattern CODE_SIZE = Pattern.compile("gen code size\\s+(\\d+)/(\\d+)");
+    private static final Pattern TB_COUNT = Pattern.compile("TB count\\s+(\\d+)");
+    private static final Pattern TB_FLUSHES = Pattern.compile("TB flush count\\s+(\\d+)");
+    private static final Pattern TB_INVALIDATIONS = Pattern.compile("TB invalidate count\\s+(\\d+)");
+    private static final Pattern TLB_FLUSHES = Pattern.compile("TLB full flushes\\s+(\\d+)");
+
+    public long codeUsedBytes = -1;
+    public long codeSizeBytes = -1;
+    public long tbCount = -1;
+    public long tbFlushes = -1;
+    public long tbInvalidations = -1;
+    public long tlbFullFlushes = -1;
+    // Set by Sampler: TB flushes per minute since the previous sample
+    // (-1 for the first one), and when this sample was taken
+    public double tbFlushesPerMin = -1;
+    public long sampledAt;
+
+    private static volatile JitStats lastStatus;
+
+    public static JitStats getLastStatus() {
+        return lastStatus;
+    }
+
+    public static void clearStatus() {
+        lastStatus = null;
+    }
+
+    /**
+     * Query the running VM; fields QEMU does not report stay -1
+     */
+    public static JitStats query(QmpClient qmp) throws IOException {
+        return parse(qmp.humanCommand("info jit", QUERY_TIMEOUT_MS));
+    }
+
+    /**
+     * Periodic "info jit" query; a VM that does not answer keeps the
+     * previous sample
+     */
+    public static class Sampler implements Runnable {
+        private final QmpClient qmp;
+
+        public Sampler(QmpClient qmp) {
+            this.qmp = qmp;
+        }
+
+        @Override
+        public void run() {
+            JitStats stats;
+            try {
+                stats = query(qmp);
+            } catch (IOException e) {
+                return;
+            }
+            stats.sampledAt = System.currentTimeMillis();
+            JitStats previous = lastStatus;
+            if (previous != null && stats.tbFlushes >= previous.tbFlushes &&
+                stats.sampledAt > previous.sampledAt) {
+                stats.tbFlushesPerMin = (stats.tbFlushes - previous.tbFlushes) * 60000.0 /
+                    (stats.sampledAt - previous.sampledAt);
+            }
+            lastStatus = stats;
+        }
+    }
+
+    static JitStats parse(String info) {
+        JitStats stats = new JitStats();
+        Matcher matcher = CODE_SIZE.matcher(info);
+        if (matcher.find()) {
+            stats.codeUsedBytes = Long.parseLong(matcher.group(1));
+            stats.codeSizeBytes = Long.parseLong(matcher.group(2));
+        }
+        stats.tbCount = find(TB_COUNT, info);
+        stats.tbFlushes = find(TB_FLUSHES, info);
+        stats.tbInvalidations = find(TB_INVALIDATIONS, info);
+        stats.tlbFullFlushes = find(TLB_FLUSHES, info);
+        return stats;
+    }
+
+    private static long find(Pattern pattern, String info) {
+        Matcher matcher = pattern.matcher(info);
+        return matcher.find() ? Long.parseLong(matcher.group(1)) : -1;
+    }
+}
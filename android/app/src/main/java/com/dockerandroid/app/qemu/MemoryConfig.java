@@ -0,0 +1,223 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import org.json.JSONObject;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.FileReader;
+import java.io.IOException;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.List;
+
+/**
+ * MemoryConfig - Backend for the guest RAM
+ * Read from the "memoryBackend" section of qemu-config.json:
+ *
+ *   "memoryBackend": { "type": "auto", "hugepages": "auto", "merge": "auto",
+ *                      "prealloc": false, "preallocThreads": 0, "dump": false }
+ *
+ * type      ram (anonymous memory), memfd, or legacy (plain -m)
+ * hugepages thp: QEMU madvises guest RAM for transparent huge pages, which
+ *           cuts TLB misses in the TCG softmmu; hugetlb: reserved hugetlbfs
+ *           pages through memfd; off: memfd, so anonymous THP does not apply
+ * merge     KSM: identical guest pages (zero pages, the same image layers
+ *           in several VMs) are shared by the host kernel
+ * prealloc  touch all guest RAM at start, with preallocThreads threads
+ * dump      include guest RAM in QEMU core dumps
+ *
+ * "auto" values are settled from the host kernel features in /sys.
+ */
+public class MemoryConfig {
+    private static final String TAG = "MemoryConfig";
+
+    public static final String BACKEND_ID = "ram0";
+
+    public static final List<String> TYPES = Arrays.asList("auto", "ram", "memfd", "legacy");
+    public static final List<String> HUGEPAGE_MODES = Arrays.asList("auto", "thp", "hugetlb", "off");
+
+    private static final String THP_ENABLED = "/sys/kernel/mm/transparent_hugepage/enabled";
+    private static final String THP_SHMEM_ENABLED = "/sys/kernel/mm/transparent_hugepage/shmem_enabled";
+    private static final String KSM_RUN = "/sys/kernel/mm/ksm/run";
+    private static final String HUGETLB_FREE = "/sys/kernel/mm/hugepages/hugepages-2048kB/free_hugepages";
+    private static final int MAX_PREALLOC_THREADS = 8;
+
+    public String type = "auto";
+    public String hugepages = "auto";
+    public String merge = "auto";       // "auto", "on" or "off"
+    public boolean prealloc = false;
+    public int preallocThreads = 0;     // 0 = one per CPU core
+    public boolean dump = false;
+
+    /**
+     * Load memory settings; missing or invalid values keep their defaults
+     */
+    public static MemoryConfig load(File configFile) {
+        return fromJson(QemuCommand.readConfig(configFile));
+    }
+
+    /**
+     * Read the "memoryBackend" section of an already parsed qemu-config.json
+     */
+    public static MemoryConfig fromJson(JSONObject root) {
+        MemoryConfig config = new MemoryConfig();
+        JSONObject memory = root.optJSONObject("memoryBackend");
+        if (memory != null) {
+            config.type = memory.optString("type", config.type);
+            config.hugepages = memory.optString("hugepages", config.hugepages);
+            Object merge = memory.opt("merge");
+            if (merge instanceof Boolean) {
+                config.merge = (Boolean) merge ? "on" : "off";
+            } else if (merge instanceof String) {
+                config.merge = (String) merge;
+            }
+            config.prealloc = memory.optBoolean("prealloc", config.prealloc);
+            config.preallocThreads = memory.optInt("preallocThreads", config.preallocThreads);
+            config.dump = memory.optBoolean("dump", config.dump);
+        }
+        config.validate();
+        return config;
+    }
+
+    private void validate() {
+        if (!TYPES.contains(type)) {
+            Log.w(TAG, "Unknown memory backend " + type + ", using auto");
+            type = "auto";
+        }
+        if (!HUGEPAGE_MODES.contains(hugepages)) {
+            Log.w(TAG, "Unknown hugepages mode " + hugepages + ", using auto");
+            hugepages = "auto";
+        }
+        if (!merge.equals("on") && !merge.equals("off")) {
+            merge = "auto";
+        }
+        if (preallocThreads < 0 || preallocThreads > MAX_PREALLOC_THREADS) {
+            preallocThreads = 0;
+        }
+    }
+
+    /**
+     * Settle the "auto" values against the host kernel:
+     *  - hugepages: hugetlb only when enough 2MB pages are reserved for the
+     *    whole guest, else THP when the kernel offers it, else off
+     *  - type: memfd for hugetlb, or for THP when only shmem THP is enabled;
+     *    anonymous RAM otherwise
+     *  - merge: on when ksmd is running
+     */
+    public void resolve(int ramMB) {
+        if (type.equals("legacy")) {
+            return;
+        }
+
+        boolean smallPagesRequested = hugepages.equals("off");
+        boolean anonThp = thpAvailable(THP_ENABLED);
+        boolean shmemThp = thpAvailable(THP_SHMEM_ENABLED);
+        if (hugepages.equals("auto")) {
+            if (readLong(HUGETLB_FREE) * 2 >= ramMB) {
+                hugepages = "hugetlb";
+            } else {
+                hugepages = anonThp || shmemThp ? "thp" : "off";
+            }
+        } else if (hugepages.equals("hugetlb") && readLong(HUGETLB_FREE) * 2 < ramMB) {
+            Log.w(TAG, "Not enough hugetlb pages reserved for " + ramMB + "MB, using thp");
+            hugepages = "thp";
+        }
+
+        if (type.equals("auto")) {
+            // QEMU always madvises anonymous guest RAM for THP, so small
+            // pages are only guaranteed through memfd
+            boolean needsMemfd = hugepages.equals("hugetlb") ||
+                (hugepages.equals("thp") && shmemThp && !anonThp) ||
+                smallPagesRequested;
+            type = needsMemfd ? "memfd" : "ram";
+        }
+        if (type.equals("ram") && hugepages.equals("hugetlb")) {
+            type = "memfd";
+        }
+
+        if (merge.equals("auto")) {
+            merge = readLong(KSM_RUN) == 1 ? "on" : "off";
+        }
+    }
+
+    public boolean usesBackend() {
+        return !type.equals("legacy");
+    }
+
+    /**
+     * Build the -m and -object arguments; the machine refers to the backend
+     * with memory-backend=BACKEND_ID (see BootConfig.machineArgs)
+     */
+    public List<String> toArgs(int ramMB) {
+        List<String> args = new ArrayList<>();
+        args.add("-m");
+        args.add(String.valueOf(ramMB));
+        if (!usesBackend()) {
+            return args;
+        }
+
+        StringBuilder object = new StringBuilder(type.equals("memfd") ?
+            "memory-backend-memfd" : "memory-backend-ram");
+        object.append(",id=").append(BACKEND_ID)
+              .append(",size=").append(ramMB).append("M")
+              .append(",merge=").append(merge.equals("on") ? "on" : "off")
+              .append(",dump=").append(dump ? "on" : "off");
+        if (type.equals("memfd") && hugepages.equals("hugetlb")) {
+            object.append(",hugetlb=on,hugetlbsize=2M");
+        }
+        if (prealloc) {
+            int threads = preallocThreads > 0 ? preallocThreads :
+                Math.max(1, Math.min(Runtime.getRuntime().availableProcessors(), MAX_PREALLOC_THREADS));
+            object.append(",prealloc=on,prealloc-threads=").append(threads);
+        }
+
+        args.add("-object");
+        args.add(object.toString());
+        return args;
+    }
+
+    /**
+     * THP is usable when the kernel mode is [always], [madvise] (QEMU
+     * madvises guest RAM) or, for shmem, [within_size]/[advise]
+     */
+    private static boolean thpAvailable(String path) {
+        String modes = readSysfs(path);
+        if (modes == null) {
+            return false;
+        }
+        return modes.contains("[always]") || modes.contains("[madvise]") ||
+               modes.contains("[within_size]") || modes.contains("[advise]");
+    }
+
+    private static long readLong(String path) {
+        String value = readSysfs(path);
+        if (value == null) {
+            return 0;
+        }
+        try {
+            return Long.parseLong(value.trim());
+        } catch (NumberFormatException e) {
+            return 0;
+        }
+    }
+
+    /**
+     * First line of a sysfs file, null when it is missing or not readable
+     * (SELinux hides parts of /sys from apps)
+     */
+    private static String readSysfs(String path) {
+        try (BufferedReader reader = new BufferedReader(new FileReader(path))) {
+            return reader.readLine();
+        } catch (IOException e) {
+            return null;
+        }
+    }
+
+    @Override
+    public String toString() {
+        return "type=" + type + " hugepages=" + hugepages + " merge=" + merge +
+               " prealloc=" + prealloc + " dump=" + dump;
+    }
+}
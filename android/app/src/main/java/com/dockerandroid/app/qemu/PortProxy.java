@@ -0,0 +1,158 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import java.io.IOException;
+import java.io.InputStream;
+import java.io.OutputStream;
+import java.net.InetSocketAddress;
+import java.net.ServerSocket;
+import java.net.Socket;
+
+/**
+ * PortProxy - TCP proxy from a forwarded port to QEMU's internal hostfwd
+ * Before a byte is passed on, the Gate makes sure the VM can take it:
+ * VmActivator boots a VM that is down, and IdleGovernor resumes one that
+ * is suspended. This also covers kept-alive connections that sat idle
+ * while the VM was stopped.
+ *
+ * For protocols where the client talks first (the Docker API) the gate
+ * is only opened once the client sends data, so port probes that connect
+ * and close do not wake the VM. Server-first protocols (SSH) open on accept.
+ */
+public class PortProxy {
+    private static final String TAG = "PortProxy";
+
+    private static final int CONNECT_TIMEOUT_MS = 5 * 1000;
+    private static final int BUFFER_SIZE = 64 * 1024;
+
+    /**
+     * Decides when traffic may reach the VM
+     */
+    public interface Gate {
+        /** Block until the VM can take traffic; throws when it cannot */
+        void open() throws IOException;
+
+        /** Record traffic from the VM */
+        void touch();
+    }
+
+    private final int listenPort;
+    private final int targetPort;
+    private final boolean clientSpeaksFirst;
+    private final Gate gate;
+
+    private ServerSocket serverSocket;
+    private Thread acceptThread;
+
+    public PortProxy(int listenPort, int targetPort, boolean clientSpeaksFirst, Gate gate) {
+        this.listenPort = listenPort;
+        this.targetPort = targetPort;
+        this.clientSpeaksFirst = clientSpeaksFirst;
+        this.gate = gate;
+    }
+
+    /**
+     * Bind the forwarded port (all interfaces, like QEMU's hostfwd did)
+     */
+    public void start() throws IOException {
+        serverSocket = new ServerSocket();
+        serverSocket.setReuseAddress(true);
+        serverSocket.bind(new InetSocketAddress(listenPort));
+        acceptThread = new Thread(this::acceptLoop, "proxy-" + listenPort);
+        acceptThread.start();
+        Log.d(TAG, "Proxying :" + listenPort + " -> 127.0.0.1:" + targetPort);
+    }
+
+    public void stop() {
+        try {
+            if (serverSocket != null) {
+                serverSocket.close();
+            }
+        } catch (IOException e) {
+            // Already closed
+        }
+        if (acceptThread != null) {
+            acceptThread.interrupt();
+            acceptThread = null;
+        }
+    }
+
+    private void acceptLoop() {
+        while (!serverSocket.isClosed()) {
+            try {
+                Socket client = serverSocket.accept();
+                new Thread(() -> handle(client), "proxy-" + listenPort + "-conn").start();
+            } catch (IOException e) {
+                if (!serverSocket.isClosed()) {
+                    Log.w(TAG, "Accept on :" + listenPort + " failed: " + e.getMessage());
+                }
+            }
+        }
+    }
+
+    private void handle(Socket client) {
+        try (Socket c = client) {
+            InputStream clientIn = c.getInputStream();
+            byte[] first = new byte[BUFFER_SIZE];
+            int firstLength = 0;
+            if (clientSpeaksFirst) {
+                firstLength = clientIn.read(first);
+                if (firstLength < 0) {
+                    return;     // connect-and-close probe
+                }
+            }
+
+            gate.open();
+
+            try (Socket vm = new Socket()) {
+                vm.connect(new InetSocketAddress("127.0.0.1", targetPort), CONNECT_TIMEOUT_MS);
+                OutputStream vmOut = vm.getOutputStream();
+                if (firstLength > 0) {
+                    vmOut.write(first, 0, firstLength);
+                    vmOut.flush();
+                }
+
+                Thread downstream = new Thread(() -> pump(vm, c, false), "proxy-" + listenPort + "-down");
+                downstream.start();
+                pump(c, vm, true);
+                downstream.join();
+            }
+        } catch (IOException e) {
+            Log.d(TAG, "Connection on :" + listenPort + " ended: " + e.getMessage());
+        } catch (InterruptedException e) {
+            Thread.currentThread().interrupt();
+        }
+    }
+
+    /**
+     * Copy one direction until EOF, then half-close the other side so the
+     * peer sees the end of the stream
+     */
+    private void pump(Socket from, Socket to, boolean toVm) {
+        byte[] buffer = new byte[BUFFER_SIZE];
+        try {
+            InputStream in = from.getInputStream();
+            OutputStream out = to.getOutputStream();
+            int n;
+            while ((n = in.read(buffer)) >= 0) {
+                if (toVm) {
+                    gate.open();
+                } else {
+                    gate.touch();
+                }
+                out.write(buffer, 0, n);
+                out.flush();
+            }
+            to.shutdownOutput();
+        } catch (IOException e) {
+            // Either side closed; closing the sockets ends the other direction
+            try {
+                to.close();
+                from.close();
+            } catch (IOException ignored) {
+                // Nothing left to do
+            }
+        }
+    }
+}
@@ -0,0 +1,117 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import com.dockerandroid.app.utils.FileUtils;
+
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.File;
+import java.util.Arrays;
+import java.util.List;
+
+/**
+ * PowerConfig - Battery and thermal policy for the VM's speed
+ * Read from the "power" section of qemu-config.json:
+ *
+ *   "power": { "policy": "balanced", "checkSec": 15, "hotTempC": 45,
+ *              "criticalTempC": 52, "lowBatteryPct": 30 }
+ *
+ * Policies (see PowerGovernor for the tiers they pick):
+ *   performance - full speed unless the phone is critically hot
+ *   balanced    - full speed while charging or in use, slower on battery
+ *                 with the screen off, when low or when hot
+ *   saver       - always on the little cores, one core on battery
+ */
+public class PowerConfig {
+    private static final String TAG = "PowerConfig";
+
+    public static final String POLICY_PERFORMANCE = "performance";
+    public static final String POLICY_BALANCED = "balanced";
+    public static final String POLICY_SAVER = "saver";
+    public static final List<String> POLICIES =
+        Arrays.asList(POLICY_PERFORMANCE, POLICY_BALANCED, POLICY_SAVER);
+
+    public String policy = POLICY_BALANCED;
+    public int checkSec = 15;
+    public int hotTempC = 45;
+    public int criticalTempC = 52;
+    public int lowBatteryPct = 30;
+
+    /**
+     * Load power settings; missing or invalid values keep their defaults
+     */
+    public static PowerConfig load(File configFile) {
+        PowerConfig config = new PowerConfig();
+        String json = configFile.exists() ? FileUtils.readFile(configFile) : null;
+        if (json == null) {
+            return config;
+        }
+
+        try {
+            JSONObject power = new JSONObject(json).optJSONObject("power");
+            if (power != null) {
+                config.policy = power.optString("policy", config.policy);
+                config.checkSec = power.optInt("checkSec", config.checkSec);
+                config.hotTempC = power.optInt("hotTempC", config.hotTempC);
+                config.criticalTempC = power.optInt("criticalTempC", config.criticalTempC);
+                config.lowBatteryPct = power.optInt("lowBatteryPct", config.lowBatteryPct);
+            }
+        } catch (JSONException e) {
+            Log.e(TAG, "Invalid " + configFile.getName() + ": " + e.getMessage());
+        }
+        if (!POLICIES.contains(config.policy)) {
+            Log.w(TAG, "Unknown power policy " + config.policy + ", using balanced");
+            config.policy = POLICY_BALANCED;
+        }
+        if (config.checkSec < 5) {
+            config.checkSec = 5;
+        }
+        if (config.criticalTempC <= config.hotTempC) {
+            config.criticalTempC = config.hotTempC + 7;
+        }
+        return config;
+    }
+
+    /**
+     * Copy of these settings with another policy
+     */
+    public PowerConfig withPolicy(String newPolicy) {
+        PowerConfig copy = new PowerConfig();
+        copy.policy = newPolicy;
+        copy.checkSec = checkSec;
+        copy.hotTempC = hotTempC;
+        copy.criticalTempC = criticalTempC;
+        copy.lowBatteryPct = lowBatteryPct;
+        return copy;
+    }
+
+    /**
+     * Store a new policy in qemu-config.json, keeping the other sections
+     */
+    public static boolean savePolicy(File configFile, String policy) {
+        if (!POLICIES.contains(policy)) {
+            return false;
+        }
+        try {
+            String json = configFile.exists() ? FileUtils.readFile(configFile) : null;
+            JSONObject config = json != null ? new JSONObject(json) : new JSONObject();
+            JSONObject power = config.optJSONObject("power");
+            if (power == null) {
+                power = new JSONObject();
+                config.put("power", power);
+            }
+            power.put("policy", policy);
+            return FileUtils.writeFile(configFile, config.toString(2));
+        } catch (JSONException e) {
+            Log.e(TAG, "Invalid " + configFile.getName() + ": " + e.getMessage());
+            return false;
+        }
+    }
+
+    @Override
+    public String toString() {
+        return "policy=" + policy + " hotTempC=" + hotTempC + " criticalTempC=" + criticalTempC;
+    }
+}
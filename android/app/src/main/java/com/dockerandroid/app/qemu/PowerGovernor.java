@@ -0,0 +1,293 @@
+package com.dockerandroid.app.qemu;
+
+import android.content.Context;
+import android.content.Intent;
+import android.content.IntentFilter;
+import android.os.BatteryManager;
+import android.os.Build;
+import android.os.PowerManager;
+import android.util.Log;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.FileReader;
+import java.io.IOException;
+import java.util.Arrays;
+
+/**
+ * PowerGovernor - Sets the VM's speed from battery, temperature and screen
+ *
+ * Every checkSec the governor reads the battery (charging, level), the
+ * hottest /sys/class/thermal zone plus Android's thermal status, and
+ * whether the screen is on, and picks a tier for the vCPU threads:
+ *
+ *   full     performance cores (or all cores)
+ *   reduced  efficiency cores (or half the cores on uniform SoCs)
+ *   minimal  a single efficiency core, all vCPUs take turns on it
+ *
+ * Apps cannot write cgroup cpu.max or raise a thread's priority back once
+ * lowered, so the tiers only move vCPU affinity; suspending an idle VM is
+ * IdleGovernor's job. Temperatures have a 3 degree hysteresis so the tier
+ * does not flap around a threshold. Every change is logged and kept in
+ * the status read by QemuModule.getStatus.
+ */
+public class PowerGovernor implements Runnable {
+    private static final String TAG = "PowerGovernor";
+
+    public static final String TIER_FULL = "full";
+    public static final String TIER_REDUCED = "reduced";
+    public static final String TIER_MINIMAL = "minimal";
+
+    private static final int THERMAL_NORMAL = 0;
+    private static final int THERMAL_HOT = 1;
+    private static final int THERMAL_CRITICAL = 2;
+    private static final String[] THERMAL_NAMES = {"normal", "hot", "critical"};
+    private static final int HYSTERESIS_C = 3;
+    private static final String THERMAL_DIR = "/sys/class/thermal";
+
+    /**
+     * Last decision (the service and the React module share the app process)
+     */
+    public static class Status {
+        public String policy;
+        public String tier;
+        public String reason;
+        public int cores;
+        public double tempC;
+        public String thermal;
+        public boolean charging;
+        public int batteryPct;
+        public boolean screenOn;
+        public long changedAt;
+        public long changes;
+    }
+
+    private static volatile Status lastStatus;
+
+    private final Context context;
+    private final QmpClient qmp;
+    private final boolean pinVcpus;
+    private volatile PowerConfig config;
+
+    private int thermalLevel = THERMAL_NORMAL;
+    private String appliedTier;
+    private long changedAt = 0;
+    private long changes = 0;
+
+    public PowerGovernor(Context context, PowerConfig config, QmpClient qmp, boolean pinVcpus) {
+        this.context = context;
+        this.config = config;
+        this.qmp = qmp;
+        this.pinVcpus = pinVcpus;
+        lastStatus = null;
+    }
+
+    public static Status getLastStatus() {
+        return lastStatus;
+    }
+
+    public static void clearStatus() {
+        lastStatus = null;
+    }
+
+    /**
+     * Switch policy at runtime; applied on the next check
+     */
+    public void setPolicy(String policy) {
+        if (PowerConfig.POLICIES.contains(policy)) {
+            config = config.withPolicy(policy);
+        }
+    }
+
+    /**
+     * The initial vCPU placement replaced the affinity; the next check
+     * applies the current tier again
+     */
+    public synchronized void vcpusPlaced() {
+        appliedTier = null;
+    }
+
+    @Override
+    public synchronized void run() {
+        PowerConfig cfg = config;
+
+        Intent battery = context.registerReceiver(null, new IntentFilter(Intent.ACTION_BATTERY_CHANGED));
+        boolean charging = battery != null && battery.getIntExtra(BatteryManager.EXTRA_PLUGGED, 0) != 0;
+        int batteryPct = 100;
+        if (battery != null) {
+            int level = battery.getIntExtra(BatteryManager.EXTRA_LEVEL, -1);
+            int scale = battery.getIntExtra(BatteryManager.EXTRA_SCALE, 100);
+            if (level >= 0 && scale > 0) {
+                batteryPct = level * 100 / scale;
+            }
+        }
+        PowerManager pm = (PowerManager) context.getSystemService(Context.POWER_SERVICE);
+        boolean screenOn = pm == null || pm.isInteractive();
+        double tempC = readMaxTemperature();
+        thermalLevel = thermalLevel(cfg, tempC, androidThermalLevel(pm));
+
+        String tier;
+        String reason;
+        switch (cfg.policy) {
+            case PowerConfig.POLICY_PERFORMANCE:
+                tier = thermalLevel == THERMAL_CRITICAL ? TIER_REDUCED : TIER_FULL;
+                reason = thermalLevel == THERMAL_CRITICAL ? "critical temperature" : "performance policy";
+                break;
+            case PowerConfig.POLICY_SAVER:
+                tier = charging && thermalLevel != THERMAL_CRITICAL ? TIER_REDUCED : TIER_MINIMAL;
+                reason = thermalLevel == THERMAL_CRITICAL ? "critical temperature" :
+                    charging ? "saver policy, charging" : "saver policy, on battery";
+                break;
+            default:
+                if (thermalLevel == THERMAL_CRITICAL) {
+                    tier = TIER_MINIMAL;
+                    reason = "critical temperature";
+                } else if (thermalLevel == THERMAL_HOT) {
+                    tier = TIER_REDUCED;
+                    reason = "hot";
+                } else if (charging) {
+                    tier = TIER_FULL;
+                    reason = "charging";
+                } else if (batteryPct < cfg.lowBatteryPct) {
+                    tier = TIER_REDUCED;
+                    reason = "battery at " + batteryPct + "%";
+                } else if (!screenOn) {
+                    tier = TIER_REDUCED;
+                    reason = "on battery, screen off";
+                } else {
+                    tier = TIER_FULL;
+                    reason = "on battery, screen on";
+                }
+                break;
+        }
+
+        int cores = lastStatus != null ? lastStatus.cores : 0;
+        if (!tier.equals(appliedTier)) {
+            try {
+                int[] hostCpus = coresFor(tier, VcpuPlacement.countVcpus(qmp));
+                VcpuPlacement.setVcpuAffinity(qmp, hostCpus);
+                Log.i(TAG, "VM speed " + (appliedTier != null ? appliedTier : "-") + " -> " + tier +
+                    " (" + cfg.policy + ": " + reason + ", " + formatTemp(tempC) + ", battery " +
+                    batteryPct + "%" + (charging ? " charging" : "") + ", screen " +
+                    (screenOn ? "on" : "off") + ") on cores " + Arrays.toString(hostCpus));
+                appliedTier = tier;
+                cores = hostCpus.length;
+                changedAt = System.currentTimeMillis();
+                changes++;
+            } catch (IOException e) {
+                // QMP not up yet; retried on the next check
+                Log.d(TAG, "Power check skipped: " + e.getMessage());
+                return;
+            }
+        }
+
+        Status status = new Status();
+        status.policy = cfg.policy;
+        status.tier = tier;
+        status.reason = reason;
+        status.cores = cores;
+        status.tempC = tempC;
+        status.thermal = THERMAL_NAMES[thermalLevel];
+        status.charging = charging;
+        status.batteryPct = batteryPct;
+        status.screenOn = screenOn;
+        status.changedAt = changedAt;
+        status.changes = changes;
+        lastStatus = status;
+        VmStatus.publish();
+    }
+
+    /**
+     * Host CPUs for a tier
+     */
+    private int[] coresFor(String tier, int vcpus) {
+        int[] big = VcpuPlacement.getPerformanceCores();
+        int[] little = VcpuPlacement.getEfficiencyCores();
+        int[] all;
+        if (big.length > 0 && little.length > 0) {
+            all = new int[big.length + little.length];
+            System.arraycopy(little, 0, all, 0, little.length);
+            System.arraycopy(big, 0, all, little.length, big.length);
+        } else {
+            all = new int[Runtime.getRuntime().availableProcessors()];
+            for (int i = 0; i < all.length; i++) {
+                all[i] = i;
+            }
+        }
+
+        switch (tier) {
+            case TIER_FULL:
+                return pinVcpus && big.length >= vcpus && big.length > 0 ? big : all;
+            case TIER_REDUCED:
+                return little.length > 0 ? little : Arrays.copyOf(all, Math.max(1, all.length / 2));
+            default:
+                return new int[] { little.length > 0 ? little[0] : all[0] };
+        }
+    }
+
+    /**
+     * Thermal level with hysteresis: a level is left only once the
+     * temperature is HYSTERESIS_C below its threshold
+     */
+    private int thermalLevel(PowerConfig cfg, double tempC, int androidLevel) {
+        if (tempC >= cfg.criticalTempC || androidLevel == THERMAL_CRITICAL ||
+                (thermalLevel == THERMAL_CRITICAL && tempC >= cfg.criticalTempC - HYSTERESIS_C)) {
+            return THERMAL_CRITICAL;
+        }
+        if (tempC >= cfg.hotTempC || androidLevel == THERMAL_HOT ||
+                (thermalLevel >= THERMAL_HOT && tempC >= cfg.hotTempC - HYSTERESIS_C)) {
+            return THERMAL_HOT;
+        }
+        return THERMAL_NORMAL;
+    }
+
+    /**
+     * Android's own view (API 29+): moderate throttling counts as hot,
+     * severe and worse as critical
+     */
+    private static int androidThermalLevel(PowerManager pm) {
+        if (pm == null || Build.VERSION.SDK_INT < Build.VERSION_CODES.Q) {
+            return THERMAL_NORMAL;
+        }
+        int status = pm.getCurrentThermalStatus();
+        if (status >= PowerManager.THERMAL_STATUS_SEVERE) {
+            return THERMAL_CRITICAL;
+        }
+        if (status >= PowerManager.THERMAL_STATUS_MODERATE) {
+            return THERMAL_HOT;
+        }
+        return THERMAL_NORMAL;
+    }
+
+    /**
+     * Hottest thermal zone in degrees C, -1 when none is readable
+     * (SELinux hides the zones from apps on many devices)
+     */
+    private static double readMaxTemperature() {
+        File[] zones = new File(THERMAL_DIR).listFiles((dir, name) -> name.startsWith("thermal_zone"));
+        double max = -1;
+        if (zones == null) {
+            return max;
+        }
+        for (File zone : zones) {
+            try (BufferedReader reader = new BufferedReader(new FileReader(new File(zone, "temp")))) {
+                double temp = Double.parseDouble(reader.readLine().trim());
+                // Most zones report millidegrees, a few whole degrees
+                if (Math.abs(temp) >= 1000) {
+                    temp /= 1000;
+                }
+                // Disabled zones and broken sensors report 0 or nonsense
+                if (temp > 0 && temp < 150) {
+                    max = Math.max(max, temp);
+                }
+            } catch (IOException | NumberFormatException | NullPointerException e) {
+                // Zone not readable
+            }
+        }
+        return max;
+    }
+
+    private static String formatTemp(double tempC) {
+        return tempC < 0 ? "temperature unknown" : String.format("%.1fC", tempC);
+    }
+}
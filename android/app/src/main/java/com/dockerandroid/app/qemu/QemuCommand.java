@@ -0,0 +1,355 @@
+package com.dockerandroid.app.qemu;
+
+import android.app.ActivityManager;
+import android.content.Context;
+import android.text.TextUtils;
+import android.util.Log;
+
+import com.dockerandroid.app.utils.FileUtils;
+
+import org.json.JSONArray;
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.File;
+import java.nio.charset.StandardCharsets;
+import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
+import java.util.ArrayList;
+import java.util.Arrays;
+import java.util.Collections;
+import java.util.List;
+import java.util.regex.Matcher;
+import java.util.regex.Pattern;
+
+/**
+ * QemuCommand - Compiles qemu-config.json into the QEMU command line
+ *
+ * This is the only place the argv is built; QemuService hands it to the
+ * native launcher through QemuProcess. The file is read and parsed once
+ * per start. Each section is validated and given its defaults by its own
+ * class (BootConfig, TcgConfig, MemoryConfig, BlockConfig, BalloonConfig,
+ * IdleConfig). The top-level keys are read here:
+ *
+ *   "cpu": "max", "memory": 2048, "smp": 2, "display": "none",
+ *   "network": { "hostfwd": ["tcp::8080-:8080", "tcp::8443-:443"] }
+ *
+ * memory and smp apply when a start does not ask for a size. The Docker
+ * and SSH forwards are always present and follow IdleConfig, so a rule
+ * for their host ports is ignored.
+ *
+ * The compiled argv is kept in qemu/qemu-argv.json under a SHA-256 of
+ * everything it depends on: the config file, the requested size, the
+ * resolved "auto" choices and the files it points at. A start with the
+ * same hash takes the stored argv as is.
+ */
+public class QemuCommand {
+    private static final String TAG = "QemuCommand";
+
+    public static final String CONFIG_FILE = "qemu-config.json";
+    public static final String CACHE_FILE = "qemu-argv.json";
+
+    // Part of the cache key; bump when the same inputs compile to
+    // different arguments
+    private static final int FORMAT = 3;
+
+    private static final int DEFAULT_RAM_MB = 2048;
+    private static final int DEFAULT_CPU_CORES = 2;
+    private static final List<String> DEFAULT_HOSTFWD =
+        Arrays.asList("tcp::8080-:8080", "tcp::8443-:443");
+    private static final Pattern HOSTFWD_PATTERN =
+        Pattern.compile("(tcp|udp):([0-9.]*):(\\d{1,5})-([0-9.]*):(\\d{1,5})");
+
+    public final List<String> argv;
+    public final String hash;
+    // Taken from qemu-argv.json instead of assembled
+    public final boolean cached;
+    public final int ramMB;
+    public final int cpuCores;
+
+    // Sections the service also needs at runtime
+    public final BootConfig boot;
+    public final TcgConfig tcg;
+    public final BalloonConfig balloon;
+    public final IdleConfig idle;
+
+    private QemuCommand(List<String> argv, String hash, boolean cached, int ramMB, int cpuCores,
+                        BootConfig boot, TcgConfig tcg, BalloonConfig balloon, IdleConfig idle) {
+        this.argv = Collections.unmodifiableList(argv);
+        this.hash = hash;
+        this.cached = cached;
+        this.ramMB = ramMB;
+        this.cpuCores = cpuCores;
+        this.boot = boot;
+        this.tcg = tcg;
+        this.balloon = balloon;
+        this.idle = idle;
+    }
+
+    /**
+     * Compile the command line for a start
+     * @param ramMB Guest RAM, 0 for the config's "memory"
+     * @param cpuCores vCPUs, 0 for the config's "smp"
+     */
+    public static QemuCommand compile(Context context, int ramMB, int cpuCores) {
+        File qemuDir = new File(context.getFilesDir(), "qemu");
+        File configFile = new File(qemuDir, CONFIG_FILE);
+        String json = configFile.exists() ? FileUtils.readFile(configFile) : null;
+        JSONObject root = parse(json, configFile.getName());
+
+        if (ramMB <= 0) {
+            ramMB = root.optInt("memory", DEFAULT_RAM_MB);
+        }
+        if (cpuCores <= 0) {
+            cpuCores = root.optInt("smp", DEFAULT_CPU_CORES);
+        }
+        if (ramMB < 256) {
+            Log.w(TAG, "Guest RAM " + ramMB + "MB too small, using " + DEFAULT_RAM_MB);
+            ramMB = DEFAULT_RAM_MB;
+        }
+        if (cpuCores < 1) {
+            cpuCores = 1;
+        }
+        String cpu = root.optString("cpu", "max");
+        String display = root.optString("display", "none");
+        List<String> hostfwd = hostfwdRules(root);
+
+        // Settle every "auto" against this device before hashing
+        DiskManager diskManager = new DiskManager(qemuDir);
+        BootConfig boot = BootConfig.fromJson(root);
+        boot.resolve(diskManager);
+        MemoryConfig memory = MemoryConfig.fromJson(root);
+        memory.resolve(ramMB);
+        TcgConfig tcg = TcgConfig.fromJson(root);
+        ActivityManager activityManager = (ActivityManager) context.getSystemService(Context.ACTIVITY_SERVICE);
+        if (activityManager != null) {
+            ActivityManager.MemoryInfo memoryInfo = new ActivityManager.MemoryInfo();
+            activityManager.getMemoryInfo(memoryInfo);
+            tcg.resolveTbSize(memoryInfo, ramMB);
+        }
+        BlockConfig block = BlockConfig.fromJson(root);
+        BalloonConfig balloon = BalloonConfig.fromJson(root);
+        IdleConfig idle = IdleConfig.fromJson(root);
+        Log.d(TAG, "Boot: " + boot + "; Memory: " + memory + "; TCG: " + tcg + "; Block I/O: " + block +
+            "; Balloon: " + balloon + "; Idle: " + idle);
+
+        File qemuBinary = new File(context.getApplicationInfo().nativeLibraryDir, "libqemu-system-x86_64.so");
+        // Fallback for development - won't work without actual binary
+        String binary = qemuBinary.exists() ? qemuBinary.getAbsolutePath() : "/system/bin/qemu-system-x86_64";
+        File overlay = diskManager.getOverlay(DiskManager.DEFAULT_OVERLAY);
+        File iso = new File(qemuDir, "alpine-virt.iso");
+        boolean installer = !diskManager.isProvisioned() && !boot.isKernelBoot();
+
+        StringBuilder key = new StringBuilder()
+            .append(FORMAT).append('\n')
+            .append(json != null ? json : "").append('\n')
+            .append(binary).append(' ').append(ramMB).append(' ').append(cpuCores).append('\n')
+            .append(boot).append('|').append(memory).append('|').append(tcg).append('|')
+            .append(block).append('|').append(balloon).append('|').append(idle).append('\n')
+            .append(overlay.getAbsolutePath()).append(' ').append(installer);
+        if (boot.isKernelBoot()) {
+            // A new image brings a new kernel and command line
+            key.append(' ').append(diskManager.getKernel().lastModified())
+               .append(' ').append(diskManager.getInitrd().lastModified())
+               .append(' ').append(diskManager.getKernelCmdline());
+        }
+        String hash = sha256(key.toString());
+
+        File cacheFile = new File(qemuDir, CACHE_FILE);
+        List<String> argv = readCache(cacheFile, hash);
+        if (argv != null) {
+            Log.d(TAG, "Using compiled command " + hash.substring(0, 12));
+            return new QemuCommand(argv, hash, true, ramMB, cpuCores, boot, tcg, balloon, idle);
+        }
+
+        argv = new ArrayList<>();
+        argv.add(binary);
+
+        // Machine configuration: firmware boot on q35, or direct kernel boot
+        // on a q35/microvm without legacy devices
+        argv.addAll(boot.machineArgs(memory.usesBackend() ? MemoryConfig.BACKEND_ID : null));
+        argv.addAll(boot.kernelArgs(diskManager));
+
+        // TCG: one host thread per vCPU (MTTCG), translation cache sized to the device
+        argv.addAll(tcg.toArgs());
+
+        // CPU
+        argv.add("-cpu");
+        argv.add(cpu);
+        argv.add("-smp");
+        argv.add(String.valueOf(cpuCores));
+
+        // Memory: guest RAM backend with THP/KSM settings
+        argv.addAll(memory.toArgs(ramMB));
+
+        // No display (headless)
+        argv.add("-display");
+        argv.add(display);
+
+        // Serial console for logs
+        argv.add("-serial");
+        argv.add("stdio");
+
+        // Boot drive: copy-on-write overlay over the read-only base image
+        argv.addAll(block.toArgs(overlay, cpuCores, boot));
+
+        // CD-ROM (Alpine installer), only for disks that are not provisioned
+        if (installer) {
+            argv.add("-cdrom");
+            argv.add(iso.getAbsolutePath());
+        }
+
+        // Balloon with free page reporting, sized by BalloonPolicy
+        argv.addAll(balloon.toArgs(boot));
+
+        // Network with port forwarding; Docker API and SSH go through the
+        // idle proxy when auto-suspend or socket activation is on
+        StringBuilder netdev = new StringBuilder("user,id=net0")
+            .append(',').append(idle.hostfwd(IdleConfig.DOCKER_PORT, 2375))
+            .append(',').append(idle.hostfwd(IdleConfig.SSH_PORT, 22));
+        for (String rule : hostfwd) {
+            netdev.append(",hostfwd=").append(rule);
+        }
+        argv.add("-netdev");
+        argv.add(netdev.toString());
+        argv.add("-device");
+        argv.add(boot.virtioDevice("virtio-net") + ",netdev=net0");
+
+        // Guest agent channel (fstrim, guest info)
+        argv.add("-chardev");
+        argv.add("socket,id=qga0,path=" + new File(qemuDir, GuestAgent.SOCKET_NAME).getAbsolutePath() +
+                 ",server,nowait");
+        argv.add("-device");
+        argv.add(boot.virtioDevice("virtio-serial"));
+        argv.add("-device");
+        argv.add("virtserialport,chardev=qga0,name=" + GuestAgent.CHANNEL_NAME);
+
+        // QMP monitor for control
+        argv.add("-qmp");
+        argv.add("unix:" + new File(qemuDir, QmpClient.SOCKET_NAME).getAbsolutePath() + ",server,nowait");
+        // and a second one the health monitor keeps open (see VmHealth)
+        argv.add("-qmp");
+        argv.add("unix:" + new File(qemuDir, VmHealth.QMP_SOCKET_NAME).getAbsolutePath() + ",server,nowait");
+
+        // HMP monitor on the FIFO pair monitor.in / monitor.out, drained
+        // by the launcher next to the serial console (see QemuProcess)
+        argv.add("-chardev");
+        argv.add("pipe,id=mon0,path=" + new File(qemuDir, QemuProcess.MONITOR_FIFO).getAbsolutePath());
+        argv.add("-mon");
+        argv.add("chardev=mon0,mode=readline");
+
+        // No -daemonize: QEMU stays our child so its output and its exit
+        // status reach the launcher and the crash supervisor
+
+        writeCache(cacheFile, hash, argv);
+        Log.d(TAG, "Compiled command " + hash.substring(0, 12) + " (" + argv.size() + " args)");
+        return new QemuCommand(argv, hash, false, ramMB, cpuCores, boot, tcg, balloon, idle);
+    }
+
+    /**
+     * Parse qemu-config.json; empty when missing or invalid, so every
+     * section falls back to its defaults
+     */
+    static JSONObject readConfig(File configFile) {
+        String json = configFile.exists() ? FileUtils.readFile(configFile) : null;
+        return parse(json, configFile.getName());
+    }
+
+    private static JSONObject parse(String json, String name) {
+        if (json == null) {
+            return new JSONObject();
+        }
+        try {
+            return new JSONObject(json);
+        } catch (JSONException e) {
+            Log.e(TAG, "Invalid " + name + ": " + e.getMessage());
+            return new JSONObject();
+        }
+    }
+
+    /**
+     * Extra port forwards from "network": valid rules whose host port is
+     * not one of the managed Docker and SSH ports
+     */
+    private static List<String> hostfwdRules(JSONObject root) {
+        JSONObject network = root.optJSONObject("network");
+        JSONArray rules = network != null ? network.optJSONArray("hostfwd") : null;
+        if (rules == null) {
+            return DEFAULT_HOSTFWD;
+        }
+        List<String> result = new ArrayList<>();
+        for (int i = 0; i < rules.length(); i++) {
+            String rule = rules.optString(i);
+            Matcher m = HOSTFWD_PATTERN.matcher(rule);
+            if (!m.matches()) {
+                Log.w(TAG, "Ignoring invalid hostfwd rule " + rule);
+                continue;
+            }
+            int hostPort = Integer.parseInt(m.group(3));
+            if (hostPort == IdleConfig.DOCKER_PORT || hostPort == IdleConfig.SSH_PORT) {
+                continue;
+            }
+            if (hostPort == 0 || hostPort > 65535 || Integer.parseInt(m.group(5)) > 65535) {
+                Log.w(TAG, "Ignoring hostfwd rule with a bad port " + rule);
+                continue;
+            }
+            result.add(rule);
+        }
+        return result;
+    }
+
+    private static List<String> readCache(File cacheFile, String hash) {
+        String json = cacheFile.exists() ? FileUtils.readFile(cacheFile) : null;
+        if (json == null) {
+            return null;
+        }
+        try {
+            JSONObject cache = new JSONObject(json);
+            if (!hash.equals(cache.optString("hash"))) {
+                return null;
+            }
+            JSONArray array = cache.getJSONArray("argv");
+            List<String> argv = new ArrayList<>(array.length());
+            for (int i = 0; i < array.length(); i++) {
+                argv.add(array.getString(i));
+            }
+            return argv.isEmpty() ? null : argv;
+        } catch (JSONException e) {
+            Log.w(TAG, "Discarding unreadable " + cacheFile.getName());
+            return null;
+        }
+    }
+
+    private static void writeCache(File cacheFile, String hash, List<String> argv) {
+        try {
+            JSONObject cache = new JSONObject()
+                .put("hash", hash)
+                .put("compiledAt", System.currentTimeMillis())
+                .put("argv", new JSONArray(argv));
+            if (!FileUtils.writeFile(cacheFile, cache.toString(2))) {
+                Log.w(TAG, "Failed to write " + cacheFile.getName());
+            }
+        } catch (JSONException e) {
+            Log.w(TAG, "Failed to store compiled command: " + e.getMessage());
+        }
+    }
+
+    private static String sha256(String text) {
+        try {
+            byte[] digest = MessageDigest.getInstance("SHA-256").digest(text.getBytes(StandardCharsets.UTF_8));
+            StringBuilder hex = new StringBuilder();
+            for (byte b : digest) {
+                hex.append(String.format("%02x", b));
+            }
+            return hex.toString();
+        } catch (NoSuchAlgorithmException e) {
+            // Every Android runtime ships SHA-256
+            throw new IllegalStateException(e);
+        }
+    }
+
+    @Override
+    public String toString() {
+        return TextUtils.join(" ", argv);
+    }
+}
@@ -36,25 +36,12 @@ public class QemuManager {
     }
     
     /**
-     * Check if QEMU is running
+     * Check if QEMU is running: whether the launcher's process is alive.
+     * Answered from memory (see VmHealth); QMP and dockerd are probed by
+     * the health monitor, not here.
      */
     public boolean isRunning() {
-        // Check if QMP socket exists
-        File qmpSock = new File(context.getFilesDir(), "qemu/qmp.sock");
-        if (!qmpSock.exists()) {
-            return false;
-        }
-        
-        // Try to connect to verify
-        try {
-            // Check if Docker API is responding
-            Socket testSocket = new Socket("localhost", 2375);
-            testSocket.close();
-            return true;
-        } catch (Exception e) {
-            // Docker not responding, but QEMU might still be booting
-            return qmpSock.exists();
-        }
+        return VmHealth.isProcessAlive();
     }
     
     /**
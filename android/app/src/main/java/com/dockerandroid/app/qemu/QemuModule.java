@@ -12,13 +12,17 @@ import com.facebook.react.bridge.Promise;
 import com.facebook.react.bridge.ReactApplicationContext;
 import com.facebook.react.bridge.ReactContextBaseJavaModule;
 import com.facebook.react.bridge.ReactMethod;
+import com.facebook.react.bridge.WritableArray;
 import com.facebook.react.bridge.WritableMap;
 import com.facebook.react.modules.core.DeviceEventManagerModule;
 
+import com.dockerandroid.app.utils.FileUtils;
+
+import org.json.JSONObject;
+
 import java.io.File;
 import java.io.FileOutputStream;
 import java.io.IOException;
-import java.io.InputStream;
 
 /**
  * QemuModule - Native module for QEMU VM control
@@ -28,18 +32,17 @@ public class QemuModule extends ReactContextBaseJavaModule {
     private static final String TAG = "QemuModule";
     private static final String MODULE_NAME = "QemuModule";
     
+    // Chunks (1 MiB) of each VM file re-verified per launch
+    private static final long VERIFY_CHUNKS_PER_LAUNCH = 256;
+    
     private final ReactApplicationContext reactContext;
     private QemuManager qemuManager;
+    private DiskManager diskManager;
     private boolean isInitialized = false;
     
-    // Native JNI methods (implemented in qemu_jni.c)
-    private static native long nativeInit(String dataDir, String[] args);
-    private static native int nativeStart(long handle);
-    private static native int nativeStop(long handle);
-    private static native int nativeGetStatus(long handle);
-    private static native String nativeGetLogs(long handle, int lines);
-    private static native void nativeCleanup(long handle);
-    private static native int nativeSendCommand(long handle, String command);
+    // JSI bindings (implemented in qemu_jsi.cpp)
+    private static native boolean nativeInstallJsi(long runtime, String logDir, String dataDir);
+    private static boolean jsiLoaded = false;
     
     // Load native library
     static {
@@ -49,6 +52,12 @@ public class QemuModule extends ReactContextBaseJavaModule {
         } catch (UnsatisfiedLinkError e) {
             Log.e(TAG, "Failed to load native library qemu-jni: " + e.getMessage());
         }
+        try {
+            System.loadLibrary("qemu-jsi");
+            jsiLoaded = true;
+        } catch (UnsatisfiedLinkError e) {
+            Log.w(TAG, "JSI bindings not available: " + e.getMessage());
+        }
     }
     
     public QemuModule(ReactApplicationContext context) {
@@ -77,8 +86,8 @@ public class QemuModule extends ReactContextBaseJavaModule {
     /**
      * Initialize QEMU environment
      * - Creates QEMU directory structure
-     * - Copies Alpine ISO from assets
-     * - Creates virtual disk image
+     * - Sets up the base disk image and the default overlay
+     * - Copies Alpine ISO from assets unless the disk is provisioned
      */
     @ReactMethod
     public void initialize(Promise promise) {
@@ -97,18 +106,30 @@ public class QemuModule extends ReactContextBaseJavaModule {
                 }
             }
             
-            // Copy Alpine ISO from assets if not exists
+            // Read-only base image plus the default copy-on-write overlay
+            diskManager = new DiskManager(qemuDir);
+            diskManager.ensureLayout(dest -> extractBaseImage(context, dest));
+            File diskFile = diskManager.getOverlay(DiskManager.DEFAULT_OVERLAY);
+            boolean provisioned = diskManager.isProvisioned();
+            
+            // The installer ISO is only needed when the disk is not provisioned
             File isoFile = new File(qemuDir, "alpine-virt.iso");
-            if (!isoFile.exists()) {
-                Log.d(TAG, "Copying Alpine ISO from assets...");
+            if (provisioned) {
+                if (isoFile.exists()) {
+                    Log.d(TAG, "Disk is provisioned, removing installer ISO");
+                    isoFile.delete();
+                    new File(isoFile.getPath() + ".stamp").delete();
+                    FileUtils.getTreeHashIndex(isoFile).delete();
+                }
+            } else {
+                // Extract Alpine ISO from assets (skipped when already up to date)
+                Log.d(TAG, "Extracting Alpine ISO from assets...");
                 copyAssetToFile(context, "alpine-virt.iso", isoFile);
             }
             
-            // Create virtual disk image if not exists
-            File diskFile = new File(qemuDir, "alpine-disk.qcow2");
-            if (!diskFile.exists()) {
-                Log.d(TAG, "Creating virtual disk image...");
-                createQcow2Disk(diskFile.getAbsolutePath(), 10 * 1024); // 10GB
+            // Kernel and initramfs for direct kernel boot, when the image has them
+            if (provisioned) {
+                extractKernel(context);
             }
             
             // Copy QEMU configuration
@@ -122,7 +143,9 @@ public class QemuModule extends ReactContextBaseJavaModule {
             WritableMap result = Arguments.createMap();
             result.putBoolean("success", true);
             result.putString("qemuDir", qemuDir.getAbsolutePath());
-            result.putString("isoPath", isoFile.getAbsolutePath());
+            result.putString("isoPath", provisioned ? null : isoFile.getAbsolutePath());
+            result.putBoolean("provisioned", provisioned);
+            result.putBoolean("kernelBoot", diskManager.canBootKernel());
             result.putString("diskPath", diskFile.getAbsolutePath());
             result.putString("configPath", configFile.getAbsolutePath());
             
@@ -133,6 +156,8 @@ public class QemuModule extends ReactContextBaseJavaModule {
             
             promise.resolve(result);
             
+            verifyVmFilesAsync(context, isoFile);
+            
         } catch (Exception e) {
             Log.e(TAG, "Initialization failed: " + e.getMessage(), e);
             promise.reject("INIT_ERROR", "Failed to initialize QEMU: " + e.getMessage());
@@ -204,6 +229,81 @@ public class QemuModule extends ReactContextBaseJavaModule {
         }
     }
     
+    /**
+     * Listen on the Docker API port with the VM down; the first connection
+     * boots it and waits for Docker (socket activation, see VmActivator)
+     * @param ramMB RAM allocation in MB for the on-demand boot
+     * @param cpuCores Number of CPU cores for the on-demand boot
+     */
+    @ReactMethod
+    public void listenVM(int ramMB, int cpuCores, Promise promise) {
+        try {
+            if (!isInitialized) {
+                promise.reject("NOT_INITIALIZED", "QEMU not initialized. Call initialize() first.");
+                return;
+            }
+            
+            Context context = getReactApplicationContext();
+            Intent serviceIntent = new Intent(context, QemuService.class);
+            serviceIntent.setAction(QemuService.ACTION_LISTEN);
+            serviceIntent.putExtra(QemuService.EXTRA_RAM_MB, ramMB);
+            serviceIntent.putExtra(QemuService.EXTRA_CPU_CORES, cpuCores);
+            
+            if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.O) {
+                context.startForegroundService(serviceIntent);
+            } else {
+                context.startService(serviceIntent);
+            }
+            
+            WritableMap result = Arguments.createMap();
+            result.putBoolean("success", true);
+            result.putDouble("port", IdleConfig.DOCKER_PORT);
+            promise.resolve(result);
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to listen: " + e.getMessage(), e);
+            promise.reject("LISTEN_ERROR", "Failed to listen: " + e.getMessage());
+        }
+    }
+    
+    /**
+     * Choose how the VM trades speed for battery and heat
+     * (performance, balanced or saver); saved in qemu-config.json and
+     * applied to a running VM right away
+     */
+    @ReactMethod
+    public void setPowerPolicy(String policy, Promise promise) {
+        try {
+            if (!PowerConfig.POLICIES.contains(policy)) {
+                promise.reject("INVALID_POLICY", "Unknown power policy: " + policy);
+                return;
+            }
+            
+            Context context = getReactApplicationContext();
+            File configFile = new File(new File(context.getFilesDir(), "qemu"), "qemu-config.json");
+            if (!PowerConfig.savePolicy(configFile, policy)) {
+                promise.reject("CONFIG_ERROR", "Failed to save power policy");
+                return;
+            }
+            
+            if (qemuManager.isRunning()) {
+                Intent serviceIntent = new Intent(context, QemuService.class);
+                serviceIntent.setAction(QemuService.ACTION_SET_POWER_POLICY);
+                serviceIntent.putExtra(QemuService.EXTRA_POWER_POLICY, policy);
+                context.startService(serviceIntent);
+            }
+            
+            WritableMap result = Arguments.createMap();
+            result.putBoolean("success", true);
+            result.putString("policy", policy);
+            promise.resolve(result);
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to set power policy: " + e.getMessage(), e);
+            promise.reject("POWER_ERROR", "Failed to set power policy: " + e.getMessage());
+        }
+    }
+    
     /**
      * Stop the running VM
      */
@@ -249,17 +349,27 @@ public class QemuModule extends ReactContextBaseJavaModule {
             WritableMap status = Arguments.createMap();
             
             boolean isRunning = qemuManager.isRunning();
-            status.putString("status", isRunning ? "running" : "stopped");
+            CrashSupervisor.Status supervisor = CrashSupervisor.getLastStatus();
+            boolean restarting = !isRunning && supervisor != null &&
+                CrashSupervisor.STATE_RESTARTING.equals(supervisor.state);
+            status.putString("status", isRunning ? "running" : restarting ? "restarting" : "stopped");
             
             if (isRunning) {
                 status.putDouble("uptime", qemuManager.getUptime());
                 status.putDouble("cpuUsage", qemuManager.getCpuUsage());
                 status.putDouble("memoryUsage", qemuManager.getMemoryUsage());
+                status.putBoolean("suspended", IdleGovernor.isVmSuspended());
+                putJitStats(status);
+                putBalloonStats(status);
+                putPowerStats(status);
+                putHealthStats(status);
             } else {
                 status.putDouble("uptime", 0);
                 status.putDouble("cpuUsage", 0);
                 status.putDouble("memoryUsage", 0);
             }
+            putActivationStats(status);
+            putSupervisorStats(status, supervisor);
             
             promise.resolve(status);
             
@@ -269,6 +379,29 @@ public class QemuModule extends ReactContextBaseJavaModule {
         }
     }
     
+    /**
+     * Install global.__QemuNative, the synchronous status and log getters,
+     * LogViewer's indexed log buffers and the settings store (see
+     * qemu_jsi.cpp). Blocking so it runs on the JS thread, which owns
+     * the runtime.
+     * @return true when the bindings are installed
+     */
+    @ReactMethod(isBlockingSynchronousMethod = true)
+    public boolean installJsi() {
+        if (!jsiLoaded) {
+            return false;
+        }
+        long runtime = getReactApplicationContext().getJavaScriptContextHolder().get();
+        if (runtime == 0) {
+            return false;
+        }
+        VmStatus.publish();
+        File logDir = new File(reactContext.getCacheDir(), "logs");
+        logDir.mkdirs();
+        return nativeInstallJsi(runtime, logDir.getAbsolutePath(),
+                reactContext.getFilesDir().getAbsolutePath());
+    }
+    
     /**
      * Send command to VM console
      */
@@ -316,39 +449,568 @@ public class QemuModule extends ReactContextBaseJavaModule {
     }
     
     /**
-     * Copy asset file to internal storage
+     * List disk overlays
      */
-    private void copyAssetToFile(Context context, String assetName, File destFile) throws IOException {
-        try (InputStream in = context.getAssets().open(assetName);
-             FileOutputStream out = new FileOutputStream(destFile)) {
+    @ReactMethod
+    public void listOverlays(Promise promise) {
+        try {
+            if (!checkDiskManager(promise)) {
+                return;
+            }
+            
+            WritableArray overlays = Arguments.createArray();
+            for (String name : diskManager.listOverlays()) {
+                File file = diskManager.getOverlay(name);
+                WritableMap overlay = Arguments.createMap();
+                overlay.putString("name", name);
+                overlay.putString("path", file.getAbsolutePath());
+                overlay.putDouble("size", file.length());
+                overlay.putDouble("modified", file.lastModified());
+                overlays.pushMap(overlay);
+            }
+            
+            promise.resolve(overlays);
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to list overlays: " + e.getMessage(), e);
+            promise.reject("DISK_ERROR", "Failed to list overlays: " + e.getMessage());
+        }
+    }
+    
+    /**
+     * Create an empty overlay on top of the base image
+     */
+    @ReactMethod
+    public void createOverlay(String name, Promise promise) {
+        try {
+            if (!checkDiskManager(promise)) {
+                return;
+            }
+            
+            File overlay = diskManager.createOverlay(name);
+            
+            WritableMap result = Arguments.createMap();
+            result.putBoolean("success", true);
+            result.putString("path", overlay.getAbsolutePath());
+            promise.resolve(result);
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to create overlay: " + e.getMessage(), e);
+            promise.reject("DISK_ERROR", "Failed to create overlay: " + e.getMessage());
+        }
+    }
+    
+    /**
+     * Discard all changes in an overlay, returning it to the base image
+     */
+    @ReactMethod
+    public void resetOverlay(String name, Promise promise) {
+        try {
+            if (!checkDiskManager(promise) || !checkVmStopped(promise)) {
+                return;
+            }
+            
+            diskManager.resetOverlay(name);
+            
+            WritableMap result = Arguments.createMap();
+            result.putBoolean("success", true);
+            promise.resolve(result);
             
-            byte[] buffer = new byte[8192];
-            int read;
-            while ((read = in.read(buffer)) != -1) {
-                out.write(buffer, 0, read);
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to reset overlay: " + e.getMessage(), e);
+            promise.reject("DISK_ERROR", "Failed to reset overlay: " + e.getMessage());
+        }
+    }
+    
+    /**
+     * Clone an overlay into a new one sharing the same base image
+     */
+    @ReactMethod
+    public void cloneOverlay(String source, String name, Promise promise) {
+        try {
+            if (!checkDiskManager(promise) || !checkVmStopped(promise)) {
+                return;
             }
-            out.flush();
+            
+            File overlay = diskManager.cloneOverlay(source, name);
+            
+            WritableMap result = Arguments.createMap();
+            result.putBoolean("success", true);
+            result.putString("path", overlay.getAbsolutePath());
+            promise.resolve(result);
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to clone overlay: " + e.getMessage(), e);
+            promise.reject("DISK_ERROR", "Failed to clone overlay: " + e.getMessage());
         }
     }
     
     /**
-     * Create QCOW2 disk image
-     * In production, this would call QEMU tools or native code
+     * Delete an overlay
      */
-    private void createQcow2Disk(String path, int sizeMB) throws IOException {
-        // Create a placeholder file
-        // In production, use qemu-img or native code to create proper QCOW2
-        File file = new File(path);
-        try (FileOutputStream fos = new FileOutputStream(file)) {
-            // Write QCOW2 header (simplified)
-            byte[] header = new byte[512];
-            header[0] = 'Q';
-            header[1] = 'F';
-            header[2] = 'I';
-            header[3] = (byte) 0xfb;
-            fos.write(header);
+    @ReactMethod
+    public void deleteOverlay(String name, Promise promise) {
+        try {
+            if (!checkDiskManager(promise) || !checkVmStopped(promise)) {
+                return;
+            }
+            if (DiskManager.DEFAULT_OVERLAY.equals(name)) {
+                promise.reject("DISK_ERROR", "The default overlay cannot be deleted");
+                return;
+            }
+            
+            diskManager.deleteOverlay(name);
+            
+            WritableMap result = Arguments.createMap();
+            result.putBoolean("success", true);
+            promise.resolve(result);
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to delete overlay: " + e.getMessage(), e);
+            promise.reject("DISK_ERROR", "Failed to delete overlay: " + e.getMessage());
         }
-        Log.d(TAG, "Created disk image: " + path);
+    }
+    
+    /**
+     * Merge an overlay into the base image (runs in background)
+     */
+    @ReactMethod
+    public void commitOverlay(String name, Promise promise) {
+        if (!checkDiskManager(promise) || !checkVmStopped(promise)) {
+            return;
+        }
+        
+        new Thread(() -> {
+            try {
+                long[] stats = diskManager.commitOverlay(name, setupProgressListener(name + ".qcow2"));
+                
+                WritableMap result = Arguments.createMap();
+                result.putBoolean("success", true);
+                result.putDouble("overlayBytes", stats[0]);
+                result.putDouble("baseBytes", stats[1]);
+                promise.resolve(result);
+                
+            } catch (Exception e) {
+                Log.e(TAG, "Failed to commit overlay: " + e.getMessage(), e);
+                promise.reject("DISK_ERROR", "Failed to commit overlay: " + e.getMessage());
+            }
+        }).start();
+    }
+    
+    /**
+     * Run fstrim in the guest so freed blocks are discarded from the overlay
+     */
+    @ReactMethod
+    public void trimDisk(Promise promise) {
+        if (!qemuManager.isRunning()) {
+            promise.reject("VM_NOT_RUNNING", "The VM must be running to trim its disk");
+            return;
+        }
+        
+        new Thread(() -> {
+            try {
+                File qemuDir = new File(getReactApplicationContext().getFilesDir(), "qemu");
+                long trimmed = new GuestAgent(qemuDir).fstrim();
+                
+                WritableMap result = Arguments.createMap();
+                result.putBoolean("success", true);
+                result.putDouble("trimmedBytes", trimmed);
+                promise.resolve(result);
+                
+            } catch (Exception e) {
+                Log.e(TAG, "Failed to trim disk: " + e.getMessage(), e);
+                promise.reject("TRIM_ERROR", "Failed to trim disk: " + e.getMessage());
+            }
+        }).start();
+    }
+    
+    /**
+     * Rewrite an overlay without its free clusters (runs in background)
+     * Resolves with the number of bytes returned to the phone's storage.
+     */
+    @ReactMethod
+    public void compactOverlay(String name, Promise promise) {
+        if (!checkDiskManager(promise) || !checkVmStopped(promise)) {
+            return;
+        }
+        
+        new Thread(() -> {
+            android.os.Process.setThreadPriority(android.os.Process.THREAD_PRIORITY_BACKGROUND);
+            try {
+                long[] stats = diskManager.compactOverlay(name, setupProgressListener(name + ".qcow2"));
+                
+                WritableMap result = Arguments.createMap();
+                result.putBoolean("success", true);
+                result.putDouble("bytesBefore", stats[0]);
+                result.putDouble("bytesAfter", stats[1]);
+                result.putDouble("reclaimedBytes", Math.max(0, stats[0] - stats[1]));
+                
+                WritableMap event = Arguments.createMap();
+                event.putString("overlay", name);
+                event.putDouble("reclaimedBytes", Math.max(0, stats[0] - stats[1]));
+                sendEvent("vmDiskCompacted", event);
+                
+                promise.resolve(result);
+                
+            } catch (Exception e) {
+                Log.e(TAG, "Failed to compact overlay: " + e.getMessage(), e);
+                promise.reject("DISK_ERROR", "Failed to compact overlay: " + e.getMessage());
+            }
+        }, "disk-compactor").start();
+    }
+    
+    /**
+     * Fully verify the ISO and base image against their tree hashes
+     */
+    @ReactMethod
+    public void verifyDisk(Promise promise) {
+        if (!checkDiskManager(promise)) {
+            return;
+        }
+        
+        new Thread(() -> {
+            try {
+                File qemuDir = new File(getReactApplicationContext().getFilesDir(), "qemu");
+                File isoFile = new File(qemuDir, "alpine-virt.iso");
+                File baseImage = diskManager.getBaseImage();
+                
+                WritableMap result = Arguments.createMap();
+                result.putBoolean("isoOk", !isoFile.exists() || FileUtils.verifyFile(isoFile, 0,
+                    setupProgressListener(isoFile.getName())) == FileUtils.VERIFY_OK);
+                result.putBoolean("baseOk", FileUtils.verifyFile(baseImage, 0,
+                    setupProgressListener(baseImage.getName())) == FileUtils.VERIFY_OK);
+                promise.resolve(result);
+                
+            } catch (Exception e) {
+                Log.e(TAG, "Failed to verify disk: " + e.getMessage(), e);
+                promise.reject("VERIFY_ERROR", "Failed to verify disk: " + e.getMessage());
+            }
+        }).start();
+    }
+    
+    /**
+     * Compare MD5 and tree hash throughput on the base image
+     */
+    @ReactMethod
+    public void benchmarkHash(Promise promise) {
+        if (!checkDiskManager(promise)) {
+            return;
+        }
+        
+        new Thread(() -> {
+            try {
+                File file = diskManager.getBaseImage();
+                double[] mbps = FileUtils.benchmarkHash(file);
+                
+                WritableMap result = Arguments.createMap();
+                result.putString("file", file.getName());
+                result.putDouble("sizeBytes", file.length());
+                result.putDouble("md5MBps", mbps[0]);
+                result.putDouble("treeHashMBps", mbps[1]);
+                promise.resolve(result);
+                
+            } catch (Exception e) {
+                Log.e(TAG, "Hash benchmark failed: " + e.getMessage(), e);
+                promise.reject("BENCHMARK_ERROR", "Hash benchmark failed: " + e.getMessage());
+            }
+        }).start();
+    }
+    
+    /**
+     * Post-mortems of the last QEMU crashes, newest first (see CrashSupervisor)
+     */
+    @ReactMethod
+    public void getCrashRecords(int limit, Promise promise) {
+        try {
+            File qemuDir = new File(getReactApplicationContext().getFilesDir(), "qemu");
+            WritableArray records = Arguments.createArray();
+            for (JSONObject record : CrashSupervisor.listRecords(qemuDir, limit)) {
+                WritableMap map = Arguments.createMap();
+                map.putString("file", record.optString("file"));
+                map.putDouble("time", record.optLong("time"));
+                map.putDouble("uptimeMs", record.optLong("uptimeMs"));
+                map.putInt("exitCode", record.optInt("exitCode", -1));
+                map.putInt("signal", record.optInt("signal", -1));
+                map.putString("reason", record.optString("reason"));
+                map.putString("action", record.optString("action"));
+                map.putString("bootMode", record.optString("bootMode"));
+                map.putString("serialTail", record.optString("serialTail"));
+                map.putString("stderrTail", record.optString("stderrTail"));
+                records.pushMap(map);
+            }
+            promise.resolve(records);
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to read crash records: " + e.getMessage(), e);
+            promise.reject("CRASH_RECORDS_ERROR", "Failed to read crash records: " + e.getMessage());
+        }
+    }
+    
+    /**
+     * Phase breakdown of the last VM boot (see BootTimer)
+     */
+    @ReactMethod
+    public void getBootTimings(Promise promise) {
+        try {
+            File timingsFile = new File(getReactApplicationContext().getFilesDir(),
+                "qemu/" + BootTimer.TIMINGS_FILE);
+            String json = timingsFile.exists() ? FileUtils.readFile(timingsFile) : null;
+            if (json == null) {
+                promise.resolve(null);
+                return;
+            }
+            
+            JSONObject timings = new JSONObject(json);
+            WritableMap result = Arguments.createMap();
+            result.putString("mode", timings.optString("mode"));
+            result.putDouble("startedAt", timings.optLong("startedAt"));
+            for (String phase : new String[] {"qemuMs", "firmwareMs", "kernelMs", "userspaceMs",
+                    "guestMs", "dockerMs", "totalMs"}) {
+                result.putDouble(phase, timings.optLong(phase, -1));
+            }
+            promise.resolve(result);
+            
+        } catch (Exception e) {
+            Log.e(TAG, "Failed to read boot timings: " + e.getMessage(), e);
+            promise.reject("BOOT_TIMINGS_ERROR", "Failed to read boot timings: " + e.getMessage());
+        }
+    }
+    
+    /**
+     * Last VM speed decision (see PowerGovernor)
+     */
+    private void putPowerStats(WritableMap status) {
+        PowerGovernor.Status last = PowerGovernor.getLastStatus();
+        if (last == null) {
+            return;
+        }
+        WritableMap power = Arguments.createMap();
+        power.putString("policy", last.policy);
+        power.putString("tier", last.tier);
+        power.putString("reason", last.reason);
+        power.putInt("cores", last.cores);
+        power.putDouble("tempC", last.tempC);
+        power.putString("thermal", last.thermal);
+        power.putBoolean("charging", last.charging);
+        power.putInt("batteryPct", last.batteryPct);
+        power.putBoolean("screenOn", last.screenOn);
+        power.putDouble("changedAt", last.changedAt);
+        power.putDouble("changes", last.changes);
+        status.putMap("power", power);
+    }
+    
+    /**
+     * Cached QMP and dockerd probes (see VmHealth); null for a probe
+     * that has no answer yet
+     */
+    private void putHealthStats(WritableMap status) {
+        VmHealth.Status last = VmHealth.read();
+        if (last == null) {
+            return;
+        }
+        WritableMap health = Arguments.createMap();
+        health.putBoolean("processAlive", last.pid > 0);
+        health.putString("runState", last.runState);
+        putProbe(health, "qmpResponsive", last.qmp);
+        health.putDouble("qmpLatencyMs", last.qmpLatencyMs);
+        health.putDouble("qmpCheckedAt", last.qmpCheckedAt);
+        health.putInt("qmpFailures", last.qmpFailures);
+        putProbe(health, "dockerResponsive", last.docker);
+        health.putDouble("dockerLatencyMs", last.dockerLatencyMs);
+        health.putDouble("dockerCheckedAt", last.dockerCheckedAt);
+        health.putInt("dockerFailures", last.dockerFailures);
+        status.putMap("health", health);
+    }
+    
+    private static void putProbe(WritableMap map, String key, int probe) {
+        if (probe == VmHealth.UNKNOWN) {
+            map.putNull(key);
+        } else {
+            map.putBoolean(key, probe == VmHealth.UP);
+        }
+    }
+    
+    /**
+     * Crash supervisor state and the last crash (see CrashSupervisor)
+     */
+    private void putSupervisorStats(WritableMap status, CrashSupervisor.Status last) {
+        if (last == null) {
+            return;
+        }
+        WritableMap supervisor = Arguments.createMap();
+        supervisor.putString("state", last.state);
+        supervisor.putDouble("restarts", last.restarts);
+        supervisor.putInt("recentCrashes", last.recentCrashes);
+        supervisor.putDouble("nextRestartAt", last.nextRestartAt);
+        if (last.lastCrash != null) {
+            WritableMap crash = Arguments.createMap();
+            crash.putDouble("time", last.lastCrash.time);
+            crash.putDouble("uptimeMs", last.lastCrash.uptimeMs);
+            crash.putInt("exitCode", last.lastCrash.exitCode);
+            crash.putInt("signal", last.lastCrash.signal);
+            crash.putString("reason", last.lastCrash.reason);
+            crash.putString("file", last.lastCrash.recordFile);
+            supervisor.putMap("lastCrash", crash);
+        }
+        status.putMap("supervisor", supervisor);
+    }
+    
+    /**
+     * Socket activation queue (see VmActivator)
+     */
+    private void putActivationStats(WritableMap status) {
+        VmActivator.Status last = VmActivator.getLastStatus();
+        if (last == null) {
+            return;
+        }
+        WritableMap activation = Arguments.createMap();
+        activation.putBoolean("listening", last.listening);
+        activation.putInt("waiting", last.waiting);
+        activation.putDouble("activations", last.activations);
+        activation.putDouble("lastWaitMs", last.lastWaitMs);
+        activation.putDouble("maxWaitMs", last.maxWaitMs);
+        status.putMap("activation", activation);
+    }
+    
+    /**
+     * Balloon size and the policy's last decision (see BalloonPolicy)
+     */
+    private void putBalloonStats(WritableMap status) {
+        BalloonPolicy.Status last = BalloonPolicy.getLastStatus();
+        if (last == null) {
+            return;
+        }
+        WritableMap balloon = Arguments.createMap();
+        balloon.putDouble("ramMB", last.ramMB);
+        balloon.putDouble("actualMB", last.actualMB);
+        balloon.putDouble("sizeMB", Math.max(0, last.ramMB - last.actualMB));
+        balloon.putDouble("targetMB", last.targetMB);
+        balloon.putDouble("floorMB", last.floorMB);
+        balloon.putDouble("workingSetMB", last.workingSetMB);
+        balloon.putString("pressure", last.pressure);
+        balloon.putDouble("updatedAt", last.updatedAt);
+        status.putMap("balloon", balloon);
+    }
+    
+    /**
+     * Add the TCG translation cache counters as status.jit, from the last
+     * sample QemuService's maintenance executor took (see JitStats). Never
+     * queries QMP here: getStatus runs on the bridge's module thread.
+     */
+    private void putJitStats(WritableMap status) {
+        JitStats stats = JitStats.getLastStatus();
+        if (stats == null) {
+            return;
+        }
+        
+        WritableMap jit = Arguments.createMap();
+        jit.putDouble("codeUsedBytes", stats.codeUsedBytes);
+        jit.putDouble("codeSizeBytes", stats.codeSizeBytes);
+        jit.putDouble("tbCount", stats.tbCount);
+        jit.putDouble("tbFlushes", stats.tbFlushes);
+        jit.putDouble("tbFlushesPerMin", stats.tbFlushesPerMin);
+        jit.putDouble("tbInvalidations", stats.tbInvalidations);
+        jit.putDouble("tlbFullFlushes", stats.tlbFullFlushes);
+        jit.putDouble("sampledAt", stats.sampledAt);
+        status.putMap("jit", jit);
+    }
+    
+    private boolean checkDiskManager(Promise promise) {
+        if (diskManager == null) {
+            promise.reject("NOT_INITIALIZED", "QEMU not initialized. Call initialize() first.");
+            return false;
+        }
+        return true;
+    }
+    
+    private boolean checkVmStopped(Promise promise) {
+        if (qemuManager.isRunning()) {
+            promise.reject("VM_RUNNING", "Stop the VM before changing its disk");
+            return false;
+        }
+        return true;
+    }
+    
+    /**
+     * Extract the packaged disk image and its manifest as the base image
+     */
+    private boolean extractBaseImage(Context context, File dest) {
+        if (!FileUtils.copyAsset(context, "alpine-disk.qcow2", dest,
+                setupProgressListener("alpine-disk.qcow2"))) {
+            return false;
+        }
+        File manifest = diskManager.getBaseManifest();
+        if (!FileUtils.copyAsset(context, "alpine-disk.json", manifest)) {
+            Log.d(TAG, "No disk manifest packaged, the ISO is needed for setup");
+            manifest.delete();
+        }
+        return true;
+    }
+    
+    /**
+     * Extract the kernel and initramfs packaged with a provisioned image;
+     * without them the VM boots through firmware
+     */
+    private void extractKernel(Context context) {
+        File kernel = diskManager.getKernel();
+        File initrd = diskManager.getInitrd();
+        if (!FileUtils.copyAsset(context, DiskManager.KERNEL_IMAGE, kernel) ||
+                !FileUtils.copyAsset(context, DiskManager.INITRD_IMAGE, initrd)) {
+            Log.d(TAG, "No kernel packaged, the VM boots through firmware");
+            kernel.delete();
+            initrd.delete();
+        }
+    }
+    
+    /**
+     * Copy asset file to internal storage
+     */
+    private void copyAssetToFile(Context context, String assetName, File destFile) throws IOException {
+        if (!FileUtils.copyAsset(context, assetName, destFile, setupProgressListener(assetName))) {
+            throw new IOException("Failed to copy asset " + assetName);
+        }
+    }
+    
+    /**
+     * Check a slice of the ISO and base image against their tree hashes on
+     * every launch; a corrupt ISO is extracted again
+     */
+    private void verifyVmFilesAsync(Context context, File isoFile) {
+        File baseImage = diskManager.getBaseImage();
+        new Thread(() -> {
+            android.os.Process.setThreadPriority(android.os.Process.THREAD_PRIORITY_BACKGROUND);
+            try {
+                if (isoFile.exists() &&
+                        FileUtils.verifyFile(isoFile, VERIFY_CHUNKS_PER_LAUNCH, null) == FileUtils.VERIFY_MISMATCH) {
+                    Log.e(TAG, "Alpine ISO is corrupt, extracting it again");
+                    isoFile.delete();
+                    copyAssetToFile(context, "alpine-virt.iso", isoFile);
+                }
+                
+                if (FileUtils.verifyFile(baseImage, VERIFY_CHUNKS_PER_LAUNCH, null) == FileUtils.VERIFY_MISMATCH) {
+                    Log.e(TAG, "Base disk image is corrupt");
+                    WritableMap errorEvent = Arguments.createMap();
+                    errorEvent.putString("status", "error");
+                    errorEvent.putString("message", "The base disk image is corrupt. Reinstall the app to restore it.");
+                    sendEvent("vmError", errorEvent);
+                }
+            } catch (IOException e) {
+                Log.e(TAG, "Integrity check failed: " + e.getMessage(), e);
+            }
+        }, "integrity-check").start();
+    }
+    
+    /**
+     * Report asset extraction progress to React Native as vmSetupProgress
+     */
+    private FileUtils.ProgressListener setupProgressListener(String assetName) {
+        return (done, total) -> {
+            WritableMap event = Arguments.createMap();
+            event.putString("asset", assetName);
+            event.putDouble("done", done);
+            event.putDouble("total", total);
+            sendEvent("vmSetupProgress", event);
+        };
     }
     
     /**
@@ -356,30 +1018,75 @@ public class QemuModule extends ReactContextBaseJavaModule {
      */
     private void createDefaultConfig(File configFile) throws IOException {
         String config = "{\n" +
-            "  \"machine\": \"q35\",\n" +
             "  \"cpu\": \"max\",\n" +
             "  \"memory\": 2048,\n" +
             "  \"smp\": 2,\n" +
             "  \"display\": \"none\",\n" +
             "  \"network\": {\n" +
-            "    \"type\": \"user\",\n" +
             "    \"hostfwd\": [\n" +
             "      \"tcp::2375-:2375\",\n" +
             "      \"tcp::2222-:22\",\n" +
-            "      \"tcp::8080-:8080\"\n" +
+            "      \"tcp::8080-:8080\",\n" +
+            "      \"tcp::8443-:443\"\n" +
             "    ]\n" +
             "  },\n" +
-            "  \"drives\": [\n" +
-            "    {\n" +
-            "      \"file\": \"alpine-disk.qcow2\",\n" +
-            "      \"if\": \"virtio\",\n" +
-            "      \"format\": \"qcow2\"\n" +
-            "    },\n" +
-            "    {\n" +
-            "      \"file\": \"alpine-virt.iso\",\n" +
-            "      \"media\": \"cdrom\"\n" +
-            "    }\n" +
-            "  ]\n" +
+            "  \"tcg\": {\n" +
+            "    \"mttcg\": true,\n" +
+            "    \"pinVcpus\": true,\n" +
+            "    \"tbSizeMB\": 0\n" +
+            "  },\n" +
+            "  \"memoryBackend\": {\n" +
+            "    \"type\": \"auto\",\n" +
+            "    \"hugepages\": \"auto\",\n" +
+            "    \"merge\": \"auto\",\n" +
+            "    \"prealloc\": false,\n" +
+            "    \"preallocThreads\": 0,\n" +
+            "    \"dump\": false\n" +
+            "  },\n" +
+            "  \"balloon\": {\n" +
+            "    \"enabled\": true,\n" +
+            "    \"freePageReporting\": true,\n" +
+            "    \"deflateOnOom\": true,\n" +
+            "    \"floorMB\": 512,\n" +
+            "    \"headroomMB\": 256,\n" +
+            "    \"minChangeMB\": 64,\n" +
+            "    \"pollSec\": 10,\n" +
+            "    \"relaxSec\": 120\n" +
+            "  },\n" +
+            "  \"idle\": {\n" +
+            "    \"autoSuspend\": true,\n" +
+            "    \"idleSec\": 300,\n" +
+            "    \"checkSec\": 30,\n" +
+            "    \"keepAwakeWithContainers\": true,\n" +
+            "    \"socketActivation\": true,\n" +
+            "    \"activationTimeoutSec\": 300\n" +
+            "  },\n" +
+            "  \"supervisor\": {\n" +
+            "    \"restart\": \"on-failure\",\n" +
+            "    \"backoffMs\": 1000,\n" +
+            "    \"maxBackoffMs\": 60000,\n" +
+            "    \"stableSec\": 300,\n" +
+            "    \"maxRestarts\": 5,\n" +
+            "    \"windowSec\": 600,\n" +
+            "    \"crashLogKB\": 16,\n" +
+            "    \"keepRecords\": 10\n" +
+            "  },\n" +
+            "  \"power\": {\n" +
+            "    \"policy\": \"balanced\",\n" +
+            "    \"checkSec\": 15,\n" +
+            "    \"hotTempC\": 45,\n" +
+            "    \"criticalTempC\": 52,\n" +
+            "    \"lowBatteryPct\": 30\n" +
+            "  },\n" +
+            "  \"boot\": {\n" +
+            "    \"mode\": \"auto\"\n" +
+            "  },\n" +
+            "  \"block\": {\n" +
+            "    \"iothread\": true,\n" +
+            "    \"aio\": \"threads\",\n" +
+            "    \"cache\": \"writeback\",\n" +
+            "    \"queues\": 0\n" +
+            "  }\n" +
             "}";
         
         try (FileOutputStream fos = new FileOutputStream(configFile)) {
@@ -0,0 +1,272 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import java.io.File;
+import java.io.IOException;
+import java.nio.charset.StandardCharsets;
+import java.util.List;
+
+/**
+ * QemuProcess - QEMU running in the foreground under the native launcher
+ *
+ * Replaces ProcessBuilder for QEMU. The launcher (qemu_launcher.c) reaps
+ * the process itself and drains three streams with one epoll thread into
+ * ring buffers that keep their last ringBytes:
+ *
+ *   - serial:  QEMU's stdout, the guest console (-serial stdio)
+ *   - monitor: the HMP monitor on the FIFO pair qemu/monitor.in and
+ *              qemu/monitor.out (-chardev pipe)
+ *   - stderr:  QEMU's own warnings and errors
+ *
+ * Nothing here blocks on a pipe, so a chatty guest cannot stall QEMU and
+ * the tails survive the process for the crash record.
+ */
+public class QemuProcess {
+    private static final String TAG = "QemuProcess";
+
+    public static final int STREAM_SERIAL = 0;
+    public static final int STREAM_MONITOR = 1;
+    public static final int STREAM_STDERR = 2;
+
+    public static final String MONITOR_FIFO = "monitor";
+
+    private static final int SIGTERM = 15;
+    private static final int SIGKILL = 9;
+    private static final int ETIMEDOUT = 110;
+    private static final long WAIT_SLICE_MS = 1000;
+
+    // Native launcher (implemented in qemu_launcher.c via qemu_jni.c)
+    private static native long nativeStart(String[] argv, String dir, String monitorPath, int ringBytes,
+                                           int[] error);
+    private static native int nativePid(long handle);
+    private static native boolean nativeIsAlive(long handle);
+    private static native int nativeWaitFor(long handle, long timeoutMs);
+    private static native int nativeSignal(long handle, int sig);
+    private static native byte[] nativeTail(long handle, int stream, int maxBytes);
+    private static native long nativeWritten(long handle, int stream);
+    private static native int nativeMonitorCommand(long handle, String command);
+    private static native void nativeRelease(long handle);
+    private static native void nativeAttachStatus(long handle, int cpuCores, int ramMB);
+
+    static {
+        try {
+            System.loadLibrary("qemu-jni");
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Failed to load native library qemu-jni: " + e.getMessage());
+        }
+    }
+
+    // Guarded by this: the handle is freed once released and no call is
+    // still using it
+    private long handle;
+    private int users = 0;
+    private boolean released = false;
+    private final int pid;
+    private volatile int exitValue = -1;
+
+    private QemuProcess(long handle) {
+        this.handle = handle;
+        this.pid = nativePid(handle);
+    }
+
+    /**
+     * Start QEMU in dir with the monitor FIFOs dir/monitor.{in,out}
+     */
+    public static QemuProcess start(List<String> argv, File dir, int ringBytes) throws IOException {
+        int[] error = new int[1];
+        long handle;
+        try {
+            handle = nativeStart(argv.toArray(new String[0]), dir.getAbsolutePath(),
+                new File(dir, MONITOR_FIFO).getAbsolutePath(), ringBytes, error);
+        } catch (UnsatisfiedLinkError e) {
+            throw new IOException("Native launcher not available: " + e.getMessage());
+        }
+        if (handle == 0) {
+            throw new IOException("Cannot start " + argv.get(0) + " (errno " + error[0] + ")");
+        }
+        return new QemuProcess(handle);
+    }
+
+    public int pid() {
+        return pid;
+    }
+
+    public boolean isAlive() {
+        long h = acquire();
+        if (h == 0) {
+            return false;
+        }
+        try {
+            return nativeIsAlive(h);
+        } finally {
+            done();
+        }
+    }
+
+    /**
+     * Wait for QEMU to exit
+     * @return exit value, 128 + N when killed by signal N
+     */
+    public int waitFor() throws InterruptedException {
+        while (true) {
+            int result = waitFor(WAIT_SLICE_MS);
+            if (result != -1) {
+                return result;
+            }
+            if (Thread.interrupted()) {
+                throw new InterruptedException();
+            }
+            if (!holding()) {
+                throw new InterruptedException("released");
+            }
+        }
+    }
+
+    /**
+     * Wait up to timeoutMs for QEMU to exit
+     * @return exit value, -1 if still running
+     */
+    public int waitFor(long timeoutMs) {
+        if (exitValue != -1) {
+            return exitValue;
+        }
+        long h = acquire();
+        if (h == 0) {
+            return exitValue;
+        }
+        try {
+            int result = nativeWaitFor(h, timeoutMs);
+            if (result == -ETIMEDOUT) {
+                return -1;
+            }
+            exitValue = result;
+            return result;
+        } finally {
+            done();
+        }
+    }
+
+    /**
+     * SIGTERM: QEMU shuts the guest down as if its power button was held
+     */
+    public void destroy() {
+        signal(SIGTERM);
+    }
+
+    public void destroyForcibly() {
+        signal(SIGKILL);
+    }
+
+    private void signal(int sig) {
+        long h = acquire();
+        if (h == 0) {
+            return;
+        }
+        try {
+            nativeSignal(h, sig);
+        } finally {
+            done();
+        }
+    }
+
+    /**
+     * Last maxBytes of a stream, decoded as UTF-8
+     */
+    public String tail(int stream, int maxBytes) {
+        long h = acquire();
+        if (h == 0) {
+            return "";
+        }
+        try {
+            return new String(nativeTail(h, stream, maxBytes), StandardCharsets.UTF_8);
+        } finally {
+            done();
+        }
+    }
+
+    /**
+     * Bytes a stream has produced so far, including those the ring dropped
+     */
+    public long written(int stream) {
+        long h = acquire();
+        if (h == 0) {
+            return 0;
+        }
+        try {
+            return nativeWritten(h, stream);
+        } finally {
+            done();
+        }
+    }
+
+    /**
+     * Send an HMP command line; the reply appears on STREAM_MONITOR
+     * @return 0, or a negative errno
+     */
+    public int monitorCommand(String command) {
+        long h = acquire();
+        if (h == 0) {
+            return -1;
+        }
+        try {
+            return nativeMonitorCommand(h, command);
+        } finally {
+            done();
+        }
+    }
+
+    /**
+     * Make this the VM the JSI bindings report on and the stats sampler
+     * watches (see VmStatus); undone by release()
+     */
+    void attachStatus(int cpuCores, int ramMB) {
+        long h = acquire();
+        if (h == 0) {
+            return;
+        }
+        try {
+            nativeAttachStatus(h, cpuCores, ramMB);
+        } finally {
+            done();
+        }
+    }
+
+    /**
+     * Free the launcher and its buffers; kills QEMU if it still runs
+     */
+    public void release() {
+        synchronized (this) {
+            released = true;
+            if (users == 0) {
+                free();
+            }
+        }
+    }
+
+    private synchronized boolean holding() {
+        return !released;
+    }
+
+    private synchronized long acquire() {
+        if (released || handle == 0) {
+            return 0;
+        }
+        users++;
+        return handle;
+    }
+
+    private synchronized void done() {
+        users--;
+        if (released && users == 0) {
+            free();
+        }
+    }
+
+    private void free() {
+        if (handle != 0) {
+            nativeRelease(handle);
+            handle = 0;
+        }
+    }
+}
@@ -8,49 +8,103 @@ import android.app.Service;
 import android.content.Context;
 import android.content.Intent;
 import android.os.Build;
+import android.os.Handler;
 import android.os.IBinder;
+import android.os.Looper;
 import android.os.PowerManager;
 import android.util.Log;
 
 import androidx.annotation.Nullable;
 import androidx.core.app.NotificationCompat;
 
-import java.io.BufferedReader;
+import com.dockerandroid.app.utils.FileUtils;
+
 import java.io.File;
-import java.io.InputStreamReader;
+import java.io.IOException;
 import java.util.ArrayList;
 import java.util.List;
+import java.util.concurrent.Executors;
+import java.util.concurrent.RejectedExecutionException;
+import java.util.concurrent.ScheduledExecutorService;
+import java.util.concurrent.TimeUnit;
 
 /**
  * QemuService - Android Foreground Service for running QEMU
  * Keeps QEMU process alive even when app is in background
  */
-public class QemuService extends Service {
+public class QemuService extends Service implements IdleGovernor.Listener, VmActivator.Starter {
     private static final String TAG = "QemuService";
     
     public static final String ACTION_START = "com.dockerandroid.qemu.START";
     public static final String ACTION_STOP = "com.dockerandroid.qemu.STOP";
+    // Listen on the Docker port and boot the VM on the first connection
+    public static final String ACTION_LISTEN = "com.dockerandroid.qemu.LISTEN";
+    public static final String ACTION_SET_POWER_POLICY = "com.dockerandroid.qemu.SET_POWER_POLICY";
+    public static final String EXTRA_POWER_POLICY = "power_policy";
     public static final String EXTRA_RAM_MB = "ram_mb";
     public static final String EXTRA_CPU_CORES = "cpu_cores";
     
     private static final String CHANNEL_ID = "qemu_service_channel";
     private static final int NOTIFICATION_ID = 1001;
     
-    private Process qemuProcess;
+    // Periodic in-guest fstrim so space freed by Docker reaches the overlay
+    private static final long FSTRIM_INITIAL_DELAY_MIN = 15;
+    private static final long FSTRIM_INTERVAL_MIN = 6 * 60;
+    
+    private QemuProcess qemuProcess;
     private PowerManager.WakeLock wakeLock;
-    private boolean isRunning = false;
+    private volatile boolean isRunning = false;
     private long startTime = 0;
     
-    // Process output reader thread
-    private Thread outputReaderThread;
-    private StringBuilder logBuffer = new StringBuilder();
+    // Serial console, monitor and stderr are drained by the native
+    // launcher; each keeps this much for getLogs and crash records
+    private static final int LOG_BUFFER_BYTES = SupervisorConfig.MAX_CRASH_LOG_KB * 1024;
+    private static final long STOP_TIMEOUT_SEC = 10;
+    
+    // Restart after a crash, with backoff and a crash loop breaker
+    private CrashSupervisor crashSupervisor;
+    private Thread exitWatcherThread;
+    private final Runnable restartRunnable = this::restartQemu;
+    
+    private ScheduledExecutorService maintenanceExecutor;
+    // fstrim and vCPU placement can block for minutes; they get their own
+    // thread so balloon resizes and the governors are not held up
+    private ScheduledExecutorService guestOpExecutor;
+    
+    // vCPU placement on performance cores
+    private static final long VCPU_PLACEMENT_TIMEOUT_MS = 30 * 1000;
+    private static final long VCPU_PLACEMENT_RETRY_MS = 200;
+    private boolean pinVcpus;
+    
+    // Balloon sizing from Android memory pressure (null when disabled)
+    private BalloonPolicy balloonPolicy;
+    private int balloonPollSec;
+    
+    // Idle auto-suspend and the port proxies in front of QEMU's hostfwd
+    private IdleConfig idleConfig;
+    private IdleGovernor idleGovernor;
+    private final List<PortProxy> portProxies = new ArrayList<>();
+    
+    // Socket activation: VM settings for a boot triggered by a connection
+    private VmActivator vmActivator;
+    private boolean listening = false;
+    private int activationRamMB = 2048;
+    private int activationCpuCores = 2;
+    private final Handler mainHandler = new Handler(Looper.getMainLooper());
+    
+    // VM speed from battery, temperature and screen state
+    private PowerGovernor powerGovernor;
+    
+    // Boot phase measurement for the current boot
+    private String bootMode;
+    private Thread bootTimerThread;
     
     @Override
     public void onCreate() {
         super.onCreate();
         Log.d(TAG, "QemuService created");
+        crashSupervisor = new CrashSupervisor(new File(getFilesDir(), "qemu"));
         createNotificationChannel();
-        acquireWakeLock();
     }
     
     @Override
@@ -64,9 +118,27 @@ public class QemuService extends Service {
         if (ACTION_START.equals(action)) {
             int ramMB = intent.getIntExtra(EXTRA_RAM_MB, 2048);
             int cpuCores = intent.getIntExtra(EXTRA_CPU_CORES, 2);
+            // Started by hand: earlier crashes no longer count
+            crashSupervisor.reset();
             startQemu(ramMB, cpuCores);
+        } else if (ACTION_LISTEN.equals(action)) {
+            int ramMB = intent.getIntExtra(EXTRA_RAM_MB, 2048);
+            int cpuCores = intent.getIntExtra(EXTRA_CPU_CORES, 2);
+            startListening(ramMB, cpuCores);
+        } else if (ACTION_SET_POWER_POLICY.equals(action)) {
+            PowerGovernor governor = powerGovernor;
+            if (governor != null) {
+                governor.setPolicy(intent.getStringExtra(EXTRA_POWER_POLICY));
+                runMaintenance(governor);
+            }
         } else if (ACTION_STOP.equals(action)) {
-            stopQemu();
+            // A running VM is stopped first; a second stop ends listening
+            cancelRestart();
+            if (isRunning) {
+                stopQemu();
+            } else {
+                stopListening();
+            }
         }
         
         return START_STICKY;
@@ -81,11 +153,50 @@ public class QemuService extends Service {
     @Override
     public void onDestroy() {
         super.onDestroy();
+        listening = false;
+        cancelRestart();
         stopQemu();
+        stopPortProxies();
         releaseWakeLock();
         Log.d(TAG, "QemuService destroyed");
     }
     
+    /**
+     * Android memory pressure: inflate the balloon before the low memory
+     * killer picks this process
+     */
+    @Override
+    public void onTrimMemory(int level) {
+        super.onTrimMemory(level);
+        BalloonPolicy policy = balloonPolicy;
+        if (policy != null && policy.onTrimMemory(level)) {
+            Log.d(TAG, "Memory pressure (trim level " + level + "), resizing balloon");
+            runMaintenance(policy);
+        }
+    }
+    
+    /**
+     * Run a task on the maintenance thread now; dropped when the VM is
+     * stopping, since the executor goes away with it
+     */
+    private void runMaintenance(Runnable task) {
+        ScheduledExecutorService executor = maintenanceExecutor;
+        if (executor == null || executor.isShutdown()) {
+            return;
+        }
+        try {
+            executor.execute(task);
+        } catch (RejectedExecutionException e) {
+            // Shut down between the check and the submit
+        }
+    }
+    
+    @Override
+    public void onLowMemory() {
+        super.onLowMemory();
+        onTrimMemory(TRIM_MEMORY_COMPLETE);
+    }
+    
     /**
      * Start QEMU process
      */
@@ -95,27 +206,68 @@ public class QemuService extends Service {
             return;
         }
         
+        mainHandler.removeCallbacks(restartRunnable);
+        
         try {
             Log.d(TAG, "Starting QEMU with " + ramMB + "MB RAM and " + cpuCores + " CPU cores");
+            activationRamMB = ramMB;
+            activationCpuCores = cpuCores;
             
             // Start as foreground service
             Notification notification = createNotification("Starting VM...");
             startForeground(NOTIFICATION_ID, notification);
+            acquireWakeLock();
             
-            // Build QEMU command
-            List<String> command = buildQemuCommand(ramMB, cpuCores);
+            // Compile qemu-config.json into the command line (see QemuCommand)
+            QemuCommand command = QemuCommand.compile(this, ramMB, cpuCores);
+            bootMode = command.boot.mode;
+            pinVcpus = command.tcg.pinVcpus;
+            idleConfig = command.idle;
+            balloonPolicy = command.balloon.enabled ? new BalloonPolicy(command.balloon,
+                new QmpClient(new File(getFilesDir(), "qemu")), command.ramMB) : null;
+            balloonPollSec = command.balloon.pollSec;
             
-            // Start QEMU process
-            ProcessBuilder pb = new ProcessBuilder(command);
-            pb.directory(new File(getFilesDir(), "qemu"));
-            pb.redirectErrorStream(true);
-            
-            qemuProcess = pb.start();
+            // Start QEMU process under the native launcher
+            qemuProcess = QemuProcess.start(command.argv, new File(getFilesDir(), "qemu"), LOG_BUFFER_BYTES);
             isRunning = true;
             startTime = System.currentTimeMillis();
             
-            // Start output reader thread
-            startOutputReader();
+            // Watch for the process to die
+            SupervisorConfig supervisorConfig =
+                SupervisorConfig.load(new File(new File(getFilesDir(), "qemu"), "qemu-config.json"));
+            crashSupervisor.vmStarted(supervisorConfig, ramMB, cpuCores, bootMode);
+            VmStatus.vmStarted(qemuProcess, ramMB, cpuCores, startTime);
+            VmHealth.watch(new File(getFilesDir(), "qemu"), idleConfig.qemuPort(IdleConfig.DOCKER_PORT));
+            startExitWatcher(qemuProcess);
+            
+            bootTimerThread = new Thread(new BootTimer(new File(getFilesDir(), "qemu"), bootMode, startTime,
+                idleConfig.qemuPort(IdleConfig.DOCKER_PORT)), "boot-timer");
+            bootTimerThread.start();
+            
+            maintenanceExecutor = Executors.newSingleThreadScheduledExecutor();
+            guestOpExecutor = Executors.newSingleThreadScheduledExecutor();
+            if (pinVcpus) {
+                guestOpExecutor.execute(this::placeVcpus);
+            }
+            scheduleFstrim();
+            if (idleConfig.proxied()) {
+                startPortProxies();
+            }
+            if (idleConfig.autoSuspend) {
+                startIdleGovernor();
+            }
+            if (vmActivator != null) {
+                vmActivator.vmStarted(idleGovernor);
+            }
+            startPowerGovernor();
+            startStatsSampler();
+            maintenanceExecutor.scheduleWithFixedDelay(
+                new JitStats.Sampler(new QmpClient(new File(getFilesDir(), "qemu"))),
+                JitStats.SAMPLE_SEC, JitStats.SAMPLE_SEC, TimeUnit.SECONDS);
+            if (balloonPolicy != null) {
+                maintenanceExecutor.scheduleWithFixedDelay(balloonPolicy,
+                    balloonPollSec, balloonPollSec, TimeUnit.SECONDS);
+            }
             
             // Update notification
             updateNotification("Alpine Linux VM Running");
@@ -125,7 +277,10 @@ public class QemuService extends Service {
         } catch (Exception e) {
             Log.e(TAG, "Failed to start QEMU: " + e.getMessage(), e);
             isRunning = false;
-            stopSelf();
+            releaseWakeLock();
+            if (!listening) {
+                stopSelf();
+            }
         }
     }
     
@@ -144,29 +299,28 @@ public class QemuService extends Service {
                 // Send SIGTERM first
                 qemuProcess.destroy();
                 
-                // Wait for graceful shutdown
-                try {
-                    qemuProcess.waitFor();
-                } catch (InterruptedException e) {
-                    // Force kill if needed
+                // Wait for graceful shutdown, force kill if needed
+                if (qemuProcess.waitFor(TimeUnit.SECONDS.toMillis(STOP_TIMEOUT_SEC)) == -1) {
                     qemuProcess.destroyForcibly();
+                    qemuProcess.waitFor(TimeUnit.SECONDS.toMillis(STOP_TIMEOUT_SEC));
                 }
                 
+                qemuProcess.release();
                 qemuProcess = null;
             }
             
-            isRunning = false;
-            startTime = 0;
+            crashSupervisor.vmStopped();
+            cleanUpAfterExit();
             
-            // Stop output reader
-            if (outputReaderThread != null) {
-                outputReaderThread.interrupt();
-                outputReaderThread = null;
+            if (listening) {
+                // Keep the Docker port open; the next connection boots again
+                updateNotification(listeningText());
+            } else {
+                stopPortProxies();
+                stopForeground(true);
+                stopSelf();
             }
             
-            stopForeground(true);
-            stopSelf();
-            
             Log.d(TAG, "QEMU stopped successfully");
             
         } catch (Exception e) {
@@ -175,118 +329,338 @@ public class QemuService extends Service {
     }
     
     /**
-     * Build QEMU command line arguments
+     * Release everything tied to the QEMU process that just ended
      */
-    private List<String> buildQemuCommand(int ramMB, int cpuCores) {
-        File qemuDir = new File(getFilesDir(), "qemu");
-        File qemuBinary = new File(getApplicationInfo().nativeLibraryDir, "libqemu-system-x86_64.so");
-        
-        List<String> cmd = new ArrayList<>();
+    private void cleanUpAfterExit() {
+        isRunning = false;
+        startTime = 0;
         
-        // Use bundled QEMU binary or system path
-        if (qemuBinary.exists()) {
-            cmd.add(qemuBinary.getAbsolutePath());
-        } else {
-            // Fallback for development - won't work without actual binary
-            cmd.add("/system/bin/qemu-system-x86_64");
+        stopIdleGovernor();
+        if (vmActivator != null) {
+            vmActivator.vmStopped();
         }
         
-        // Machine configuration
-        cmd.add("-machine");
-        cmd.add("q35,accel=tcg");
-        
-        // CPU
-        cmd.add("-cpu");
-        cmd.add("max");
-        cmd.add("-smp");
-        cmd.add(String.valueOf(cpuCores));
-        
-        // Memory
-        cmd.add("-m");
-        cmd.add(String.valueOf(ramMB));
-        
-        // No display (headless)
-        cmd.add("-display");
-        cmd.add("none");
-        
-        // Serial console for logs
-        cmd.add("-serial");
-        cmd.add("stdio");
-        
-        // Boot drive (Alpine disk)
-        cmd.add("-drive");
-        cmd.add("file=" + new File(qemuDir, "alpine-disk.qcow2").getAbsolutePath() + 
-                ",if=virtio,format=qcow2");
-        
-        // CD-ROM (Alpine ISO for first boot)
-        cmd.add("-cdrom");
-        cmd.add(new File(qemuDir, "alpine-virt.iso").getAbsolutePath());
+        // Stop the exit watcher
+        if (exitWatcherThread != null) {
+            exitWatcherThread.interrupt();
+            exitWatcherThread = null;
+        }
         
-        // Network with port forwarding
-        cmd.add("-netdev");
-        cmd.add("user,id=net0," +
-                "hostfwd=tcp::2375-:2375," +  // Docker API
-                "hostfwd=tcp::2222-:22," +     // SSH
-                "hostfwd=tcp::8080-:8080," +   // Web
-                "hostfwd=tcp::8443-:443");     // HTTPS
+        if (bootTimerThread != null) {
+            bootTimerThread.interrupt();
+            bootTimerThread = null;
+        }
         
-        cmd.add("-device");
-        cmd.add("virtio-net-pci,netdev=net0");
+        if (maintenanceExecutor != null) {
+            maintenanceExecutor.shutdownNow();
+            maintenanceExecutor = null;
+        }
+        if (guestOpExecutor != null) {
+            guestOpExecutor.shutdownNow();
+            guestOpExecutor = null;
+        }
+        balloonPolicy = null;
+        BalloonPolicy.clearStatus();
+        powerGovernor = null;
+        PowerGovernor.clearStatus();
+        JitStats.clearStatus();
+        VmStatus.vmStopped();
+        VmHealth.unwatch();
+        releaseWakeLock();
+    }
+    
+    /**
+     * Wait for the QEMU process to exit; an exit nobody asked for is
+     * handled on the main thread like the service's other commands
+     */
+    private void startExitWatcher(QemuProcess process) {
+        exitWatcherThread = new Thread(() -> {
+            try {
+                int exitValue = process.waitFor();
+                mainHandler.post(() -> onQemuExited(process, exitValue));
+            } catch (InterruptedException e) {
+                // Stopped on purpose
+            }
+        }, "qemu-exit-watcher");
+        exitWatcherThread.start();
+    }
+    
+    /**
+     * QEMU died (low memory kill, TCG assertion, guest poweroff): record
+     * the crash and restart as the supervisor decides
+     */
+    private void onQemuExited(QemuProcess process, int exitValue) {
+        if (process != qemuProcess || !isRunning) {
+            // stopQemu got there first
+            return;
+        }
+        long uptimeMs = System.currentTimeMillis() - startTime;
+        qemuProcess = null;
         
-        // QMP monitor for control
-        cmd.add("-qmp");
-        cmd.add("unix:" + new File(qemuDir, "qmp.sock").getAbsolutePath() + ",server,nowait");
+        // The launcher drained both pipes to EOF before reporting the exit,
+        // so the tails hold QEMU's last words
+        String serialTail = process.tail(QemuProcess.STREAM_SERIAL, LOG_BUFFER_BYTES);
+        String stderrTail = process.tail(QemuProcess.STREAM_STDERR, LOG_BUFFER_BYTES);
+        process.release();
         
-        // Daemon mode
-        cmd.add("-daemonize");
+        cleanUpAfterExit();
+        removeStaleSockets();
         
-        return cmd;
+        long delay = crashSupervisor.onExit(exitValue, uptimeMs, serialTail, stderrTail);
+        if (delay >= 0) {
+            updateNotification("VM crashed, restarting in " + Math.max(1, (delay + 999) / 1000) + "s");
+            mainHandler.postDelayed(restartRunnable, delay);
+        } else if (listening) {
+            updateNotification(crashSupervisor.isCrashLoop() ?
+                "VM keeps crashing, start it from the app" : listeningText());
+        } else {
+            stopPortProxies();
+            stopForeground(true);
+            stopSelf();
+        }
     }
     
     /**
-     * Start thread to read QEMU output
+     * Boot again after a crash with the last settings; BootConfig "auto"
+     * takes direct kernel boot whenever the image has a kernel
      */
-    private void startOutputReader() {
-        outputReaderThread = new Thread(() -> {
+    private void restartQemu() {
+        if (isRunning) {
+            return;
+        }
+        Log.i(TAG, "Restarting QEMU after a crash");
+        startQemu(activationRamMB, activationCpuCores);
+    }
+    
+    private void cancelRestart() {
+        mainHandler.removeCallbacks(restartRunnable);
+        crashSupervisor.vmStopped();
+    }
+    
+    /**
+     * A killed QEMU leaves its sockets behind; without them nothing
+     * mistakes the dead VM for a booting one
+     */
+    private void removeStaleSockets() {
+        File qemuDir = new File(getFilesDir(), "qemu");
+        new File(qemuDir, QmpClient.SOCKET_NAME).delete();
+        new File(qemuDir, GuestAgent.SOCKET_NAME).delete();
+        new File(qemuDir, VmHealth.QMP_SOCKET_NAME).delete();
+    }
+    
+    /**
+     * Pin the vCPU threads to the performance cores once QMP is up
+     */
+    private void placeVcpus() {
+        QmpClient qmp = new QmpClient(new File(getFilesDir(), "qemu"));
+        long deadline = System.currentTimeMillis() + VCPU_PLACEMENT_TIMEOUT_MS;
+        while (isRunning() && System.currentTimeMillis() < deadline) {
             try {
-                BufferedReader reader = new BufferedReader(
-                    new InputStreamReader(qemuProcess.getInputStream()));
-                
-                String line;
-                while ((line = reader.readLine()) != null && !Thread.interrupted()) {
-                    Log.d(TAG, "QEMU: " + line);
-                    synchronized (logBuffer) {
-                        logBuffer.append(line).append("\n");
-                        // Keep last 10000 chars
-                        if (logBuffer.length() > 10000) {
-                            logBuffer.delete(0, logBuffer.length() - 10000);
-                        }
-                    }
-                }
-            } catch (Exception e) {
-                if (!Thread.interrupted()) {
-                    Log.e(TAG, "Output reader error: " + e.getMessage());
+                VcpuPlacement.pinVcpus(qmp);
+                // Runs on its own thread, so a governor check may have
+                // come first; let it put its tier back
+                PowerGovernor governor = powerGovernor;
+                if (governor != null) {
+                    governor.vcpusPlaced();
+                    runMaintenance(governor);
                 }
+                return;
+            } catch (IOException e) {
+                // QMP not listening yet
             }
-        });
-        outputReaderThread.start();
+            try {
+                Thread.sleep(VCPU_PLACEMENT_RETRY_MS);
+            } catch (InterruptedException e) {
+                return;
+            }
+        }
+        Log.w(TAG, "vCPU placement skipped, QMP did not answer");
     }
     
     /**
-     * Get logs from buffer
+     * Listen on the forwarded ports with no VM running; the first
+     * connection boots the VM with these settings (see VmActivator)
      */
-    public String getLogs(int lines) {
-        synchronized (logBuffer) {
-            String[] allLines = logBuffer.toString().split("\n");
-            int start = Math.max(0, allLines.length - lines);
-            StringBuilder result = new StringBuilder();
-            for (int i = start; i < allLines.length; i++) {
-                result.append(allLines[i]).append("\n");
+    private void startListening(int ramMB, int cpuCores) {
+        idleConfig = IdleConfig.load(new File(new File(getFilesDir(), "qemu"), "qemu-config.json"));
+        if (!idleConfig.socketActivation) {
+            Log.d(TAG, "Socket activation disabled in qemu-config.json");
+            if (!isRunning) {
+                stopSelf();
+            }
+            return;
+        }
+        if (!isRunning) {
+            activationRamMB = ramMB;
+            activationCpuCores = cpuCores;
+        }
+        listening = true;
+        startForeground(NOTIFICATION_ID, createNotification(
+            isRunning ? "Alpine Linux VM Running" : listeningText()));
+        startPortProxies();
+        vmActivator.setListening(true);
+        Log.d(TAG, "Listening on :" + IdleConfig.DOCKER_PORT + " (" + activationRamMB + "MB, " +
+            activationCpuCores + " CPU cores on demand)");
+    }
+    
+    private void stopListening() {
+        listening = false;
+        if (vmActivator != null) {
+            vmActivator.setListening(false);
+        }
+        if (!isRunning) {
+            stopPortProxies();
+            stopForeground(true);
+            stopSelf();
+        }
+    }
+    
+    private String listeningText() {
+        return "VM stopped, starts on the next Docker connection";
+    }
+    
+    /**
+     * VmActivator.Starter: boot for a waiting connection
+     */
+    @Override
+    public void startVm() {
+        if (crashSupervisor.isCrashLoop()) {
+            Log.w(TAG, "VM is in a crash loop, not starting it for a connection");
+            return;
+        }
+        mainHandler.post(() -> startQemu(activationRamMB, activationCpuCores));
+    }
+    
+    @Override
+    public boolean isVmRunning() {
+        return isRunning();
+    }
+    
+    /**
+     * Put the proxies on the forwarded Docker and SSH ports; they stay
+     * while the VM runs or the service listens
+     */
+    private void startPortProxies() {
+        if (!portProxies.isEmpty()) {
+            return;
+        }
+        if (vmActivator == null) {
+            vmActivator = new VmActivator(idleConfig, this);
+        }
+        portProxies.add(new PortProxy(IdleConfig.DOCKER_PORT,
+            idleConfig.qemuPort(IdleConfig.DOCKER_PORT), true, vmActivator));
+        portProxies.add(new PortProxy(IdleConfig.SSH_PORT,
+            idleConfig.qemuPort(IdleConfig.SSH_PORT), false, vmActivator));
+        for (PortProxy proxy : portProxies) {
+            try {
+                proxy.start();
+            } catch (IOException e) {
+                Log.e(TAG, "Failed to start port proxy: " + e.getMessage());
             }
-            return result.toString();
         }
     }
     
+    private void stopPortProxies() {
+        for (PortProxy proxy : portProxies) {
+            proxy.stop();
+        }
+        portProxies.clear();
+        vmActivator = null;
+        VmActivator.clearStatus();
+        VmStatus.publish();
+    }
+    
+    /**
+     * Adjust the vCPU placement to battery and thermal state every
+     * checkSec; the first check follows the initial vCPU placement
+     */
+    private void startPowerGovernor() {
+        File qemuDir = new File(getFilesDir(), "qemu");
+        PowerConfig powerConfig = PowerConfig.load(new File(qemuDir, "qemu-config.json"));
+        Log.d(TAG, "Power: " + powerConfig);
+        powerGovernor = new PowerGovernor(this, powerConfig, new QmpClient(qemuDir), pinVcpus);
+        maintenanceExecutor.scheduleWithFixedDelay(powerGovernor,
+            powerConfig.checkSec, powerConfig.checkSec, TimeUnit.SECONDS);
+    }
+    
+    /**
+     * Fill the guest's network and container stats into the shared stats
+     * block every SAMPLE_SEC
+     */
+    private void startStatsSampler() {
+        StatsSampler sampler = new StatsSampler(new GuestAgent(new File(getFilesDir(), "qemu")),
+            idleConfig.qemuPort(IdleConfig.DOCKER_PORT));
+        maintenanceExecutor.scheduleWithFixedDelay(sampler,
+            StatsSampler.SAMPLE_SEC, StatsSampler.SAMPLE_SEC, TimeUnit.SECONDS);
+    }
+    
+    /**
+     * Check for idleness every checkSec
+     */
+    private void startIdleGovernor() {
+        File qemuDir = new File(getFilesDir(), "qemu");
+        idleGovernor = new IdleGovernor(idleConfig, new QmpClient(qemuDir), new GuestAgent(qemuDir), this);
+        maintenanceExecutor.scheduleWithFixedDelay(idleGovernor,
+            idleConfig.checkSec, idleConfig.checkSec, TimeUnit.SECONDS);
+    }
+    
+    private void stopIdleGovernor() {
+        idleGovernor = null;
+    }
+    
+    private boolean isSuspended() {
+        IdleGovernor governor = idleGovernor;
+        return governor != null && governor.isSuspended();
+    }
+    
+    @Override
+    public void onSuspended() {
+        releaseWakeLock();
+        updateNotification("Alpine Linux VM suspended (idle)");
+    }
+    
+    @Override
+    public void onResumed() {
+        acquireWakeLock();
+        updateNotification("Alpine Linux VM Running");
+    }
+    
+    /**
+     * Run fstrim in the guest periodically while the VM is up
+     */
+    private void scheduleFstrim() {
+        GuestAgent agent = new GuestAgent(new File(getFilesDir(), "qemu"));
+        guestOpExecutor.scheduleWithFixedDelay(() -> {
+            // A stopped guest cannot answer; the next window catches up
+            if (!isRunning() || isSuspended()) {
+                return;
+            }
+            try {
+                long trimmed = agent.fstrim();
+                Log.d(TAG, "Scheduled fstrim released " + FileUtils.formatFileSize(trimmed));
+            } catch (IOException e) {
+                Log.w(TAG, "Scheduled fstrim failed: " + e.getMessage());
+            }
+        }, FSTRIM_INITIAL_DELAY_MIN, FSTRIM_INTERVAL_MIN, TimeUnit.MINUTES);
+    }
+    
+    /**
+     * Get the last lines of the serial console
+     */
+    public String getLogs(int lines) {
+        QemuProcess process = qemuProcess;
+        if (process == null) {
+            return "";
+        }
+        String[] allLines = process.tail(QemuProcess.STREAM_SERIAL, LOG_BUFFER_BYTES).split("\n");
+        int start = Math.max(0, allLines.length - lines);
+        StringBuilder result = new StringBuilder();
+        for (int i = start; i < allLines.length; i++) {
+            result.append(allLines[i]).append("\n");
+        }
+        return result.toString();
+    }
+    
     /**
      * Check if QEMU is running
      */
@@ -360,7 +734,10 @@ public class QemuService extends Service {
     /**
      * Acquire wake lock to keep CPU running
      */
-    private void acquireWakeLock() {
+    private synchronized void acquireWakeLock() {
+        if (wakeLock != null && wakeLock.isHeld()) {
+            return;
+        }
         PowerManager pm = (PowerManager) getSystemService(Context.POWER_SERVICE);
         if (pm != null) {
             wakeLock = pm.newWakeLock(
@@ -374,7 +751,7 @@ public class QemuService extends Service {
     /**
      * Release wake lock
      */
-    private void releaseWakeLock() {
+    private synchronized void releaseWakeLock() {
         if (wakeLock != null && wakeLock.isHeld()) {
             wakeLock.release();
         }
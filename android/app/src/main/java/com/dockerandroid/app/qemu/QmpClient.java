@@ -0,0 +1,106 @@
+package com.dockerandroid.app.qemu;
+
+import android.net.LocalSocket;
+import android.net.LocalSocketAddress;
+
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.BufferedReader;
+import java.io.File;
+import java.io.IOException;
+import java.io.InputStreamReader;
+import java.io.OutputStream;
+import java.nio.charset.StandardCharsets;
+
+/**
+ * QmpClient - Client for the QEMU Machine Protocol monitor
+ * Talks JSON over qemu/qmp.sock. QEMU serves one monitor client at a
+ * time, so every command uses its own short-lived connection.
+ */
+public class QmpClient {
+    public static final String SOCKET_NAME = "qmp.sock";
+
+    private static final int DEFAULT_TIMEOUT_MS = 5 * 1000;
+
+    private final File socketFile;
+
+    public QmpClient(File qemuDir) {
+        this.socketFile = new File(qemuDir, SOCKET_NAME);
+    }
+
+    /**
+     * Run a QMP command and return its "return" value
+     * (a JSONObject or JSONArray depending on the command)
+     */
+    public Object execute(String command, JSONObject arguments) throws IOException {
+        return execute(command, arguments, DEFAULT_TIMEOUT_MS);
+    }
+
+    public Object execute(String command, JSONObject arguments, int timeoutMs) throws IOException {
+        try (LocalSocket socket = new LocalSocket()) {
+            socket.connect(new LocalSocketAddress(socketFile.getAbsolutePath(),
+                LocalSocketAddress.Namespace.FILESYSTEM));
+            socket.setSoTimeout(timeoutMs);
+
+            OutputStream out = socket.getOutputStream();
+            BufferedReader in = new BufferedReader(
+                new InputStreamReader(socket.getInputStream(), StandardCharsets.UTF_8));
+
+            // Greeting, then leave capabilities negotiation mode
+            readReply(in, "greeting", "QMP");
+            send(out, new JSONObject().put("execute", "qmp_capabilities"));
+            readReply(in, "qmp_capabilities", "return");
+
+            JSONObject request = new JSONObject().put("execute", command);
+            if (arguments != null) {
+                request.put("arguments", arguments);
+            }
+            send(out, request);
+            return readReply(in, command, "return").opt("return");
+        } catch (JSONException e) {
+            throw new IOException("Invalid QMP message: " + e.getMessage(), e);
+        }
+    }
+
+    /**
+     * Run a human monitor (HMP) command, e.g. "info jit", and return its text
+     */
+    public String humanCommand(String commandLine, int timeoutMs) throws IOException {
+        try {
+            Object result = execute("human-monitor-command",
+                new JSONObject().put("command-line", commandLine), timeoutMs);
+            return result instanceof String ? (String) result : "";
+        } catch (JSONException e) {
+            throw new IOException("Invalid QMP message: " + e.getMessage(), e);
+        }
+    }
+
+    /**
+     * Read messages until one has the given key; asynchronous events
+     * arriving in between are skipped
+     */
+    private static JSONObject readReply(BufferedReader in, String command, String key)
+            throws IOException, JSONException {
+        String line;
+        while ((line = in.readLine()) != null) {
+            if (line.trim().isEmpty()) {
+                continue;
+            }
+            JSONObject reply = new JSONObject(line.trim());
+            if (reply.has("error")) {
+                JSONObject error = reply.getJSONObject("error");
+                throw new IOException(command + " failed: " + error.optString("desc"));
+            }
+            if (reply.has(key)) {
+                return reply;
+            }
+        }
+        throw new IOException("QEMU closed the monitor connection");
+    }
+
+    private static void send(OutputStream out, JSONObject message) throws IOException {
+        out.write((message.toString() + "\n").getBytes(StandardCharsets.UTF_8));
+        out.flush();
+    }
+}
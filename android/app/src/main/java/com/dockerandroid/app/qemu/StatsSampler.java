@@ -0,0 +1,248 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import org.json.JSONArray;
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.ByteArrayOutputStream;
+import java.io.IOException;
+import java.io.InputStream;
+import java.net.HttpURLConnection;
+import java.net.URL;
+import java.nio.charset.StandardCharsets;
+import java.util.HashMap;
+import java.util.Iterator;
+import java.util.Map;
+
+/**
+ * StatsSampler - Guest network and per-container stats for the shared
+ * stats block
+ *
+ * The QEMU process's CPU, memory and disk I/O are sampled natively
+ * (vm_stats.c). What only the guest knows is filled in here every
+ * SAMPLE_SEC on QemuService's maintenance executor: the guest's network
+ * counters from the guest agent, and one slot per running container from
+ * the Docker API on QEMU's internal port (one-shot stats, so no request
+ * waits for a second sample). Skipped while the VM is suspended.
+ */
+public class StatsSampler implements Runnable {
+    private static final String TAG = "StatsSampler";
+
+    public static final int SAMPLE_SEC = 5;
+
+    // Container slot fields, same order as CT_STAT_* in vm_stats.h
+    private static final int CPU_PCT = 0;
+    private static final int MEM_BYTES = 1;
+    private static final int MEM_LIMIT = 2;
+    private static final int NET_RX_BYTES = 3;
+    private static final int NET_TX_BYTES = 4;
+    private static final int BLK_READ_BYTES = 5;
+    private static final int BLK_WRITE_BYTES = 6;
+    private static final int PIDS = 7;
+    private static final int UPDATED_AT = 8;
+    private static final int FIELDS = 9;
+    private static final int SLOTS = 16;
+
+    private static final int AGENT_TIMEOUT_MS = 2000;
+    private static final int DOCKER_TIMEOUT_MS = 2000;
+
+    // Shared stats block writers (implemented in vm_stats.c)
+    private static native void nativeWriteNet(double rxBytes, double txBytes, double rxBps, double txBps);
+    private static native void nativeWriteContainers(String[] ids, String[] names, double[] values);
+
+    static {
+        try {
+            System.loadLibrary("qemu-jni");
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Failed to load native library qemu-jni: " + e.getMessage());
+        }
+    }
+
+    private final GuestAgent agent;
+    private final int dockerPort;
+
+    // Previous samples for rates; only touched on the executor thread
+    private long lastRxBytes = -1;
+    private long lastTxBytes = -1;
+    private long lastNetAt = 0;
+    private final Map<String, long[]> lastCpu = new HashMap<>();
+
+    public StatsSampler(GuestAgent agent, int dockerPort) {
+        this.agent = agent;
+        this.dockerPort = dockerPort;
+    }
+
+    @Override
+    public void run() {
+        if (IdleGovernor.isVmSuspended()) {
+            return;
+        }
+        try {
+            sampleNetwork();
+            sampleContainers();
+        } catch (UnsatisfiedLinkError e) {
+            // No native library, nobody to read the block
+        }
+    }
+
+    private void sampleNetwork() {
+        long[] bytes;
+        try {
+            bytes = agent.networkBytes(AGENT_TIMEOUT_MS);
+        } catch (IOException e) {
+            return;
+        }
+        long now = System.currentTimeMillis();
+        double rxBps = 0;
+        double txBps = 0;
+        if (lastNetAt > 0 && now > lastNetAt && bytes[0] >= lastRxBytes && bytes[1] >= lastTxBytes) {
+            rxBps = (bytes[0] - lastRxBytes) * 1000.0 / (now - lastNetAt);
+            txBps = (bytes[1] - lastTxBytes) * 1000.0 / (now - lastNetAt);
+        }
+        lastRxBytes = bytes[0];
+        lastTxBytes = bytes[1];
+        lastNetAt = now;
+        nativeWriteNet(bytes[0], bytes[1], rxBps, txBps);
+    }
+
+    private void sampleContainers() {
+        JSONArray containers;
+        try {
+            containers = new JSONArray(get("/containers/json"));
+        } catch (IOException | JSONException e) {
+            // Docker not up yet
+            return;
+        }
+
+        int count = Math.min(containers.length(), SLOTS);
+        String[] ids = new String[count];
+        String[] names = new String[count];
+        double[] values = new double[count * FIELDS];
+        Map<String, long[]> seen = new HashMap<>();
+        int filled = 0;
+        for (int i = 0; i < count; i++) {
+            JSONObject container = containers.optJSONObject(i);
+            if (container == null) {
+                continue;
+            }
+            String id = container.optString("Id");
+            JSONArray nameList = container.optJSONArray("Names");
+            String name = nameList != null && nameList.length() > 0 ? nameList.optString(0) : id;
+            try {
+                JSONObject stats = new JSONObject(get("/containers/" + id + "/stats?stream=false&one-shot=true"));
+                fill(values, filled * FIELDS, id, stats, seen);
+            } catch (IOException | JSONException e) {
+                Log.w(TAG, "No stats for " + name + ": " + e.getMessage());
+                continue;
+            }
+            ids[filled] = id.length() > 12 ? id.substring(0, 12) : id;
+            names[filled] = name.startsWith("/") ? name.substring(1) : name;
+            filled++;
+        }
+        lastCpu.clear();
+        lastCpu.putAll(seen);
+
+        if (filled < count) {
+            String[] fewerIds = new String[filled];
+            String[] fewerNames = new String[filled];
+            double[] fewerValues = new double[filled * FIELDS];
+            System.arraycopy(ids, 0, fewerIds, 0, filled);
+            System.arraycopy(names, 0, fewerNames, 0, filled);
+            System.arraycopy(values, 0, fewerValues, 0, filled * FIELDS);
+            ids = fewerIds;
+            names = fewerNames;
+            values = fewerValues;
+        }
+        nativeWriteContainers(ids, names, values);
+    }
+
+    /**
+     * One container's slot from a one-shot stats reply; CPU is measured
+     * against the previous sample since one-shot has no precpu_stats
+     */
+    private void fill(double[] values, int at, String id, JSONObject stats, Map<String, long[]> seen) {
+        JSONObject cpuStats = stats.optJSONObject("cpu_stats");
+        if (cpuStats != null) {
+            JSONObject usage = cpuStats.optJSONObject("cpu_usage");
+            long total = usage != null ? usage.optLong("total_usage", 0) : 0;
+            long system = cpuStats.optLong("system_cpu_usage", 0);
+            int cpus = cpuStats.optInt("online_cpus", 1);
+            long[] last = lastCpu.get(id);
+            if (last != null && system > last[1] && total >= last[0]) {
+                values[at + CPU_PCT] = (double) (total - last[0]) / (system - last[1]) * cpus * 100;
+            }
+            seen.put(id, new long[] {total, system});
+        }
+
+        JSONObject memory = stats.optJSONObject("memory_stats");
+        if (memory != null) {
+            // Page cache is reclaimable; docker stats leaves it out too
+            JSONObject detail = memory.optJSONObject("stats");
+            long cache = detail == null ? 0 :
+                detail.has("inactive_file") ? detail.optLong("inactive_file") : detail.optLong("cache", 0);
+            values[at + MEM_BYTES] = Math.max(0, memory.optLong("usage", 0) - cache);
+            values[at + MEM_LIMIT] = memory.optLong("limit", 0);
+        }
+
+        JSONObject networks = stats.optJSONObject("networks");
+        if (networks != null) {
+            Iterator<String> keys = networks.keys();
+            while (keys.hasNext()) {
+                JSONObject net = networks.optJSONObject(keys.next());
+                if (net != null) {
+                    values[at + NET_RX_BYTES] += net.optLong("rx_bytes", 0);
+                    values[at + NET_TX_BYTES] += net.optLong("tx_bytes", 0);
+                }
+            }
+        }
+
+        JSONObject blkio = stats.optJSONObject("blkio_stats");
+        JSONArray io = blkio != null ? blkio.optJSONArray("io_service_bytes_recursive") : null;
+        if (io != null) {
+            for (int i = 0; i < io.length(); i++) {
+                JSONObject entry = io.optJSONObject(i);
+                if (entry == null) {
+                    continue;
+                }
+                String op = entry.optString("op");
+                if (op.equalsIgnoreCase("read")) {
+                    values[at + BLK_READ_BYTES] += entry.optLong("value", 0);
+                } else if (op.equalsIgnoreCase("write")) {
+                    values[at + BLK_WRITE_BYTES] += entry.optLong("value", 0);
+                }
+            }
+        }
+
+        JSONObject pids = stats.optJSONObject("pids_stats");
+        values[at + PIDS] = pids != null ? pids.optLong("current", 0) : 0;
+        values[at + UPDATED_AT] = System.currentTimeMillis();
+    }
+
+    private String get(String path) throws IOException {
+        HttpURLConnection connection = null;
+        try {
+            URL url = new URL("http://127.0.0.1:" + dockerPort + path);
+            connection = (HttpURLConnection) url.openConnection();
+            connection.setConnectTimeout(DOCKER_TIMEOUT_MS);
+            connection.setReadTimeout(DOCKER_TIMEOUT_MS);
+            if (connection.getResponseCode() != HttpURLConnection.HTTP_OK) {
+                throw new IOException("HTTP " + connection.getResponseCode());
+            }
+            ByteArrayOutputStream body = new ByteArrayOutputStream();
+            try (InputStream in = connection.getInputStream()) {
+                byte[] buffer = new byte[8192];
+                int n;
+                while ((n = in.read(buffer)) >= 0) {
+                    body.write(buffer, 0, n);
+                }
+            }
+            return body.toString(StandardCharsets.UTF_8.name());
+        } finally {
+            if (connection != null) {
+                connection.disconnect();
+            }
+        }
+    }
+}
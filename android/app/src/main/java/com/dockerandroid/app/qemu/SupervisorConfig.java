@@ -0,0 +1,102 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import com.dockerandroid.app.utils.FileUtils;
+
+import org.json.JSONException;
+import org.json.JSONObject;
+
+import java.io.File;
+
+/**
+ * SupervisorConfig - Restart policy for a QEMU process that dies
+ * Read from the "supervisor" section of qemu-config.json:
+ *
+ *   "supervisor": { "restart": "on-failure", "backoffMs": 1000,
+ *                   "maxBackoffMs": 60000, "stableSec": 300,
+ *                   "maxRestarts": 5, "windowSec": 600, "crashLogKB": 16,
+ *                   "keepRecords": 10 }
+ *
+ * restart is "on-failure" (any exit but a clean guest poweroff) or "never".
+ * The backoff doubles per crash from backoffMs up to maxBackoffMs and
+ * starts over once a VM ran stableSec. More than maxRestarts crashes
+ * within windowSec is a crash loop: the supervisor gives up until the VM
+ * is started by hand.
+ */
+public class SupervisorConfig {
+    private static final String TAG = "SupervisorConfig";
+
+    public static final String RESTART_ON_FAILURE = "on-failure";
+    public static final String RESTART_NEVER = "never";
+
+    // The output buffers QemuService keeps hold this much
+    public static final int MAX_CRASH_LOG_KB = 64;
+
+    public String restart = RESTART_ON_FAILURE;
+    public long backoffMs = 1000;
+    public long maxBackoffMs = 60 * 1000;
+    public int stableSec = 300;
+    public int maxRestarts = 5;
+    public int windowSec = 600;
+    public int crashLogKB = 16;
+    public int keepRecords = 10;
+
+    /**
+     * Load supervisor settings; missing or invalid values keep their defaults
+     */
+    public static SupervisorConfig load(File configFile) {
+        SupervisorConfig config = new SupervisorConfig();
+        String json = configFile.exists() ? FileUtils.readFile(configFile) : null;
+        if (json == null) {
+            return config;
+        }
+
+        try {
+            JSONObject supervisor = new JSONObject(json).optJSONObject("supervisor");
+            if (supervisor != null) {
+                config.restart = supervisor.optString("restart", config.restart);
+                config.backoffMs = supervisor.optLong("backoffMs", config.backoffMs);
+                config.maxBackoffMs = supervisor.optLong("maxBackoffMs", config.maxBackoffMs);
+                config.stableSec = supervisor.optInt("stableSec", config.stableSec);
+                config.maxRestarts = supervisor.optInt("maxRestarts", config.maxRestarts);
+                config.windowSec = supervisor.optInt("windowSec", config.windowSec);
+                config.crashLogKB = supervisor.optInt("crashLogKB", config.crashLogKB);
+                config.keepRecords = supervisor.optInt("keepRecords", config.keepRecords);
+            }
+        } catch (JSONException e) {
+            Log.e(TAG, "Invalid " + configFile.getName() + ": " + e.getMessage());
+        }
+        if (!config.restart.equals(RESTART_ON_FAILURE) && !config.restart.equals(RESTART_NEVER)) {
+            Log.w(TAG, "Unknown restart policy " + config.restart + ", using on-failure");
+            config.restart = RESTART_ON_FAILURE;
+        }
+        if (config.backoffMs < 100) {
+            config.backoffMs = 100;
+        }
+        if (config.maxBackoffMs < config.backoffMs) {
+            config.maxBackoffMs = config.backoffMs;
+        }
+        if (config.maxRestarts < 1) {
+            config.maxRestarts = 1;
+        }
+        if (config.windowSec < 60) {
+            config.windowSec = 60;
+        }
+        config.crashLogKB = Math.max(1, Math.min(MAX_CRASH_LOG_KB, config.crashLogKB));
+        if (config.keepRecords < 1) {
+            config.keepRecords = 1;
+        }
+        return config;
+    }
+
+    public boolean restartOnFailure() {
+        return restart.equals(RESTART_ON_FAILURE);
+    }
+
+    @Override
+    public String toString() {
+        return "restart=" + restart + " backoffMs=" + backoffMs + ".." + maxBackoffMs +
+               " maxRestarts=" + maxRestarts + "/" + windowSec + "s";
+    }
+}
@@ -0,0 +1,107 @@
+package com.dockerandroid.app.qemu;
+
+import android.app.ActivityManager;
+import android.util.Log;
+
+import org.json.JSONObject;
+
+import java.io.File;
+import java.util.ArrayList;
+import java.util.List;
+
+/**
+ * TcgConfig - Settings of QEMU's TCG accelerator
+ * Read from the "tcg" section of qemu-config.json:
+ *
+ *   "tcg": { "mttcg": true, "pinVcpus": true, "tbSizeMB": 0 }
+ *
+ * With MTTCG every vCPU runs on its own host thread instead of all vCPUs
+ * taking turns on one. pinVcpus keeps those threads on the performance
+ * cores of big.LITTLE SoCs (see VcpuPlacement).
+ *
+ * tbSizeMB is the translation cache for generated host code. QEMU's 1GB
+ * default gets the process killed on low-RAM phones; too small a cache
+ * is flushed over and over under Docker workloads (see JitStats).
+ * 0 sizes it from the device and guest RAM.
+ */
+public class TcgConfig {
+    private static final String TAG = "TcgConfig";
+
+    public boolean mttcg = true;
+    public boolean pinVcpus = true;
+    public int tbSizeMB = 0;        // 0 = auto
+
+    private static final int MIN_TB_SIZE_MB = 32;
+    private static final int MAX_TB_SIZE_MB = 512;
+    private static final long HEADROOM_MB = 512;
+
+    /**
+     * Load TCG settings; missing or invalid values keep their defaults
+     */
+    public static TcgConfig load(File configFile) {
+        return fromJson(QemuCommand.readConfig(configFile));
+    }
+
+    /**
+     * Read the "tcg" section of an already parsed qemu-config.json
+     */
+    public static TcgConfig fromJson(JSONObject root) {
+        TcgConfig config = new TcgConfig();
+        JSONObject tcg = root.optJSONObject("tcg");
+        if (tcg != null) {
+            config.mttcg = tcg.optBoolean("mttcg", config.mttcg);
+            config.pinVcpus = tcg.optBoolean("pinVcpus", config.pinVcpus);
+            config.tbSizeMB = tcg.optInt("tbSizeMB", config.tbSizeMB);
+        }
+        if (config.tbSizeMB < 0 || config.tbSizeMB > MAX_TB_SIZE_MB * 2) {
+            config.tbSizeMB = 0;
+        }
+        return config;
+    }
+
+    /**
+     * Pick tbSizeMB when it is auto: a quarter of the guest RAM, limited
+     * by what the phone can spare next to the guest RAM, and capped on
+     * devices with 4GB or 8GB RAM or less
+     */
+    public void resolveTbSize(ActivityManager.MemoryInfo memoryInfo, int guestRamMB) {
+        if (tbSizeMB > 0) {
+            return;
+        }
+        long totalMB = memoryInfo.totalMem / (1024 * 1024);
+        long availMB = memoryInfo.availMem / (1024 * 1024);
+        long thresholdMB = memoryInfo.threshold / (1024 * 1024);
+
+        long size = Math.max(64, Math.min(guestRamMB / 4, MAX_TB_SIZE_MB));
+        long spareMB = availMB - thresholdMB - guestRamMB - HEADROOM_MB;
+        size = Math.min(size, spareMB / 2);
+        if (totalMB <= 4096) {
+            size = Math.min(size, 128);
+        } else if (totalMB <= 8192) {
+            size = Math.min(size, 256);
+        }
+        tbSizeMB = (int) Math.max(MIN_TB_SIZE_MB, size);
+
+        Log.d(TAG, "tb-size " + tbSizeMB + "MB (device " + totalMB + "MB, available " + availMB +
+            "MB, guest " + guestRamMB + "MB)");
+    }
+
+    /**
+     * Build the -accel arguments.
+     * MTTCG is requested explicitly: QEMU only defaults to it when the host
+     * memory model is at least as strong as the guest's, which ARM is not
+     * for x86 guests (QEMU adds the barriers x86 code expects).
+     */
+    public List<String> toArgs() {
+        List<String> args = new ArrayList<>();
+        args.add("-accel");
+        args.add("tcg,thread=" + (mttcg ? "multi" : "single") +
+                 (tbSizeMB > 0 ? ",tb-size=" + tbSizeMB : ""));
+        return args;
+    }
+
+    @Override
+    public String toString() {
+        return "mttcg=" + mttcg + " pinVcpus=" + pinVcpus + " tbSizeMB=" + tbSizeMB;
+    }
+}
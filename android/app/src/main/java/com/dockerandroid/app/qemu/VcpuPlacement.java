@@ -0,0 +1,127 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import org.json.JSONArray;
+import org.json.JSONObject;
+
+import java.io.IOException;
+import java.util.Arrays;
+
+/**
+ * VcpuPlacement - Pins QEMU's vCPU threads to the performance cores
+ * On big.LITTLE SoCs the scheduler otherwise migrates busy vCPU threads
+ * onto little cores, where translated code runs several times slower.
+ * I/O threads and QEMU's main loop are left to float.
+ */
+public class VcpuPlacement {
+    private static final String TAG = "VcpuPlacement";
+
+    // Native CPU topology and affinity (implemented in cpu_affinity.c)
+    private static native int[] nativeGetPerformanceCores();
+    private static native int[] nativeGetEfficiencyCores();
+    private static native int nativeSetThreadAffinity(int tid, int[] cpus);
+
+    static {
+        try {
+            System.loadLibrary("qemu-jni");
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Failed to load native library qemu-jni: " + e.getMessage());
+        }
+    }
+
+    /**
+     * Performance cores of this device, empty when all cores are alike
+     */
+    public static int[] getPerformanceCores() {
+        try {
+            return nativeGetPerformanceCores();
+        } catch (UnsatisfiedLinkError e) {
+            return new int[0];
+        }
+    }
+
+    /**
+     * Efficiency cores of this device, empty when all cores are alike
+     */
+    public static int[] getEfficiencyCores() {
+        try {
+            return nativeGetEfficiencyCores();
+        } catch (UnsatisfiedLinkError e) {
+            return new int[0];
+        }
+    }
+
+    /**
+     * Look up the vCPU threads with query-cpus-fast and restrict them to
+     * the performance cores. Skipped when there are fewer performance
+     * cores than vCPUs, since crowding the vCPUs onto them would be slower
+     * than letting some run on little cores.
+     * @return number of vCPU threads pinned
+     */
+    public static int pinVcpus(QmpClient qmp) throws IOException {
+        int[] bigCores = getPerformanceCores();
+        if (bigCores.length == 0) {
+            Log.d(TAG, "No heterogeneous cores, vCPUs left to the scheduler");
+            return 0;
+        }
+
+        JSONArray cpus = queryVcpus(qmp);
+        if (cpus.length() > bigCores.length) {
+            Log.d(TAG, cpus.length() + " vCPUs but only " + bigCores.length +
+                " performance cores, vCPUs left to the scheduler");
+            return 0;
+        }
+        return setAffinity(cpus, bigCores);
+    }
+
+    /**
+     * Restrict all vCPU threads to the given host CPUs
+     * @return number of vCPU threads moved
+     */
+    public static int setVcpuAffinity(QmpClient qmp, int[] hostCpus) throws IOException {
+        return setAffinity(queryVcpus(qmp), hostCpus);
+    }
+
+    /**
+     * Number of vCPUs of the running VM
+     */
+    public static int countVcpus(QmpClient qmp) throws IOException {
+        return queryVcpus(qmp).length();
+    }
+
+    private static JSONArray queryVcpus(QmpClient qmp) throws IOException {
+        Object result = qmp.execute("query-cpus-fast", null);
+        if (!(result instanceof JSONArray)) {
+            throw new IOException("Unexpected query-cpus-fast reply");
+        }
+        return (JSONArray) result;
+    }
+
+    private static int setAffinity(JSONArray cpus, int[] hostCpus) {
+        int pinned = 0;
+        for (int i = 0; i < cpus.length(); i++) {
+            JSONObject cpu = cpus.optJSONObject(i);
+            int tid = cpu != null ? cpu.optInt("thread-id", -1) : -1;
+            if (tid <= 0) {
+                continue;
+            }
+            int err;
+            try {
+                err = nativeSetThreadAffinity(tid, hostCpus);
+            } catch (UnsatisfiedLinkError e) {
+                return 0;
+            }
+            if (err < 0) {
+                // Outside the app's cpuset, e.g. while in the background group
+                Log.w(TAG, "Failed to pin vCPU " + cpu.optInt("cpu-index") + " (errno " + -err + ")");
+                continue;
+            }
+            pinned++;
+        }
+
+        Log.d(TAG, "Pinned " + pinned + "/" + cpus.length() + " vCPU threads to cores " +
+            Arrays.toString(hostCpus));
+        return pinned;
+    }
+}
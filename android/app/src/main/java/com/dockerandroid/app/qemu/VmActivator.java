@@ -0,0 +1,211 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import java.io.IOException;
+import java.net.HttpURLConnection;
+import java.net.URL;
+
+/**
+ * VmActivator - Boots the VM on the first connection to a forwarded port
+ *
+ * While QemuService listens (ACTION_LISTEN) the port proxies accept
+ * connections with no VM running. The first one starts the VM; it and
+ * every connection arriving during the boot are held until the Docker
+ * API answers on QEMU's internal port, then spliced through. A Docker CLI
+ * or remote client just sees a slow first request.
+ *
+ * Once the VM is up this gate only passes through to the IdleGovernor,
+ * which resumes a suspended VM.
+ */
+public class VmActivator implements PortProxy.Gate {
+    private static final String TAG = "VmActivator";
+
+    private static final long POLL_MS = 200;
+    private static final int PING_TIMEOUT_MS = 1000;
+    // Time QemuService gets to spawn QEMU before a dead process counts as failed
+    private static final long START_GRACE_MS = 5 * 1000;
+
+    /**
+     * Starts the VM on behalf of a waiting connection
+     */
+    public interface Starter {
+        void startVm();
+        boolean isVmRunning();
+    }
+
+    /**
+     * Queue state, read by QemuModule.getStatus (the service and the React
+     * module share the app process)
+     */
+    public static class Status {
+        public boolean listening;
+        public int waiting;
+        public long activations;
+        public long lastWaitMs = -1;
+        public long maxWaitMs = -1;
+    }
+
+    private static volatile Status lastStatus;
+
+    private final IdleConfig config;
+    private final Starter starter;
+
+    private volatile IdleGovernor governor;
+    private volatile boolean listening = false;
+    private volatile boolean ready = false;
+
+    // Guarded by this
+    private boolean starting = false;
+    private long startRequestedAt = 0;
+    private int waiting = 0;
+    private long activations = 0;
+    private long lastWaitMs = -1;
+    private long maxWaitMs = -1;
+
+    public VmActivator(IdleConfig config, Starter starter) {
+        this.config = config;
+        this.starter = starter;
+        publish();
+    }
+
+    public static Status getLastStatus() {
+        return lastStatus;
+    }
+
+    public static void clearStatus() {
+        lastStatus = null;
+    }
+
+    /**
+     * Start the VM on demand (or stop doing so)
+     */
+    public synchronized void setListening(boolean listening) {
+        this.listening = listening;
+        publish();
+    }
+
+    /**
+     * The VM process is up; traffic now also resumes it through the
+     * governor (null without auto-suspend)
+     */
+    public synchronized void vmStarted(IdleGovernor governor) {
+        this.governor = governor;
+        starting = true;
+        startRequestedAt = System.currentTimeMillis();
+    }
+
+    public synchronized void vmStopped() {
+        governor = null;
+        ready = false;
+        starting = false;
+    }
+
+    @Override
+    public void open() throws IOException {
+        if (!ready) {
+            awaitVm();
+        }
+        IdleGovernor g = governor;
+        if (g != null) {
+            g.resume();
+        }
+    }
+
+    @Override
+    public void touch() {
+        IdleGovernor g = governor;
+        if (g != null) {
+            g.touch();
+        }
+    }
+
+    /**
+     * Start the VM if it is down and hold the caller until Docker answers
+     */
+    private void awaitVm() throws IOException {
+        long start = System.currentTimeMillis();
+        synchronized (this) {
+            if (!starting && !starter.isVmRunning()) {
+                if (!listening) {
+                    throw new IOException("VM is not running");
+                }
+                starting = true;
+                startRequestedAt = start;
+                activations++;
+                Log.d(TAG, "Connection waiting, starting VM");
+                starter.startVm();
+            }
+            waiting++;
+            publish();
+        }
+
+        try {
+            long deadline = start + config.activationTimeoutSec * 1000L;
+            while (!ready) {
+                if (dockerAnswers()) {
+                    ready = true;
+                    break;
+                }
+                long now = System.currentTimeMillis();
+                if (now >= deadline) {
+                    throw new IOException("VM not ready after " + config.activationTimeoutSec + "s");
+                }
+                if (!starter.isVmRunning() && now - startedAt() > START_GRACE_MS) {
+                    throw new IOException("VM exited during boot");
+                }
+                try {
+                    Thread.sleep(POLL_MS);
+                } catch (InterruptedException e) {
+                    Thread.currentThread().interrupt();
+                    throw new IOException("Interrupted waiting for the VM");
+                }
+            }
+        } finally {
+            long waited = System.currentTimeMillis() - start;
+            synchronized (this) {
+                waiting--;
+                starting = starting && !ready;
+                lastWaitMs = waited;
+                maxWaitMs = Math.max(maxWaitMs, waited);
+                publish();
+            }
+        }
+        Log.d(TAG, "Connection released after " + (System.currentTimeMillis() - start) + " ms");
+    }
+
+    private synchronized long startedAt() {
+        return startRequestedAt;
+    }
+
+    /**
+     * Docker's /_ping on QEMU's internal port
+     */
+    private boolean dockerAnswers() {
+        HttpURLConnection connection = null;
+        try {
+            URL url = new URL("http://127.0.0.1:" + config.qemuPort(IdleConfig.DOCKER_PORT) + "/_ping");
+            connection = (HttpURLConnection) url.openConnection();
+            connection.setConnectTimeout(PING_TIMEOUT_MS);
+            connection.setReadTimeout(PING_TIMEOUT_MS);
+            return connection.getResponseCode() == HttpURLConnection.HTTP_OK;
+        } catch (IOException e) {
+            return false;
+        } finally {
+            if (connection != null) {
+                connection.disconnect();
+            }
+        }
+    }
+
+    private void publish() {
+        Status status = new Status();
+        status.listening = listening;
+        status.waiting = waiting;
+        status.activations = activations;
+        status.lastWaitMs = lastWaitMs;
+        status.maxWaitMs = maxWaitMs;
+        lastStatus = status;
+        VmStatus.publish();
+    }
+}
@@ -0,0 +1,130 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+import java.io.File;
+
+/**
+ * VmHealth - Cached health of the running VM
+ *
+ * vm_health.c keeps a QMP session on its own monitor socket and a
+ * keep-alive connection to dockerd, probes them every few seconds and
+ * caches the outcome with its latency. Reading here copies that cache
+ * and asks the launcher whether QEMU is alive; nothing waits on a
+ * socket, so status calls can run on any thread.
+ */
+public final class VmHealth {
+    private static final String TAG = "VmHealth";
+
+    // Second QMP monitor, held open by the health monitor; QmpClient's
+    // short-lived connections keep qmp.sock to themselves
+    public static final String QMP_SOCKET_NAME = "qmp-health.sock";
+
+    // Probe results, VM_HEALTH_* in vm_health.h
+    public static final int UNKNOWN = 0;
+    public static final int UP = 1;
+    public static final int DOWN = 2;
+
+    // nativeRead fields
+    private static final int PID = 0;
+    private static final int QMP = 1;
+    private static final int DOCKER = 2;
+    private static final int QMP_LATENCY_US = 3;
+    private static final int DOCKER_LATENCY_US = 4;
+    private static final int QMP_CHECKED_AT = 5;
+    private static final int DOCKER_CHECKED_AT = 6;
+    private static final int QMP_FAILURES = 7;
+    private static final int DOCKER_FAILURES = 8;
+    private static final int FIELDS = 9;
+
+    /**
+     * One read of the cache
+     */
+    public static class Status {
+        public int pid;
+        public int qmp;
+        public int docker;
+        public String runState;
+        public double qmpLatencyMs;
+        public double dockerLatencyMs;
+        public long qmpCheckedAt;
+        public long dockerCheckedAt;
+        public int qmpFailures;
+        public int dockerFailures;
+    }
+
+    // Health monitor (implemented in vm_health.c)
+    private static native void nativeWatch(String qmpPath, int dockerPort);
+    private static native int nativePid();
+    private static native String nativeRead(double[] values);
+
+    static {
+        try {
+            System.loadLibrary("qemu-jni");
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Failed to load native library qemu-jni: " + e.getMessage());
+        }
+    }
+
+    private VmHealth() {
+    }
+
+    /**
+     * Start probing a VM started with QemuCommand's health monitor
+     * socket in qemuDir and dockerd forwarded to dockerPort
+     */
+    public static void watch(File qemuDir, int dockerPort) {
+        try {
+            nativeWatch(new File(qemuDir, QMP_SOCKET_NAME).getAbsolutePath(), dockerPort);
+        } catch (UnsatisfiedLinkError e) {
+            Log.w(TAG, "No native health monitor");
+        }
+    }
+
+    /**
+     * The VM is gone; drop the sessions and the cached results
+     */
+    public static void unwatch() {
+        try {
+            nativeWatch(null, 0);
+        } catch (UnsatisfiedLinkError e) {
+            // Nothing was watched
+        }
+    }
+
+    /**
+     * Whether the QEMU process is alive, straight from the launcher
+     */
+    public static boolean isProcessAlive() {
+        try {
+            return nativePid() > 0;
+        } catch (UnsatisfiedLinkError e) {
+            return false;
+        }
+    }
+
+    /**
+     * Copy the cached health, null without the native library
+     */
+    public static Status read() {
+        double[] values = new double[FIELDS];
+        String runState;
+        try {
+            runState = nativeRead(values);
+        } catch (UnsatisfiedLinkError e) {
+            return null;
+        }
+        Status status = new Status();
+        status.pid = (int) values[PID];
+        status.qmp = (int) values[QMP];
+        status.docker = (int) values[DOCKER];
+        status.runState = runState;
+        status.qmpLatencyMs = values[QMP_LATENCY_US] / 1000;
+        status.dockerLatencyMs = values[DOCKER_LATENCY_US] / 1000;
+        status.qmpCheckedAt = (long) values[QMP_CHECKED_AT];
+        status.dockerCheckedAt = (long) values[DOCKER_CHECKED_AT];
+        status.qmpFailures = (int) values[QMP_FAILURES];
+        status.dockerFailures = (int) values[DOCKER_FAILURES];
+        return status;
+    }
+}
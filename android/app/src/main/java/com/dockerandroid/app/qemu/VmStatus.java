@@ -0,0 +1,182 @@
+package com.dockerandroid.app.qemu;
+
+import android.util.Log;
+
+/**
+ * VmStatus - Native copy of the VM's status for the JSI bindings
+ *
+ * The governors, the activator and the crash supervisor each keep a
+ * status snapshot for QemuModule.getStatus. Whoever replaces one calls
+ * publish(), which flattens all of them into one array and hands it to
+ * vm_status.c, where qemu_jsi.cpp reads it synchronously on the JS
+ * thread. QemuService attaches the running QemuProcess so the native
+ * side can check the process itself.
+ */
+public final class VmStatus {
+    private static final String TAG = "VmStatus";
+
+    // Numeric fields, same order as VM_STATUS_* in vm_status.h
+    private static final int STARTED_AT = 0;
+    private static final int RAM_MB = 1;
+    private static final int CPU_CORES = 2;
+    private static final int SUSPENDED = 3;
+    private static final int SECTIONS = 4;
+    private static final int BALLOON_ACTUAL_MB = 5;
+    private static final int BALLOON_TARGET_MB = 6;
+    private static final int BALLOON_FLOOR_MB = 7;
+    private static final int BALLOON_WORKING_SET_MB = 8;
+    private static final int BALLOON_UPDATED_AT = 9;
+    private static final int POWER_CORES = 10;
+    private static final int POWER_TEMP_C = 11;
+    private static final int POWER_CHARGING = 12;
+    private static final int POWER_BATTERY_PCT = 13;
+    private static final int POWER_SCREEN_ON = 14;
+    private static final int POWER_CHANGED_AT = 15;
+    private static final int POWER_CHANGES = 16;
+    private static final int ACTIVATION_LISTENING = 17;
+    private static final int ACTIVATION_WAITING = 18;
+    private static final int ACTIVATION_COUNT = 19;
+    private static final int ACTIVATION_LAST_WAIT_MS = 20;
+    private static final int ACTIVATION_MAX_WAIT_MS = 21;
+    private static final int SUPERVISOR_RESTARTS = 22;
+    private static final int SUPERVISOR_RECENT = 23;
+    private static final int SUPERVISOR_NEXT_RESTART = 24;
+    private static final int CRASH_TIME = 25;
+    private static final int CRASH_UPTIME_MS = 26;
+    private static final int CRASH_EXIT_CODE = 27;
+    private static final int CRASH_SIGNAL = 28;
+    private static final int FIELDS = 29;
+
+    // Text fields (VM_TEXT_*)
+    private static final int TEXT_BALLOON_PRESSURE = 0;
+    private static final int TEXT_POWER_POLICY = 1;
+    private static final int TEXT_POWER_TIER = 2;
+    private static final int TEXT_POWER_REASON = 3;
+    private static final int TEXT_POWER_THERMAL = 4;
+    private static final int TEXT_SUPERVISOR_STATE = 5;
+    private static final int TEXT_CRASH_REASON = 6;
+    private static final int TEXT_CRASH_FILE = 7;
+    private static final int TEXTS = 8;
+
+    // VM_SECTION_* bits
+    private static final int SECTION_BALLOON = 1;
+    private static final int SECTION_POWER = 1 << 1;
+    private static final int SECTION_ACTIVATION = 1 << 2;
+    private static final int SECTION_SUPERVISOR = 1 << 3;
+    private static final int SECTION_CRASH = 1 << 4;
+
+    // Native status table (implemented in vm_status.c)
+    private static native void nativePublish(double[] values, String[] texts);
+
+    static {
+        try {
+            System.loadLibrary("qemu-jni");
+        } catch (UnsatisfiedLinkError e) {
+            Log.e(TAG, "Failed to load native library qemu-jni: " + e.getMessage());
+        }
+    }
+
+    private static volatile long startedAt = 0;
+    private static volatile int ramMB = 0;
+    private static volatile int cpuCores = 0;
+
+    private VmStatus() {
+    }
+
+    /**
+     * QemuService started a VM
+     */
+    public static void vmStarted(QemuProcess process, int ramMB, int cpuCores, long startedAt) {
+        VmStatus.ramMB = ramMB;
+        VmStatus.cpuCores = cpuCores;
+        VmStatus.startedAt = startedAt;
+        process.attachStatus(cpuCores, ramMB);
+        publish();
+    }
+
+    /**
+     * The VM is gone; QemuProcess.release detaches the process
+     */
+    public static void vmStopped() {
+        startedAt = 0;
+        publish();
+    }
+
+    /**
+     * Copy every status snapshot to native memory. Synchronized so two
+     * publishers cannot land out of order.
+     */
+    public static synchronized void publish() {
+        double[] values = new double[FIELDS];
+        String[] texts = new String[TEXTS];
+        int sections = 0;
+
+        values[STARTED_AT] = startedAt;
+        values[RAM_MB] = ramMB;
+        values[CPU_CORES] = cpuCores;
+        values[SUSPENDED] = IdleGovernor.isVmSuspended() ? 1 : 0;
+
+        BalloonPolicy.Status balloon = BalloonPolicy.getLastStatus();
+        if (balloon != null) {
+            sections |= SECTION_BALLOON;
+            values[BALLOON_ACTUAL_MB] = balloon.actualMB;
+            values[BALLOON_TARGET_MB] = balloon.targetMB;
+            values[BALLOON_FLOOR_MB] = balloon.floorMB;
+            values[BALLOON_WORKING_SET_MB] = balloon.workingSetMB;
+            values[BALLOON_UPDATED_AT] = balloon.updatedAt;
+            texts[TEXT_BALLOON_PRESSURE] = balloon.pressure;
+        }
+
+        PowerGovernor.Status power = PowerGovernor.getLastStatus();
+        if (power != null) {
+            sections |= SECTION_POWER;
+            values[POWER_CORES] = power.cores;
+            values[POWER_TEMP_C] = power.tempC;
+            values[POWER_CHARGING] = power.charging ? 1 : 0;
+            values[POWER_BATTERY_PCT] = power.batteryPct;
+            values[POWER_SCREEN_ON] = power.screenOn ? 1 : 0;
+            values[POWER_CHANGED_AT] = power.changedAt;
+            values[POWER_CHANGES] = power.changes;
+            texts[TEXT_POWER_POLICY] = power.policy;
+            texts[TEXT_POWER_TIER] = power.tier;
+            texts[TEXT_POWER_REASON] = power.reason;
+            texts[TEXT_POWER_THERMAL] = power.thermal;
+        }
+
+        VmActivator.Status activation = VmActivator.getLastStatus();
+        if (activation != null) {
+            sections |= SECTION_ACTIVATION;
+            values[ACTIVATION_LISTENING] = activation.listening ? 1 : 0;
+            values[ACTIVATION_WAITING] = activation.waiting;
+            values[ACTIVATION_COUNT] = activation.activations;
+            values[ACTIVATION_LAST_WAIT_MS] = activation.lastWaitMs;
+            values[ACTIVATION_MAX_WAIT_MS] = activation.maxWaitMs;
+        }
+
+        CrashSupervisor.Status supervisor = CrashSupervisor.getLastStatus();
+        if (supervisor != null) {
+            sections |= SECTION_SUPERVISOR;
+            values[SUPERVISOR_RESTARTS] = supervisor.restarts;
+            values[SUPERVISOR_RECENT] = supervisor.recentCrashes;
+            values[SUPERVISOR_NEXT_RESTART] = supervisor.nextRestartAt;
+            texts[TEXT_SUPERVISOR_STATE] = supervisor.state;
+            CrashSupervisor.Crash crash = supervisor.lastCrash;
+            if (crash != null) {
+                sections |= SECTION_CRASH;
+                values[CRASH_TIME] = crash.time;
+                values[CRASH_UPTIME_MS] = crash.uptimeMs;
+                values[CRASH_EXIT_CODE] = crash.exitCode;
+                values[CRASH_SIGNAL] = crash.signal;
+                texts[TEXT_CRASH_REASON] = crash.reason;
+                texts[TEXT_CRASH_FILE] = crash.recordFile;
+            }
+        }
+        values[SECTIONS] = sections;
+
+        try {
+            nativePublish(values, texts);
+        } catch (UnsatisfiedLinkError e) {
+            // No native library: the JSI bindings are not there either
+        }
+    }
+}
@@ -1,17 +1,21 @@
 package com.dockerandroid.app.utils;
 
 import android.content.Context;
+import android.content.pm.PackageInfo;
+import android.content.res.AssetManager;
 import android.util.Log;
 
 import java.io.BufferedInputStream;
 import java.io.BufferedOutputStream;
 import java.io.File;
 import java.io.FileInputStream;
+import java.io.FileNotFoundException;
 import java.io.FileOutputStream;
 import java.io.IOException;
 import java.io.InputStream;
 import java.io.OutputStream;
 import java.security.MessageDigest;
+import java.security.NoSuchAlgorithmException;
 import java.util.zip.GZIPInputStream;
 
 /**
@@ -20,28 +24,125 @@ import java.util.zip.GZIPInputStream;
 public class FileUtils {
     private static final String TAG = "FileUtils";
     private static final int BUFFER_SIZE = 8192;
+    private static final int ASSET_BUFFER_SIZE = 1024 * 1024;
+    
+    /**
+     * Receives progress from long-running native file operations
+     */
+    public interface ProgressListener {
+        void onProgress(long done, long total);
+    }
+    
+    // Native file operations (implemented in asset_extract.c / decompress.c)
+    // Return 0 = done (1 = asset already up to date), < 0 = -errno
+    private static native int nativeExtractAsset(AssetManager assets, String assetName,
+                                                 String destPath, String sourceKey,
+                                                 ProgressListener listener);
+    private static native int nativeDecompressFile(String srcPath, String destPath,
+                                                   ProgressListener listener);
+    
+    // Tree hash (implemented in tree_hash.c)
+    private static native String nativeTreeHash(String path, String indexPath,
+                                                ProgressListener listener);
+    private static native int nativeVerifyTreeHash(String path, String indexPath, long maxChunks,
+                                                   ProgressListener listener);
+    
+    // Results of verifyFile()
+    public static final int VERIFY_OK = 0;
+    public static final int VERIFY_MISMATCH = 1;
+    private static final int VERIFY_STALE = 2;
+    private static final int EINVAL = 22;
+    private static final int TREE_HASH_CHUNK_SIZE = 1024 * 1024;
+    
+    private static boolean nativeAvailable = false;
+    
+    static {
+        try {
+            System.loadLibrary("qemu-jni");
+            nativeAvailable = true;
+        } catch (UnsatisfiedLinkError e) {
+            Log.w(TAG, "Native library qemu-jni unavailable, using Java file copies");
+        }
+    }
     
     /**
      * Copy file from assets to internal storage
      */
     public static boolean copyAsset(Context context, String assetName, File destFile) {
-        try (InputStream in = context.getAssets().open(assetName);
-             OutputStream out = new FileOutputStream(destFile)) {
+        return copyAsset(context, assetName, destFile, null);
+    }
+    
+    /**
+     * Copy file from assets to internal storage
+     * Skips the copy when destFile already holds this build's asset;
+     * the file is replaced atomically so a partial copy is never left behind.
+     * If assetName is not packaged, the gzip/BGZF asset assetName.gz is
+     * decompressed in its place.
+     */
+    public static boolean copyAsset(Context context, String assetName, File destFile,
+                                    ProgressListener listener) {
+        if (nativeAvailable) {
+            int result = nativeExtractAsset(context.getAssets(), assetName,
+                destFile.getAbsolutePath(), getAssetSourceKey(context), listener);
+            if (result >= 0) {
+                Log.d(TAG, (result == 1 ? "Asset up to date: " : "Extracted asset ") +
+                    assetName + " -> " + destFile.getAbsolutePath());
+                return true;
+            }
+            Log.e(TAG, "Native extraction of " + assetName + " failed (errno " + -result +
+                "), falling back to stream copy");
+        }
+        
+        File tmpFile = new File(destFile.getAbsolutePath() + ".tmp");
+        try (InputStream in = openAssetOrGzip(context, assetName);
+             FileOutputStream out = new FileOutputStream(tmpFile)) {
             
-            byte[] buffer = new byte[BUFFER_SIZE];
+            byte[] buffer = new byte[ASSET_BUFFER_SIZE];
             int read;
             while ((read = in.read(buffer)) != -1) {
                 out.write(buffer, 0, read);
             }
             out.flush();
-            
-            Log.d(TAG, "Copied asset " + assetName + " to " + destFile.getAbsolutePath());
-            return true;
+            out.getFD().sync();
             
         } catch (IOException e) {
             Log.e(TAG, "Failed to copy asset: " + e.getMessage(), e);
+            tmpFile.delete();
+            return false;
+        }
+        
+        if (!tmpFile.renameTo(destFile)) {
+            Log.e(TAG, "Failed to move asset into place: " + destFile.getAbsolutePath());
+            tmpFile.delete();
             return false;
         }
+        
+        Log.d(TAG, "Copied asset " + assetName + " to " + destFile.getAbsolutePath());
+        return true;
+    }
+    
+    /**
+     * Open an asset, falling back to its gzip-compressed variant
+     */
+    private static InputStream openAssetOrGzip(Context context, String assetName) throws IOException {
+        try {
+            return context.getAssets().open(assetName);
+        } catch (FileNotFoundException e) {
+            return new GZIPInputStream(context.getAssets().open(assetName + ".gz"), ASSET_BUFFER_SIZE);
+        }
+    }
+    
+    /**
+     * Identify the installed APK build, so assets are re-extracted after an update
+     */
+    private static String getAssetSourceKey(Context context) {
+        try {
+            PackageInfo info = context.getPackageManager()
+                .getPackageInfo(context.getPackageName(), 0);
+            return info.versionName + "-" + info.lastUpdateTime;
+        } catch (Exception e) {
+            return "unknown";
+        }
     }
     
     /**
@@ -70,6 +171,24 @@ public class FileUtils {
      * Extract gzipped file
      */
     public static boolean extractGzip(File gzFile, File destFile) {
+        return extractGzip(gzFile, destFile, null);
+    }
+    
+    /**
+     * Extract gzipped file
+     * BGZF files are inflated in parallel natively and zero blocks stay sparse.
+     */
+    public static boolean extractGzip(File gzFile, File destFile, ProgressListener listener) {
+        if (nativeAvailable) {
+            int result = nativeDecompressFile(gzFile.getAbsolutePath(),
+                destFile.getAbsolutePath(), listener);
+            if (result == 0) {
+                return true;
+            }
+            Log.e(TAG, "Native decompression of " + gzFile.getName() + " failed (errno " +
+                -result + "), falling back to GZIPInputStream");
+        }
+        
         try (GZIPInputStream gzis = new GZIPInputStream(new FileInputStream(gzFile));
              FileOutputStream fos = new FileOutputStream(destFile)) {
             
@@ -110,9 +229,63 @@ public class FileUtils {
     }
     
     /**
-     * Get file MD5 hash
+     * Get the tree hash of a file: SHA-256 over 1 MiB chunk digests,
+     * computed on all cores (hex string, null on failure)
      */
-    public static String getMD5(File file) {
+    public static String getTreeHash(File file) {
+        if (nativeAvailable) {
+            return nativeTreeHash(file.getAbsolutePath(), null, null);
+        }
+        return getTreeHashJava(file);
+    }
+    
+    /**
+     * Check a file against its tree hash index (file.treehash), re-hashing
+     * at most maxChunks chunks per call (<= 0 = all). Successive calls
+     * continue where the last one stopped. A missing or outdated index is
+     * rebuilt from the current contents.
+     * @return VERIFY_OK or VERIFY_MISMATCH
+     */
+    public static int verifyFile(File file, long maxChunks, ProgressListener listener) throws IOException {
+        if (!nativeAvailable) {
+            Log.w(TAG, "Native library unavailable, skipping verification of " + file.getName());
+            return VERIFY_OK;
+        }
+        
+        File index = getTreeHashIndex(file);
+        int result = index.exists() ?
+            nativeVerifyTreeHash(file.getAbsolutePath(), index.getAbsolutePath(), maxChunks, listener) :
+            VERIFY_STALE;
+        
+        if (result == VERIFY_STALE || result == -EINVAL) {
+            Log.d(TAG, "Indexing " + file.getName());
+            if (nativeTreeHash(file.getAbsolutePath(), index.getAbsolutePath(), listener) == null) {
+                throw new IOException("Failed to index " + file.getName());
+            }
+            return VERIFY_OK;
+        }
+        if (result < 0) {
+            throw new IOException("Failed to verify " + file.getName() + " (errno " + -result + ")");
+        }
+        return result;
+    }
+    
+    /**
+     * Index file holding the chunk hashes of file
+     */
+    public static File getTreeHashIndex(File file) {
+        return new File(file.getPath() + ".treehash");
+    }
+    
+    /**
+     * Compare hashing throughput of the old single-threaded MD5 stream
+     * with the parallel tree hash on the same file
+     * @return {md5MBps, treeHashMBps}
+     */
+    public static double[] benchmarkHash(File file) throws IOException {
+        double sizeMB = file.length() / (1024.0 * 1024.0);
+        
+        long start = System.nanoTime();
         try (FileInputStream fis = new FileInputStream(file)) {
             MessageDigest md = MessageDigest.getInstance("MD5");
             byte[] buffer = new byte[BUFFER_SIZE];
@@ -120,16 +293,65 @@ public class FileUtils {
             while ((read = fis.read(buffer)) != -1) {
                 md.update(buffer, 0, read);
             }
+            md.digest();
+        } catch (NoSuchAlgorithmException e) {
+            throw new IOException(e);
+        }
+        double md5Seconds = (System.nanoTime() - start) / 1e9;
+        
+        start = System.nanoTime();
+        if (getTreeHash(file) == null) {
+            throw new IOException("Failed to hash " + file.getName());
+        }
+        double treeSeconds = (System.nanoTime() - start) / 1e9;
+        
+        double[] result = {
+            md5Seconds > 0 ? sizeMB / md5Seconds : 0,
+            treeSeconds > 0 ? sizeMB / treeSeconds : 0
+        };
+        Log.d(TAG, String.format("Hash benchmark %s (%.0f MB): MD5 %.1f MB/s, tree hash %.1f MB/s",
+            file.getName(), sizeMB, result[0], result[1]));
+        return result;
+    }
+    
+    /**
+     * Same construction as tree_hash.c, single-threaded
+     */
+    private static String getTreeHashJava(File file) {
+        try (FileInputStream fis = new FileInputStream(file)) {
+            MessageDigest root = MessageDigest.getInstance("SHA-256");
+            MessageDigest leaf = MessageDigest.getInstance("SHA-256");
+            byte[] chunk = new byte[TREE_HASH_CHUNK_SIZE];
+            long length = 0;
+            
+            root.update((byte) 0x01);
+            int filled;
+            do {
+                filled = 0;
+                int read;
+                while (filled < chunk.length && (read = fis.read(chunk, filled, chunk.length - filled)) != -1) {
+                    filled += read;
+                }
+                if (filled > 0) {
+                    leaf.update((byte) 0x00);
+                    leaf.update(chunk, 0, filled);
+                    root.update(leaf.digest());
+                    length += filled;
+                }
+            } while (filled == chunk.length);
+            
+            for (int i = 7; i >= 0; i--) {
+                root.update((byte) (length >>> (i * 8)));
+            }
             
-            byte[] digest = md.digest();
             StringBuilder sb = new StringBuilder();
-            for (byte b : digest) {
+            for (byte b : root.digest()) {
                 sb.append(String.format("%02x", b));
             }
             return sb.toString();
             
         } catch (Exception e) {
-            Log.e(TAG, "Failed to compute MD5: " + e.getMessage(), e);
+            Log.e(TAG, "Failed to compute tree hash: " + e.getMessage(), e);
             return null;
         }
     }
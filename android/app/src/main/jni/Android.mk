@@ -6,9 +6,43 @@ LOCAL_PATH := $(call my-dir)
 include $(CLEAR_VARS)
 
 LOCAL_MODULE := qemu-jni
-LOCAL_SRC_FILES := qemu_jni.c
+LOCAL_SRC_FILES := qemu_jni.c \
+                   asset_extract.c \
+                   decompress.c \
+                   qcow2.c \
+                   disk_layers.c \
+                   sha256.c \
+                   tree_hash.c \
+                   cpu_affinity.c \
+                   qemu_launcher.c \
+                   vm_status.c \
+                   vm_stats.c \
+                   vm_health.c \
+                   log_index.c \
+                   vt_term.c \
+                   kv_store.c
 
-LOCAL_LDLIBS := -llog -landroid
+LOCAL_LDLIBS := -llog -landroid -lz
 LOCAL_CFLAGS := -Wall -Wextra -O2
 
+# SHA-256 instructions; sha256.c only uses them when HWCAP_SHA2 is set
+ifeq ($(TARGET_ARCH_ABI),arm64-v8a)
+LOCAL_CFLAGS += -march=armv8-a+crypto
+endif
+
+include $(BUILD_SHARED_LIBRARY)
+
+# JSI bindings: synchronous status and logs for JS without the bridge.
+# jsi comes from the ReactAndroid prefab package (buildFeatures.prefab)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := qemu-jsi
+LOCAL_SRC_FILES := qemu_jsi.cpp
+
+LOCAL_SHARED_LIBRARIES := qemu-jni jsi
+LOCAL_LDLIBS := -llog
+LOCAL_CPPFLAGS := -std=c++20 -fexceptions -frtti -Wall -Wextra -O2
+
 include $(BUILD_SHARED_LIBRARY)
+
+$(call import-module,prefab/ReactAndroid)
@@ -0,0 +1,462 @@
+/**
+ * Asset Extractor
+ * Native replacement for the 8 KB Java stream copy of large assets
+ * Also hosts the JNI entry points used by FileUtils
+ */
+
+#define _GNU_SOURCE
+#include <jni.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/sendfile.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <android/asset_manager_jni.h>
+#include <android/log.h>
+
+#include "asset_extract.h"
+#include "io_util.h"
+#include "decompress.h"
+#include "jni_progress.h"
+
+#define TAG "AssetExtract"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
+
+#define COPY_CHUNK    (8 * 1024 * 1024)   // bytes per copy_file_range/sendfile call
+#define BUFFER_SIZE   (1024 * 1024)       // fallback read/write buffer
+#define BUFFER_ALIGN  4096
+#define SAMPLE_SIZE   (1024 * 1024)       // bytes fingerprinted at each end of the file
+
+typedef enum {
+    COPY_FILE_RANGE,
+    COPY_SENDFILE,
+    COPY_BUFFERED,
+    COPY_STREAMING,
+} CopyMethod;
+
+static const char* copy_method_name(CopyMethod method) {
+    switch (method) {
+        case COPY_FILE_RANGE: return "copy_file_range";
+        case COPY_SENDFILE:   return "sendfile";
+        case COPY_BUFFERED:   return "buffered";
+        case COPY_STREAMING:  return "streaming";
+    }
+    return "unknown";
+}
+
+/**
+ * FNV-1a over the first and last SAMPLE_SIZE bytes of a file.
+ * Cheap enough to run on every launch; the full length is checked separately.
+ */
+static int fingerprint_file(int fd, off64_t length, unsigned long long* out) {
+    unsigned long long hash = 0xcbf29ce484222325ULL;
+    char* buf = (char*)malloc(SAMPLE_SIZE);
+    if (buf == NULL) {
+        return -ENOMEM;
+    }
+
+    off64_t offsets[2] = { 0, length > SAMPLE_SIZE ? length - SAMPLE_SIZE : 0 };
+    int samples = length > SAMPLE_SIZE ? 2 : 1;
+
+    for (int s = 0; s < samples; s++) {
+        size_t want = length < SAMPLE_SIZE ? (size_t)length : SAMPLE_SIZE;
+        ssize_t n = pread64(fd, buf, want, offsets[s]);
+        if (n < 0 || (size_t)n != want) {
+            free(buf);
+            return n < 0 ? -errno : -EIO;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            hash ^= (unsigned char)buf[i];
+            hash *= 0x100000001b3ULL;
+        }
+    }
+
+    free(buf);
+    *out = hash ^ (unsigned long long)length;
+    return 0;
+}
+
+/**
+ * Check whether dest_path already holds this asset.
+ * The stamp file records the source key, asset length and the fingerprint of
+ * the last completed output, so a truncated or stale copy is always redone.
+ */
+static int is_up_to_date(const char* dest_path, const char* stamp_path,
+                         const char* source_key, off64_t length) {
+    char stored_key[256] = {0};
+    long long stored_length = -1;
+    unsigned long long stored_hash = 0;
+
+    FILE* f = fopen(stamp_path, "r");
+    if (f == NULL) {
+        return 0;
+    }
+    // The key runs to the end of its line: version names may hold spaces
+    int fields = fscanf(f, "source=%255[^\n]\nlength=%lld\nfnv64=%llx\n",
+                        stored_key, &stored_length, &stored_hash);
+    fclose(f);
+
+    if (fields != 3 || stored_length != length || strcmp(stored_key, source_key) != 0) {
+        return 0;
+    }
+
+    int fd = open(dest_path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return 0;
+    }
+
+    struct stat st;
+    unsigned long long hash = 0;
+    int ok = fstat(fd, &st) == 0 &&
+             fingerprint_file(fd, st.st_size, &hash) == 0 && hash == stored_hash;
+    close(fd);
+
+    return ok;
+}
+
+/**
+ * Write the stamp file atomically
+ */
+static int write_stamp(const char* stamp_path, const char* source_key,
+                       off64_t length, unsigned long long hash) {
+    char tmp_path[1024];
+    if (snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", stamp_path) >= (int)sizeof(tmp_path)) {
+        return -ENAMETOOLONG;
+    }
+
+    FILE* f = fopen(tmp_path, "w");
+    if (f == NULL) {
+        return -errno;
+    }
+    fprintf(f, "source=%s\nlength=%lld\nfnv64=%016llx\n", source_key, (long long)length, hash);
+    if (fflush(f) != 0 || fsync(fileno(f)) != 0) {
+        int err = -errno;
+        fclose(f);
+        unlink(tmp_path);
+        return err;
+    }
+    fclose(f);
+
+    if (rename(tmp_path, stamp_path) != 0) {
+        int err = -errno;
+        unlink(tmp_path);
+        return err;
+    }
+    return 0;
+}
+
+/**
+ * Copy length bytes from in_fd (starting at in_off) to the start of out_fd.
+ * Tries copy_file_range first, then sendfile, then a large aligned buffer,
+ * falling back whenever the kernel or filesystem rejects the faster path.
+ */
+static int copy_fd_range(int in_fd, off64_t in_off, int out_fd, off64_t length, CopyMethod* method,
+                         progress_fn progress, void* progress_ctx) {
+    off64_t done = 0;
+    char* buf = NULL;
+
+    *method = COPY_FILE_RANGE;
+#ifndef __NR_copy_file_range
+    *method = COPY_SENDFILE;
+#endif
+
+    while (done < length) {
+        size_t want = (length - done) < COPY_CHUNK ? (size_t)(length - done) : COPY_CHUNK;
+        ssize_t n;
+
+        if (*method == COPY_FILE_RANGE) {
+#ifdef __NR_copy_file_range
+            loff_t src = in_off + done;
+            loff_t dst = done;
+            n = syscall(__NR_copy_file_range, in_fd, &src, out_fd, &dst, want, 0);
+            if (n < 0 && (errno == ENOSYS || errno == EXDEV || errno == EINVAL ||
+                          errno == EOPNOTSUPP || errno == EPERM)) {
+                LOGD("copy_file_range unavailable (%s), trying sendfile", strerror(errno));
+                *method = COPY_SENDFILE;
+                continue;
+            }
+#endif
+        } else if (*method == COPY_SENDFILE) {
+            off64_t src = in_off + done;
+            if (lseek64(out_fd, done, SEEK_SET) < 0) {
+                return -errno;
+            }
+            n = sendfile64(out_fd, in_fd, &src, want);
+            if (n < 0 && (errno == EINVAL || errno == ENOSYS)) {
+                LOGD("sendfile unavailable (%s), using buffered copy", strerror(errno));
+                *method = COPY_BUFFERED;
+                continue;
+            }
+        } else {
+            if (buf == NULL && posix_memalign((void**)&buf, BUFFER_ALIGN, BUFFER_SIZE) != 0) {
+                return -ENOMEM;
+            }
+            if (want > BUFFER_SIZE) {
+                want = BUFFER_SIZE;
+            }
+            n = pread64(in_fd, buf, want, in_off + done);
+            if (n > 0) {
+                int err = pwrite_full(out_fd, buf, (size_t)n, done);
+                if (err < 0) {
+                    free(buf);
+                    return err;
+                }
+            }
+        }
+
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            int err = -errno;
+            free(buf);
+            return err;
+        }
+        if (n == 0) {
+            free(buf);
+            return -EIO; // Asset shorter than advertised
+        }
+        done += n;
+        if (progress != NULL) {
+            progress(progress_ctx, done, length);
+        }
+    }
+
+    free(buf);
+    return 0;
+}
+
+/**
+ * Copy a compressed asset through AAsset_read with a large buffer
+ */
+static int copy_streaming(AAsset* asset, int out_fd, off64_t length,
+                          progress_fn progress, void* progress_ctx) {
+    char* buf = NULL;
+    if (posix_memalign((void**)&buf, BUFFER_ALIGN, BUFFER_SIZE) != 0) {
+        return -ENOMEM;
+    }
+
+    off64_t done = 0;
+    while (done < length) {
+        int n = AAsset_read(asset, buf, BUFFER_SIZE);
+        if (n <= 0) {
+            free(buf);
+            return -EIO; // Read error or asset shorter than advertised
+        }
+        int err = pwrite_full(out_fd, buf, (size_t)n, done);
+        if (err < 0) {
+            free(buf);
+            return err;
+        }
+        done += n;
+        if (progress != NULL) {
+            progress(progress_ctx, done, length);
+        }
+    }
+
+    free(buf);
+    return 0;
+}
+
+/**
+ * fsync the directory holding path so the rename is durable
+ */
+static void sync_parent_dir(const char* path) {
+    char dir[1024];
+    strncpy(dir, path, sizeof(dir) - 1);
+    dir[sizeof(dir) - 1] = '\0';
+
+    int fd = open(dirname(dir), O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd >= 0) {
+        fsync(fd);
+        close(fd);
+    }
+}
+
+int extract_asset(AAssetManager* mgr, const char* asset_name,
+                  const char* dest_path, const char* source_key,
+                  progress_fn progress, void* progress_ctx) {
+    long start_ms = get_current_time_ms();
+
+    // Assets may ship BGZF-compressed as <name>.gz
+    char gz_name[512];
+    int compressed = 0;
+    AAsset* asset = AAssetManager_open(mgr, asset_name, AASSET_MODE_STREAMING);
+    if (asset == NULL) {
+        snprintf(gz_name, sizeof(gz_name), "%s.gz", asset_name);
+        asset = AAssetManager_open(mgr, gz_name, AASSET_MODE_STREAMING);
+        compressed = 1;
+    }
+    if (asset == NULL) {
+        LOGE("Asset not found: %s", asset_name);
+        return -ENOENT;
+    }
+    off64_t length = AAsset_getLength64(asset);
+
+    char stamp_path[1024];
+    char tmp_path[1024];
+    if (snprintf(stamp_path, sizeof(stamp_path), "%s.stamp", dest_path) >= (int)sizeof(stamp_path) ||
+        snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", dest_path) >= (int)sizeof(tmp_path)) {
+        LOGE("Destination path too long: %s", dest_path);
+        AAsset_close(asset);
+        return -ENAMETOOLONG;
+    }
+
+    if (is_up_to_date(dest_path, stamp_path, source_key, length)) {
+        AAsset_close(asset);
+        LOGI("%s up to date, skipped (%ld ms)", asset_name, get_current_time_ms() - start_ms);
+        return EXTRACT_SKIPPED;
+    }
+
+    // Invalidate the stamp first so an interrupted copy is never trusted
+    unlink(stamp_path);
+
+    int out_fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out_fd < 0) {
+        int err = -errno;
+        LOGE("Failed to create %s: %s", tmp_path, strerror(errno));
+        AAsset_close(asset);
+        return err;
+    }
+
+    // Reserve space up front: fails fast on a full disk and avoids fragmentation.
+    // Compressed assets are left sparse instead, so zero blocks stay holes.
+    if (!compressed && length > 0 && fallocate64(out_fd, 0, 0, length) != 0 &&
+        errno != EOPNOTSUPP && errno != ENOSYS) {
+        int err = -errno;
+        LOGE("fallocate %lld bytes failed: %s", (long long)length, strerror(errno));
+        close(out_fd);
+        unlink(tmp_path);
+        AAsset_close(asset);
+        return err;
+    }
+
+    // Uncompressed assets expose the APK fd, which lets the kernel do the copy
+    CopyMethod method = COPY_STREAMING;
+    off64_t asset_start = 0;
+    off64_t asset_length = 0;
+    off64_t out_length = length;
+    int err = 0;
+    int in_fd = AAsset_openFileDescriptor64(asset, &asset_start, &asset_length);
+    if (compressed) {
+        if (in_fd >= 0) {
+            out_length = decompress_gzip_fd(in_fd, asset_start, asset_length, out_fd,
+                                            progress, progress_ctx);
+            err = out_length < 0 ? (int)out_length : 0;
+        } else {
+            LOGE("%s is stored compressed in the APK; add it to noCompress", gz_name);
+            err = -EOPNOTSUPP;
+        }
+    } else if (in_fd >= 0) {
+        err = copy_fd_range(in_fd, asset_start, out_fd, asset_length, &method,
+                            progress, progress_ctx);
+    } else {
+        err = copy_streaming(asset, out_fd, length, progress, progress_ctx);
+    }
+    if (in_fd >= 0) {
+        close(in_fd);
+    }
+    AAsset_close(asset);
+
+    unsigned long long hash = 0;
+    if (err == 0 && fsync(out_fd) != 0) {
+        err = -errno;
+    }
+    if (err == 0) {
+        err = fingerprint_file(out_fd, out_length, &hash);
+    }
+    close(out_fd);
+
+    if (err == 0 && rename(tmp_path, dest_path) != 0) {
+        err = -errno;
+    }
+    if (err < 0) {
+        LOGE("Extracting %s failed: %s", asset_name, strerror(-err));
+        unlink(tmp_path);
+        return err;
+    }
+    sync_parent_dir(dest_path);
+
+    err = write_stamp(stamp_path, source_key, length, hash);
+    if (err < 0) {
+        LOGE("Failed to write stamp for %s: %s", asset_name, strerror(-err));
+    }
+
+    long elapsed_ms = get_current_time_ms() - start_ms;
+    LOGI("Extracted %s: %lld bytes in %ld ms (%.1f MB/s, %s)",
+         asset_name, (long long)out_length, elapsed_ms,
+         elapsed_ms > 0 ? (out_length / (1024.0 * 1024.0)) / (elapsed_ms / 1000.0) : 0.0,
+         compressed ? "decompress" : copy_method_name(method));
+
+    return EXTRACT_COPIED;
+}
+
+/**
+ * Extract an asset from the APK
+ * Returns: 0 = copied, 1 = already up to date, < 0 = -errno
+ */
+JNIEXPORT jint JNICALL
+Java_com_dockerandroid_app_utils_FileUtils_nativeExtractAsset(
+    JNIEnv *env,
+    jclass clazz,
+    jobject asset_manager,
+    jstring asset_name,
+    jstring dest_path,
+    jstring source_key,
+    jobject listener
+) {
+    (void)clazz;
+    AAssetManager* mgr = AAssetManager_fromJava(env, asset_manager);
+    if (mgr == NULL) {
+        LOGE("Invalid asset manager");
+        return -EINVAL;
+    }
+
+    const char* name = (*env)->GetStringUTFChars(env, asset_name, NULL);
+    const char* dest = (*env)->GetStringUTFChars(env, dest_path, NULL);
+    const char* key = (*env)->GetStringUTFChars(env, source_key, NULL);
+
+    JniProgress progress;
+    progress_fn progress_cb = init_jni_progress(env, listener, &progress);
+
+    int result = extract_asset(mgr, name, dest, key, progress_cb, &progress);
+
+    (*env)->ReleaseStringUTFChars(env, asset_name, name);
+    (*env)->ReleaseStringUTFChars(env, dest_path, dest);
+    (*env)->ReleaseStringUTFChars(env, source_key, key);
+
+    return result;
+}
+
+/**
+ * Decompress a gzip/BGZF file
+ * Returns: 0 = success, < 0 = -errno
+ */
+JNIEXPORT jint JNICALL
+Java_com_dockerandroid_app_utils_FileUtils_nativeDecompressFile(
+    JNIEnv *env,
+    jclass clazz,
+    jstring src_path,
+    jstring dest_path,
+    jobject listener
+) {
+    (void)clazz;
+    const char* src = (*env)->GetStringUTFChars(env, src_path, NULL);
+    const char* dest = (*env)->GetStringUTFChars(env, dest_path, NULL);
+
+    JniProgress progress;
+    progress_fn progress_cb = init_jni_progress(env, listener, &progress);
+
+    int result = decompress_file(src, dest, progress_cb, &progress);
+
+    (*env)->ReleaseStringUTFChars(env, src_path, src);
+    (*env)->ReleaseStringUTFChars(env, dest_path, dest);
+
+    return result;
+}
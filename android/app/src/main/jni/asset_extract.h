@@ -0,0 +1,28 @@
+/**
+ * Asset Extractor
+ * Copies large APK assets (Alpine ISO, disk images) into app storage
+ */
+
+#ifndef ASSET_EXTRACT_H
+#define ASSET_EXTRACT_H
+
+#include <android/asset_manager.h>
+
+#include "decompress.h"
+
+// Result codes returned by extract_asset()
+#define EXTRACT_COPIED   0
+#define EXTRACT_SKIPPED  1
+
+/**
+ * Extract an asset to dest_path atomically (temp file + rename).
+ * If asset_name is missing, asset_name.gz is decompressed in its place.
+ * source_key identifies the APK build the asset came from; the copy is
+ * skipped when dest_path and its stamp file already match it.
+ * Returns EXTRACT_COPIED, EXTRACT_SKIPPED or a negative errno.
+ */
+int extract_asset(AAssetManager* mgr, const char* asset_name,
+                  const char* dest_path, const char* source_key,
+                  progress_fn progress, void* progress_ctx);
+
+#endif // ASSET_EXTRACT_H
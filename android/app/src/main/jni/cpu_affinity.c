@@ -0,0 +1,160 @@
+/**
+ * CPU Affinity JNI
+ * Finds the performance and efficiency cores of a big.LITTLE SoC and pins
+ * QEMU vCPU threads to them: the big cores for speed, the little ones
+ * when PowerGovernor trades speed for battery and heat
+ */
+
+#define _GNU_SOURCE
+#include <jni.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/types.h>
+#include <android/log.h>
+
+#define TAG "CpuAffinity"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+#define MAX_CPUS 32
+
+/**
+ * Read the scheduler capacity of a CPU (1024 = fastest core in the system)
+ * Returns: capacity, -1 if the kernel does not report one
+ */
+static int read_cpu_capacity(int cpu) {
+    char path[128];
+    snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%d/cpu_capacity", cpu);
+
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    int capacity = -1;
+    if (fscanf(f, "%d", &capacity) != 1) {
+        capacity = -1;
+    }
+    fclose(f);
+    return capacity;
+}
+
+/**
+ * Find the performance cores: every CPU whose capacity is above the
+ * midpoint between the slowest and the fastest core. On tri-cluster SoCs
+ * this keeps the prime and the mid cores and drops the little ones.
+ * With performance = 0 the remaining (efficiency) cores are returned.
+ * Returns: number of cores written to cpus, 0 if all cores are equal or
+ * capacities are unknown
+ */
+static int find_cores(int* cpus, int max_cpus, int performance) {
+    int capacity[MAX_CPUS];
+    int count = 0;
+    int min_capacity = -1;
+    int max_capacity = -1;
+
+    for (int cpu = 0; cpu < MAX_CPUS; cpu++) {
+        capacity[cpu] = read_cpu_capacity(cpu);
+        if (capacity[cpu] < 0) {
+            continue;
+        }
+        if (min_capacity < 0 || capacity[cpu] < min_capacity) {
+            min_capacity = capacity[cpu];
+        }
+        if (capacity[cpu] > max_capacity) {
+            max_capacity = capacity[cpu];
+        }
+    }
+
+    if (max_capacity <= 0 || min_capacity == max_capacity) {
+        return 0;
+    }
+
+    int threshold = (min_capacity + max_capacity) / 2;
+    for (int cpu = 0; cpu < MAX_CPUS && count < max_cpus; cpu++) {
+        if (capacity[cpu] < 0) {
+            continue;
+        }
+        if ((capacity[cpu] > threshold) == (performance != 0)) {
+            cpus[count++] = cpu;
+        }
+    }
+    return count;
+}
+
+/**
+ * Get the performance cores of this device
+ * Returns: CPU numbers, empty when the SoC is not heterogeneous
+ */
+JNIEXPORT jintArray JNICALL
+Java_com_dockerandroid_app_qemu_VcpuPlacement_nativeGetPerformanceCores(
+    JNIEnv *env,
+    jclass clazz
+) {
+    (void)clazz;
+    jint cpus[MAX_CPUS];
+    int count = find_cores((int*)cpus, MAX_CPUS, 1);
+
+    jintArray result = (*env)->NewIntArray(env, count);
+    if (result != NULL && count > 0) {
+        (*env)->SetIntArrayRegion(env, result, 0, count, cpus);
+    }
+    return result;
+}
+
+/**
+ * Get the efficiency (little) cores of this device
+ * Returns: CPU numbers, empty when the SoC is not heterogeneous
+ */
+JNIEXPORT jintArray JNICALL
+Java_com_dockerandroid_app_qemu_VcpuPlacement_nativeGetEfficiencyCores(
+    JNIEnv *env,
+    jclass clazz
+) {
+    (void)clazz;
+    jint cpus[MAX_CPUS];
+    int count = find_cores((int*)cpus, MAX_CPUS, 0);
+
+    jintArray result = (*env)->NewIntArray(env, count);
+    if (result != NULL && count > 0) {
+        (*env)->SetIntArrayRegion(env, result, 0, count, cpus);
+    }
+    return result;
+}
+
+/**
+ * Restrict a thread (of this or a child process) to a set of CPUs
+ * Returns: 0 = success, < 0 = -errno
+ */
+JNIEXPORT jint JNICALL
+Java_com_dockerandroid_app_qemu_VcpuPlacement_nativeSetThreadAffinity(
+    JNIEnv *env,
+    jclass clazz,
+    jint tid,
+    jintArray cpus
+) {
+    (void)clazz;
+    jint values[MAX_CPUS];
+    jsize count = (*env)->GetArrayLength(env, cpus);
+    if (count > MAX_CPUS) {
+        count = MAX_CPUS;
+    }
+    (*env)->GetIntArrayRegion(env, cpus, 0, count, values);
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (jsize i = 0; i < count; i++) {
+        if (values[i] >= 0 && values[i] < CPU_SETSIZE) {
+            CPU_SET(values[i], &set);
+        }
+    }
+
+    if (sched_setaffinity((pid_t)tid, sizeof(set), &set) < 0) {
+        int err = errno;
+        LOGE("sched_setaffinity(%d) failed: %s", tid, strerror(err));
+        return -err;
+    }
+    return 0;
+}
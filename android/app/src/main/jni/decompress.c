@@ -0,0 +1,430 @@
+/**
+ * Parallel Decompressor
+ * Multithreaded BGZF inflate with zero-block skipping
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <android/log.h>
+
+#include "decompress.h"
+#include "io_util.h"
+
+#define TAG "Decompress"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
+
+#define BGZF_MAX_BLOCK     65536            // BSIZE is a 16-bit field
+#define GZIP_HEADER_SIZE   12               // fixed header up to and including XLEN
+#define GZIP_TRAILER_SIZE  8                // CRC32 + ISIZE
+#define ZERO_GRANULE       65536            // smallest run left as a hole
+#define STREAM_BUFFER      (1024 * 1024)    // plain gzip input/output buffers
+#define MAX_WORKERS        8
+#define PROGRESS_INTERVAL_US 100000
+
+typedef struct {
+    off64_t in_off;
+    off64_t out_off;
+    uint32_t in_size;
+    uint32_t out_size;
+} BgzfBlock;
+
+typedef struct {
+    int in_fd;
+    int out_fd;
+    const BgzfBlock* blocks;
+    size_t count;
+    atomic_size_t next;
+    atomic_llong bytes_done;
+    atomic_int error;
+    atomic_int finished;
+} BgzfJob;
+
+static uint16_t read_le16(const unsigned char* p) {
+    return (uint16_t)(p[0] | (p[1] << 8));
+}
+
+static uint32_t read_le32(const unsigned char* p) {
+    return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+/**
+ * Write buf at offset, leaving ZERO_GRANULE-aligned zero runs unwritten
+ */
+static int pwrite_sparse(int fd, const unsigned char* buf, size_t len, off64_t offset) {
+    size_t pos = 0;
+    while (pos < len) {
+        size_t n = len - pos < ZERO_GRANULE ? len - pos : ZERO_GRANULE;
+        if (!is_zero(buf + pos, n)) {
+            int err = pwrite_full(fd, buf + pos, n, offset + pos);
+            if (err < 0) {
+                return err;
+            }
+        }
+        pos += n;
+    }
+    return 0;
+}
+
+/**
+ * Return the BGZF block size (BSIZE + 1) if header is a BGZF member, else 0
+ */
+static uint32_t bgzf_block_size(const unsigned char* header, size_t len) {
+    if (len < GZIP_HEADER_SIZE || header[0] != 0x1f || header[1] != 0x8b ||
+        header[2] != 8 || !(header[3] & 0x04)) {
+        return 0;
+    }
+
+    uint16_t xlen = read_le16(header + 10);
+    const unsigned char* extra = header + GZIP_HEADER_SIZE;
+    size_t pos = 0;
+    while (pos + 4 <= (size_t)xlen && GZIP_HEADER_SIZE + pos + 4 <= len) {
+        uint16_t slen = read_le16(extra + pos + 2);
+        if (extra[pos] == 'B' && extra[pos + 1] == 'C' && slen == 2 &&
+            GZIP_HEADER_SIZE + pos + 6 <= len) {
+            return (uint32_t)read_le16(extra + pos + 4) + 1;
+        }
+        pos += 4 + slen;
+    }
+    return 0;
+}
+
+/**
+ * Walk the BGZF member headers and trailers to build the block index.
+ * Returns the number of blocks, 0 if the input is not BGZF, or a negative errno.
+ */
+static ssize_t bgzf_index(int fd, off64_t in_off, off64_t in_len, BgzfBlock** out_blocks,
+                          off64_t* out_total) {
+    unsigned char header[GZIP_HEADER_SIZE + 64];
+    size_t capacity = 1024;
+    size_t count = 0;
+    off64_t pos = 0;
+    off64_t total = 0;
+
+    BgzfBlock* blocks = (BgzfBlock*)malloc(capacity * sizeof(BgzfBlock));
+    if (blocks == NULL) {
+        return -ENOMEM;
+    }
+
+    while (pos < in_len) {
+        size_t want = (in_len - pos) < (off64_t)sizeof(header) ? (size_t)(in_len - pos) : sizeof(header);
+        int err = pread_full(fd, header, want, in_off + pos);
+        uint32_t size = err == 0 ? bgzf_block_size(header, want) : 0;
+        if (err < 0 || size == 0 || size > in_len - pos ||
+            size < GZIP_HEADER_SIZE + GZIP_TRAILER_SIZE) {
+            free(blocks);
+            // A bad first header just means this is plain gzip
+            return count == 0 && err == 0 ? 0 : (err < 0 ? err : -EBADMSG);
+        }
+
+        unsigned char trailer[4];
+        err = pread_full(fd, trailer, sizeof(trailer), in_off + pos + size - 4);
+        if (err < 0) {
+            free(blocks);
+            return err;
+        }
+
+        if (count == capacity) {
+            capacity *= 2;
+            BgzfBlock* grown = (BgzfBlock*)realloc(blocks, capacity * sizeof(BgzfBlock));
+            if (grown == NULL) {
+                free(blocks);
+                return -ENOMEM;
+            }
+            blocks = grown;
+        }
+
+        blocks[count].in_off = in_off + pos;
+        blocks[count].in_size = size;
+        blocks[count].out_off = total;
+        blocks[count].out_size = read_le32(trailer);
+        if (blocks[count].out_size > BGZF_MAX_BLOCK) {
+            free(blocks);
+            return -EBADMSG;
+        }
+
+        total += blocks[count].out_size;
+        pos += size;
+        count++;
+    }
+
+    *out_blocks = blocks;
+    *out_total = total;
+    return (ssize_t)count;
+}
+
+/**
+ * Worker: claim blocks in order, inflate and write them at their final offset
+ */
+static void* bgzf_worker(void* arg) {
+    BgzfJob* job = (BgzfJob*)arg;
+    unsigned char* in_buf = (unsigned char*)malloc(BGZF_MAX_BLOCK);
+    unsigned char* out_buf = (unsigned char*)malloc(BGZF_MAX_BLOCK);
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    if (in_buf == NULL || out_buf == NULL || inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+        atomic_store(&job->error, -ENOMEM);
+        free(in_buf);
+        free(out_buf);
+        atomic_fetch_add(&job->finished, 1);
+        return NULL;
+    }
+
+    while (atomic_load(&job->error) == 0) {
+        size_t index = atomic_fetch_add(&job->next, 1);
+        if (index >= job->count) {
+            break;
+        }
+        const BgzfBlock* block = &job->blocks[index];
+
+        int err = pread_full(job->in_fd, in_buf, block->in_size, block->in_off);
+        if (err < 0) {
+            atomic_store(&job->error, err);
+            break;
+        }
+
+        uint32_t header_len = GZIP_HEADER_SIZE + read_le16(in_buf + 10);
+        inflateReset(&zs);
+        zs.next_in = in_buf + header_len;
+        zs.avail_in = block->in_size - header_len - GZIP_TRAILER_SIZE;
+        zs.next_out = out_buf;
+        zs.avail_out = BGZF_MAX_BLOCK;
+
+        int ret = inflate(&zs, Z_FINISH);
+        uint32_t expected_crc = read_le32(in_buf + block->in_size - GZIP_TRAILER_SIZE);
+        if (ret != Z_STREAM_END || zs.total_out != (uLong)block->out_size ||
+            crc32(0L, out_buf, block->out_size) != (uLong)expected_crc) {
+            LOGE("Corrupt BGZF block %zu at offset %lld", index, (long long)block->in_off);
+            atomic_store(&job->error, -EBADMSG);
+            break;
+        }
+
+        if (!is_zero(out_buf, block->out_size)) {
+            err = pwrite_full(job->out_fd, out_buf, block->out_size, block->out_off);
+            if (err < 0) {
+                atomic_store(&job->error, err);
+                break;
+            }
+        }
+        atomic_fetch_add(&job->bytes_done, block->in_size);
+    }
+
+    inflateEnd(&zs);
+    free(in_buf);
+    free(out_buf);
+    atomic_fetch_add(&job->finished, 1);
+    return NULL;
+}
+
+/**
+ * Inflate an indexed BGZF stream across a pool of worker threads.
+ * Progress counts compressed bytes against in_len, like the stream path.
+ */
+static off64_t decompress_bgzf(int in_fd, int out_fd, const BgzfBlock* blocks, size_t count,
+                               off64_t total, off64_t in_len,
+                               progress_fn progress, void* progress_ctx) {
+    BgzfJob job;
+    memset(&job, 0, sizeof(job));
+    job.in_fd = in_fd;
+    job.out_fd = out_fd;
+    job.blocks = blocks;
+    job.count = count;
+
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cpus > MAX_WORKERS ? MAX_WORKERS : (cpus < 1 ? 1 : (int)cpus);
+    pthread_t threads[MAX_WORKERS];
+    int started = 0;
+
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&threads[i], NULL, bgzf_worker, &job) != 0) {
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        return -EAGAIN;
+    }
+
+    while (atomic_load(&job.finished) < started) {
+        usleep(PROGRESS_INTERVAL_US);
+        if (progress != NULL) {
+            progress(progress_ctx, atomic_load(&job.bytes_done), in_len);
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    LOGD("Inflated %zu BGZF blocks on %d threads", count, started);
+    int err = atomic_load(&job.error);
+    return err < 0 ? err : total;
+}
+
+/**
+ * Inflate a plain (possibly multi-member) gzip stream on the calling thread
+ */
+static off64_t decompress_stream(int in_fd, off64_t in_off, off64_t in_len, int out_fd,
+                                 progress_fn progress, void* progress_ctx) {
+    unsigned char* in_buf = (unsigned char*)malloc(STREAM_BUFFER);
+    unsigned char* out_buf = (unsigned char*)malloc(STREAM_BUFFER);
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+
+    if (in_buf == NULL || out_buf == NULL || inflateInit2(&zs, 16 + MAX_WBITS) != Z_OK) {
+        free(in_buf);
+        free(out_buf);
+        return -ENOMEM;
+    }
+
+    off64_t consumed = 0;
+    off64_t written = 0;
+    long last_report = 0;
+    int ret = Z_OK;
+    int pending = 0;
+    int err = 0;
+
+    while (err == 0) {
+        if (zs.avail_in == 0 && !pending) {
+            if (consumed >= in_len) {
+                break;
+            }
+            size_t want = (in_len - consumed) < STREAM_BUFFER ? (size_t)(in_len - consumed) : STREAM_BUFFER;
+            err = pread_full(in_fd, in_buf, want, in_off + consumed);
+            consumed += want;
+            zs.next_in = in_buf;
+            zs.avail_in = (uInt)want;
+            continue;
+        }
+
+        zs.next_out = out_buf;
+        zs.avail_out = STREAM_BUFFER;
+        ret = inflate(&zs, Z_NO_FLUSH);
+        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR) {
+            err = -EBADMSG;
+            break;
+        }
+
+        // A full output buffer may leave more output buffered inside zlib
+        pending = zs.avail_out == 0;
+        size_t produced = STREAM_BUFFER - zs.avail_out;
+        err = pwrite_sparse(out_fd, out_buf, produced, written);
+        written += produced;
+
+        // Concatenated members: start over on the next header
+        if (ret == Z_STREAM_END && (zs.avail_in > 0 || consumed < in_len)) {
+            inflateReset(&zs);
+        }
+
+        long now = get_current_time_ms();
+        if (progress != NULL && now - last_report >= PROGRESS_INTERVAL_US / 1000) {
+            progress(progress_ctx, consumed, in_len);
+            last_report = now;
+        }
+    }
+
+    inflateEnd(&zs);
+    free(in_buf);
+    free(out_buf);
+
+    if (err == 0 && ret != Z_STREAM_END) {
+        err = -EBADMSG; // Truncated stream
+    }
+    return err < 0 ? err : written;
+}
+
+off64_t decompress_gzip_fd(int in_fd, off64_t in_off, off64_t in_len, int out_fd,
+                           progress_fn progress, void* progress_ctx) {
+    long start_ms = get_current_time_ms();
+    BgzfBlock* blocks = NULL;
+    off64_t total = 0;
+    off64_t result;
+
+    ssize_t count = bgzf_index(in_fd, in_off, in_len, &blocks, &total);
+    if (count < 0) {
+        return count;
+    }
+
+    if (count > 0) {
+        // Size the file first: skipped zero blocks become holes
+        if (ftruncate64(out_fd, total) != 0) {
+            free(blocks);
+            return -errno;
+        }
+        result = decompress_bgzf(in_fd, out_fd, blocks, (size_t)count, total, in_len,
+                                 progress, progress_ctx);
+        free(blocks);
+    } else {
+        result = decompress_stream(in_fd, in_off, in_len, out_fd, progress, progress_ctx);
+        if (result >= 0 && ftruncate64(out_fd, result) != 0) {
+            result = -errno;
+        }
+    }
+
+    if (result >= 0) {
+        if (progress != NULL) {
+            progress(progress_ctx, in_len, in_len);
+        }
+        long elapsed_ms = get_current_time_ms() - start_ms;
+        LOGI("Decompressed %lld -> %lld bytes in %ld ms (%s)",
+             (long long)in_len, (long long)result, elapsed_ms, count > 0 ? "bgzf" : "gzip");
+    }
+    return result;
+}
+
+int decompress_file(const char* src_path, const char* dest_path,
+                    progress_fn progress, void* progress_ctx) {
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", dest_path);
+
+    int in_fd = open(src_path, O_RDONLY | O_CLOEXEC);
+    if (in_fd < 0) {
+        LOGE("Failed to open %s: %s", src_path, strerror(errno));
+        return -errno;
+    }
+
+    struct stat st;
+    if (fstat(in_fd, &st) != 0) {
+        int err = -errno;
+        close(in_fd);
+        return err;
+    }
+
+    int out_fd = open(tmp_path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (out_fd < 0) {
+        int err = -errno;
+        LOGE("Failed to create %s: %s", tmp_path, strerror(errno));
+        close(in_fd);
+        return err;
+    }
+
+    off64_t result = decompress_gzip_fd(in_fd, 0, st.st_size, out_fd, progress, progress_ctx);
+    close(in_fd);
+
+    int err = result < 0 ? (int)result : 0;
+    if (err == 0 && fsync(out_fd) != 0) {
+        err = -errno;
+    }
+    close(out_fd);
+
+    if (err == 0 && rename(tmp_path, dest_path) != 0) {
+        err = -errno;
+    }
+    if (err < 0) {
+        LOGE("Decompressing %s failed: %s", src_path, strerror(-err));
+        unlink(tmp_path);
+    }
+    return err;
+}
@@ -0,0 +1,34 @@
+/**
+ * Parallel Decompressor
+ * Inflates gzip/BGZF VM assets straight into sparse output files
+ */
+
+#ifndef DECOMPRESS_H
+#define DECOMPRESS_H
+
+#include <sys/types.h>
+
+/**
+ * Progress callback, always invoked on the calling thread
+ */
+typedef void (*progress_fn)(void* ctx, long long done, long long total);
+
+/**
+ * Decompress in_len bytes of gzip data at in_off of in_fd into out_fd.
+ * BGZF input (bgzip output: independent members carrying their size) is
+ * inflated by a pool of worker threads; any other gzip stream is inflated
+ * on the calling thread. All-zero blocks are left as holes in out_fd, which
+ * must be empty. Progress reports compressed bytes consumed out of in_len.
+ * Returns the uncompressed size or a negative errno.
+ */
+off64_t decompress_gzip_fd(int in_fd, off64_t in_off, off64_t in_len, int out_fd,
+                           progress_fn progress, void* progress_ctx);
+
+/**
+ * Decompress src_path into dest_path atomically (temp file + rename).
+ * Returns 0 or a negative errno.
+ */
+int decompress_file(const char* src_path, const char* dest_path,
+                    progress_fn progress, void* progress_ctx);
+
+#endif // DECOMPRESS_H
@@ -0,0 +1,152 @@
+/**
+ * Disk Layers JNI
+ * Native qcow2 operations behind DiskManager: overlay creation,
+ * compaction and committing overlays into the base image
+ */
+
+#define _GNU_SOURCE
+#include <jni.h>
+#include <errno.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <android/log.h>
+
+#include "qcow2.h"
+#include "jni_progress.h"
+
+#define TAG "DiskLayers"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+// I/O scheduling classes from linux/ioprio.h
+#define IOPRIO_CLASS_SHIFT      13
+#define IOPRIO_CLASS_IDLE       3
+#define IOPRIO_WHO_PROCESS      1
+#define IOPRIO_PRIO_VALUE(class, data) (((class) << IOPRIO_CLASS_SHIFT) | (data))
+
+/**
+ * Create an empty qcow2 image, optionally on top of a backing file
+ * Returns: 0 = success, < 0 = -errno
+ */
+JNIEXPORT jint JNICALL
+Java_com_dockerandroid_app_qemu_DiskManager_nativeCreateImage(
+    JNIEnv *env,
+    jclass clazz,
+    jstring image_path,
+    jlong size_bytes,
+    jstring backing_path,
+    jstring backing_format
+) {
+    (void)clazz;
+    const char* path = (*env)->GetStringUTFChars(env, image_path, NULL);
+    const char* backing = backing_path != NULL ? (*env)->GetStringUTFChars(env, backing_path, NULL) : NULL;
+    const char* fmt = backing_format != NULL ? (*env)->GetStringUTFChars(env, backing_format, NULL) : NULL;
+
+    int result = qcow2_create(path, (uint64_t)size_bytes, backing, fmt != NULL ? fmt : "qcow2");
+    if (result == 0) {
+        LOGI("Created %s (%lld bytes%s%s)", path, (long long)size_bytes,
+             backing != NULL ? ", backing " : "", backing != NULL ? backing : "");
+    }
+
+    (*env)->ReleaseStringUTFChars(env, image_path, path);
+    if (backing != NULL) {
+        (*env)->ReleaseStringUTFChars(env, backing_path, backing);
+    }
+    if (fmt != NULL) {
+        (*env)->ReleaseStringUTFChars(env, backing_format, fmt);
+    }
+
+    return result;
+}
+
+/**
+ * Get the virtual size of an image
+ * Returns: size in bytes, < 0 = -errno
+ */
+JNIEXPORT jlong JNICALL
+Java_com_dockerandroid_app_qemu_DiskManager_nativeGetVirtualSize(
+    JNIEnv *env,
+    jclass clazz,
+    jstring image_path
+) {
+    (void)clazz;
+    const char* path = (*env)->GetStringUTFChars(env, image_path, NULL);
+
+    Qcow2Image* img = NULL;
+    int err = qcow2_open(path, &img);
+    jlong result = err < 0 ? err : (jlong)qcow2_virtual_size(img);
+    qcow2_close(img);
+
+    (*env)->ReleaseStringUTFChars(env, image_path, path);
+    return result;
+}
+
+/**
+ * Rewrite an image into dest_path: keep_backing compacts the top layer,
+ * otherwise the whole chain is flattened. stats receives
+ * {bytesBefore, bytesAfter} when not null.
+ * Returns: 0 = success, < 0 = -errno
+ */
+JNIEXPORT jint JNICALL
+Java_com_dockerandroid_app_qemu_DiskManager_nativeRewriteImage(
+    JNIEnv *env,
+    jclass clazz,
+    jstring src_path,
+    jstring dest_path,
+    jboolean keep_backing,
+    jlongArray stats,
+    jobject listener
+) {
+    (void)clazz;
+    const char* src = (*env)->GetStringUTFChars(env, src_path, NULL);
+    const char* dest = (*env)->GetStringUTFChars(env, dest_path, NULL);
+
+    JniProgress progress;
+    progress_fn progress_cb = init_jni_progress(env, listener, &progress);
+
+    Qcow2RewriteStats result_stats;
+    memset(&result_stats, 0, sizeof(result_stats));
+    int result = qcow2_rewrite(src, dest, keep_backing ? 1 : 0, progress_cb, &progress, &result_stats);
+
+    if (result == 0 && stats != NULL && (*env)->GetArrayLength(env, stats) >= 2) {
+        jlong values[2] = { result_stats.bytes_before, result_stats.bytes_after };
+        (*env)->SetLongArrayRegion(env, stats, 0, 2, values);
+    }
+
+    (*env)->ReleaseStringUTFChars(env, src_path, src);
+    (*env)->ReleaseStringUTFChars(env, dest_path, dest);
+
+    return result;
+}
+
+/**
+ * Compact an image into dest_path at idle I/O priority so the rewrite
+ * never competes with the UI or a running VM for storage bandwidth.
+ * Zero and unallocated clusters are dropped, the backing file is kept.
+ * stats receives {bytesBefore, bytesAfter}.
+ * Returns: 0 = success, < 0 = -errno
+ */
+JNIEXPORT jint JNICALL
+Java_com_dockerandroid_app_qemu_DiskManager_nativeCompactImage(
+    JNIEnv *env,
+    jclass clazz,
+    jstring src_path,
+    jstring dest_path,
+    jlongArray stats,
+    jobject listener
+) {
+    // ioprio applies to the calling thread only
+    int old_prio = (int)syscall(SYS_ioprio_get, IOPRIO_WHO_PROCESS, 0);
+    if (syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, IOPRIO_PRIO_VALUE(IOPRIO_CLASS_IDLE, 0)) != 0) {
+        LOGE("ioprio_set failed: %s", strerror(errno));
+    }
+
+    jint result = Java_com_dockerandroid_app_qemu_DiskManager_nativeRewriteImage(
+        env, clazz, src_path, dest_path, JNI_TRUE, stats, listener);
+
+    if (old_prio >= 0) {
+        syscall(SYS_ioprio_set, IOPRIO_WHO_PROCESS, 0, old_prio);
+    }
+    return result;
+}
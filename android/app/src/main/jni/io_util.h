@@ -0,0 +1,71 @@
+/**
+ * I/O Helpers
+ * Small inline helpers shared by the native file and disk modules
+ */
+
+#ifndef IO_UTIL_H
+#define IO_UTIL_H
+
+#include <errno.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/types.h>
+
+/**
+ * Get current time in milliseconds
+ */
+static inline long get_current_time_ms() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Read exactly len bytes at offset; hitting EOF is -EIO
+ */
+static inline int pread_full(int fd, void* buf, size_t len, off64_t offset) {
+    char* p = (char*)buf;
+    while (len > 0) {
+        ssize_t n = pread64(fd, p, len, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        if (n == 0) {
+            return -EIO;
+        }
+        p += n;
+        len -= (size_t)n;
+        offset += n;
+    }
+    return 0;
+}
+
+/**
+ * Write the whole buffer at the given offset, retrying short writes
+ */
+static inline int pwrite_full(int fd, const void* buf, size_t len, off64_t offset) {
+    const char* p = (const char*)buf;
+    while (len > 0) {
+        ssize_t n = pwrite64(fd, p, len, offset);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            return -errno;
+        }
+        p += n;
+        len -= (size_t)n;
+        offset += n;
+    }
+    return 0;
+}
+
+/**
+ * Check whether a buffer is entirely zero
+ */
+static inline int is_zero(const void* buf, size_t len) {
+    const unsigned char* p = (const unsigned char*)buf;
+    return len == 0 || (p[0] == 0 && memcmp(p, p + 1, len - 1) == 0);
+}
+
+#endif // IO_UTIL_H
@@ -0,0 +1,42 @@
+/**
+ * JNI Progress Bridge
+ * Forwards native progress callbacks to a FileUtils.ProgressListener
+ */
+
+#ifndef JNI_PROGRESS_H
+#define JNI_PROGRESS_H
+
+#include <jni.h>
+
+#include "decompress.h"
+
+typedef struct {
+    JNIEnv* env;
+    jobject listener;
+    jmethodID on_progress;
+} JniProgress;
+
+static inline void jni_progress(void* ctx, long long done, long long total) {
+    JniProgress* p = (JniProgress*)ctx;
+    (*p->env)->CallVoidMethod(p->env, p->listener, p->on_progress, (jlong)done, (jlong)total);
+    if ((*p->env)->ExceptionCheck(p->env)) {
+        (*p->env)->ExceptionClear(p->env);
+    }
+}
+
+/**
+ * Returns the callback to pass to native code, or NULL without a listener
+ */
+static inline progress_fn init_jni_progress(JNIEnv* env, jobject listener, JniProgress* p) {
+    if (listener == NULL) {
+        return NULL;
+    }
+    jclass cls = (*env)->GetObjectClass(env, listener);
+    p->env = env;
+    p->listener = listener;
+    p->on_progress = (*env)->GetMethodID(env, cls, "onProgress", "(JJ)V");
+    (*env)->DeleteLocalRef(env, cls);
+    return p->on_progress != NULL ? jni_progress : NULL;
+}
+
+#endif // JNI_PROGRESS_H
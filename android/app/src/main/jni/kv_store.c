@@ -0,0 +1,604 @@
+/**
+ * KV Store
+ * File: a 16-byte header ("KVS1", version) and records of
+ *   u32 crc32 | u32 key length | u32 value length | key | value
+ * where the CRC covers everything after itself and a value length of
+ * TOMBSTONE marks a removal. The file is kept a multiple of the page size
+ * and zero past the last record; a zero key length ends the log.
+ *
+ * Index: open addressing with linear probing over record offsets,
+ * deletes by backward shift so no tombstones pile up in the table.
+ */
+
+#define _GNU_SOURCE
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "io_util.h"
+#include "kv_store.h"
+
+#define KV_MAGIC 0x3153564bu  // "KVS1"
+#define KV_VERSION 1
+#define HEADER_SIZE 16
+#define RECORD_HEADER 12
+#define TOMBSTONE 0xFFFFFFFFu
+#define MIN_CAPACITY (64 * 1024)
+#define MIN_SLOTS 64
+// Compact once dead records pass half the log, and the log this size
+#define COMPACT_MIN_BYTES (64 * 1024)
+
+typedef struct {
+    uint64_t offset;
+    uint32_t hash;
+    uint32_t used;
+} slot_t;
+
+struct kv_store {
+    char* path;
+    int fd;
+    char* map;
+    size_t capacity;  // file and mapping size
+    size_t used;      // end of the last record
+    size_t dead;      // bytes of records that no longer count
+    slot_t* slots;
+    size_t slot_count;  // a power of two
+    size_t live;
+};
+
+static uint32_t hash_key(const char* key, size_t len) {
+    uint32_t h = 2166136261u;
+    for (size_t i = 0; i < len; i++) {
+        h = (h ^ (unsigned char)key[i]) * 16777619u;
+    }
+    return h;
+}
+
+static uint32_t read_u32(const char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+static void write_u32(char* p, uint32_t v) {
+    memcpy(p, &v, sizeof(v));
+}
+
+static size_t record_size(uint32_t key_len, uint32_t value_len) {
+    return RECORD_HEADER + key_len + (value_len == TOMBSTONE ? 0 : value_len);
+}
+
+static size_t record_size_at(const kv_store_t* store, uint64_t offset) {
+    const char* rec = store->map + offset;
+    return record_size(read_u32(rec + 4), read_u32(rec + 8));
+}
+
+static uint32_t record_crc(const char* rec, size_t size) {
+    return (uint32_t)crc32(0L, (const Bytef*)rec + 4, (uInt)(size - 4));
+}
+
+// ============================================
+// Index
+// ============================================
+
+/**
+ * Slot holding key, or the empty slot where it would go
+ */
+static size_t find_slot(const kv_store_t* store, const char* key, size_t key_len, uint32_t hash) {
+    size_t mask = store->slot_count - 1;
+    size_t i = hash & mask;
+    while (store->slots[i].used) {
+        const slot_t* slot = &store->slots[i];
+        if (slot->hash == hash) {
+            const char* rec = store->map + slot->offset;
+            if (read_u32(rec + 4) == key_len && memcmp(rec + RECORD_HEADER, key, key_len) == 0) {
+                return i;
+            }
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static int grow_index(kv_store_t* store) {
+    size_t count = store->slot_count * 2;
+    slot_t* slots = calloc(count, sizeof(slot_t));
+    if (slots == NULL) {
+        return -ENOMEM;
+    }
+    for (size_t i = 0; i < store->slot_count; i++) {
+        if (store->slots[i].used) {
+            size_t j = store->slots[i].hash & (count - 1);
+            while (slots[j].used) {
+                j = (j + 1) & (count - 1);
+            }
+            slots[j] = store->slots[i];
+        }
+    }
+    free(store->slots);
+    store->slots = slots;
+    store->slot_count = count;
+    return 0;
+}
+
+/**
+ * Point key at the record at offset; the record it replaces is dead
+ */
+static int index_put(kv_store_t* store, uint64_t offset) {
+    const char* rec = store->map + offset;
+    uint32_t key_len = read_u32(rec + 4);
+    uint32_t hash = hash_key(rec + RECORD_HEADER, key_len);
+    size_t i = find_slot(store, rec + RECORD_HEADER, key_len, hash);
+    if (store->slots[i].used) {
+        store->dead += record_size_at(store, store->slots[i].offset);
+        store->slots[i].offset = offset;
+        return 0;
+    }
+    if ((store->live + 1) * 10 > store->slot_count * 7) {
+        int err = grow_index(store);
+        if (err < 0) {
+            return err;
+        }
+        i = find_slot(store, rec + RECORD_HEADER, key_len, hash);
+    }
+    store->slots[i].offset = offset;
+    store->slots[i].hash = hash;
+    store->slots[i].used = 1;
+    store->live++;
+    return 0;
+}
+
+static void index_remove(kv_store_t* store, const char* key, size_t key_len) {
+    size_t mask = store->slot_count - 1;
+    size_t i = find_slot(store, key, key_len, hash_key(key, key_len));
+    if (!store->slots[i].used) {
+        return;
+    }
+    store->dead += record_size_at(store, store->slots[i].offset);
+    store->live--;
+
+    // Backward shift: pull later entries of the run into the gap
+    size_t gap = i;
+    size_t j = i;
+    for (;;) {
+        j = (j + 1) & mask;
+        if (!store->slots[j].used) {
+            break;
+        }
+        size_t home = store->slots[j].hash & mask;
+        // Movable unless its home lies cyclically in (gap, j]
+        int stays = gap <= j ? (home > gap && home <= j) : (home > gap || home <= j);
+        if (!stays) {
+            store->slots[gap] = store->slots[j];
+            gap = j;
+        }
+    }
+    store->slots[gap].used = 0;
+}
+
+static void index_reset(kv_store_t* store) {
+    memset(store->slots, 0, store->slot_count * sizeof(slot_t));
+    store->live = 0;
+}
+
+// ============================================
+// File
+// ============================================
+
+static size_t page_round(size_t size) {
+    size_t page = (size_t)sysconf(_SC_PAGESIZE);
+    return (size + page - 1) / page * page;
+}
+
+static int map_file(kv_store_t* store, size_t capacity) {
+    void* map = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, store->fd, 0);
+    if (map == MAP_FAILED) {
+        return -errno;
+    }
+    if (store->map != NULL) {
+        munmap(store->map, store->capacity);
+    }
+    store->map = map;
+    store->capacity = capacity;
+    return 0;
+}
+
+/**
+ * Room for need more bytes, doubling the file
+ */
+static int reserve(kv_store_t* store, size_t need) {
+    if (store->used + need <= store->capacity) {
+        return 0;
+    }
+    size_t capacity = store->capacity;
+    while (store->used + need > capacity) {
+        capacity *= 2;
+    }
+    if (ftruncate(store->fd, (off_t)capacity) < 0) {
+        return -errno;
+    }
+    return map_file(store, capacity);
+}
+
+static int write_header(int fd) {
+    char header[HEADER_SIZE] = { 0 };
+    write_u32(header, KV_MAGIC);
+    write_u32(header + 4, KV_VERSION);
+    return pwrite_full(fd, header, sizeof(header), 0);
+}
+
+/**
+ * Replay the log into the index. A record that does not check out is
+ * where a write was cut short: the log ends there and the rest is
+ * zeroed, so the next append starts clean.
+ */
+static int replay(kv_store_t* store) {
+    size_t offset = HEADER_SIZE;
+    while (offset + RECORD_HEADER <= store->capacity) {
+        const char* rec = store->map + offset;
+        uint32_t key_len = read_u32(rec + 4);
+        uint32_t value_len = read_u32(rec + 8);
+        if (key_len == 0 || key_len > KV_MAX_KEY ||
+            (value_len != TOMBSTONE && value_len > KV_MAX_VALUE)) {
+            break;
+        }
+        size_t size = record_size(key_len, value_len);
+        if (offset + size > store->capacity || record_crc(rec, size) != read_u32(rec)) {
+            break;
+        }
+        if (value_len == TOMBSTONE) {
+            index_remove(store, rec + RECORD_HEADER, key_len);
+            store->dead += size;
+        } else {
+            int err = index_put(store, offset);
+            if (err < 0) {
+                return err;
+            }
+        }
+        offset += size;
+    }
+    store->used = offset;
+    if (!is_zero(store->map + offset, store->capacity - offset)) {
+        memset(store->map + offset, 0, store->capacity - offset);
+    }
+    return 0;
+}
+
+static int fsync_parent(const char* path) {
+    char dir[512];
+    const char* slash = strrchr(path, '/');
+    if (slash == NULL || (size_t)(slash - path) >= sizeof(dir)) {
+        return 0;
+    }
+    memcpy(dir, path, (size_t)(slash - path));
+    dir[slash - path] = '\0';
+    int fd = open(dir[0] != '\0' ? dir : "/", O_RDONLY | O_DIRECTORY | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+    int err = fsync(fd) < 0 ? -errno : 0;
+    close(fd);
+    return err;
+}
+
+/**
+ * Start an empty file at path, setting aside one that is not a store
+ */
+static int init_file(kv_store_t* store, int corrupt) {
+    if (corrupt) {
+        char aside[560];
+        snprintf(aside, sizeof(aside), "%s.corrupt", store->path);
+        close(store->fd);
+        rename(store->path, aside);
+        store->fd = open(store->path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+        if (store->fd < 0) {
+            return -errno;
+        }
+    }
+    if (ftruncate(store->fd, MIN_CAPACITY) < 0) {
+        return -errno;
+    }
+    int err = write_header(store->fd);
+    if (err == 0 && fsync(store->fd) < 0) {
+        err = -errno;
+    }
+    return err;
+}
+
+kv_store_t* kv_store_open(const char* path) {
+    if (strlen(path) >= 512) {
+        errno = ENAMETOOLONG;
+        return NULL;
+    }
+    kv_store_t* store = calloc(1, sizeof(*store));
+    if (store == NULL) {
+        return NULL;
+    }
+    store->fd = -1;
+    store->path = strdup(path);
+    store->slot_count = MIN_SLOTS;
+    store->slots = calloc(MIN_SLOTS, sizeof(slot_t));
+    if (store->path == NULL || store->slots == NULL) {
+        kv_store_close(store);
+        errno = ENOMEM;
+        return NULL;
+    }
+
+    // A compaction that did not get to its rename
+    char tmp[520];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    unlink(tmp);
+
+    int err = 0;
+    store->fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+    if (store->fd < 0) {
+        err = -errno;
+    }
+    struct stat st;
+    if (err == 0 && fstat(store->fd, &st) < 0) {
+        err = -errno;
+    }
+    if (err == 0) {
+        char header[HEADER_SIZE];
+        int fresh = st.st_size == 0;
+        int corrupt = !fresh && (st.st_size < HEADER_SIZE ||
+            pread_full(store->fd, header, sizeof(header), 0) < 0 ||
+            read_u32(header) != KV_MAGIC || read_u32(header + 4) != KV_VERSION);
+        if (fresh || corrupt) {
+            err = init_file(store, corrupt);
+            st.st_size = MIN_CAPACITY;
+        }
+    }
+    if (err == 0) {
+        size_t capacity = page_round((size_t)st.st_size);
+        if (capacity != (size_t)st.st_size && ftruncate(store->fd, (off_t)capacity) < 0) {
+            err = -errno;
+        }
+        if (err == 0) {
+            err = map_file(store, capacity);
+        }
+    }
+    if (err == 0) {
+        err = replay(store);
+    }
+    if (err < 0) {
+        kv_store_close(store);
+        errno = -err;
+        return NULL;
+    }
+    return store;
+}
+
+void kv_store_close(kv_store_t* store) {
+    if (store == NULL) {
+        return;
+    }
+    if (store->map != NULL) {
+        munmap(store->map, store->capacity);
+    }
+    if (store->fd >= 0) {
+        close(store->fd);
+    }
+    free(store->slots);
+    free(store->path);
+    free(store);
+}
+
+// ============================================
+// Reads and writes
+// ============================================
+
+int kv_store_get(kv_store_t* store, const char* key, size_t key_len,
+                 const char** value, size_t* value_len) {
+    if (key_len == 0 || key_len > KV_MAX_KEY) {
+        return 0;
+    }
+    size_t i = find_slot(store, key, key_len, hash_key(key, key_len));
+    if (!store->slots[i].used) {
+        return 0;
+    }
+    const char* rec = store->map + store->slots[i].offset;
+    *value = rec + RECORD_HEADER + key_len;
+    *value_len = read_u32(rec + 8);
+    return 1;
+}
+
+/**
+ * Copy a record in; the CRC goes last, so a record cut short never
+ * checks out
+ * Returns: its offset, or a negative errno
+ */
+static int64_t append(kv_store_t* store, const char* key, size_t key_len,
+                      const char* value, uint32_t value_len) {
+    size_t size = record_size((uint32_t)key_len, value_len);
+    int err = reserve(store, size);
+    if (err < 0) {
+        return err;
+    }
+    uint64_t offset = store->used;
+    char* rec = store->map + offset;
+    write_u32(rec + 4, (uint32_t)key_len);
+    write_u32(rec + 8, value_len);
+    memcpy(rec + RECORD_HEADER, key, key_len);
+    if (value_len != TOMBSTONE) {
+        memcpy(rec + RECORD_HEADER + key_len, value, value_len);
+    }
+    write_u32(rec, record_crc(rec, size));
+    store->used += size;
+    return (int64_t)offset;
+}
+
+static int rewrite(kv_store_t* store, int keep_live);
+
+static void maybe_compact(kv_store_t* store) {
+    if (store->used >= COMPACT_MIN_BYTES && store->dead > store->used / 2) {
+        // On failure the log just stays longer than it needs to be
+        kv_store_compact(store);
+    }
+}
+
+int kv_store_set(kv_store_t* store, const char* key, size_t key_len,
+                 const char* value, size_t value_len) {
+    if (key_len == 0 || key_len > KV_MAX_KEY || value_len > KV_MAX_VALUE) {
+        return -EINVAL;
+    }
+    // Settings are often saved unchanged; that costs no record
+    const char* current;
+    size_t current_len;
+    if (kv_store_get(store, key, key_len, &current, &current_len) &&
+        current_len == value_len && memcmp(current, value, value_len) == 0) {
+        return 0;
+    }
+    int64_t offset = append(store, key, key_len, value, (uint32_t)value_len);
+    if (offset < 0) {
+        return (int)offset;
+    }
+    int err = index_put(store, (uint64_t)offset);
+    if (err < 0) {
+        return err;
+    }
+    maybe_compact(store);
+    return 0;
+}
+
+int kv_store_remove(kv_store_t* store, const char* key, size_t key_len) {
+    const char* current;
+    size_t current_len;
+    if (!kv_store_get(store, key, key_len, &current, &current_len)) {
+        return 0;
+    }
+    int64_t offset = append(store, key, key_len, NULL, TOMBSTONE);
+    if (offset < 0) {
+        return (int)offset;
+    }
+    index_remove(store, key, key_len);
+    store->dead += record_size((uint32_t)key_len, TOMBSTONE);
+    maybe_compact(store);
+    return 0;
+}
+
+int kv_store_clear(kv_store_t* store) {
+    return rewrite(store, 0);
+}
+
+size_t kv_store_count(const kv_store_t* store) {
+    return store->live;
+}
+
+void kv_store_each(kv_store_t* store,
+                   int (*fn)(void* ctx, const char* key, size_t key_len,
+                             const char* value, size_t value_len),
+                   void* ctx) {
+    for (size_t i = 0; i < store->slot_count; i++) {
+        if (!store->slots[i].used) {
+            continue;
+        }
+        const char* rec = store->map + store->slots[i].offset;
+        uint32_t key_len = read_u32(rec + 4);
+        if (fn(ctx, rec + RECORD_HEADER, key_len, rec + RECORD_HEADER + key_len, read_u32(rec + 8))) {
+            return;
+        }
+    }
+}
+
+// ============================================
+// Compaction
+// ============================================
+
+/**
+ * Write the live records (none when keep_live is 0) to a new file and
+ * swap it in. Until the rename the old log stands, and the new file is
+ * mapped before it, so a failure leaves the store as it was.
+ */
+static int rewrite(kv_store_t* store, int keep_live) {
+    char tmp[520];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", store->path);
+    uint64_t* offsets = malloc(store->slot_count * sizeof(uint64_t));
+    if (offsets == NULL) {
+        return -ENOMEM;
+    }
+    int fd = open(tmp, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        free(offsets);
+        return -errno;
+    }
+
+    // Live records are copied as they are, CRCs included
+    int err = write_header(fd);
+    size_t end = HEADER_SIZE;
+    for (size_t i = 0; keep_live && err == 0 && i < store->slot_count; i++) {
+        if (!store->slots[i].used) {
+            continue;
+        }
+        size_t size = record_size_at(store, store->slots[i].offset);
+        err = pwrite_full(fd, store->map + store->slots[i].offset, size, (off64_t)end);
+        offsets[i] = end;
+        end += size;
+    }
+    size_t capacity = MIN_CAPACITY;
+    while (capacity < end * 2) {
+        capacity *= 2;
+    }
+    if (err == 0 && ftruncate(fd, (off_t)capacity) < 0) {
+        err = -errno;
+    }
+    if (err == 0 && fsync(fd) < 0) {
+        err = -errno;
+    }
+    void* map = MAP_FAILED;
+    if (err == 0) {
+        map = mmap(NULL, capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (map == MAP_FAILED) {
+            err = -errno;
+        }
+    }
+
+    // The rename is the commit point
+    if (err == 0 && rename(tmp, store->path) < 0) {
+        err = -errno;
+    }
+    if (err < 0) {
+        if (map != MAP_FAILED) {
+            munmap(map, capacity);
+        }
+        close(fd);
+        unlink(tmp);
+        free(offsets);
+        return err;
+    }
+    fsync_parent(store->path);
+
+    munmap(store->map, store->capacity);
+    close(store->fd);
+    store->fd = fd;
+    store->map = map;
+    store->capacity = capacity;
+    store->used = end;
+    store->dead = 0;
+    if (keep_live) {
+        for (size_t i = 0; i < store->slot_count; i++) {
+            if (store->slots[i].used) {
+                store->slots[i].offset = offsets[i];
+            }
+        }
+    } else {
+        index_reset(store);
+    }
+    free(offsets);
+    return 0;
+}
+
+int kv_store_compact(kv_store_t* store) {
+    return rewrite(store, 1);
+}
+
+void kv_store_usage(const kv_store_t* store, uint64_t* used, uint64_t* dead) {
+    *used = store->used;
+    *dead = store->dead;
+}
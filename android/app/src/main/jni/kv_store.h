@@ -0,0 +1,95 @@
+/**
+ * KV Store
+ * Small persistent key-value store for app settings, read synchronously
+ * from JS. The file is an append-only log of CRC-checked records, mapped
+ * into memory; an in-memory hash index points at each key's latest
+ * record, so a read is a hash lookup and no I/O.
+ *
+ * A write is one record copied into the shared mapping: it survives the
+ * process being killed as soon as the call returns, and the kernel writes
+ * it back. A torn record (power cut mid-write) fails its CRC and is
+ * dropped on the next open, along with anything after it. When dead
+ * records outweigh live ones the log is compacted into a new file that
+ * replaces the old one by rename, so a crash leaves one or the other.
+ *
+ * Not thread-safe: one user at a time.
+ */
+
+#ifndef KV_STORE_H
+#define KV_STORE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KV_MAX_KEY   1024
+#define KV_MAX_VALUE (1024 * 1024)
+
+typedef struct kv_store kv_store_t;
+
+/**
+ * Open or create the store at path and index it
+ * Returns: the store, NULL on error (errno set)
+ */
+kv_store_t* kv_store_open(const char* path);
+
+void kv_store_close(kv_store_t* store);
+
+/**
+ * Value for a key, pointing into the mapping: valid until the next
+ * write to the store
+ * Returns: 1 if found, 0 if not
+ */
+int kv_store_get(kv_store_t* store, const char* key, size_t key_len,
+                 const char** value, size_t* value_len);
+
+/**
+ * Returns: 0 or a negative errno
+ */
+int kv_store_set(kv_store_t* store, const char* key, size_t key_len,
+                 const char* value, size_t value_len);
+
+/**
+ * Returns: 0 (also when the key was absent) or a negative errno
+ */
+int kv_store_remove(kv_store_t* store, const char* key, size_t key_len);
+
+/**
+ * Drop every key
+ * Returns: 0 or a negative errno
+ */
+int kv_store_clear(kv_store_t* store);
+
+/**
+ * Live keys
+ */
+size_t kv_store_count(const kv_store_t* store);
+
+/**
+ * Call fn for every live key in no particular order; stops early when
+ * fn returns nonzero. fn must not write to the store.
+ */
+void kv_store_each(kv_store_t* store,
+                   int (*fn)(void* ctx, const char* key, size_t key_len,
+                             const char* value, size_t value_len),
+                   void* ctx);
+
+/**
+ * Rewrite the log with live records only
+ * Returns: 0 or a negative errno
+ */
+int kv_store_compact(kv_store_t* store);
+
+/**
+ * Bytes used by the log, and by records a later write replaced
+ */
+void kv_store_usage(const kv_store_t* store, uint64_t* used, uint64_t* dead);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // KV_STORE_H
@@ -0,0 +1,324 @@
+/**
+ * Log Index
+ * Text file plus an array of line start offsets (uint64) in a second
+ * file: entry i is where line i starts, and the entry after the last
+ * complete line is where the unterminated tail starts
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <android/log.h>
+
+#include "log_index.h"
+
+#define TAG "LogIndex"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+#define OFFSET_BATCH 512
+#define SCAN_CHUNK (256 * 1024)
+
+struct log_index {
+    int data_fd;
+    int offsets_fd;
+    uint64_t size;        // bytes of text
+    size_t complete;      // lines ended by '\n'
+    uint64_t tail_start;  // start of the unterminated tail (offset entry `complete`)
+};
+
+static int write_all(int fd, const void* buf, size_t len, uint64_t offset) {
+    const char* p = buf;
+    while (len > 0) {
+        ssize_t n = pwrite(fd, p, len, (off_t)offset);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return n < 0 ? -errno : -EIO;
+        }
+        p += n;
+        len -= (size_t)n;
+        offset += (uint64_t)n;
+    }
+    return 0;
+}
+
+static ssize_t read_full(int fd, void* buf, size_t len, uint64_t offset) {
+    size_t done = 0;
+    while (done < len) {
+        ssize_t n = pread(fd, (char*)buf + done, len - done, (off_t)(offset + done));
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n < 0) {
+            return -1;
+        }
+        if (n == 0) {
+            break;
+        }
+        done += (size_t)n;
+    }
+    return (ssize_t)done;
+}
+
+/**
+ * Create a file in dir that is gone as soon as it is closed
+ */
+static int open_unlinked(const char* dir) {
+    char path[512];
+    if (snprintf(path, sizeof(path), "%s/log-XXXXXX", dir) >= (int)sizeof(path)) {
+        errno = ENAMETOOLONG;
+        return -1;
+    }
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        unlink(path);
+        fcntl(fd, F_SETFD, FD_CLOEXEC);
+    }
+    return fd;
+}
+
+static int reset(log_index_t* index) {
+    uint64_t zero = 0;
+    index->size = 0;
+    index->complete = 0;
+    index->tail_start = 0;
+    return write_all(index->offsets_fd, &zero, sizeof(zero), 0);
+}
+
+log_index_t* log_index_open(const char* dir) {
+    log_index_t* index = calloc(1, sizeof(*index));
+    if (index == NULL) {
+        return NULL;
+    }
+    index->data_fd = open_unlinked(dir);
+    index->offsets_fd = open_unlinked(dir);
+    if (index->data_fd < 0 || index->offsets_fd < 0 || reset(index) < 0) {
+        int saved = errno;
+        LOGE("Cannot create log index in %s: %s", dir, strerror(saved));
+        log_index_close(index);
+        errno = saved;
+        return NULL;
+    }
+    return index;
+}
+
+void log_index_close(log_index_t* index) {
+    if (index == NULL) {
+        return;
+    }
+    if (index->data_fd >= 0) {
+        close(index->data_fd);
+    }
+    if (index->offsets_fd >= 0) {
+        close(index->offsets_fd);
+    }
+    free(index);
+}
+
+int log_index_append(log_index_t* index, const char* data, size_t len) {
+    int err = write_all(index->data_fd, data, len, index->size);
+    if (err < 0) {
+        return err;
+    }
+
+    // Only the new bytes are scanned; starts go out in batches
+    uint64_t batch[OFFSET_BATCH];
+    size_t batched = 0;
+    size_t complete = index->complete;
+    const char* p = data;
+    const char* end = data + len;
+    while ((p = memchr(p, '\n', (size_t)(end - p))) != NULL) {
+        p++;
+        batch[batched++] = index->size + (uint64_t)(p - data);
+        if (batched == OFFSET_BATCH) {
+            err = write_all(index->offsets_fd, batch, sizeof(batch), (uint64_t)(complete + 1) * 8);
+            if (err < 0) {
+                return err;
+            }
+            complete += batched;
+            batched = 0;
+        }
+    }
+    if (batched > 0) {
+        err = write_all(index->offsets_fd, batch, batched * 8, (uint64_t)(complete + 1) * 8);
+        if (err < 0) {
+            return err;
+        }
+        complete += batched;
+        index->tail_start = batch[batched - 1];
+    } else if (complete != index->complete) {
+        index->tail_start = batch[OFFSET_BATCH - 1];
+    }
+    index->complete = complete;
+    index->size += len;
+    return 0;
+}
+
+int log_index_clear(log_index_t* index) {
+    if (ftruncate(index->data_fd, 0) < 0 || ftruncate(index->offsets_fd, 0) < 0) {
+        return -errno;
+    }
+    return reset(index);
+}
+
+size_t log_index_line_count(const log_index_t* index) {
+    return index->complete + (index->size > index->tail_start ? 1 : 0);
+}
+
+uint64_t log_index_bytes(const log_index_t* index) {
+    return index->size;
+}
+
+ssize_t log_index_window(log_index_t* index, size_t first, size_t count,
+                         uint64_t* starts, uint64_t* ends) {
+    size_t lines = log_index_line_count(index);
+    if (first >= lines || count == 0) {
+        return 0;
+    }
+    size_t n = lines - first < count ? lines - first : count;
+
+    // Starts of first .. first+n, as far as the offsets file has them
+    size_t last = first + n <= index->complete ? first + n : index->complete;
+    size_t entries = last - first + 1;
+    uint64_t* offsets = malloc(entries * sizeof(uint64_t));
+    if (offsets == NULL) {
+        return -1;
+    }
+    if (read_full(index->offsets_fd, offsets, entries * 8, (uint64_t)first * 8) != (ssize_t)(entries * 8)) {
+        free(offsets);
+        return -1;
+    }
+    for (size_t k = 0; k < n; k++) {
+        starts[k] = offsets[k];
+        ends[k] = first + k < index->complete ? offsets[k + 1] - 1 : index->size;
+    }
+    free(offsets);
+    return (ssize_t)n;
+}
+
+ssize_t log_index_read(log_index_t* index, char* buf, size_t len, uint64_t offset) {
+    return read_full(index->data_fd, buf, len, offset);
+}
+
+static inline char lower(char c) {
+    return c >= 'A' && c <= 'Z' ? (char)(c + ('a' - 'A')) : c;
+}
+
+ssize_t log_index_match(const char* text, size_t len, const char* needle, size_t needle_len) {
+    if (needle_len == 0 || needle_len > len) {
+        return -1;
+    }
+    char first = lower(needle[0]);
+    for (size_t i = 0; i + needle_len <= len; i++) {
+        if (lower(text[i]) != first) {
+            continue;
+        }
+        size_t j = 1;
+        while (j < needle_len && lower(text[i + j]) == lower(needle[j])) {
+            j++;
+        }
+        if (j == needle_len) {
+            return (ssize_t)i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * Line that holds byte pos: the last start at or before it
+ */
+static ssize_t line_of(log_index_t* index, uint64_t pos) {
+    size_t lo = 0;
+    size_t hi = index->complete;
+    while (lo < hi) {
+        size_t mid = lo + (hi - lo + 1) / 2;
+        uint64_t start;
+        if (read_full(index->offsets_fd, &start, 8, (uint64_t)mid * 8) != 8) {
+            return -1;
+        }
+        if (start <= pos) {
+            lo = mid;
+        } else {
+            hi = mid - 1;
+        }
+    }
+    return (ssize_t)lo;
+}
+
+static int line_start(log_index_t* index, size_t line, uint64_t* start) {
+    if (line >= log_index_line_count(index)) {
+        *start = index->size;
+        return 0;
+    }
+    return read_full(index->offsets_fd, start, 8, (uint64_t)line * 8) == 8 ? 0 : -1;
+}
+
+ssize_t log_index_find(log_index_t* index, const char* needle, size_t from, int backwards) {
+    size_t needle_len = strlen(needle);
+    // Lines hold no '\n', so a needle with one never matches
+    if (needle_len == 0 || needle_len > SCAN_CHUNK / 2 || memchr(needle, '\n', needle_len) != NULL) {
+        return -1;
+    }
+    uint64_t boundary;
+    if (line_start(index, from, &boundary) < 0) {
+        return -1;
+    }
+    char* chunk = malloc(SCAN_CHUNK);
+    if (chunk == NULL) {
+        return -1;
+    }
+
+    // Chunks overlap by needle_len - 1 so no match is cut in two
+    ssize_t found = -1;
+    if (!backwards) {
+        uint64_t pos = boundary;
+        while (pos < index->size) {
+            size_t want = index->size - pos < SCAN_CHUNK ? (size_t)(index->size - pos) : SCAN_CHUNK;
+            ssize_t got = read_full(index->data_fd, chunk, want, pos);
+            if (got <= 0) {
+                break;
+            }
+            ssize_t at = log_index_match(chunk, (size_t)got, needle, needle_len);
+            if (at >= 0) {
+                found = line_of(index, pos + (uint64_t)at);
+                break;
+            }
+            if ((size_t)got < needle_len || pos + (uint64_t)got >= index->size) {
+                break;
+            }
+            pos += (uint64_t)got - (needle_len - 1);
+        }
+    } else {
+        uint64_t hi = boundary;
+        while (hi >= needle_len) {
+            uint64_t lo = hi > SCAN_CHUNK ? hi - SCAN_CHUNK : 0;
+            ssize_t got = read_full(index->data_fd, chunk, (size_t)(hi - lo), lo);
+            if (got <= 0) {
+                break;
+            }
+            // Last match in the chunk
+            ssize_t last = -1;
+            size_t offset = 0;
+            ssize_t at;
+            while (offset < (size_t)got &&
+                   (at = log_index_match(chunk + offset, (size_t)got - offset, needle, needle_len)) >= 0) {
+                last = (ssize_t)offset + at;
+                offset += (size_t)at + 1;
+            }
+            if (last >= 0) {
+                found = line_of(index, lo + (uint64_t)last);
+                break;
+            }
+            if (lo == 0) {
+                break;
+            }
+            hi = lo + needle_len - 1;
+        }
+    }
+    free(chunk);
+    return found;
+}
@@ -0,0 +1,87 @@
+/**
+ * Log Index
+ * Append-only log text with a line-offset index, for viewers that show a
+ * window of a log of any size. Text and offsets live in two files that
+ * are unlinked right after they are created: memory use is a few
+ * counters, the kernel's page cache does the rest, and nothing is left
+ * behind if the process dies.
+ *
+ * Appends only scan the new bytes. Not thread-safe: one user at a time.
+ */
+
+#ifndef LOG_INDEX_H
+#define LOG_INDEX_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct log_index log_index_t;
+
+/**
+ * Open an empty index with its files in dir
+ * Returns: the index, NULL on error (errno set)
+ */
+log_index_t* log_index_open(const char* dir);
+
+/**
+ * Close the index and free it; its files are already gone
+ */
+void log_index_close(log_index_t* index);
+
+/**
+ * Append text; a line without its '\n' yet is continued by the next
+ * append
+ * Returns: 0 or a negative errno
+ */
+int log_index_append(log_index_t* index, const char* data, size_t len);
+
+/**
+ * Drop all lines
+ */
+int log_index_clear(log_index_t* index);
+
+/**
+ * Lines held, counting an unterminated last line
+ */
+size_t log_index_line_count(const log_index_t* index);
+
+/**
+ * Bytes of text held
+ */
+uint64_t log_index_bytes(const log_index_t* index);
+
+/**
+ * Byte ranges of lines first .. first+count-1, without their '\n'
+ * Returns: lines in range (fewer at the end of the log), -1 on error
+ */
+ssize_t log_index_window(log_index_t* index, size_t first, size_t count,
+                         uint64_t* starts, uint64_t* ends);
+
+/**
+ * Read text at offset (ranges from log_index_window)
+ * Returns: bytes read, -1 on error
+ */
+ssize_t log_index_read(log_index_t* index, char* buf, size_t len, uint64_t offset);
+
+/**
+ * First line at or after from (backwards: last line before from) that
+ * contains needle, ignoring ASCII case
+ * Returns: the line, -1 if there is none
+ */
+ssize_t log_index_find(log_index_t* index, const char* needle, size_t from, int backwards);
+
+/**
+ * Position of needle in text[0, len), ignoring ASCII case; -1 if absent
+ */
+ssize_t log_index_match(const char* text, size_t len, const char* needle, size_t needle_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // LOG_INDEX_H
@@ -0,0 +1,790 @@
+/**
+ * QCOW2 Image Access
+ * Enough of the qcow2 format to create overlays, read backing chains
+ * and write compacted or flattened copies of an image
+ */
+
+#define _GNU_SOURCE
+#include <endian.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <zlib.h>
+#include <android/log.h>
+
+#include "qcow2.h"
+#include "io_util.h"
+
+#define TAG "Qcow2"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
+
+#define QCOW2_MAGIC             0x514649fbU   // "QFI\xfb"
+#define QCOW2_V2_HEADER_SIZE    72
+#define QCOW2_V3_HEADER_SIZE    104
+#define QCOW2_EXT_END           0x00000000U
+#define QCOW2_EXT_BACKING_FMT   0xe2792acaU
+
+#define QCOW2_INCOMPAT_DIRTY    (1ULL << 0)
+#define QCOW2_INCOMPAT_CORRUPT  (1ULL << 1)
+
+#define QCOW_OFLAG_COPIED       (1ULL << 63)
+#define QCOW_OFLAG_COMPRESSED   (1ULL << 62)
+#define QCOW_OFLAG_ZERO         (1ULL << 0)
+#define L1E_OFFSET_MASK         0x00fffffffffffe00ULL
+#define L2E_OFFSET_MASK         0x00fffffffffffe00ULL
+
+#define MAX_BACKING_DEPTH       16
+#define MAX_L1_ENTRIES          (32 * 1024 * 1024)
+
+typedef enum {
+    CLUSTER_UNALLOCATED,
+    CLUSTER_ZERO,
+    CLUSTER_DATA,
+    CLUSTER_COMPRESSED,
+} ClusterKind;
+
+struct Qcow2Image {
+    int fd;
+    int raw;
+    uint32_t version;
+    uint32_t cluster_bits;
+    uint64_t cluster_size;
+    uint64_t size;
+    uint32_t l1_size;
+    uint64_t* l1;
+    uint64_t* l2_cache;          // one L2 table, big-endian as on disk
+    uint64_t l2_cache_offset;
+    unsigned char* zbuf;         // compressed cluster scratch
+    unsigned char* dbuf;         // decompressed cluster scratch
+    Qcow2Image* backing;
+    char backing_fmt[16];
+};
+
+typedef struct {
+    int fd;
+    uint32_t cluster_bits;
+    uint64_t cluster_size;
+    uint64_t size;
+    uint32_t l1_size;
+    uint64_t** l2;               // host-endian L2 tables, allocated on first use
+    uint64_t next_offset;
+    const char* backing;
+    const char* backing_fmt;
+} Qcow2Writer;
+
+static uint32_t get_be32(const unsigned char* p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return be32toh(v);
+}
+
+static uint64_t get_be64(const unsigned char* p) {
+    uint64_t v;
+    memcpy(&v, p, sizeof(v));
+    return be64toh(v);
+}
+
+static void put_be32(unsigned char* p, uint32_t v) {
+    v = htobe32(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+static void put_be64(unsigned char* p, uint64_t v) {
+    v = htobe64(v);
+    memcpy(p, &v, sizeof(v));
+}
+
+static uint64_t div_round_up(uint64_t n, uint64_t d) {
+    return (n + d - 1) / d;
+}
+
+/**
+ * Allocated bytes of a file on disk
+ */
+static long long allocated_bytes(const char* path) {
+    struct stat st;
+    return stat(path, &st) == 0 ? (long long)st.st_blocks * 512 : 0;
+}
+
+// ============================================
+// READER
+// ============================================
+
+static int open_depth(const char* path, int depth, Qcow2Image** out);
+
+/**
+ * Parse the header, header extensions, L1 table and backing file
+ */
+static int load_qcow2(Qcow2Image* img, const char* path, int depth) {
+    unsigned char header[QCOW2_V3_HEADER_SIZE];
+    int err = pread_full(img->fd, header, QCOW2_V2_HEADER_SIZE, 0);
+    if (err < 0) {
+        return err;
+    }
+
+    img->version = get_be32(header + 4);
+    uint64_t backing_offset = get_be64(header + 8);
+    uint32_t backing_size = get_be32(header + 16);
+    img->cluster_bits = get_be32(header + 20);
+    img->size = get_be64(header + 24);
+    uint32_t crypt_method = get_be32(header + 32);
+    img->l1_size = get_be32(header + 36);
+    uint64_t l1_offset = get_be64(header + 40);
+
+    if ((img->version != 2 && img->version != 3) || crypt_method != 0 ||
+        img->cluster_bits < 9 || img->cluster_bits > 21 || img->l1_size > MAX_L1_ENTRIES) {
+        LOGE("Unsupported qcow2 image %s (version %u)", path, img->version);
+        return -ENOTSUP;
+    }
+    img->cluster_size = 1ULL << img->cluster_bits;
+
+    uint32_t header_length = QCOW2_V2_HEADER_SIZE;
+    if (img->version == 3) {
+        err = pread_full(img->fd, header, QCOW2_V3_HEADER_SIZE, 0);
+        if (err < 0) {
+            return err;
+        }
+        uint64_t incompatible = get_be64(header + 72);
+        uint32_t refcount_order = get_be32(header + 96);
+        header_length = get_be32(header + 100);
+        if (incompatible & (QCOW2_INCOMPAT_DIRTY | QCOW2_INCOMPAT_CORRUPT)) {
+            LOGE("%s is dirty or corrupt; repair it with qemu-img check -r all", path);
+            return -EUCLEAN;
+        }
+        if (incompatible != 0 || refcount_order > 6 || header_length < QCOW2_V3_HEADER_SIZE) {
+            LOGE("%s uses unsupported qcow2 features (0x%llx)", path, (unsigned long long)incompatible);
+            return -ENOTSUP;
+        }
+    }
+
+    // Header extensions: only the backing file format matters here
+    uint64_t ext_offset = (header_length + 7) & ~7ULL;
+    while (ext_offset + 8 <= img->cluster_size) {
+        unsigned char ext[8];
+        if (pread_full(img->fd, ext, sizeof(ext), ext_offset) < 0) {
+            break;
+        }
+        uint32_t type = get_be32(ext);
+        uint32_t len = get_be32(ext + 4);
+        if (type == QCOW2_EXT_END) {
+            break;
+        }
+        if (type == QCOW2_EXT_BACKING_FMT && len < sizeof(img->backing_fmt)) {
+            err = pread_full(img->fd, img->backing_fmt, len, ext_offset + 8);
+            if (err < 0) {
+                return err;
+            }
+            img->backing_fmt[len] = '\0';
+        }
+        ext_offset += 8 + ((len + 7) & ~7U);
+    }
+
+    img->l1 = (uint64_t*)calloc(img->l1_size ? img->l1_size : 1, sizeof(uint64_t));
+    img->l2_cache = (uint64_t*)malloc(img->cluster_size);
+    img->zbuf = (unsigned char*)malloc(img->cluster_size * 2);
+    img->dbuf = (unsigned char*)malloc(img->cluster_size);
+    if (img->l1 == NULL || img->l2_cache == NULL || img->zbuf == NULL || img->dbuf == NULL) {
+        return -ENOMEM;
+    }
+
+    if (img->l1_size > 0) {
+        err = pread_full(img->fd, img->l1, img->l1_size * sizeof(uint64_t), l1_offset);
+        if (err < 0) {
+            return err;
+        }
+        for (uint32_t i = 0; i < img->l1_size; i++) {
+            img->l1[i] = be64toh(img->l1[i]);
+        }
+    }
+
+    if (backing_offset != 0 && backing_size > 0) {
+        if (depth >= MAX_BACKING_DEPTH || backing_size >= 1024) {
+            return -ELOOP;
+        }
+        char name[1024];
+        char resolved[2048];
+        err = pread_full(img->fd, name, backing_size, backing_offset);
+        if (err < 0) {
+            return err;
+        }
+        name[backing_size] = '\0';
+
+        // Relative backing names are relative to the overlay's directory
+        if (name[0] == '/') {
+            snprintf(resolved, sizeof(resolved), "%s", name);
+        } else {
+            char dir[1024];
+            snprintf(dir, sizeof(dir), "%s", path);
+            snprintf(resolved, sizeof(resolved), "%s/%s", dirname(dir), name);
+        }
+
+        err = open_depth(resolved, depth + 1, &img->backing);
+        if (err < 0) {
+            LOGE("Failed to open backing file %s: %s", resolved, strerror(-err));
+            return err;
+        }
+    }
+
+    return 0;
+}
+
+static int open_depth(const char* path, int depth, Qcow2Image** out) {
+    Qcow2Image* img = (Qcow2Image*)calloc(1, sizeof(Qcow2Image));
+    if (img == NULL) {
+        return -ENOMEM;
+    }
+    img->l2_cache_offset = 0;
+
+    img->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (img->fd < 0) {
+        int err = -errno;
+        free(img);
+        return err;
+    }
+
+    unsigned char magic[4] = {0};
+    int err = pread_full(img->fd, magic, sizeof(magic), 0);
+    if (err < 0) {
+        qcow2_close(img);
+        return err;
+    }
+
+    if (get_be32(magic) == QCOW2_MAGIC) {
+        err = load_qcow2(img, path, depth);
+    } else {
+        struct stat st;
+        img->raw = 1;
+        img->cluster_bits = QCOW2_DEFAULT_CLUSTER_BITS;
+        img->cluster_size = 1ULL << img->cluster_bits;
+        err = fstat(img->fd, &st) == 0 ? 0 : -errno;
+        img->size = (uint64_t)st.st_size;
+    }
+
+    if (err < 0) {
+        qcow2_close(img);
+        return err;
+    }
+    *out = img;
+    return 0;
+}
+
+int qcow2_open(const char* path, Qcow2Image** out) {
+    return open_depth(path, 0, out);
+}
+
+void qcow2_close(Qcow2Image* img) {
+    if (img == NULL) {
+        return;
+    }
+    qcow2_close(img->backing);
+    if (img->fd >= 0) {
+        close(img->fd);
+    }
+    free(img->l1);
+    free(img->l2_cache);
+    free(img->zbuf);
+    free(img->dbuf);
+    free(img);
+}
+
+uint64_t qcow2_virtual_size(const Qcow2Image* img) {
+    return img->size;
+}
+
+const char* qcow2_format(const Qcow2Image* img) {
+    return img->raw ? "raw" : "qcow2";
+}
+
+/**
+ * Look up the L2 entry for a guest cluster in this layer only
+ */
+static int cluster_kind(Qcow2Image* img, uint64_t vcluster, uint64_t* entry, ClusterKind* kind) {
+    uint32_t l2_bits = img->cluster_bits - 3;
+    uint64_t l1_index = vcluster >> l2_bits;
+    uint64_t l2_index = vcluster & ((1ULL << l2_bits) - 1);
+
+    *entry = 0;
+    *kind = CLUSTER_UNALLOCATED;
+    if (l1_index >= img->l1_size) {
+        return 0;
+    }
+
+    uint64_t l2_offset = img->l1[l1_index] & L1E_OFFSET_MASK;
+    if (l2_offset == 0) {
+        return 0;
+    }
+
+    if (img->l2_cache_offset != l2_offset) {
+        int err = pread_full(img->fd, img->l2_cache, img->cluster_size, l2_offset);
+        if (err < 0) {
+            img->l2_cache_offset = 0;
+            return err;
+        }
+        img->l2_cache_offset = l2_offset;
+    }
+
+    uint64_t e = be64toh(img->l2_cache[l2_index]);
+    *entry = e;
+    if (e & QCOW_OFLAG_COMPRESSED) {
+        *kind = CLUSTER_COMPRESSED;
+    } else if (img->version >= 3 && (e & QCOW_OFLAG_ZERO)) {
+        *kind = CLUSTER_ZERO;
+    } else if ((e & L2E_OFFSET_MASK) != 0) {
+        *kind = CLUSTER_DATA;
+    }
+    return 0;
+}
+
+/**
+ * Inflate a compressed cluster into img->dbuf
+ */
+static int read_compressed(Qcow2Image* img, uint64_t entry) {
+    uint32_t csize_shift = 62 - (img->cluster_bits - 8);
+    uint64_t offset = entry & ((1ULL << csize_shift) - 1);
+    uint64_t sectors = ((entry >> csize_shift) & ((1ULL << (img->cluster_bits - 8)) - 1)) + 1;
+    uint64_t csize = sectors * 512 - (offset & 511);
+    if (csize > img->cluster_size * 2) {
+        return -EBADMSG;
+    }
+
+    // The descriptor may overstate the size at the end of the file
+    ssize_t n = pread64(img->fd, img->zbuf, csize, offset);
+    if (n <= 0) {
+        return n < 0 ? -errno : -EIO;
+    }
+
+    z_stream zs;
+    memset(&zs, 0, sizeof(zs));
+    if (inflateInit2(&zs, -MAX_WBITS) != Z_OK) {
+        return -ENOMEM;
+    }
+    zs.next_in = img->zbuf;
+    zs.avail_in = (uInt)n;
+    zs.next_out = img->dbuf;
+    zs.avail_out = (uInt)img->cluster_size;
+    int ret = inflate(&zs, Z_FINISH);
+    uLong produced = zs.total_out;
+    inflateEnd(&zs);
+
+    if ((ret != Z_STREAM_END && ret != Z_BUF_ERROR) || produced != img->cluster_size) {
+        return -EBADMSG;
+    }
+    return 0;
+}
+
+/**
+ * Read one full cluster of this layer's own data (DATA or COMPRESSED)
+ */
+static int read_own_cluster(Qcow2Image* img, ClusterKind kind, uint64_t entry, void* buf) {
+    if (kind == CLUSTER_COMPRESSED) {
+        int err = read_compressed(img, entry);
+        if (err == 0) {
+            memcpy(buf, img->dbuf, img->cluster_size);
+        }
+        return err;
+    }
+    return pread_full(img->fd, buf, img->cluster_size, entry & L2E_OFFSET_MASK);
+}
+
+int qcow2_read(Qcow2Image* img, uint64_t offset, void* buf, size_t len) {
+    unsigned char* out = (unsigned char*)buf;
+
+    // Anything past the virtual size (e.g. a smaller backing file) reads as zero
+    if (offset >= img->size) {
+        memset(out, 0, len);
+        return 0;
+    }
+    if (offset + len > img->size) {
+        size_t valid = (size_t)(img->size - offset);
+        memset(out + valid, 0, len - valid);
+        len = valid;
+    }
+
+    if (img->raw) {
+        ssize_t n = pread64(img->fd, out, len, offset);
+        if (n < 0) {
+            return -errno;
+        }
+        memset(out + n, 0, len - (size_t)n);
+        return 0;
+    }
+
+    while (len > 0) {
+        uint64_t vcluster = offset >> img->cluster_bits;
+        uint64_t in_cluster = offset & (img->cluster_size - 1);
+        size_t n = img->cluster_size - in_cluster < len ? (size_t)(img->cluster_size - in_cluster) : len;
+
+        uint64_t entry;
+        ClusterKind kind;
+        int err = cluster_kind(img, vcluster, &entry, &kind);
+        if (err < 0) {
+            return err;
+        }
+
+        switch (kind) {
+            case CLUSTER_ZERO:
+                memset(out, 0, n);
+                break;
+            case CLUSTER_DATA:
+                err = pread_full(img->fd, out, n, (entry & L2E_OFFSET_MASK) + in_cluster);
+                break;
+            case CLUSTER_COMPRESSED:
+                err = read_compressed(img, entry);
+                if (err == 0) {
+                    memcpy(out, img->dbuf + in_cluster, n);
+                }
+                break;
+            case CLUSTER_UNALLOCATED:
+                if (img->backing != NULL) {
+                    err = qcow2_read(img->backing, offset, out, n);
+                } else {
+                    memset(out, 0, n);
+                }
+                break;
+        }
+        if (err < 0) {
+            return err;
+        }
+
+        out += n;
+        offset += n;
+        len -= n;
+    }
+    return 0;
+}
+
+// ============================================
+// WRITER
+// ============================================
+
+static int writer_open(Qcow2Writer* w, const char* path, uint64_t size, uint32_t cluster_bits,
+                       const char* backing, const char* backing_fmt) {
+    memset(w, 0, sizeof(*w));
+    w->cluster_bits = cluster_bits;
+    w->cluster_size = 1ULL << cluster_bits;
+    w->size = size;
+    w->backing = backing;
+    w->backing_fmt = backing_fmt;
+
+    uint64_t l2_coverage = w->cluster_size * (w->cluster_size / sizeof(uint64_t));
+    uint64_t l1_size = div_round_up(size, l2_coverage);
+    if (l1_size > MAX_L1_ENTRIES) {
+        return -EFBIG;
+    }
+    w->l1_size = (uint32_t)l1_size;
+
+    w->l2 = (uint64_t**)calloc(w->l1_size ? w->l1_size : 1, sizeof(uint64_t*));
+    if (w->l2 == NULL) {
+        return -ENOMEM;
+    }
+
+    // Cluster 0 holds the header, written last
+    w->next_offset = w->cluster_size;
+
+    w->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (w->fd < 0) {
+        int err = -errno;
+        free(w->l2);
+        return err;
+    }
+    return 0;
+}
+
+static void writer_free(Qcow2Writer* w) {
+    if (w->l2 != NULL) {
+        for (uint32_t i = 0; i < w->l1_size; i++) {
+            free(w->l2[i]);
+        }
+        free(w->l2);
+        w->l2 = NULL;
+    }
+    if (w->fd >= 0) {
+        close(w->fd);
+        w->fd = -1;
+    }
+}
+
+/**
+ * Record a guest cluster: data == NULL marks it as a zero cluster
+ */
+static int writer_put(Qcow2Writer* w, uint64_t vcluster, const void* data) {
+    uint32_t l2_bits = w->cluster_bits - 3;
+    uint64_t l1_index = vcluster >> l2_bits;
+    uint64_t l2_index = vcluster & ((1ULL << l2_bits) - 1);
+
+    if (w->l2[l1_index] == NULL) {
+        w->l2[l1_index] = (uint64_t*)calloc(1, w->cluster_size);
+        if (w->l2[l1_index] == NULL) {
+            return -ENOMEM;
+        }
+    }
+
+    if (data == NULL) {
+        w->l2[l1_index][l2_index] = QCOW_OFLAG_ZERO;
+        return 0;
+    }
+
+    int err = pwrite_full(w->fd, data, w->cluster_size, w->next_offset);
+    if (err < 0) {
+        return err;
+    }
+    w->l2[l1_index][l2_index] = w->next_offset | QCOW_OFLAG_COPIED;
+    w->next_offset += w->cluster_size;
+    return 0;
+}
+
+/**
+ * Write L2 tables, L1 table, refcounts and finally the header.
+ * Every cluster in the new file is referenced exactly once.
+ */
+static int writer_finish(Qcow2Writer* w) {
+    uint64_t cs = w->cluster_size;
+    uint64_t* l1 = (uint64_t*)calloc(w->l1_size ? w->l1_size : 1, sizeof(uint64_t));
+    uint64_t* table = (uint64_t*)malloc(cs);
+    int err = 0;
+
+    if (l1 == NULL || table == NULL) {
+        free(l1);
+        free(table);
+        return -ENOMEM;
+    }
+
+    // L2 tables
+    for (uint32_t i = 0; i < w->l1_size && err == 0; i++) {
+        if (w->l2[i] == NULL) {
+            continue;
+        }
+        for (uint64_t j = 0; j < cs / sizeof(uint64_t); j++) {
+            table[j] = htobe64(w->l2[i][j]);
+        }
+        err = pwrite_full(w->fd, table, cs, w->next_offset);
+        l1[i] = htobe64(w->next_offset | QCOW_OFLAG_COPIED);
+        w->next_offset += cs;
+    }
+
+    // L1 table
+    uint64_t l1_offset = w->next_offset;
+    uint64_t l1_clusters = div_round_up((uint64_t)w->l1_size * sizeof(uint64_t), cs);
+    if (l1_clusters == 0) {
+        l1_clusters = 1;
+    }
+    if (err == 0 && w->l1_size > 0) {
+        err = pwrite_full(w->fd, l1, w->l1_size * sizeof(uint64_t), l1_offset);
+    }
+    w->next_offset += l1_clusters * cs;
+    free(l1);
+
+    // Refcount table and blocks (16-bit refcounts) sized to cover themselves
+    uint64_t used_clusters = w->next_offset / cs;
+    uint64_t refs_per_block = cs / sizeof(uint16_t);
+    uint64_t rb_clusters = 1;
+    uint64_t rt_clusters = 1;
+    for (;;) {
+        uint64_t total = used_clusters + rt_clusters + rb_clusters;
+        uint64_t rb = div_round_up(total, refs_per_block);
+        uint64_t rt = div_round_up(rb * sizeof(uint64_t), cs);
+        if (rb == rb_clusters && rt == rt_clusters) {
+            break;
+        }
+        rb_clusters = rb;
+        rt_clusters = rt;
+    }
+    uint64_t total_clusters = used_clusters + rt_clusters + rb_clusters;
+    uint64_t rt_offset = w->next_offset;
+    uint64_t rb_offset = rt_offset + rt_clusters * cs;
+
+    for (uint64_t c = 0; c < rt_clusters && err == 0; c++) {
+        memset(table, 0, cs);
+        for (uint64_t j = 0; j < cs / sizeof(uint64_t); j++) {
+            uint64_t block = c * (cs / sizeof(uint64_t)) + j;
+            if (block < rb_clusters) {
+                table[j] = htobe64(rb_offset + block * cs);
+            }
+        }
+        err = pwrite_full(w->fd, table, cs, rt_offset + c * cs);
+    }
+
+    uint16_t* refs = (uint16_t*)table;
+    for (uint64_t b = 0; b < rb_clusters && err == 0; b++) {
+        for (uint64_t j = 0; j < refs_per_block; j++) {
+            refs[j] = b * refs_per_block + j < total_clusters ? htobe16(1) : 0;
+        }
+        err = pwrite_full(w->fd, refs, cs, rb_offset + b * cs);
+    }
+
+    // Header, extensions and backing file name in cluster 0
+    if (err == 0) {
+        unsigned char* header = (unsigned char*)table;
+        memset(header, 0, cs);
+        put_be32(header + 0, QCOW2_MAGIC);
+        put_be32(header + 4, 3);
+        put_be32(header + 20, w->cluster_bits);
+        put_be64(header + 24, w->size);
+        put_be32(header + 36, w->l1_size);
+        put_be64(header + 40, l1_offset);
+        put_be64(header + 48, rt_offset);
+        put_be32(header + 56, (uint32_t)rt_clusters);
+        put_be32(header + 96, 4);                      // refcount_order: 16-bit
+        put_be32(header + 100, QCOW2_V3_HEADER_SIZE);
+
+        size_t pos = QCOW2_V3_HEADER_SIZE;
+        if (w->backing != NULL) {
+            size_t fmt_len = strlen(w->backing_fmt);
+            put_be32(header + pos, QCOW2_EXT_BACKING_FMT);
+            put_be32(header + pos + 4, (uint32_t)fmt_len);
+            memcpy(header + pos + 8, w->backing_fmt, fmt_len);
+            pos += 8 + ((fmt_len + 7) & ~(size_t)7);
+        }
+        pos += 8; // QCOW2_EXT_END
+
+        if (w->backing != NULL) {
+            size_t name_len = strlen(w->backing);
+            if (pos + name_len > cs) {
+                err = -ENAMETOOLONG;
+            } else {
+                memcpy(header + pos, w->backing, name_len);
+                put_be64(header + 8, pos);
+                put_be32(header + 16, (uint32_t)name_len);
+                pos += name_len;
+            }
+        }
+        if (err == 0) {
+            err = pwrite_full(w->fd, header, pos, 0);
+        }
+    }
+
+    if (err == 0 && ftruncate64(w->fd, total_clusters * cs) != 0) {
+        err = -errno;
+    }
+    if (err == 0 && fsync(w->fd) != 0) {
+        err = -errno;
+    }
+
+    free(table);
+    return err;
+}
+
+int qcow2_create(const char* path, uint64_t size, const char* backing, const char* backing_fmt) {
+    Qcow2Writer w;
+    int err = writer_open(&w, path, size, QCOW2_DEFAULT_CLUSTER_BITS, backing, backing_fmt);
+    if (err < 0) {
+        return err;
+    }
+    err = writer_finish(&w);
+    writer_free(&w);
+    if (err < 0) {
+        LOGE("Failed to create %s: %s", path, strerror(-err));
+        unlink(path);
+    }
+    return err;
+}
+
+int qcow2_rewrite(const char* src_path, const char* dest_path, int keep_backing,
+                  progress_fn progress, void* progress_ctx, Qcow2RewriteStats* stats) {
+    long start_ms = get_current_time_ms();
+    Qcow2Image* src = NULL;
+    int err = qcow2_open(src_path, &src);
+    if (err < 0) {
+        LOGE("Failed to open %s: %s", src_path, strerror(-err));
+        return err;
+    }
+    if (src->raw && keep_backing) {
+        qcow2_close(src);
+        return -EINVAL;
+    }
+
+    // Keep the exact backing reference of the source top layer
+    char backing_name[1024] = {0};
+    const char* backing = NULL;
+    if (keep_backing && src->backing != NULL) {
+        unsigned char header[20];
+        err = pread_full(src->fd, header, sizeof(header), 0);
+        uint32_t name_len = get_be32(header + 16);
+        if (err == 0 && name_len < sizeof(backing_name)) {
+            err = pread_full(src->fd, backing_name, name_len, get_be64(header + 8));
+            backing = backing_name;
+        }
+        if (err < 0 || backing == NULL) {
+            qcow2_close(src);
+            return err < 0 ? err : -ENAMETOOLONG;
+        }
+    }
+
+    Qcow2Writer w;
+    err = writer_open(&w, dest_path, src->size, src->cluster_bits, backing,
+                      src->backing_fmt[0] ? src->backing_fmt : qcow2_format(src->backing ? src->backing : src));
+    if (err < 0) {
+        qcow2_close(src);
+        return err;
+    }
+
+    unsigned char* buf = (unsigned char*)malloc(src->cluster_size);
+    uint64_t clusters = div_round_up(src->size, src->cluster_size);
+    long last_report = 0;
+    if (buf == NULL) {
+        err = -ENOMEM;
+    }
+
+    for (uint64_t vc = 0; vc < clusters && err == 0; vc++) {
+        if (keep_backing) {
+            // Top layer only: holes keep reading through to the backing file
+            uint64_t entry;
+            ClusterKind kind;
+            err = cluster_kind(src, vc, &entry, &kind);
+            if (err < 0 || kind == CLUSTER_UNALLOCATED) {
+                continue;
+            }
+            if (kind == CLUSTER_ZERO) {
+                err = writer_put(&w, vc, NULL);
+                continue;
+            }
+            err = read_own_cluster(src, kind, entry, buf);
+            if (err == 0) {
+                err = writer_put(&w, vc, is_zero(buf, src->cluster_size) ? NULL : buf);
+            }
+        } else {
+            // Whole chain: zeros become holes in the standalone image
+            err = qcow2_read(src, vc * src->cluster_size, buf, src->cluster_size);
+            if (err == 0 && !is_zero(buf, src->cluster_size)) {
+                err = writer_put(&w, vc, buf);
+            }
+        }
+
+        long now = get_current_time_ms();
+        if (progress != NULL && now - last_report >= 100) {
+            progress(progress_ctx, (long long)vc, (long long)clusters);
+            last_report = now;
+        }
+    }
+    free(buf);
+
+    if (err == 0) {
+        err = writer_finish(&w);
+    }
+    writer_free(&w);
+    qcow2_close(src);
+
+    if (err < 0) {
+        LOGE("Rewriting %s failed: %s", src_path, strerror(-err));
+        unlink(dest_path);
+        return err;
+    }
+
+    if (progress != NULL) {
+        progress(progress_ctx, (long long)clusters, (long long)clusters);
+    }
+    if (stats != NULL) {
+        stats->bytes_before = allocated_bytes(src_path);
+        stats->bytes_after = allocated_bytes(dest_path);
+    }
+    LOGI("Rewrote %s -> %s (%s) in %ld ms", src_path, dest_path,
+         keep_backing ? "compact" : "flatten", get_current_time_ms() - start_ms);
+    return 0;
+}
@@ -0,0 +1,61 @@
+/**
+ * QCOW2 Image Access
+ * Minimal qcow2 reader/writer for layered VM disks
+ */
+
+#ifndef QCOW2_H
+#define QCOW2_H
+
+#include <stdint.h>
+#include <sys/types.h>
+
+#include "decompress.h"
+
+#define QCOW2_DEFAULT_CLUSTER_BITS 16   // 64 KB clusters, as qemu-img uses
+
+/**
+ * Open image (qcow2 or raw) with its backing chain
+ */
+typedef struct Qcow2Image Qcow2Image;
+
+/**
+ * Result of qcow2_rewrite()
+ */
+typedef struct {
+    long long bytes_before;   // allocated bytes of the source top layer
+    long long bytes_after;    // allocated bytes of the rewritten image
+} Qcow2RewriteStats;
+
+/**
+ * Create an empty qcow2 v3 image of the given virtual size.
+ * backing may be NULL; otherwise backing_fmt ("qcow2" or "raw") is recorded.
+ * Returns 0 or a negative errno.
+ */
+int qcow2_create(const char* path, uint64_t size, const char* backing, const char* backing_fmt);
+
+/**
+ * Open an image read-only, following its backing files.
+ * Returns 0 or a negative errno; *out is set on success.
+ */
+int qcow2_open(const char* path, Qcow2Image** out);
+void qcow2_close(Qcow2Image* img);
+
+uint64_t qcow2_virtual_size(const Qcow2Image* img);
+const char* qcow2_format(const Qcow2Image* img);
+
+/**
+ * Read guest data through the backing chain; holes read as zeros
+ */
+int qcow2_read(Qcow2Image* img, uint64_t offset, void* buf, size_t len);
+
+/**
+ * Write src_path into a fresh qcow2 image at dest_path.
+ * keep_backing = 1 copies only the top layer and keeps its backing file;
+ * keep_backing = 0 flattens the whole chain into a standalone image.
+ * Zero and unallocated clusters are never written.
+ * Returns 0 or a negative errno.
+ */
+int qcow2_rewrite(const char* src_path, const char* dest_path, int keep_backing,
+                  progress_fn progress, void* progress_ctx, Qcow2RewriteStats* stats);
+
+#endif // QCOW2_H
@@ -0,0 +1,822 @@
+/**
+ * QEMU JSI bindings
+ * Installs global.__QemuNative into the JS runtime with synchronous
+ * getters that read the native VM status directly:
+ *
+ *   getStatus()      same shape as QemuModule.getStatus, minus jit
+ *   getLogs(lines)   last lines of the serial console
+ *   stats            ArrayBuffer with the stats block (see vm_stats.h)
+ *   readStats()      refresh stats from the live block; returns its
+ *                    sequence number, 0 if a write kept it busy
+ *   logOpen() ...    line-indexed log buffers for LogViewer (log_index.h):
+ *                    logOpen, logAppend, logLineCount, logWindow,
+ *                    logFind, logClear, logClose
+ *   termOpen() ...   terminal emulators for Terminal (vt_term.h):
+ *                    termOpen, termWrite, termResize, termReset,
+ *                    termFrame, termLines, termClose
+ *   kvGet(key) ...   the settings store (kv_store.h): kvGet, kvGetAll,
+ *                    kvSet, kvRemove, kvKeys, kvClear
+ *
+ * No bridge message, no WritableMap and no Java allocation per call; the
+ * cost is a memcpy or two and the JS objects returned. Start and stop
+ * stay on QemuModule: they are rare, already asynchronous and would need
+ * the bridge's call invoker to settle a promise from another thread.
+ */
+
+#include <jni.h>
+#include <jsi/jsi.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <android/log.h>
+
+#include <algorithm>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "kv_store.h"
+#include "log_index.h"
+#include "vm_health.h"
+#include "vm_stats.h"
+#include "vm_status.h"
+#include "vt_term.h"
+
+#define TAG "QemuJsi"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+using namespace facebook;
+
+namespace {
+
+constexpr size_t LOG_TAIL_BYTES = 64 * 1024;
+// Longer lines are cut for display; one read covers a window up to this
+constexpr size_t LOG_LINE_MAX_BYTES = 4096;
+constexpr size_t LOG_WINDOW_READ_BYTES = 1024 * 1024;
+constexpr size_t LOG_WINDOW_MAX_LINES = 1024;
+
+// Where log buffers keep their files
+std::string log_dir;
+
+constexpr int TERM_MAX_RECTS = 64;
+constexpr int TERM_MAX_ROWS = 500;
+constexpr int TERM_MAX_COLS = 1000;
+
+// Settings; opened once and kept across reloads, JS thread only
+kv_store_t* settings = nullptr;
+
+int64_t now_ms(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * Private copy of the stats block for one runtime. JS reads it through
+ * typed arrays; readStats() refreshes it in place, so a frame's read
+ * allocates nothing.
+ */
+class StatsBuffer : public jsi::MutableBuffer {
+public:
+    size_t size() const override {
+        return sizeof(snapshot);
+    }
+
+    uint8_t* data() override {
+        return reinterpret_cast<uint8_t*>(&snapshot);
+    }
+
+    vm_stats_block_t snapshot = {};
+};
+
+/**
+ * Log buffers and terminals by handle for one runtime. Its host functions
+ * share it, so it goes when the runtime drops them on teardown or reload,
+ * closing whatever JS left open. Only touched on the JS thread.
+ */
+class Handles {
+public:
+    Handles() = default;
+    Handles(const Handles&) = delete;
+    Handles& operator=(const Handles&) = delete;
+
+    ~Handles() {
+        for (auto& entry : logs) {
+            log_index_close(entry.second);
+        }
+        for (auto& entry : terms) {
+            vt_term_close(entry.second);
+        }
+    }
+
+    std::unordered_map<int, log_index_t*> logs;
+    std::unordered_map<int, vt_term_t*> terms;
+    int next_log = 1;
+    int next_term = 1;
+};
+
+jsi::String text(jsi::Runtime& rt, const char* value) {
+    return jsi::String::createFromUtf8(rt, std::string(value));
+}
+
+jsi::Value get_status(jsi::Runtime& rt) {
+    vm_status_t status;
+    vm_status_snapshot(&status);
+    const double* v = status.values;
+    int sections = (int)v[VM_STATUS_SECTIONS];
+    bool running = status.pid > 0;
+
+    jsi::Object result(rt);
+    const char* state = "stopped";
+    if (running) {
+        state = "running";
+    } else if ((sections & VM_SECTION_SUPERVISOR) &&
+               strcmp(status.texts[VM_TEXT_SUPERVISOR_STATE], "restarting") == 0) {
+        state = "restarting";
+    }
+    result.setProperty(rt, "status", text(rt, state));
+
+    if (running) {
+        // CPU and memory from the stats sampler (vm_stats.c)
+        vm_stats_block_t stats;
+        bool sampled = vm_stats_read(&stats) != 0 && stats.vm[VM_STAT_PID] == status.pid;
+        double started = v[VM_STATUS_STARTED_AT];
+        result.setProperty(rt, "uptime",
+            started > 0 ? (double)((now_ms(CLOCK_REALTIME) - (int64_t)started) / 1000) : 0.0);
+        result.setProperty(rt, "cpuUsage", sampled ? stats.vm[VM_STAT_CPU_PCT] : 0.0);
+        result.setProperty(rt, "memoryUsage", sampled ? stats.vm[VM_STAT_MEM_PCT] : 0.0);
+        result.setProperty(rt, "suspended", v[VM_STATUS_SUSPENDED] != 0);
+        result.setProperty(rt, "pid", (double)status.pid);
+
+        if (sections & VM_SECTION_BALLOON) {
+            jsi::Object balloon(rt);
+            double actual = v[VM_STATUS_BALLOON_ACTUAL_MB];
+            double ram = v[VM_STATUS_RAM_MB];
+            balloon.setProperty(rt, "ramMB", ram);
+            balloon.setProperty(rt, "actualMB", actual);
+            balloon.setProperty(rt, "sizeMB", ram > actual ? ram - actual : 0.0);
+            balloon.setProperty(rt, "targetMB", v[VM_STATUS_BALLOON_TARGET_MB]);
+            balloon.setProperty(rt, "floorMB", v[VM_STATUS_BALLOON_FLOOR_MB]);
+            balloon.setProperty(rt, "workingSetMB", v[VM_STATUS_BALLOON_WORKING_SET_MB]);
+            balloon.setProperty(rt, "pressure", text(rt, status.texts[VM_TEXT_BALLOON_PRESSURE]));
+            balloon.setProperty(rt, "updatedAt", v[VM_STATUS_BALLOON_UPDATED_AT]);
+            result.setProperty(rt, "balloon", std::move(balloon));
+        }
+
+        if (sections & VM_SECTION_POWER) {
+            jsi::Object power(rt);
+            power.setProperty(rt, "policy", text(rt, status.texts[VM_TEXT_POWER_POLICY]));
+            power.setProperty(rt, "tier", text(rt, status.texts[VM_TEXT_POWER_TIER]));
+            power.setProperty(rt, "reason", text(rt, status.texts[VM_TEXT_POWER_REASON]));
+            power.setProperty(rt, "cores", v[VM_STATUS_POWER_CORES]);
+            power.setProperty(rt, "tempC", v[VM_STATUS_POWER_TEMP_C]);
+            power.setProperty(rt, "thermal", text(rt, status.texts[VM_TEXT_POWER_THERMAL]));
+            power.setProperty(rt, "charging", v[VM_STATUS_POWER_CHARGING] != 0);
+            power.setProperty(rt, "batteryPct", v[VM_STATUS_POWER_BATTERY_PCT]);
+            power.setProperty(rt, "screenOn", v[VM_STATUS_POWER_SCREEN_ON] != 0);
+            power.setProperty(rt, "changedAt", v[VM_STATUS_POWER_CHANGED_AT]);
+            power.setProperty(rt, "changes", v[VM_STATUS_POWER_CHANGES]);
+            result.setProperty(rt, "power", std::move(power));
+        }
+
+        // Cached probes (vm_health.c); null until a probe has an answer
+        vm_health_t health;
+        vm_health_read(&health);
+        auto probe = [](int value) {
+            return value == VM_HEALTH_UNKNOWN ? jsi::Value::null() : jsi::Value(value == VM_HEALTH_UP);
+        };
+        jsi::Object checks(rt);
+        checks.setProperty(rt, "processAlive", health.pid > 0);
+        checks.setProperty(rt, "runState", text(rt, health.run_state));
+        checks.setProperty(rt, "qmpResponsive", probe(health.qmp));
+        checks.setProperty(rt, "qmpLatencyMs", health.qmp_latency_us / 1000);
+        checks.setProperty(rt, "qmpCheckedAt", health.qmp_checked_at);
+        checks.setProperty(rt, "qmpFailures", (double)health.qmp_failures);
+        checks.setProperty(rt, "dockerResponsive", probe(health.docker));
+        checks.setProperty(rt, "dockerLatencyMs", health.docker_latency_us / 1000);
+        checks.setProperty(rt, "dockerCheckedAt", health.docker_checked_at);
+        checks.setProperty(rt, "dockerFailures", (double)health.docker_failures);
+        result.setProperty(rt, "health", std::move(checks));
+    } else {
+        result.setProperty(rt, "uptime", 0.0);
+        result.setProperty(rt, "cpuUsage", 0.0);
+        result.setProperty(rt, "memoryUsage", 0.0);
+    }
+
+    if (sections & VM_SECTION_ACTIVATION) {
+        jsi::Object activation(rt);
+        activation.setProperty(rt, "listening", v[VM_STATUS_ACTIVATION_LISTENING] != 0);
+        activation.setProperty(rt, "waiting", v[VM_STATUS_ACTIVATION_WAITING]);
+        activation.setProperty(rt, "activations", v[VM_STATUS_ACTIVATION_COUNT]);
+        activation.setProperty(rt, "lastWaitMs", v[VM_STATUS_ACTIVATION_LAST_WAIT_MS]);
+        activation.setProperty(rt, "maxWaitMs", v[VM_STATUS_ACTIVATION_MAX_WAIT_MS]);
+        result.setProperty(rt, "activation", std::move(activation));
+    }
+
+    if (sections & VM_SECTION_SUPERVISOR) {
+        jsi::Object supervisor(rt);
+        supervisor.setProperty(rt, "state", text(rt, status.texts[VM_TEXT_SUPERVISOR_STATE]));
+        supervisor.setProperty(rt, "restarts", v[VM_STATUS_SUPERVISOR_RESTARTS]);
+        supervisor.setProperty(rt, "recentCrashes", v[VM_STATUS_SUPERVISOR_RECENT]);
+        supervisor.setProperty(rt, "nextRestartAt", v[VM_STATUS_SUPERVISOR_NEXT_RESTART]);
+        if (sections & VM_SECTION_CRASH) {
+            jsi::Object crash(rt);
+            crash.setProperty(rt, "time", v[VM_STATUS_CRASH_TIME]);
+            crash.setProperty(rt, "uptimeMs", v[VM_STATUS_CRASH_UPTIME_MS]);
+            crash.setProperty(rt, "exitCode", v[VM_STATUS_CRASH_EXIT_CODE]);
+            crash.setProperty(rt, "signal", v[VM_STATUS_CRASH_SIGNAL]);
+            crash.setProperty(rt, "reason", text(rt, status.texts[VM_TEXT_CRASH_REASON]));
+            crash.setProperty(rt, "file", text(rt, status.texts[VM_TEXT_CRASH_FILE]));
+            supervisor.setProperty(rt, "lastCrash", std::move(crash));
+        }
+        result.setProperty(rt, "supervisor", std::move(supervisor));
+    }
+
+    result.setProperty(rt, "generation", (double)status.generation);
+    return jsi::Value(std::move(result));
+}
+
+jsi::Value get_logs(jsi::Runtime& rt, int lines) {
+    std::vector<char> buf(LOG_TAIL_BYTES);
+    size_t len = vm_status_serial_tail(buf.data(), buf.size());
+
+    // Walk back to the start of the last `lines` lines; a trailing
+    // newline does not start a line of its own
+    size_t start = len;
+    int seen = 0;
+    if (start > 0 && buf[start - 1] == '\n') {
+        start--;
+    }
+    while (start > 0) {
+        if (buf[start - 1] == '\n' && ++seen >= lines) {
+            break;
+        }
+        start--;
+    }
+    return jsi::Value(jsi::String::createFromUtf8(rt, (const uint8_t*)buf.data() + start, len - start));
+}
+
+log_index_t* log_arg(jsi::Runtime& rt, Handles& handles, const jsi::Value* args, size_t count) {
+    if (count == 0 || !args[0].isNumber()) {
+        throw jsi::JSError(rt, "log handle expected");
+    }
+    auto it = handles.logs.find((int)args[0].asNumber());
+    if (it == handles.logs.end()) {
+        throw jsi::JSError(rt, "unknown or closed log handle");
+    }
+    return it->second;
+}
+
+/**
+ * UTF-16 length of UTF-8 text: JS string indices for highlight spans
+ */
+size_t utf16_length(const char* text, size_t len) {
+    size_t units = 0;
+    for (size_t i = 0; i < len; i++) {
+        unsigned char c = (unsigned char)text[i];
+        if ((c & 0xC0) != 0x80) {
+            units += c >= 0xF0 ? 2 : 1;
+        }
+    }
+    return units;
+}
+
+/**
+ * Cut a line to LOG_LINE_MAX_BYTES on a character boundary and drop
+ * a trailing '\r'
+ */
+size_t display_length(const char* text, size_t len) {
+    if (len > LOG_LINE_MAX_BYTES) {
+        len = LOG_LINE_MAX_BYTES;
+        while (len > 0 && ((unsigned char)text[len] & 0xC0) == 0x80) {
+            len--;
+        }
+    }
+    if (len > 0 && text[len - 1] == '\r') {
+        len--;
+    }
+    return len;
+}
+
+/**
+ * Lines first .. first+count-1 and, with a query, where it matches in
+ * them: { first, lines: [...], spans: [row, start, length, ...] }
+ */
+jsi::Value log_window(jsi::Runtime& rt, log_index_t* index, size_t first, size_t count,
+                      const std::string& query) {
+    count = std::min(count, LOG_WINDOW_MAX_LINES);
+    std::vector<uint64_t> starts(count);
+    std::vector<uint64_t> ends(count);
+    ssize_t n = log_index_window(index, first, count, starts.data(), ends.data());
+    if (n < 0) {
+        throw jsi::JSError(rt, "log window read failed");
+    }
+
+    // One read for the window unless a huge line would make it large
+    std::vector<char> text;
+    uint64_t base = n > 0 ? starts[0] : 0;
+    bool single = n > 0 && ends[n - 1] - base <= LOG_WINDOW_READ_BYTES;
+    if (single) {
+        text.resize(ends[n - 1] - base);
+        if (log_index_read(index, text.data(), text.size(), base) != (ssize_t)text.size()) {
+            throw jsi::JSError(rt, "log window read failed");
+        }
+    }
+
+    jsi::Array lines(rt, (size_t)n);
+    std::vector<double> spans;
+    std::vector<char> line_buf;
+    for (ssize_t row = 0; row < n; row++) {
+        const char* line;
+        size_t len = ends[row] - starts[row];
+        if (single) {
+            line = text.data() + (starts[row] - base);
+        } else {
+            line_buf.resize(std::min(len, LOG_LINE_MAX_BYTES + 1));
+            ssize_t got = log_index_read(index, line_buf.data(), line_buf.size(), starts[row]);
+            line = line_buf.data();
+            len = got > 0 ? (size_t)got : 0;
+        }
+        len = display_length(line, len);
+        lines.setValueAtIndex(rt, (size_t)row,
+            jsi::String::createFromUtf8(rt, reinterpret_cast<const uint8_t*>(line), len));
+
+        // Every match in the line, in UTF-16 units
+        size_t at = 0;
+        ssize_t match;
+        while (!query.empty() &&
+               (match = log_index_match(line + at, len - at, query.data(), query.size())) >= 0) {
+            size_t start = at + (size_t)match;
+            spans.push_back((double)row);
+            spans.push_back((double)utf16_length(line, start));
+            spans.push_back((double)utf16_length(line + start, query.size()));
+            at = start + query.size();
+        }
+    }
+
+    jsi::Array span_array(rt, spans.size());
+    for (size_t i = 0; i < spans.size(); i++) {
+        span_array.setValueAtIndex(rt, i, spans[i]);
+    }
+    jsi::Object result(rt);
+    result.setProperty(rt, "first", (double)first);
+    result.setProperty(rt, "lines", std::move(lines));
+    result.setProperty(rt, "spans", std::move(span_array));
+    return jsi::Value(std::move(result));
+}
+
+void install_logs(jsi::Runtime& rt, jsi::Object& qemu, const std::shared_ptr<Handles>& handles) {
+    qemu.setProperty(rt, "logOpen", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "logOpen"), 0,
+        [handles](jsi::Runtime&, const jsi::Value&, const jsi::Value*, size_t) {
+            log_index_t* index = log_index_open(log_dir.c_str());
+            if (index == nullptr) {
+                return jsi::Value(0);
+            }
+            int handle = handles->next_log++;
+            handles->logs[handle] = index;
+            return jsi::Value(handle);
+        }));
+    qemu.setProperty(rt, "logAppend", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "logAppend"), 2,
+        [handles](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            log_index_t* index = log_arg(rt, *handles, args, count);
+            if (count > 1 && args[1].isString()) {
+                std::string text = args[1].asString(rt).utf8(rt);
+                if (log_index_append(index, text.data(), text.size()) < 0) {
+                    throw jsi::JSError(rt, "log append failed");
+                }
+            }
+            return jsi::Value((double)log_index_line_count(index));
+        }));
+    qemu.setProperty(rt, "logLineCount", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "logLineCount"), 1,
+        [handles](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            return jsi::Value((double)log_index_line_count(log_arg(rt, *handles, args, count)));
+        }));
+    qemu.setProperty(rt, "logWindow", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "logWindow"), 4,
+        [handles](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            log_index_t* index = log_arg(rt, *handles, args, count);
+            double first = count > 1 && args[1].isNumber() ? args[1].asNumber() : 0;
+            double lines = count > 2 && args[2].isNumber() ? args[2].asNumber() : 0;
+            std::string query = count > 3 && args[3].isString() ? args[3].asString(rt).utf8(rt) : "";
+            return log_window(rt, index, first > 0 ? (size_t)first : 0, lines > 0 ? (size_t)lines : 0, query);
+        }));
+    qemu.setProperty(rt, "logFind", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "logFind"), 4,
+        [handles](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            log_index_t* index = log_arg(rt, *handles, args, count);
+            if (count < 2 || !args[1].isString()) {
+                return jsi::Value(-1);
+            }
+            std::string query = args[1].asString(rt).utf8(rt);
+            double from = count > 2 && args[2].isNumber() ? args[2].asNumber() : 0;
+            bool backwards = count > 3 && args[3].isBool() && args[3].getBool();
+            return jsi::Value((double)log_index_find(index, query.c_str(), from > 0 ? (size_t)from : 0, backwards));
+        }));
+    qemu.setProperty(rt, "logClear", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "logClear"), 1,
+        [handles](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            log_index_clear(log_arg(rt, *handles, args, count));
+            return jsi::Value::undefined();
+        }));
+    qemu.setProperty(rt, "logClose", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "logClose"), 1,
+        [handles](jsi::Runtime&, const jsi::Value&, const jsi::Value* args, size_t count) {
+            if (count > 0 && args[0].isNumber()) {
+                auto it = handles->logs.find((int)args[0].asNumber());
+                if (it != handles->logs.end()) {
+                    log_index_close(it->second);
+                    handles->logs.erase(it);
+                }
+            }
+            return jsi::Value::undefined();
+        }));
+}
+
+vt_term_t* term_arg(jsi::Runtime& rt, Handles& handles, const jsi::Value* args, size_t count) {
+    if (count == 0 || !args[0].isNumber()) {
+        throw jsi::JSError(rt, "terminal handle expected");
+    }
+    auto it = handles.terms.find((int)args[0].asNumber());
+    if (it == handles.terms.end()) {
+        throw jsi::JSError(rt, "unknown or closed terminal handle");
+    }
+    return it->second;
+}
+
+int int_arg(const jsi::Value* args, size_t count, size_t i, int fallback) {
+    return i < count && args[i].isNumber() ? (int)args[i].asNumber() : fallback;
+}
+
+void append_utf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += (char)cp;
+    } else if (cp < 0x800) {
+        out += (char)(0xC0 | (cp >> 6));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else if (cp < 0x10000) {
+        out += (char)(0xE0 | (cp >> 12));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    } else {
+        out += (char)(0xF0 | (cp >> 18));
+        out += (char)(0x80 | ((cp >> 12) & 0x3F));
+        out += (char)(0x80 | ((cp >> 6) & 0x3F));
+        out += (char)(0x80 | (cp & 0x3F));
+    }
+}
+
+/**
+ * A line as styled runs: [text, style, text, style, ...] with style
+ * fg | bg << 8 | attr << 16. Trailing blanks without a background are
+ * dropped.
+ */
+jsi::Array line_runs(jsi::Runtime& rt, const vt_cell_t* cells, int cols) {
+    constexpr uint16_t STYLE_ATTRS = 0x03FF;
+    int end = cols;
+    while (end > 0 && cells[end - 1].ch == 0 &&
+           !(cells[end - 1].attr & (VT_ATTR_BG | VT_ATTR_INVERSE))) {
+        end--;
+    }
+
+    std::vector<std::pair<std::string, double>> runs;
+    for (int x = 0; x < end; x++) {
+        const vt_cell_t& cell = cells[x];
+        if (cell.attr & VT_ATTR_WIDE_CONT) {
+            continue;
+        }
+        uint16_t attr = cell.attr & STYLE_ATTRS;
+        double style = (double)((cell.fg) | (cell.bg << 8) | ((uint32_t)attr << 16));
+        if (runs.empty() || runs.back().second != style) {
+            runs.emplace_back(std::string(), style);
+        }
+        append_utf8(runs.back().first, cell.ch != 0 ? cell.ch : ' ');
+    }
+
+    jsi::Array result(rt, runs.size() * 2);
+    for (size_t i = 0; i < runs.size(); i++) {
+        result.setValueAtIndex(rt, i * 2, jsi::String::createFromUtf8(rt, runs[i].first));
+        result.setValueAtIndex(rt, i * 2 + 1, runs[i].second);
+    }
+    return result;
+}
+
+/**
+ * What changed since the last frame, null if nothing did:
+ * { rows, cols, ids?, damaged: [row, runs, ...], cursor: [row, col, visible],
+ *   history, flags, title?, reply? }
+ * ids (the screen's line ids) only come when lines moved.
+ */
+jsi::Value term_frame(jsi::Runtime& rt, vt_term_t* term) {
+    unsigned changes = vt_term_take_changes(term);
+    vt_rect_t rects[TERM_MAX_RECTS];
+    int count = vt_term_damage(term, rects, TERM_MAX_RECTS);
+    char reply[256];
+    size_t reply_len = vt_term_take_reply(term, reply, sizeof(reply));
+    if (changes == 0 && count == 0 && reply_len == 0) {
+        return jsi::Value::null();
+    }
+
+    // Rows are the unit a renderer redraws; rectangles never overlap
+    int rows = vt_term_rows(term);
+    int cols = vt_term_cols(term);
+    std::vector<int> damaged;
+    for (int i = 0; i < count; i++) {
+        for (int y = rects[i].row; y < rects[i].row + rects[i].rows; y++) {
+            damaged.push_back(y);
+        }
+    }
+    jsi::Array lines(rt, damaged.size() * 2);
+    for (size_t i = 0; i < damaged.size(); i++) {
+        lines.setValueAtIndex(rt, i * 2, damaged[i]);
+        lines.setValueAtIndex(rt, i * 2 + 1, line_runs(rt, vt_term_line(term, damaged[i]), cols));
+    }
+
+    int cursor_row;
+    int cursor_col;
+    vt_term_cursor(term, &cursor_row, &cursor_col);
+    unsigned flags = vt_term_flags(term);
+    jsi::Array cursor(rt, 3);
+    cursor.setValueAtIndex(rt, 0, cursor_row);
+    cursor.setValueAtIndex(rt, 1, cursor_col);
+    cursor.setValueAtIndex(rt, 2, (flags & VT_FLAG_CURSOR_VISIBLE) != 0);
+
+    jsi::Object frame(rt);
+    frame.setProperty(rt, "rows", rows);
+    frame.setProperty(rt, "cols", cols);
+    if (changes & VT_CHANGED_LINES) {
+        jsi::Array ids(rt, (size_t)rows);
+        for (int y = 0; y < rows; y++) {
+            ids.setValueAtIndex(rt, (size_t)y, (double)vt_term_line_id(term, y));
+        }
+        frame.setProperty(rt, "ids", std::move(ids));
+    }
+    frame.setProperty(rt, "damaged", std::move(lines));
+    frame.setProperty(rt, "cursor", std::move(cursor));
+    frame.setProperty(rt, "history", vt_term_history(term));
+    frame.setProperty(rt, "flags", (double)flags);
+    if (changes & VT_CHANGED_TITLE) {
+        frame.setProperty(rt, "title", jsi::String::createFromUtf8(rt, vt_term_title(term)));
+    }
+    if (reply_len > 0) {
+        frame.setProperty(rt, "reply", jsi::String::createFromUtf8(
+            rt, reinterpret_cast<const uint8_t*>(reply), reply_len));
+    }
+    return jsi::Value(std::move(frame));
+}
+
+void install_terms(jsi::Runtime& rt, jsi::Object& qemu, const std::shared_ptr<Handles>& handles) {
+    qemu.setProperty(rt, "termOpen", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "termOpen"), 3,
+        [handles](jsi::Runtime&, const jsi::Value&, const jsi::Value* args, size_t count) {
+            int rows = std::min(int_arg(args, count, 0, 24), TERM_MAX_ROWS);
+            int cols = std::min(int_arg(args, count, 1, 80), TERM_MAX_COLS);
+            vt_term_t* term = vt_term_open(rows, cols, int_arg(args, count, 2, 1000));
+            if (term == nullptr) {
+                return jsi::Value(0);
+            }
+            int handle = handles->next_term++;
+            handles->terms[handle] = term;
+            return jsi::Value(handle);
+        }));
+    qemu.setProperty(rt, "termWrite", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "termWrite"), 2,
+        [handles](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            vt_term_t* term = term_arg(rt, *handles, args, count);
+            if (count > 1 && args[1].isString()) {
+                std::string text = args[1].asString(rt).utf8(rt);
+                vt_term_write(term, text.data(), text.size());
+            }
+            return jsi::Value::undefined();
+        }));
+    qemu.setProperty(rt, "termResize", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "termResize"), 3,
+        [handles](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            vt_term_t* term = term_arg(rt, *handles, args, count);
+            int rows = std::min(int_arg(args, count, 1, 0), TERM_MAX_ROWS);
+            int cols = std::min(int_arg(args, count, 2, 0), TERM_MAX_COLS);
+            return jsi::Value(vt_term_resize(term, rows, cols) == 0);
+        }));
+    qemu.setProperty(rt, "termReset", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "termReset"), 1,
+        [handles](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            vt_term_reset(term_arg(rt, *handles, args, count));
+            return jsi::Value::undefined();
+        }));
+    qemu.setProperty(rt, "termFrame", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "termFrame"), 1,
+        [handles](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            return term_frame(rt, term_arg(rt, *handles, args, count));
+        }));
+    qemu.setProperty(rt, "termLines", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "termLines"), 3,
+        [handles](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            // Runs of lines first .. first+count-1; negative is scrollback
+            vt_term_t* term = term_arg(rt, *handles, args, count);
+            int first = int_arg(args, count, 1, 0);
+            int lines = std::max(0, std::min(int_arg(args, count, 2, 0), TERM_MAX_ROWS));
+            int cols = vt_term_cols(term);
+            jsi::Array result(rt, (size_t)lines);
+            for (int i = 0; i < lines; i++) {
+                const vt_cell_t* cells = vt_term_line(term, first + i);
+                if (cells != nullptr) {
+                    result.setValueAtIndex(rt, (size_t)i, line_runs(rt, cells, cols));
+                } else {
+                    result.setValueAtIndex(rt, (size_t)i, jsi::Array(rt, 0));
+                }
+            }
+            return jsi::Value(std::move(result));
+        }));
+    qemu.setProperty(rt, "termClose", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "termClose"), 1,
+        [handles](jsi::Runtime&, const jsi::Value&, const jsi::Value* args, size_t count) {
+            if (count > 0 && args[0].isNumber()) {
+                auto it = handles->terms.find((int)args[0].asNumber());
+                if (it != handles->terms.end()) {
+                    vt_term_close(it->second);
+                    handles->terms.erase(it);
+                }
+            }
+            return jsi::Value::undefined();
+        }));
+}
+
+kv_store_t* settings_arg(jsi::Runtime& rt) {
+    if (settings == nullptr) {
+        throw jsi::JSError(rt, "settings store unavailable");
+    }
+    return settings;
+}
+
+std::string key_arg(jsi::Runtime& rt, const jsi::Value* args, size_t count) {
+    if (count == 0 || !args[0].isString()) {
+        throw jsi::JSError(rt, "key expected");
+    }
+    return args[0].asString(rt).utf8(rt);
+}
+
+jsi::String utf8_string(jsi::Runtime& rt, const char* data, size_t len) {
+    return jsi::String::createFromUtf8(rt, reinterpret_cast<const uint8_t*>(data), len);
+}
+
+void install_settings(jsi::Runtime& rt, jsi::Object& qemu) {
+    qemu.setProperty(rt, "kvGet", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "kvGet"), 1,
+        [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            std::string key = key_arg(rt, args, count);
+            const char* value;
+            size_t len;
+            if (!kv_store_get(settings_arg(rt), key.data(), key.size(), &value, &len)) {
+                return jsi::Value::undefined();
+            }
+            return jsi::Value(utf8_string(rt, value, len));
+        }));
+    qemu.setProperty(rt, "kvGetAll", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "kvGetAll"), 0,
+        [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value*, size_t) {
+            // Everything in one call: what startup reads before first render
+            struct Each {
+                jsi::Runtime& rt;
+                jsi::Object result;
+            } each{rt, jsi::Object(rt)};
+            kv_store_each(settings_arg(rt), [](void* ctx, const char* key, size_t key_len,
+                                               const char* value, size_t value_len) {
+                auto* e = static_cast<Each*>(ctx);
+                e->result.setProperty(e->rt,
+                    jsi::PropNameID::forUtf8(e->rt, reinterpret_cast<const uint8_t*>(key), key_len),
+                    utf8_string(e->rt, value, value_len));
+                return 0;
+            }, &each);
+            return jsi::Value(std::move(each.result));
+        }));
+    qemu.setProperty(rt, "kvSet", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "kvSet"), 2,
+        [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            std::string key = key_arg(rt, args, count);
+            if (count < 2 || !args[1].isString()) {
+                throw jsi::JSError(rt, "string value expected");
+            }
+            std::string value = args[1].asString(rt).utf8(rt);
+            int err = kv_store_set(settings_arg(rt), key.data(), key.size(), value.data(), value.size());
+            if (err < 0) {
+                throw jsi::JSError(rt, std::string("settings write failed: ") + strerror(-err));
+            }
+            return jsi::Value::undefined();
+        }));
+    qemu.setProperty(rt, "kvRemove", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "kvRemove"), 1,
+        [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            std::string key = key_arg(rt, args, count);
+            int err = kv_store_remove(settings_arg(rt), key.data(), key.size());
+            if (err < 0) {
+                throw jsi::JSError(rt, std::string("settings write failed: ") + strerror(-err));
+            }
+            return jsi::Value::undefined();
+        }));
+    qemu.setProperty(rt, "kvKeys", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "kvKeys"), 0,
+        [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value*, size_t) {
+            std::vector<std::string> keys;
+            kv_store_each(settings_arg(rt), [](void* ctx, const char* key, size_t key_len,
+                                               const char*, size_t) {
+                static_cast<std::vector<std::string>*>(ctx)->emplace_back(key, key_len);
+                return 0;
+            }, &keys);
+            jsi::Array result(rt, keys.size());
+            for (size_t i = 0; i < keys.size(); i++) {
+                result.setValueAtIndex(rt, i, utf8_string(rt, keys[i].data(), keys[i].size()));
+            }
+            return jsi::Value(std::move(result));
+        }));
+    qemu.setProperty(rt, "kvClear", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "kvClear"), 0,
+        [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value*, size_t) {
+            int err = kv_store_clear(settings_arg(rt));
+            if (err < 0) {
+                throw jsi::JSError(rt, std::string("settings clear failed: ") + strerror(-err));
+            }
+            return jsi::Value::undefined();
+        }));
+}
+
+void install(jsi::Runtime& rt) {
+    jsi::Object qemu(rt);
+    qemu.setProperty(rt, "getStatus", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "getStatus"), 0,
+        [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value*, size_t) {
+            return get_status(rt);
+        }));
+    qemu.setProperty(rt, "getLogs", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "getLogs"), 1,
+        [](jsi::Runtime& rt, const jsi::Value&, const jsi::Value* args, size_t count) {
+            int lines = count > 0 && args[0].isNumber() ? (int)args[0].asNumber() : 100;
+            return get_logs(rt, lines > 0 ? lines : 1);
+        }));
+
+    auto stats = std::make_shared<StatsBuffer>();
+    vm_stats_read(&stats->snapshot);
+    qemu.setProperty(rt, "stats", jsi::ArrayBuffer(rt, stats));
+    qemu.setProperty(rt, "readStats", jsi::Function::createFromHostFunction(
+        rt, jsi::PropNameID::forAscii(rt, "readStats"), 0,
+        [stats](jsi::Runtime&, const jsi::Value&, const jsi::Value*, size_t) {
+            return jsi::Value((double)vm_stats_read(&stats->snapshot));
+        }));
+    auto handles = std::make_shared<Handles>();
+    install_logs(rt, qemu, handles);
+    install_terms(rt, qemu, handles);
+    if (settings != nullptr) {
+        install_settings(rt, qemu);
+    }
+
+    rt.global().setProperty(rt, "__QemuNative", std::move(qemu));
+}
+
+} // namespace
+
+/**
+ * Install global.__QemuNative; must run on the JS thread. Log buffers
+ * keep their (unlinked) files in logDir; settings live in
+ * dataDir/settings.kv, opened here so JS can read them before its first
+ * render. Without the store the kv* functions are left out and JS falls
+ * back to AsyncStorage.
+ * Returns: true once installed
+ */
+extern "C" JNIEXPORT jboolean JNICALL
+Java_com_dockerandroid_app_qemu_QemuModule_nativeInstallJsi(
+    JNIEnv *env,
+    jclass clazz,
+    jlong runtime,
+    jstring logDir,
+    jstring dataDir
+) {
+    (void)clazz;
+    auto* rt = reinterpret_cast<jsi::Runtime*>(runtime);
+    if (rt == nullptr) {
+        return JNI_FALSE;
+    }
+    const char* dir = env->GetStringUTFChars(logDir, nullptr);
+    log_dir = dir;
+    env->ReleaseStringUTFChars(logDir, dir);
+    if (settings == nullptr) {
+        dir = env->GetStringUTFChars(dataDir, nullptr);
+        std::string path = std::string(dir) + "/settings.kv";
+        env->ReleaseStringUTFChars(dataDir, dir);
+        int64_t started = now_ms(CLOCK_MONOTONIC);
+        settings = kv_store_open(path.c_str());
+        if (settings == nullptr) {
+            LOGE("Failed to open %s: %s", path.c_str(), strerror(errno));
+        } else {
+            LOGI("Settings store: %zu keys in %lld ms", kv_store_count(settings),
+                 (long long)(now_ms(CLOCK_MONOTONIC) - started));
+        }
+    }
+    install(*rt);
+    LOGI("JSI bindings installed");
+    return JNI_TRUE;
+}
@@ -0,0 +1,430 @@
+/**
+ * QEMU Launcher
+ * Runs QEMU in the foreground and drains its output streams. One thread
+ * waits in epoll on the stdout and stderr pipes and the monitor FIFO and
+ * copies whatever arrives into a ring per stream. Nothing is parsed or
+ * logged per line, and a stream is only lost once it outruns its ring.
+ * When QEMU closes stdout and stderr it is exiting, and the thread reaps
+ * it with waitid and waitpid. The exit status therefore comes from the
+ * kernel and is not guessed from a socket.
+ */
+
+#define _GNU_SOURCE
+#include "qemu_launcher.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <android/log.h>
+
+#define TAG "QemuLauncher"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+#define READ_CHUNK 16384
+#define SIGNAL_EXIT_BASE 128
+
+typedef struct {
+    char* buf;
+    size_t size;
+    unsigned long long written;
+} ring_t;
+
+struct launcher {
+    pid_t pid;
+    int fds[LAUNCHER_STREAMS];      // read ends, -1 once closed or unused
+    int monitor_in;                 // write end of the monitor FIFO, -1 if none
+    int epoll_fd;
+    pthread_t thread;
+
+    pthread_mutex_t lock;
+    pthread_cond_t exited_cond;
+    ring_t rings[LAUNCHER_STREAMS];
+    int exited;
+    int exit_value;
+};
+
+static const char* STREAM_NAMES[LAUNCHER_STREAMS] = {"serial", "monitor", "stderr"};
+
+/**
+ * Append bytes to a ring; the oldest bytes are overwritten
+ * Called with the lock held
+ */
+static void ring_append(ring_t* ring, const char* data, size_t len) {
+    if (len > ring->size) {
+        data += len - ring->size;
+        ring->written += len - ring->size;
+        len = ring->size;
+    }
+    size_t at = (size_t)(ring->written % ring->size);
+    size_t first = ring->size - at < len ? ring->size - at : len;
+    memcpy(ring->buf + at, data, first);
+    memcpy(ring->buf, data + first, len - first);
+    ring->written += len;
+}
+
+/**
+ * Read everything a non-blocking fd has into its ring
+ * Returns: 1 = more may come, 0 = end of stream
+ */
+static int drain_fd(launcher_t* launcher, int stream) {
+    char chunk[READ_CHUNK];
+    for (;;) {
+        ssize_t n = read(launcher->fds[stream], chunk, sizeof(chunk));
+        if (n > 0) {
+            pthread_mutex_lock(&launcher->lock);
+            ring_append(&launcher->rings[stream], chunk, (size_t)n);
+            pthread_mutex_unlock(&launcher->lock);
+            if (stream == LAUNCHER_STREAM_STDERR) {
+                // Rare and worth seeing in logcat
+                LOGW("QEMU: %.*s", (int)n, chunk);
+            }
+            continue;
+        }
+        if (n == 0) {
+            return 0;
+        }
+        if (errno == EINTR) {
+            continue;
+        }
+        return errno == EAGAIN ? 1 : 0;
+    }
+}
+
+static void close_stream(launcher_t* launcher, int stream) {
+    if (launcher->fds[stream] < 0) {
+        return;
+    }
+    epoll_ctl(launcher->epoll_fd, EPOLL_CTL_DEL, launcher->fds[stream], NULL);
+    close(launcher->fds[stream]);
+    launcher->fds[stream] = -1;
+}
+
+/**
+ * Drain thread: runs until QEMU has exited and been reaped
+ */
+static void* drain_thread(void* arg) {
+    launcher_t* launcher = (launcher_t*)arg;
+    struct epoll_event events[LAUNCHER_STREAMS];
+
+    while (launcher->fds[LAUNCHER_STREAM_SERIAL] >= 0 || launcher->fds[LAUNCHER_STREAM_STDERR] >= 0) {
+        int n = epoll_wait(launcher->epoll_fd, events, LAUNCHER_STREAMS, -1);
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            LOGE("epoll_wait failed: %s", strerror(errno));
+            break;
+        }
+        for (int i = 0; i < n; i++) {
+            int stream = (int)events[i].data.u32;
+            if (!drain_fd(launcher, stream) && stream != LAUNCHER_STREAM_MONITOR) {
+                close_stream(launcher, stream);
+            }
+        }
+    }
+
+    // Both pipes closed: QEMU is exiting. Wait without reaping: the zombie
+    // keeps the pid ours until exited is set, so launcher_signal cannot
+    // hit a reused pid.
+    siginfo_t info;
+    int result;
+    do {
+        memset(&info, 0, sizeof(info));
+        result = waitid(P_PID, (id_t)launcher->pid, &info, WEXITED | WNOWAIT);
+    } while (result < 0 && errno == EINTR);
+
+    int exit_value;
+    if (result < 0) {
+        LOGE("waitid(%d) failed: %s", launcher->pid, strerror(errno));
+        exit_value = -1;
+    } else if (info.si_code == CLD_KILLED || info.si_code == CLD_DUMPED) {
+        exit_value = SIGNAL_EXIT_BASE + info.si_status;
+    } else {
+        exit_value = info.si_status;
+    }
+
+    // Whatever the monitor still holds belongs to this run
+    if (launcher->fds[LAUNCHER_STREAM_MONITOR] >= 0) {
+        drain_fd(launcher, LAUNCHER_STREAM_MONITOR);
+    }
+
+    pthread_mutex_lock(&launcher->lock);
+    launcher->exited = 1;
+    launcher->exit_value = exit_value;
+    if (result == 0) {
+        pid_t reaped;
+        do {
+            reaped = waitpid(launcher->pid, NULL, 0);
+        } while (reaped < 0 && errno == EINTR);
+    }
+    pthread_cond_broadcast(&launcher->exited_cond);
+    pthread_mutex_unlock(&launcher->lock);
+
+    LOGI("QEMU (pid %d) exited: %d (serial %llu, stderr %llu bytes)", launcher->pid, exit_value,
+         launcher->rings[LAUNCHER_STREAM_SERIAL].written, launcher->rings[LAUNCHER_STREAM_STDERR].written);
+    return NULL;
+}
+
+/**
+ * Create (if needed) and open one side of a monitor FIFO. O_RDWR never
+ * blocks on a FIFO and keeps it open whether or not QEMU has it open.
+ */
+static int open_fifo(const char* monitor_path, const char* suffix) {
+    char path[1024];
+    snprintf(path, sizeof(path), "%s%s", monitor_path, suffix);
+    if (mkfifo(path, 0600) < 0 && errno != EEXIST) {
+        return -1;
+    }
+    return open(path, O_RDWR | O_NONBLOCK | O_CLOEXEC);
+}
+
+static void free_launcher(launcher_t* launcher) {
+    for (int i = 0; i < LAUNCHER_STREAMS; i++) {
+        if (launcher->fds[i] >= 0) {
+            close(launcher->fds[i]);
+        }
+        free(launcher->rings[i].buf);
+    }
+    if (launcher->monitor_in >= 0) {
+        close(launcher->monitor_in);
+    }
+    if (launcher->epoll_fd >= 0) {
+        close(launcher->epoll_fd);
+    }
+    pthread_cond_destroy(&launcher->exited_cond);
+    pthread_mutex_destroy(&launcher->lock);
+    free(launcher);
+}
+
+launcher_t* launcher_start(char* const argv[], const char* dir, const char* monitor_path,
+                           size_t ring_size) {
+    launcher_t* launcher = (launcher_t*)calloc(1, sizeof(launcher_t));
+    if (launcher == NULL) {
+        errno = ENOMEM;
+        return NULL;
+    }
+    pthread_mutex_init(&launcher->lock, NULL);
+    pthread_cond_init(&launcher->exited_cond, NULL);
+    launcher->pid = -1;
+    launcher->monitor_in = -1;
+    launcher->epoll_fd = -1;
+    for (int i = 0; i < LAUNCHER_STREAMS; i++) {
+        launcher->fds[i] = -1;
+    }
+
+    int err = 0;
+    int out_pipe[2] = {-1, -1};
+    int err_pipe[2] = {-1, -1};
+    for (int i = 0; i < LAUNCHER_STREAMS; i++) {
+        launcher->rings[i].size = ring_size > 0 ? ring_size : 65536;
+        launcher->rings[i].buf = (char*)malloc(launcher->rings[i].size);
+        if (launcher->rings[i].buf == NULL) {
+            err = ENOMEM;
+            goto fail;
+        }
+    }
+    if (pipe2(out_pipe, O_CLOEXEC) < 0 || pipe2(err_pipe, O_CLOEXEC) < 0) {
+        err = errno;
+        goto fail;
+    }
+    if (monitor_path != NULL) {
+        launcher->fds[LAUNCHER_STREAM_MONITOR] = open_fifo(monitor_path, ".out");
+        launcher->monitor_in = open_fifo(monitor_path, ".in");
+        if (launcher->fds[LAUNCHER_STREAM_MONITOR] < 0 || launcher->monitor_in < 0) {
+            err = errno;
+            LOGE("Failed to open monitor FIFOs at %s: %s", monitor_path, strerror(err));
+            goto fail;
+        }
+    }
+    int null_fd = open("/dev/null", O_RDONLY | O_CLOEXEC);
+
+    pid_t pid = fork();
+    if (pid < 0) {
+        err = errno;
+        if (null_fd >= 0) {
+            close(null_fd);
+        }
+        goto fail;
+    }
+    if (pid == 0) {
+        // Child: async-signal-safe calls only until exec
+        if (null_fd >= 0) {
+            dup2(null_fd, STDIN_FILENO);
+        }
+        dup2(out_pipe[1], STDOUT_FILENO);
+        dup2(err_pipe[1], STDERR_FILENO);
+        if (dir != NULL && chdir(dir) != 0) {
+            _exit(126);
+        }
+        execv(argv[0], argv);
+        _exit(127);
+    }
+
+    // Parent
+    launcher->pid = pid;
+    if (null_fd >= 0) {
+        close(null_fd);
+    }
+    close(out_pipe[1]);
+    close(err_pipe[1]);
+    launcher->fds[LAUNCHER_STREAM_SERIAL] = out_pipe[0];
+    launcher->fds[LAUNCHER_STREAM_STDERR] = err_pipe[0];
+    out_pipe[0] = out_pipe[1] = err_pipe[0] = err_pipe[1] = -1;
+
+    launcher->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (launcher->epoll_fd < 0) {
+        err = errno;
+        goto fail_running;
+    }
+    for (int i = 0; i < LAUNCHER_STREAMS; i++) {
+        if (launcher->fds[i] < 0) {
+            continue;
+        }
+        fcntl(launcher->fds[i], F_SETFL, fcntl(launcher->fds[i], F_GETFL) | O_NONBLOCK);
+        struct epoll_event event;
+        memset(&event, 0, sizeof(event));
+        event.events = EPOLLIN;
+        event.data.u32 = (uint32_t)i;
+        if (epoll_ctl(launcher->epoll_fd, EPOLL_CTL_ADD, launcher->fds[i], &event) < 0) {
+            err = errno;
+            goto fail_running;
+        }
+    }
+    err = pthread_create(&launcher->thread, NULL, drain_thread, launcher);
+    if (err != 0) {
+        goto fail_running;
+    }
+
+    LOGI("QEMU started with PID %d", pid);
+    return launcher;
+
+fail_running:
+    kill(pid, SIGKILL);
+    waitpid(pid, NULL, 0);
+fail:
+    LOGE("Failed to start QEMU: %s", strerror(err));
+    for (int i = 0; i < 2; i++) {
+        if (out_pipe[i] >= 0) {
+            close(out_pipe[i]);
+        }
+        if (err_pipe[i] >= 0) {
+            close(err_pipe[i]);
+        }
+    }
+    free_launcher(launcher);
+    errno = err;
+    return NULL;
+}
+
+pid_t launcher_pid(launcher_t* launcher) {
+    return launcher->pid;
+}
+
+int launcher_alive(launcher_t* launcher) {
+    pthread_mutex_lock(&launcher->lock);
+    int alive = !launcher->exited;
+    pthread_mutex_unlock(&launcher->lock);
+    return alive;
+}
+
+int launcher_wait(launcher_t* launcher, long timeout_ms) {
+    struct timespec deadline;
+    if (timeout_ms >= 0) {
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+    }
+
+    pthread_mutex_lock(&launcher->lock);
+    int result = 0;
+    while (!launcher->exited && result == 0) {
+        result = timeout_ms >= 0 ?
+            pthread_cond_timedwait(&launcher->exited_cond, &launcher->lock, &deadline) :
+            pthread_cond_wait(&launcher->exited_cond, &launcher->lock);
+    }
+    int value = launcher->exited ? launcher->exit_value : -ETIMEDOUT;
+    pthread_mutex_unlock(&launcher->lock);
+    return value;
+}
+
+int launcher_signal(launcher_t* launcher, int sig) {
+    // Never signal a reaped pid, it may belong to someone else by now
+    pthread_mutex_lock(&launcher->lock);
+    int result = launcher->exited ? -ESRCH : (kill(launcher->pid, sig) < 0 ? -errno : 0);
+    pthread_mutex_unlock(&launcher->lock);
+    return result;
+}
+
+size_t launcher_tail(launcher_t* launcher, int stream, char* buf, size_t max) {
+    if (stream < 0 || stream >= LAUNCHER_STREAMS) {
+        return 0;
+    }
+    pthread_mutex_lock(&launcher->lock);
+    ring_t* ring = &launcher->rings[stream];
+    size_t avail = ring->written < ring->size ? (size_t)ring->written : ring->size;
+    size_t len = max < avail ? max : avail;
+    unsigned long long start = ring->written - len;
+    size_t at = (size_t)(start % ring->size);
+    size_t first = ring->size - at < len ? ring->size - at : len;
+    memcpy(buf, ring->buf + at, first);
+    memcpy(buf + first, ring->buf, len - first);
+    pthread_mutex_unlock(&launcher->lock);
+    return len;
+}
+
+unsigned long long launcher_written(launcher_t* launcher, int stream) {
+    if (stream < 0 || stream >= LAUNCHER_STREAMS) {
+        return 0;
+    }
+    pthread_mutex_lock(&launcher->lock);
+    unsigned long long written = launcher->rings[stream].written;
+    pthread_mutex_unlock(&launcher->lock);
+    return written;
+}
+
+int launcher_monitor_command(launcher_t* launcher, const char* command) {
+    if (launcher->monitor_in < 0) {
+        return -ENOTCONN;
+    }
+    char line[1024];
+    int len = snprintf(line, sizeof(line), "%s\n", command);
+    if (len < 0 || (size_t)len >= sizeof(line)) {
+        return -E2BIG;
+    }
+    // Shorter than PIPE_BUF, so the write is atomic or fails as a whole
+    if (write(launcher->monitor_in, line, (size_t)len) < 0) {
+        return -errno;
+    }
+    return 0;
+}
+
+void launcher_free(launcher_t* launcher) {
+    if (launcher == NULL) {
+        return;
+    }
+    if (launcher_alive(launcher)) {
+        LOGW("Killing QEMU (pid %d) on release", launcher->pid);
+        launcher_signal(launcher, SIGKILL);
+    }
+    pthread_join(launcher->thread, NULL);
+    LOGI("Released QEMU launcher (%s %llu, %s %llu, %s %llu bytes)",
+         STREAM_NAMES[0], launcher->rings[0].written, STREAM_NAMES[1], launcher->rings[1].written,
+         STREAM_NAMES[2], launcher->rings[2].written);
+    free_launcher(launcher);
+}
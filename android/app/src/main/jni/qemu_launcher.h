@@ -0,0 +1,71 @@
+/**
+ * QEMU Launcher
+ * Runs QEMU in the foreground as a child process and drains its serial
+ * console, HMP monitor and stderr with a single epoll thread into
+ * per-stream ring buffers
+ */
+
+#ifndef QEMU_LAUNCHER_H
+#define QEMU_LAUNCHER_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#define LAUNCHER_STREAM_SERIAL  0   // QEMU stdout (-serial stdio)
+#define LAUNCHER_STREAM_MONITOR 1   // HMP monitor (-chardev pipe)
+#define LAUNCHER_STREAM_STDERR  2   // QEMU's own messages
+#define LAUNCHER_STREAMS        3
+
+typedef struct launcher launcher_t;
+
+/**
+ * Start argv[0] with argv in dir. stdout and stderr go to pipes; the
+ * monitor uses the FIFO pair monitor_path.in / monitor_path.out (created
+ * when missing, NULL for no monitor). Each stream keeps its last
+ * ring_size bytes. Returns NULL with errno set on failure.
+ */
+launcher_t* launcher_start(char* const argv[], const char* dir, const char* monitor_path,
+                           size_t ring_size);
+
+pid_t launcher_pid(launcher_t* launcher);
+
+/**
+ * 1 while the process runs, 0 once it has exited and been reaped
+ */
+int launcher_alive(launcher_t* launcher);
+
+/**
+ * Wait for the process to exit (timeout_ms < 0 waits forever).
+ * Returns the exit code, 128 + N when killed by signal N (as
+ * java.lang.Process reports it), or -ETIMEDOUT.
+ */
+int launcher_wait(launcher_t* launcher, long timeout_ms);
+
+/**
+ * Send a signal; 0 or a negative errno (-ESRCH once the process is gone)
+ */
+int launcher_signal(launcher_t* launcher, int sig);
+
+/**
+ * Copy the last max bytes (at most) of a stream into buf.
+ * Returns the number of bytes copied.
+ */
+size_t launcher_tail(launcher_t* launcher, int stream, char* buf, size_t max);
+
+/**
+ * Total bytes a stream has produced, including those the ring dropped
+ */
+unsigned long long launcher_written(launcher_t* launcher, int stream);
+
+/**
+ * Send one HMP command line to the monitor; the reply shows up on
+ * LAUNCHER_STREAM_MONITOR. 0 or a negative errno.
+ */
+int launcher_monitor_command(launcher_t* launcher, const char* command);
+
+/**
+ * Kill the process if it still runs, stop the drain thread and free
+ */
+void launcher_free(launcher_t* launcher);
+
+#endif // QEMU_LAUNCHER_H
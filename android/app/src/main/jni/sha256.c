@@ -0,0 +1,196 @@
+/**
+ * SHA-256
+ * FIPS 180-4 with a runtime switch to the ARMv8 SHA-256 instructions
+ */
+
+#include <pthread.h>
+#include <string.h>
+
+#if defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#ifndef HWCAP_SHA2
+#define HWCAP_SHA2 (1 << 6)
+#endif
+#endif
+
+#include "sha256.h"
+
+typedef void (*compress_fn)(uint32_t state[8], const uint8_t* data, size_t blocks);
+
+static const uint32_t K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+};
+
+#define ROTR(x, n) (((x) >> (n)) | ((x) << (32 - (n))))
+
+static void compress_portable(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    uint32_t w[64];
+
+    while (blocks--) {
+        for (int i = 0; i < 16; i++) {
+            w[i] = ((uint32_t)data[i * 4] << 24) | ((uint32_t)data[i * 4 + 1] << 16) |
+                   ((uint32_t)data[i * 4 + 2] << 8) | (uint32_t)data[i * 4 + 3];
+        }
+        for (int i = 16; i < 64; i++) {
+            uint32_t s0 = ROTR(w[i - 15], 7) ^ ROTR(w[i - 15], 18) ^ (w[i - 15] >> 3);
+            uint32_t s1 = ROTR(w[i - 2], 17) ^ ROTR(w[i - 2], 19) ^ (w[i - 2] >> 10);
+            w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+        }
+
+        uint32_t a = state[0], b = state[1], c = state[2], d = state[3];
+        uint32_t e = state[4], f = state[5], g = state[6], h = state[7];
+        for (int i = 0; i < 64; i++) {
+            uint32_t t1 = h + (ROTR(e, 6) ^ ROTR(e, 11) ^ ROTR(e, 25)) + ((e & f) ^ (~e & g)) + K[i] + w[i];
+            uint32_t t2 = (ROTR(a, 2) ^ ROTR(a, 13) ^ ROTR(a, 22)) + ((a & b) ^ (a & c) ^ (b & c));
+            h = g;
+            g = f;
+            f = e;
+            e = d + t1;
+            d = c;
+            c = b;
+            b = a;
+            a = t1 + t2;
+        }
+        state[0] += a; state[1] += b; state[2] += c; state[3] += d;
+        state[4] += e; state[5] += f; state[6] += g; state[7] += h;
+
+        data += SHA256_BLOCK_SIZE;
+    }
+}
+
+#if defined(__aarch64__)
+/**
+ * Four rounds per SHA256H/SHA256H2 pair; the message schedule for the
+ * next 48 rounds is expanded in place with SHA256SU0/SHA256SU1.
+ * Built with +crypto (Android.mk) but only called when HWCAP_SHA2 is set.
+ */
+static void compress_armv8(uint32_t state[8], const uint8_t* data, size_t blocks) {
+    uint32x4_t s0 = vld1q_u32(&state[0]);
+    uint32x4_t s1 = vld1q_u32(&state[4]);
+
+    while (blocks--) {
+        uint32x4_t save0 = s0;
+        uint32x4_t save1 = s1;
+        uint32x4_t msg[4];
+
+        for (int i = 0; i < 4; i++) {
+            msg[i] = vreinterpretq_u32_u8(vrev32q_u8(vld1q_u8(data + i * 16)));
+        }
+
+        for (int i = 0; i < 16; i++) {
+            uint32x4_t wk = vaddq_u32(msg[i & 3], vld1q_u32(&K[i * 4]));
+            if (i < 12) {
+                msg[i & 3] = vsha256su1q_u32(vsha256su0q_u32(msg[i & 3], msg[(i + 1) & 3]),
+                                             msg[(i + 2) & 3], msg[(i + 3) & 3]);
+            }
+            uint32x4_t tmp = s0;
+            s0 = vsha256hq_u32(s0, s1, wk);
+            s1 = vsha256h2q_u32(s1, tmp, wk);
+        }
+
+        s0 = vaddq_u32(s0, save0);
+        s1 = vaddq_u32(s1, save1);
+        data += SHA256_BLOCK_SIZE;
+    }
+
+    vst1q_u32(&state[0], s0);
+    vst1q_u32(&state[4], s1);
+}
+#endif
+
+static compress_fn compress = compress_portable;
+static const char* compress_name = "portable";
+static pthread_once_t compress_once = PTHREAD_ONCE_INIT;
+
+static void select_compress(void) {
+#if defined(__aarch64__)
+    if (getauxval(AT_HWCAP) & HWCAP_SHA2) {
+        compress = compress_armv8;
+        compress_name = "armv8-ce";
+    }
+#endif
+}
+
+const char* sha256_impl(void) {
+    pthread_once(&compress_once, select_compress);
+    return compress_name;
+}
+
+void sha256_init(Sha256Ctx* ctx) {
+    static const uint32_t iv[8] = {
+        0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19,
+    };
+    pthread_once(&compress_once, select_compress);
+    memcpy(ctx->state, iv, sizeof(iv));
+    ctx->length = 0;
+    ctx->buffered = 0;
+}
+
+void sha256_update(Sha256Ctx* ctx, const void* data, size_t len) {
+    const uint8_t* p = (const uint8_t*)data;
+    ctx->length += len;
+
+    if (ctx->buffered > 0) {
+        size_t n = SHA256_BLOCK_SIZE - ctx->buffered;
+        if (n > len) {
+            n = len;
+        }
+        memcpy(ctx->buffer + ctx->buffered, p, n);
+        ctx->buffered += n;
+        p += n;
+        len -= n;
+        if (ctx->buffered < SHA256_BLOCK_SIZE) {
+            return;
+        }
+        compress(ctx->state, ctx->buffer, 1);
+        ctx->buffered = 0;
+    }
+
+    if (len >= SHA256_BLOCK_SIZE) {
+        size_t blocks = len / SHA256_BLOCK_SIZE;
+        compress(ctx->state, p, blocks);
+        p += blocks * SHA256_BLOCK_SIZE;
+        len -= blocks * SHA256_BLOCK_SIZE;
+    }
+
+    memcpy(ctx->buffer, p, len);
+    ctx->buffered = len;
+}
+
+void sha256_final(Sha256Ctx* ctx, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    uint64_t bits = ctx->length * 8;
+
+    ctx->buffer[ctx->buffered++] = 0x80;
+    if (ctx->buffered > SHA256_BLOCK_SIZE - 8) {
+        memset(ctx->buffer + ctx->buffered, 0, SHA256_BLOCK_SIZE - ctx->buffered);
+        compress(ctx->state, ctx->buffer, 1);
+        ctx->buffered = 0;
+    }
+    memset(ctx->buffer + ctx->buffered, 0, SHA256_BLOCK_SIZE - 8 - ctx->buffered);
+    for (int i = 0; i < 8; i++) {
+        ctx->buffer[SHA256_BLOCK_SIZE - 1 - i] = (uint8_t)(bits >> (i * 8));
+    }
+    compress(ctx->state, ctx->buffer, 1);
+
+    for (int i = 0; i < 8; i++) {
+        digest[i * 4] = (uint8_t)(ctx->state[i] >> 24);
+        digest[i * 4 + 1] = (uint8_t)(ctx->state[i] >> 16);
+        digest[i * 4 + 2] = (uint8_t)(ctx->state[i] >> 8);
+        digest[i * 4 + 3] = (uint8_t)ctx->state[i];
+    }
+}
+
+void sha256(const void* data, size_t len, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    Sha256Ctx ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, data, len);
+    sha256_final(&ctx, digest);
+}
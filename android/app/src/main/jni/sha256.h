@@ -0,0 +1,36 @@
+/**
+ * SHA-256
+ * Portable implementation with ARMv8 Crypto Extensions when the CPU has them
+ */
+
+#ifndef SHA256_H
+#define SHA256_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#define SHA256_DIGEST_SIZE 32
+#define SHA256_BLOCK_SIZE  64
+
+typedef struct {
+    uint32_t state[8];
+    uint64_t length;
+    uint8_t buffer[SHA256_BLOCK_SIZE];
+    size_t buffered;
+} Sha256Ctx;
+
+void sha256_init(Sha256Ctx* ctx);
+void sha256_update(Sha256Ctx* ctx, const void* data, size_t len);
+void sha256_final(Sha256Ctx* ctx, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+/**
+ * One-shot helper
+ */
+void sha256(const void* data, size_t len, uint8_t digest[SHA256_DIGEST_SIZE]);
+
+/**
+ * Name of the compression function in use ("armv8-ce" or "portable")
+ */
+const char* sha256_impl(void);
+
+#endif // SHA256_H
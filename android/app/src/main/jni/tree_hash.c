@@ -0,0 +1,441 @@
+/**
+ * Tree Hash
+ * Parallel chunked SHA-256 with a persistent leaf index
+ */
+
+#define _GNU_SOURCE
+#include <jni.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <android/log.h>
+
+#include "tree_hash.h"
+#include "io_util.h"
+#include "jni_progress.h"
+
+#define TAG "TreeHash"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, TAG, __VA_ARGS__)
+
+#define MAX_WORKERS          8
+#define PROGRESS_INTERVAL_US 100000
+#define INDEX_MAGIC          "TREEHSH1"
+
+/**
+ * Index file layout: this header followed by one leaf digest per chunk
+ */
+typedef struct {
+    char magic[8];
+    uint32_t chunk_size;
+    uint32_t reserved;
+    int64_t length;
+    int64_t mtime_ns;
+    int64_t ino;
+    uint64_t chunks;
+    uint64_t cursor;             // next chunk for budgeted verification
+    uint8_t root[SHA256_DIGEST_SIZE];
+} IndexHeader;
+
+typedef struct {
+    int fd;
+    uint64_t chunks;
+    uint64_t first;              // chunk processed for job index i is (first + i) % chunks
+    uint64_t count;
+    int64_t length;
+    uint8_t* leaves;             // output, indexed by chunk
+    const uint8_t* expected;     // verification only
+    atomic_ullong next;
+    atomic_llong bytes_done;
+    atomic_llong first_mismatch;
+    atomic_int error;
+    atomic_int finished;
+} HashJob;
+
+static void hash_leaf(const uint8_t* data, size_t len, uint8_t digest[SHA256_DIGEST_SIZE]) {
+    static const uint8_t prefix = 0x00;
+    Sha256Ctx ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, &prefix, 1);
+    sha256_update(&ctx, data, len);
+    sha256_final(&ctx, digest);
+}
+
+static void hash_root(const uint8_t* leaves, uint64_t chunks, int64_t length,
+                      uint8_t digest[SHA256_DIGEST_SIZE]) {
+    static const uint8_t prefix = 0x01;
+    uint8_t be_length[8];
+    for (int i = 0; i < 8; i++) {
+        be_length[i] = (uint8_t)((uint64_t)length >> (56 - i * 8));
+    }
+    Sha256Ctx ctx;
+    sha256_init(&ctx);
+    sha256_update(&ctx, &prefix, 1);
+    sha256_update(&ctx, leaves, chunks * SHA256_DIGEST_SIZE);
+    sha256_update(&ctx, be_length, sizeof(be_length));
+    sha256_final(&ctx, digest);
+}
+
+static void* hash_worker(void* arg) {
+    HashJob* job = (HashJob*)arg;
+    uint8_t* buf = (uint8_t*)malloc(TREE_HASH_CHUNK_SIZE);
+
+    if (buf == NULL) {
+        atomic_store(&job->error, -ENOMEM);
+        atomic_fetch_add(&job->finished, 1);
+        return NULL;
+    }
+
+    while (atomic_load(&job->error) == 0) {
+        uint64_t i = atomic_fetch_add(&job->next, 1);
+        if (i >= job->count) {
+            break;
+        }
+        uint64_t chunk = (job->first + i) % job->chunks;
+        off64_t offset = (off64_t)chunk * TREE_HASH_CHUNK_SIZE;
+        size_t len = job->length - offset < TREE_HASH_CHUNK_SIZE ?
+                     (size_t)(job->length - offset) : TREE_HASH_CHUNK_SIZE;
+
+        int err = pread_full(job->fd, buf, len, offset);
+        if (err < 0) {
+            atomic_store(&job->error, err);
+            break;
+        }
+
+        uint8_t* leaf = job->leaves + chunk * SHA256_DIGEST_SIZE;
+        hash_leaf(buf, len, leaf);
+
+        if (job->expected != NULL &&
+            memcmp(leaf, job->expected + chunk * SHA256_DIGEST_SIZE, SHA256_DIGEST_SIZE) != 0) {
+            long long seen = atomic_load(&job->first_mismatch);
+            while ((seen < 0 || (long long)chunk < seen) &&
+                   !atomic_compare_exchange_weak(&job->first_mismatch, &seen, (long long)chunk)) {
+            }
+        }
+        atomic_fetch_add(&job->bytes_done, (long long)len);
+    }
+
+    free(buf);
+    atomic_fetch_add(&job->finished, 1);
+    return NULL;
+}
+
+/**
+ * Hash job->count chunks across a pool of worker threads
+ */
+static int run_job(HashJob* job, long long total_bytes, progress_fn progress, void* progress_ctx) {
+    long cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    int workers = cpus > MAX_WORKERS ? MAX_WORKERS : (cpus < 1 ? 1 : (int)cpus);
+    if ((uint64_t)workers > job->count) {
+        workers = job->count > 0 ? (int)job->count : 1;
+    }
+    pthread_t threads[MAX_WORKERS];
+    int started = 0;
+
+    atomic_store(&job->first_mismatch, -1);
+    for (int i = 0; i < workers; i++) {
+        if (pthread_create(&threads[i], NULL, hash_worker, job) != 0) {
+            break;
+        }
+        started++;
+    }
+    if (started == 0) {
+        return -EAGAIN;
+    }
+
+    while (atomic_load(&job->finished) < started) {
+        usleep(PROGRESS_INTERVAL_US);
+        if (progress != NULL) {
+            progress(progress_ctx, atomic_load(&job->bytes_done), total_bytes);
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(threads[i], NULL);
+    }
+
+    int err = atomic_load(&job->error);
+    return err < 0 ? err : started;
+}
+
+static int64_t mtime_ns(const struct stat* st) {
+    return (int64_t)st->st_mtim.tv_sec * 1000000000LL + st->st_mtim.tv_nsec;
+}
+
+static int write_index(const char* index_path, const IndexHeader* header, const uint8_t* leaves) {
+    char tmp_path[1024];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", index_path);
+
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0600);
+    if (fd < 0) {
+        return -errno;
+    }
+    int err = pwrite_full(fd, header, sizeof(*header), 0);
+    if (err == 0) {
+        err = pwrite_full(fd, leaves, header->chunks * SHA256_DIGEST_SIZE, sizeof(*header));
+    }
+    if (err == 0 && fsync(fd) != 0) {
+        err = -errno;
+    }
+    close(fd);
+
+    if (err == 0 && rename(tmp_path, index_path) != 0) {
+        err = -errno;
+    }
+    if (err < 0) {
+        unlink(tmp_path);
+    }
+    return err;
+}
+
+void tree_hash_hex(const uint8_t digest[SHA256_DIGEST_SIZE], char* out) {
+    static const char hex[] = "0123456789abcdef";
+    for (int i = 0; i < SHA256_DIGEST_SIZE; i++) {
+        out[i * 2] = hex[digest[i] >> 4];
+        out[i * 2 + 1] = hex[digest[i] & 0x0f];
+    }
+    out[SHA256_DIGEST_SIZE * 2] = '\0';
+}
+
+int tree_hash_file(const char* path, const char* index_path, TreeHashResult* out,
+                   progress_fn progress, void* progress_ctx) {
+    long start_ms = get_current_time_ms();
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -errno;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        int err = -errno;
+        close(fd);
+        return err;
+    }
+    posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+
+    uint64_t chunks = ((uint64_t)st.st_size + TREE_HASH_CHUNK_SIZE - 1) / TREE_HASH_CHUNK_SIZE;
+    uint8_t* leaves = (uint8_t*)calloc(chunks ? chunks : 1, SHA256_DIGEST_SIZE);
+    if (leaves == NULL) {
+        close(fd);
+        return -ENOMEM;
+    }
+
+    HashJob job;
+    memset(&job, 0, sizeof(job));
+    job.fd = fd;
+    job.chunks = chunks;
+    job.count = chunks;
+    job.length = st.st_size;
+    job.leaves = leaves;
+
+    int threads = chunks > 0 ? run_job(&job, st.st_size, progress, progress_ctx) : 1;
+    close(fd);
+    if (threads < 0) {
+        free(leaves);
+        return threads;
+    }
+
+    IndexHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, INDEX_MAGIC, sizeof(header.magic));
+    header.chunk_size = TREE_HASH_CHUNK_SIZE;
+    header.length = st.st_size;
+    header.mtime_ns = mtime_ns(&st);
+    header.ino = (int64_t)st.st_ino;
+    header.chunks = chunks;
+    hash_root(leaves, chunks, st.st_size, header.root);
+
+    int err = 0;
+    if (index_path != NULL) {
+        err = write_index(index_path, &header, leaves);
+    }
+    free(leaves);
+    if (err < 0) {
+        LOGE("Failed to write hash index %s: %s", index_path, strerror(-err));
+        return err;
+    }
+
+    if (out != NULL) {
+        memset(out, 0, sizeof(*out));
+        memcpy(out->root, header.root, SHA256_DIGEST_SIZE);
+        out->length = st.st_size;
+        out->chunks = (long long)chunks;
+        out->checked = (long long)chunks;
+        out->first_mismatch = -1;
+        out->threads = threads;
+    }
+
+    long elapsed_ms = get_current_time_ms() - start_ms;
+    LOGI("Hashed %s: %lld bytes in %ld ms (%.1f MB/s, %d threads, %s)",
+         path, (long long)st.st_size, elapsed_ms,
+         elapsed_ms > 0 ? (st.st_size / (1024.0 * 1024.0)) / (elapsed_ms / 1000.0) : 0.0,
+         threads, sha256_impl());
+    return 0;
+}
+
+int tree_hash_verify(const char* path, const char* index_path, long long max_chunks,
+                     TreeHashResult* out, progress_fn progress, void* progress_ctx) {
+    IndexHeader header;
+    int index_fd = open(index_path, O_RDWR | O_CLOEXEC);
+    if (index_fd < 0) {
+        return -errno;
+    }
+    int err = pread_full(index_fd, &header, sizeof(header), 0);
+    if (err < 0 || memcmp(header.magic, INDEX_MAGIC, sizeof(header.magic)) != 0 ||
+        header.chunk_size != TREE_HASH_CHUNK_SIZE) {
+        close(index_fd);
+        return err < 0 ? err : -EINVAL;
+    }
+
+    if (out != NULL) {
+        memset(out, 0, sizeof(*out));
+        memcpy(out->root, header.root, SHA256_DIGEST_SIZE);
+        out->length = header.length;
+        out->chunks = (long long)header.chunks;
+        out->first_mismatch = -1;
+    }
+
+    int fd = open(path, O_RDONLY | O_CLOEXEC);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        err = -errno;
+        if (fd >= 0) {
+            close(fd);
+        }
+        close(index_fd);
+        return err;
+    }
+
+    // A replaced or resized file is not corruption; the caller re-indexes
+    if (st.st_size != header.length || (int64_t)st.st_ino != header.ino ||
+        mtime_ns(&st) != header.mtime_ns) {
+        close(fd);
+        close(index_fd);
+        return TREE_HASH_STALE;
+    }
+
+    uint64_t chunks = header.chunks;
+    uint8_t* expected = (uint8_t*)malloc(chunks ? chunks * SHA256_DIGEST_SIZE : 1);
+    uint8_t* leaves = (uint8_t*)malloc(chunks ? chunks * SHA256_DIGEST_SIZE : 1);
+    if (expected == NULL || leaves == NULL) {
+        err = -ENOMEM;
+    } else {
+        err = pread_full(index_fd, expected, chunks * SHA256_DIGEST_SIZE, sizeof(header));
+    }
+
+    HashJob job;
+    memset(&job, 0, sizeof(job));
+    job.fd = fd;
+    job.chunks = chunks;
+    job.first = chunks > 0 ? header.cursor % chunks : 0;
+    job.count = max_chunks <= 0 || (uint64_t)max_chunks > chunks ? chunks : (uint64_t)max_chunks;
+    job.length = st.st_size;
+    job.leaves = leaves;
+    job.expected = expected;
+
+    int threads = 0;
+    if (err == 0 && job.count > 0) {
+        long long slice_bytes = job.count == chunks ? st.st_size : (long long)job.count * TREE_HASH_CHUNK_SIZE;
+        threads = run_job(&job, slice_bytes, progress, progress_ctx);
+        err = threads < 0 ? threads : 0;
+    }
+    close(fd);
+
+    long long mismatch = atomic_load(&job.first_mismatch);
+    if (err == 0 && chunks > 0) {
+        // Remember where the next budgeted pass starts
+        header.cursor = (job.first + job.count) % chunks;
+        pwrite_full(index_fd, &header, sizeof(header), 0);
+    }
+    close(index_fd);
+    free(expected);
+    free(leaves);
+
+    if (err < 0) {
+        return err;
+    }
+    if (out != NULL) {
+        out->checked = (long long)job.count;
+        out->first_mismatch = mismatch;
+        out->threads = threads;
+    }
+    if (mismatch >= 0) {
+        LOGE("%s: chunk %lld does not match its hash", path, mismatch);
+        return TREE_HASH_MISMATCH;
+    }
+    LOGD("Verified %llu of %llu chunks of %s", (unsigned long long)job.count,
+         (unsigned long long)chunks, path);
+    return TREE_HASH_OK;
+}
+
+/**
+ * Compute the tree hash of a file, storing its leaves in index_path
+ * Returns: hex root digest, NULL on failure
+ */
+JNIEXPORT jstring JNICALL
+Java_com_dockerandroid_app_utils_FileUtils_nativeTreeHash(
+    JNIEnv *env,
+    jclass clazz,
+    jstring file_path,
+    jstring index_path,
+    jobject listener
+) {
+    (void)clazz;
+    const char* path = (*env)->GetStringUTFChars(env, file_path, NULL);
+    const char* index = index_path != NULL ? (*env)->GetStringUTFChars(env, index_path, NULL) : NULL;
+
+    JniProgress progress;
+    progress_fn progress_cb = init_jni_progress(env, listener, &progress);
+
+    TreeHashResult result;
+    int err = tree_hash_file(path, index, &result, progress_cb, &progress);
+    if (err < 0) {
+        LOGE("Failed to hash %s: %s", path, strerror(-err));
+    }
+
+    (*env)->ReleaseStringUTFChars(env, file_path, path);
+    if (index != NULL) {
+        (*env)->ReleaseStringUTFChars(env, index_path, index);
+    }
+
+    if (err < 0) {
+        return NULL;
+    }
+    char hex[SHA256_DIGEST_SIZE * 2 + 1];
+    tree_hash_hex(result.root, hex);
+    return (*env)->NewStringUTF(env, hex);
+}
+
+/**
+ * Re-verify up to max_chunks chunks of a file against its index
+ * Returns: 0 = ok, 1 = mismatch, 2 = stale index, < 0 = -errno
+ */
+JNIEXPORT jint JNICALL
+Java_com_dockerandroid_app_utils_FileUtils_nativeVerifyTreeHash(
+    JNIEnv *env,
+    jclass clazz,
+    jstring file_path,
+    jstring index_path,
+    jlong max_chunks,
+    jobject listener
+) {
+    (void)clazz;
+    const char* path = (*env)->GetStringUTFChars(env, file_path, NULL);
+    const char* index = (*env)->GetStringUTFChars(env, index_path, NULL);
+
+    JniProgress progress;
+    progress_fn progress_cb = init_jni_progress(env, listener, &progress);
+
+    int result = tree_hash_verify(path, index, max_chunks, NULL, progress_cb, &progress);
+
+    (*env)->ReleaseStringUTFChars(env, file_path, path);
+    (*env)->ReleaseStringUTFChars(env, index_path, index);
+
+    return result;
+}
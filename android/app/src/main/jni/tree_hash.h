@@ -0,0 +1,54 @@
+/**
+ * Tree Hash
+ * Chunked SHA-256 integrity hashes for large VM files, computed on all cores
+ */
+
+#ifndef TREE_HASH_H
+#define TREE_HASH_H
+
+#include <stdint.h>
+
+#include "decompress.h"
+#include "sha256.h"
+
+#define TREE_HASH_CHUNK_SIZE (1024 * 1024)
+
+// Result codes returned by tree_hash_verify()
+#define TREE_HASH_OK        0
+#define TREE_HASH_MISMATCH  1    // a chunk no longer matches the index
+#define TREE_HASH_STALE     2    // the file was replaced or resized since indexing
+
+typedef struct {
+    uint8_t root[SHA256_DIGEST_SIZE];
+    long long length;
+    long long chunks;
+    long long checked;           // chunks hashed by this call
+    long long first_mismatch;    // chunk index, -1 if none
+    int threads;
+} TreeHashResult;
+
+/**
+ * Hash path in 1 MiB chunks: leaf = SHA-256(0x00 || chunk),
+ * root = SHA-256(0x01 || leaf_0 || ... || leaf_n-1 || length as be64).
+ * When index_path is set, the leaves are stored there for tree_hash_verify().
+ * Returns 0 or a negative errno.
+ */
+int tree_hash_file(const char* path, const char* index_path, TreeHashResult* out,
+                   progress_fn progress, void* progress_ctx);
+
+/**
+ * Re-hash chunks of path and compare them with index_path.
+ * max_chunks <= 0 checks every chunk; otherwise up to max_chunks chunks
+ * are checked starting where the previous call stopped, so repeated
+ * calls cover the whole file a slice at a time.
+ * Returns TREE_HASH_OK, TREE_HASH_MISMATCH, TREE_HASH_STALE or a negative errno.
+ */
+int tree_hash_verify(const char* path, const char* index_path, long long max_chunks,
+                     TreeHashResult* out, progress_fn progress, void* progress_ctx);
+
+/**
+ * Format a digest as lowercase hex (out needs 65 bytes)
+ */
+void tree_hash_hex(const uint8_t digest[SHA256_DIGEST_SIZE], char* out);
+
+#endif // TREE_HASH_H
@@ -0,0 +1,474 @@
+/**
+ * VM Health
+ * Monitor thread with a persistent QMP session and a keep-alive dockerd
+ * connection, and the JNI side of VmHealth.java
+ */
+
+#include <jni.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <android/log.h>
+
+#include "vm_health.h"
+#include "vm_status.h"
+
+#define TAG "VmHealth"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+#define QMP_INTERVAL_MS     2000
+#define DOCKER_INTERVAL_MS  6000   // wakes the guest, so less often
+#define IO_TIMEOUT_MS       1500
+#define LINE_MAX_BYTES      4096
+
+/**
+ * One stream socket with a read buffer for line-based replies
+ */
+typedef struct {
+    int fd;
+    char buf[LINE_MAX_BYTES];
+    size_t len;
+} conn_t;
+
+static pthread_mutex_t health_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t health_cond = PTHREAD_COND_INITIALIZER;
+static vm_health_t current;
+static char watched_qmp[sizeof(((struct sockaddr_un*)0)->sun_path)];
+static int watched_port = 0;
+static unsigned watch_generation = 0;
+static int monitor_running = 0;
+
+static int64_t now_us(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+}
+
+static void conn_close(conn_t* conn) {
+    if (conn->fd >= 0) {
+        close(conn->fd);
+    }
+    conn->fd = -1;
+    conn->len = 0;
+}
+
+static void set_timeouts(int fd) {
+    struct timeval tv = { IO_TIMEOUT_MS / 1000, (IO_TIMEOUT_MS % 1000) * 1000 };
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    setsockopt(fd, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+}
+
+static int conn_send(conn_t* conn, const char* data) {
+    size_t len = strlen(data);
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = send(conn->fd, data + sent, len - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        sent += (size_t)n;
+    }
+    return 0;
+}
+
+static int conn_fill(conn_t* conn) {
+    if (conn->len == sizeof(conn->buf)) {
+        return -1;
+    }
+    for (;;) {
+        ssize_t n = recv(conn->fd, conn->buf + conn->len, sizeof(conn->buf) - conn->len, 0);
+        if (n < 0 && errno == EINTR) {
+            continue;
+        }
+        if (n <= 0) {
+            return -1;
+        }
+        conn->len += (size_t)n;
+        return 0;
+    }
+}
+
+/**
+ * Next '\n'-terminated line without its "\r\n"
+ * Returns: 0, -1 on timeout, EOF or a line longer than the buffer
+ */
+static int conn_read_line(conn_t* conn, char* line, size_t max) {
+    for (;;) {
+        char* nl = memchr(conn->buf, '\n', conn->len);
+        if (nl != NULL) {
+            size_t used = (size_t)(nl - conn->buf) + 1;
+            size_t copy = used - 1;
+            if (copy > 0 && conn->buf[copy - 1] == '\r') {
+                copy--;
+            }
+            if (copy >= max) {
+                copy = max - 1;
+            }
+            memcpy(line, conn->buf, copy);
+            line[copy] = '\0';
+            memmove(conn->buf, conn->buf + used, conn->len - used);
+            conn->len -= used;
+            return 0;
+        }
+        if (conn_fill(conn) < 0) {
+            return -1;
+        }
+    }
+}
+
+/**
+ * Drop count bytes of body
+ */
+static int conn_skip(conn_t* conn, size_t count) {
+    while (count > 0) {
+        if (conn->len == 0 && conn_fill(conn) < 0) {
+            return -1;
+        }
+        size_t take = count < conn->len ? count : conn->len;
+        memmove(conn->buf, conn->buf + take, conn->len - take);
+        conn->len -= take;
+        count -= take;
+    }
+    return 0;
+}
+
+/**
+ * Read QMP messages until a reply ("return" or "error"); events are
+ * skipped
+ * Returns: 0 for "return", -1 otherwise
+ */
+static int qmp_reply(conn_t* conn, char* line, size_t max) {
+    for (;;) {
+        if (conn_read_line(conn, line, max) < 0) {
+            return -1;
+        }
+        if (strstr(line, "\"return\"") != NULL) {
+            return 0;
+        }
+        if (strstr(line, "\"error\"") != NULL) {
+            return -1;
+        }
+    }
+}
+
+static int qmp_connect(conn_t* conn, const char* path) {
+    conn->fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (conn->fd < 0) {
+        return -1;
+    }
+    set_timeouts(conn->fd);
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+    char line[LINE_MAX_BYTES];
+    if (connect(conn->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 ||
+        conn_read_line(conn, line, sizeof(line)) < 0 || strstr(line, "\"QMP\"") == NULL ||
+        conn_send(conn, "{\"execute\":\"qmp_capabilities\"}\r\n") < 0 ||
+        qmp_reply(conn, line, sizeof(line)) < 0) {
+        conn_close(conn);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * query-status on the open session; state gets "running", "paused", ...
+ */
+static int qmp_query_status(conn_t* conn, char* state, size_t max) {
+    char line[LINE_MAX_BYTES];
+    if (conn_send(conn, "{\"execute\":\"query-status\"}\r\n") < 0 ||
+        qmp_reply(conn, line, sizeof(line)) < 0) {
+        return -1;
+    }
+
+    // {"return": {"status": "running", "singlestep": false, "running": true}}
+    state[0] = '\0';
+    const char* p = strstr(line, "\"status\"");
+    if (p != NULL) {
+        p = strchr(p + 8, '"');
+    }
+    if (p != NULL) {
+        p++;
+        size_t len = 0;
+        while (p[len] != '\0' && p[len] != '"' && len < max - 1) {
+            state[len] = p[len];
+            len++;
+        }
+        state[len] = '\0';
+    }
+    return 0;
+}
+
+static int docker_connect(conn_t* conn, int port) {
+    conn->fd = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (conn->fd < 0) {
+        return -1;
+    }
+    set_timeouts(conn->fd);
+    int one = 1;
+    setsockopt(conn->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons((uint16_t)port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(conn->fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        conn_close(conn);
+        return -1;
+    }
+    return 0;
+}
+
+/**
+ * GET /_ping on the kept-alive connection
+ * Returns: 0 for a 200, -1 otherwise; *keep is cleared when the server
+ * closes the connection after the reply
+ */
+static int docker_ping(conn_t* conn, int* keep) {
+    char line[512];
+    if (conn_send(conn, "GET /_ping HTTP/1.1\r\nHost: docker\r\n\r\n") < 0 ||
+        conn_read_line(conn, line, sizeof(line)) < 0) {
+        return -1;
+    }
+    int code = 0;
+    if (sscanf(line, "HTTP/%*d.%*d %d", &code) != 1) {
+        return -1;
+    }
+
+    long length = -1;
+    *keep = 1;
+    for (;;) {
+        if (conn_read_line(conn, line, sizeof(line)) < 0) {
+            return -1;
+        }
+        if (line[0] == '\0') {
+            break;
+        }
+        if (strncasecmp(line, "Content-Length:", 15) == 0) {
+            length = strtol(line + 15, NULL, 10);
+        } else if (strncasecmp(line, "Connection:", 11) == 0 && strstr(line + 11, "close") != NULL) {
+            *keep = 0;
+        }
+    }
+    // Without a length the body runs to EOF; take the next connection
+    if (length < 0) {
+        *keep = 0;
+    } else if (conn_skip(conn, (size_t)length) < 0) {
+        return -1;
+    }
+    return code == 200 ? 0 : -1;
+}
+
+/**
+ * Probe on the sessions, reconnecting first when one is closed
+ */
+static void* monitor_main(void* arg) {
+    (void)arg;
+    conn_t qmp = { .fd = -1 };
+    conn_t docker = { .fd = -1 };
+    unsigned generation = 0;
+    int64_t docker_due = 0;
+    char path[sizeof(watched_qmp)];
+    int port = 0;
+
+    pthread_mutex_lock(&health_lock);
+    for (;;) {
+        while (watched_qmp[0] == '\0') {
+            conn_close(&qmp);
+            conn_close(&docker);
+            pthread_cond_wait(&health_cond, &health_lock);
+        }
+        if (generation != watch_generation) {
+            // A new VM: the old sessions point at a dead one
+            conn_close(&qmp);
+            conn_close(&docker);
+            generation = watch_generation;
+            docker_due = 0;
+        }
+        strcpy(path, watched_qmp);
+        port = watched_port;
+        pthread_mutex_unlock(&health_lock);
+
+        // QMP answers even while the guest is paused
+        char state[VM_HEALTH_STATE_MAX] = "";
+        int64_t started = now_us(CLOCK_MONOTONIC);
+        int qmp_ok = (qmp.fd >= 0 || qmp_connect(&qmp, path) == 0);
+        if (qmp_ok) {
+            started = now_us(CLOCK_MONOTONIC);
+            qmp_ok = qmp_query_status(&qmp, state, sizeof(state)) == 0;
+            if (!qmp_ok) {
+                conn_close(&qmp);
+            }
+        }
+        double qmp_latency = (double)(now_us(CLOCK_MONOTONIC) - started);
+        double qmp_at = (double)(now_us(CLOCK_REALTIME) / 1000);
+
+        // dockerd only while the guest runs; a paused guest cannot answer
+        int docker_probed = 0;
+        int docker_ok = 0;
+        double docker_latency = 0;
+        int64_t now = now_us(CLOCK_MONOTONIC);
+        int guest_running = qmp_ok && strcmp(state, "running") == 0;
+        if (guest_running && port > 0 && now >= docker_due) {
+            docker_due = now + (int64_t)DOCKER_INTERVAL_MS * 1000;
+            docker_probed = 1;
+            int keep = 1;
+            started = now_us(CLOCK_MONOTONIC);
+            if (docker.fd >= 0 || docker_connect(&docker, port) == 0) {
+                docker_ok = docker_ping(&docker, &keep) == 0;
+            }
+            docker_latency = (double)(now_us(CLOCK_MONOTONIC) - started);
+            if (!docker_ok || !keep) {
+                conn_close(&docker);
+            }
+        }
+
+        pthread_mutex_lock(&health_lock);
+        if (generation == watch_generation) {
+            current.qmp = qmp_ok ? VM_HEALTH_UP : VM_HEALTH_DOWN;
+            current.qmp_checked_at = qmp_at;
+            if (qmp_ok) {
+                current.qmp_latency_us = qmp_latency;
+                current.qmp_failures = 0;
+                memcpy(current.run_state, state, sizeof(current.run_state));
+            } else {
+                current.qmp_failures++;
+            }
+            if (docker_probed) {
+                current.docker = docker_ok ? VM_HEALTH_UP : VM_HEALTH_DOWN;
+                current.docker_checked_at = (double)(now_us(CLOCK_REALTIME) / 1000);
+                if (docker_ok) {
+                    current.docker_latency_us = docker_latency;
+                    current.docker_failures = 0;
+                } else {
+                    current.docker_failures++;
+                }
+            } else if (qmp_ok && !guest_running) {
+                current.docker = VM_HEALTH_UNKNOWN;
+            }
+        }
+
+        // Wait out the interval, or less when the target changes
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += QMP_INTERVAL_MS / 1000;
+        while (generation == watch_generation) {
+            if (pthread_cond_timedwait(&health_cond, &health_lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+void vm_health_read(vm_health_t* out) {
+    pthread_mutex_lock(&health_lock);
+    memcpy(out, &current, sizeof(*out));
+    pthread_mutex_unlock(&health_lock);
+    out->pid = vm_status_pid();
+}
+
+void vm_health_watch(const char* qmp_path, int docker_port) {
+    pthread_mutex_lock(&health_lock);
+    memset(&current, 0, sizeof(current));
+    watched_qmp[0] = '\0';
+    if (qmp_path != NULL) {
+        strncpy(watched_qmp, qmp_path, sizeof(watched_qmp) - 1);
+        watched_qmp[sizeof(watched_qmp) - 1] = '\0';
+    }
+    watched_port = docker_port;
+    watch_generation++;
+    if (watched_qmp[0] != '\0' && !monitor_running) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, monitor_main, NULL) == 0) {
+            pthread_detach(thread);
+            monitor_running = 1;
+        } else {
+            LOGE("Failed to start health monitor");
+        }
+    }
+    pthread_cond_broadcast(&health_cond);
+    pthread_mutex_unlock(&health_lock);
+    if (qmp_path != NULL) {
+        LOGI("Watching %s and dockerd on :%d", qmp_path, docker_port);
+    }
+}
+
+/**
+ * Start (path) or stop (null) the health monitor
+ */
+JNIEXPORT void JNICALL
+Java_com_dockerandroid_app_qemu_VmHealth_nativeWatch(
+    JNIEnv *env,
+    jclass clazz,
+    jstring qmp_path,
+    jint docker_port
+) {
+    (void)clazz;
+    if (qmp_path == NULL) {
+        vm_health_watch(NULL, 0);
+        return;
+    }
+    const char* path = (*env)->GetStringUTFChars(env, qmp_path, NULL);
+    vm_health_watch(path, docker_port);
+    (*env)->ReleaseStringUTFChars(env, qmp_path, path);
+}
+
+/**
+ * Pid of the running QEMU, 0 if there is none; no I/O
+ */
+JNIEXPORT jint JNICALL
+Java_com_dockerandroid_app_qemu_VmHealth_nativePid(
+    JNIEnv *env,
+    jclass clazz
+) {
+    (void)env;
+    (void)clazz;
+    return vm_status_pid();
+}
+
+/**
+ * Fill values with the cached health (order of the constants in
+ * VmHealth.java) and return the run state
+ */
+JNIEXPORT jstring JNICALL
+Java_com_dockerandroid_app_qemu_VmHealth_nativeRead(
+    JNIEnv *env,
+    jclass clazz,
+    jdoubleArray values
+) {
+    (void)clazz;
+    vm_health_t health;
+    vm_health_read(&health);
+    jdouble v[9] = {
+        health.pid,
+        health.qmp,
+        health.docker,
+        health.qmp_latency_us,
+        health.docker_latency_us,
+        health.qmp_checked_at,
+        health.docker_checked_at,
+        health.qmp_failures,
+        health.docker_failures,
+    };
+    jsize count = (*env)->GetArrayLength(env, values);
+    (*env)->SetDoubleArrayRegion(env, values, 0, count < 9 ? count : 9, v);
+    return (*env)->NewStringUTF(env, health.run_state);
+}
@@ -0,0 +1,54 @@
+/**
+ * VM Health
+ * Cached liveness of the running VM. A monitor thread keeps one QMP
+ * session on a dedicated monitor socket and one keep-alive HTTP
+ * connection to dockerd, probes both on its own schedule and stores the
+ * results; readers copy them without touching a socket. Whether the
+ * QEMU process is alive comes from the launcher at read time.
+ */
+
+#ifndef VM_HEALTH_H
+#define VM_HEALTH_H
+
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Probe results
+#define VM_HEALTH_UNKNOWN  0   // not probed yet, or not probed in this state
+#define VM_HEALTH_UP       1
+#define VM_HEALTH_DOWN     2
+
+#define VM_HEALTH_STATE_MAX 32
+
+typedef struct {
+    pid_t pid;                      // 0 unless an attached QEMU is alive
+    int qmp;                        // VM_HEALTH_*
+    int docker;                     // VM_HEALTH_*; UNKNOWN while paused
+    double qmp_latency_us;          // round trip of the last good probe
+    double docker_latency_us;
+    double qmp_checked_at;          // ms since epoch
+    double docker_checked_at;
+    unsigned qmp_failures;          // consecutive
+    unsigned docker_failures;
+    char run_state[VM_HEALTH_STATE_MAX];   // query-status, "" until known
+} vm_health_t;
+
+/**
+ * Copy the cached health; never blocks on I/O
+ */
+void vm_health_read(vm_health_t* out);
+
+/**
+ * Probe the QMP socket at qmp_path and dockerd on 127.0.0.1:docker_port;
+ * a NULL path stops probing and forgets the results
+ */
+void vm_health_watch(const char* qmp_path, int docker_port);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VM_HEALTH_H
@@ -0,0 +1,353 @@
+/**
+ * VM Stats
+ * Sequence-locked stats block (layout in vm_stats.h), the native sampler
+ * for the QEMU process and the JNI writers used by StatsSampler.java
+ */
+
+#include <jni.h>
+#include <errno.h>
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <android/log.h>
+
+#include "vm_stats.h"
+
+#define TAG "VmStats"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+#define SAMPLE_INTERVAL_MS 1000
+#define READ_ATTEMPTS 8
+
+_Static_assert(offsetof(vm_stats_block_t, vm) == 32, "vm fields at 32");
+_Static_assert(offsetof(vm_stats_block_t, containers) == 144, "containers at 144");
+_Static_assert(sizeof(vm_stats_container_t) == 136, "container slot is 136 bytes");
+
+static vm_stats_block_t block;
+static pthread_once_t block_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t write_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Sampler target, guarded by track_lock
+static pthread_mutex_t track_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t track_cond = PTHREAD_COND_INITIALIZER;
+static pid_t tracked_pid = 0;
+static int tracked_cores = 0;
+static int tracked_ram_mb = 0;
+static int sampler_running = 0;
+
+/**
+ * Writers: make the sequence odd before touching the block and even
+ * after. Readers that see an odd or changed sequence retry.
+ */
+static void write_begin(void) {
+    pthread_mutex_lock(&write_lock);
+    __atomic_store_n(&block.seq, block.seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+static void write_end(void) {
+    __atomic_store_n(&block.seq, block.seq + 1, __ATOMIC_RELEASE);
+    pthread_mutex_unlock(&write_lock);
+}
+
+static void init_block(void) {
+    write_begin();
+    block.magic = VM_STATS_MAGIC;
+    block.version = VM_STATS_VERSION;
+    block.size = sizeof(block);
+    block.vm_fields = VM_STATS_VM_FIELDS;
+    block.container_fields = VM_STATS_CONTAINER_FIELDS;
+    block.container_slots = VM_STATS_CONTAINER_SLOTS;
+    block.container_count = 0;
+    write_end();
+}
+
+uint32_t vm_stats_read(vm_stats_block_t* out) {
+    pthread_once(&block_once, init_block);
+    for (int attempt = 0; attempt < READ_ATTEMPTS; attempt++) {
+        uint32_t before = __atomic_load_n(&block.seq, __ATOMIC_ACQUIRE);
+        if (before & 1) {
+            continue;
+        }
+        vm_stats_block_t copy;
+        memcpy(&copy, &block, sizeof(copy));
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        if (__atomic_load_n(&block.seq, __ATOMIC_RELAXED) == before) {
+            memcpy(out, &copy, sizeof(copy));
+            out->seq = before;
+            return before;
+        }
+    }
+    return 0;
+}
+
+static int64_t now_ms(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return (int64_t)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+/**
+ * utime + stime of a process in clock ticks, -1 if it is gone
+ */
+static long read_cpu_ticks(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/stat", pid);
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    char buf[512];
+    size_t n = fread(buf, 1, sizeof(buf) - 1, f);
+    fclose(f);
+    buf[n] = '\0';
+
+    // The command name may contain spaces; fields resume after its ')'
+    const char* p = strrchr(buf, ')');
+    unsigned long utime = 0;
+    unsigned long stime = 0;
+    if (p == NULL ||
+        sscanf(p + 2, "%*c %*d %*d %*d %*d %*d %*u %*u %*u %*u %*u %lu %lu", &utime, &stime) != 2) {
+        return -1;
+    }
+    return (long)(utime + stime);
+}
+
+/**
+ * Resident set of a process in bytes, -1 if it is gone
+ */
+static double read_rss_bytes(pid_t pid) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/statm", pid);
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    unsigned long size = 0;
+    unsigned long resident = 0;
+    int fields = fscanf(f, "%lu %lu", &size, &resident);
+    fclose(f);
+    return fields == 2 ? (double)resident * sysconf(_SC_PAGESIZE) : -1;
+}
+
+/**
+ * Bytes the process made the block layer read and write
+ * Returns: 0, -1 if /proc/<pid>/io is not readable
+ */
+static int read_io_bytes(pid_t pid, double* read_bytes, double* write_bytes) {
+    char path[64];
+    snprintf(path, sizeof(path), "/proc/%d/io", pid);
+    FILE* f = fopen(path, "r");
+    if (f == NULL) {
+        return -1;
+    }
+    char line[128];
+    unsigned long long value;
+    int found = 0;
+    while (fgets(line, sizeof(line), f) != NULL) {
+        if (sscanf(line, "read_bytes: %llu", &value) == 1) {
+            *read_bytes = (double)value;
+            found++;
+        } else if (sscanf(line, "write_bytes: %llu", &value) == 1) {
+            *write_bytes = (double)value;
+            found++;
+        }
+    }
+    fclose(f);
+    return found == 2 ? 0 : -1;
+}
+
+static void clear_vm_fields(void) {
+    write_begin();
+    for (int i = 0; i < VM_STATS_VM_FIELDS; i++) {
+        block.vm[i] = 0;
+    }
+    write_end();
+}
+
+/**
+ * Sample the tracked process once a second; sleeps while nothing is
+ * tracked
+ */
+static void* sampler_main(void* arg) {
+    (void)arg;
+    pid_t last_pid = 0;
+    long last_ticks = 0;
+    double last_read = 0;
+    double last_write = 0;
+    int64_t last_at = 0;
+
+    pthread_mutex_lock(&track_lock);
+    for (;;) {
+        while (tracked_pid == 0) {
+            last_pid = 0;
+            pthread_cond_wait(&track_cond, &track_lock);
+        }
+        pid_t pid = tracked_pid;
+        int cores = tracked_cores;
+        int ram_mb = tracked_ram_mb;
+        pthread_mutex_unlock(&track_lock);
+
+        long ticks = read_cpu_ticks(pid);
+        double rss = read_rss_bytes(pid);
+        double io_read = 0;
+        double io_write = 0;
+        int have_io = read_io_bytes(pid, &io_read, &io_write) == 0;
+        int64_t at = now_ms(CLOCK_MONOTONIC);
+        double seconds = (double)(at - last_at) / 1000;
+
+        int have_last = pid == last_pid && last_at > 0 && seconds > 0;
+        double cpu_pct = 0;
+        if (have_last && ticks >= last_ticks && cores > 0) {
+            cpu_pct = (double)(ticks - last_ticks) / sysconf(_SC_CLK_TCK) * 100 / seconds / cores;
+            if (cpu_pct > 100) {
+                cpu_pct = 100;
+            }
+        }
+
+        // Under track_lock so a sample cannot land after vm_stats_track(0)
+        // cleared the fields
+        pthread_mutex_lock(&track_lock);
+        if (tracked_pid == pid) {
+            write_begin();
+            block.vm[VM_STAT_UPDATED_AT] = (double)now_ms(CLOCK_REALTIME);
+            block.vm[VM_STAT_PID] = ticks >= 0 ? pid : 0;
+            block.vm[VM_STAT_CPU_PCT] = cpu_pct;
+            block.vm[VM_STAT_RSS_BYTES] = rss > 0 ? rss : 0;
+            block.vm[VM_STAT_MEM_PCT] = rss > 0 && ram_mb > 0 ?
+                rss * 100 / ((double)ram_mb * 1024 * 1024) : 0;
+            if (have_io) {
+                block.vm[VM_STAT_IO_READ_BYTES] = io_read;
+                block.vm[VM_STAT_IO_WRITE_BYTES] = io_write;
+                block.vm[VM_STAT_IO_READ_BPS] = have_last && io_read >= last_read ?
+                    (io_read - last_read) / seconds : 0;
+                block.vm[VM_STAT_IO_WRITE_BPS] = have_last && io_write >= last_write ?
+                    (io_write - last_write) / seconds : 0;
+            }
+            write_end();
+        }
+
+        last_pid = pid;
+        last_ticks = ticks;
+        last_read = io_read;
+        last_write = io_write;
+        last_at = at;
+
+        // Wait out the interval, or less when the target changes
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_sec += SAMPLE_INTERVAL_MS / 1000;
+        while (tracked_pid == pid) {
+            if (pthread_cond_timedwait(&track_cond, &track_lock, &deadline) == ETIMEDOUT) {
+                break;
+            }
+        }
+    }
+    return NULL;
+}
+
+void vm_stats_track(pid_t pid, int cores, int ram_mb) {
+    pthread_once(&block_once, init_block);
+
+    pthread_mutex_lock(&track_lock);
+    tracked_pid = pid;
+    tracked_cores = cores;
+    tracked_ram_mb = ram_mb;
+    if (pid > 0 && !sampler_running) {
+        pthread_t thread;
+        if (pthread_create(&thread, NULL, sampler_main, NULL) == 0) {
+            pthread_detach(thread);
+            sampler_running = 1;
+        } else {
+            LOGE("Failed to start stats sampler");
+        }
+    }
+    pthread_cond_broadcast(&track_cond);
+    pthread_mutex_unlock(&track_lock);
+
+    if (pid == 0) {
+        clear_vm_fields();
+    }
+}
+
+/**
+ * Guest network counters (bytes and bytes per second on the guest's
+ * interfaces)
+ */
+JNIEXPORT void JNICALL
+Java_com_dockerandroid_app_qemu_StatsSampler_nativeWriteNet(
+    JNIEnv *env,
+    jclass clazz,
+    jdouble rx_bytes,
+    jdouble tx_bytes,
+    jdouble rx_bps,
+    jdouble tx_bps
+) {
+    (void)env;
+    (void)clazz;
+    pthread_once(&block_once, init_block);
+    write_begin();
+    block.vm[VM_STAT_NET_RX_BYTES] = rx_bytes;
+    block.vm[VM_STAT_NET_TX_BYTES] = tx_bytes;
+    block.vm[VM_STAT_NET_RX_BPS] = rx_bps;
+    block.vm[VM_STAT_NET_TX_BPS] = tx_bps;
+    block.vm[VM_STAT_NET_UPDATED_AT] = (double)now_ms(CLOCK_REALTIME);
+    write_end();
+}
+
+/**
+ * Replace the container slots: ids[i] and names[i] with
+ * values[i * VM_STATS_CONTAINER_FIELDS ...]; containers beyond
+ * VM_STATS_CONTAINER_SLOTS are dropped
+ */
+JNIEXPORT void JNICALL
+Java_com_dockerandroid_app_qemu_StatsSampler_nativeWriteContainers(
+    JNIEnv *env,
+    jclass clazz,
+    jobjectArray ids,
+    jobjectArray names,
+    jdoubleArray values
+) {
+    (void)clazz;
+    pthread_once(&block_once, init_block);
+
+    jsize count = (*env)->GetArrayLength(env, ids);
+    if ((*env)->GetArrayLength(env, names) != count ||
+        (*env)->GetArrayLength(env, values) != count * VM_STATS_CONTAINER_FIELDS) {
+        LOGE("Container stats layout mismatch");
+        return;
+    }
+    if (count > VM_STATS_CONTAINER_SLOTS) {
+        count = VM_STATS_CONTAINER_SLOTS;
+    }
+
+    // Build the slots outside the write so readers retry for a memcpy only
+    vm_stats_container_t slots[VM_STATS_CONTAINER_SLOTS];
+    memset(slots, 0, sizeof(slots));
+    for (jsize i = 0; i < count; i++) {
+        (*env)->GetDoubleArrayRegion(env, values, i * VM_STATS_CONTAINER_FIELDS,
+                                     VM_STATS_CONTAINER_FIELDS, slots[i].values);
+        jstring id = (jstring)(*env)->GetObjectArrayElement(env, ids, i);
+        jstring name = (jstring)(*env)->GetObjectArrayElement(env, names, i);
+        if (id != NULL) {
+            const char* utf = (*env)->GetStringUTFChars(env, id, NULL);
+            strncpy(slots[i].id, utf, VM_STATS_ID_LEN - 1);
+            (*env)->ReleaseStringUTFChars(env, id, utf);
+            (*env)->DeleteLocalRef(env, id);
+        }
+        if (name != NULL) {
+            const char* utf = (*env)->GetStringUTFChars(env, name, NULL);
+            strncpy(slots[i].name, utf, VM_STATS_NAME_LEN - 1);
+            (*env)->ReleaseStringUTFChars(env, name, utf);
+            (*env)->DeleteLocalRef(env, name);
+        }
+    }
+
+    write_begin();
+    memcpy(block.containers, slots, sizeof(slots));
+    block.container_count = (uint32_t)count;
+    write_end();
+}
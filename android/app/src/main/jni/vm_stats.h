@@ -0,0 +1,104 @@
+/**
+ * VM Stats
+ * Shared-memory stats block for the dashboards. A native sampler thread
+ * writes the QEMU process's CPU, memory and disk I/O once a second;
+ * StatsSampler.java adds guest network counters and per-container slots.
+ * Writers and readers meet through a sequence lock: a write makes the
+ * sequence odd, copies, and makes it even again, and a reader retries
+ * when the sequence changed under it. Neither side ever waits on the
+ * other (writers only wait for each other).
+ *
+ * Layout (little endian, version 1), exposed to JS as an ArrayBuffer:
+ *
+ *   0    uint32 header[8]   seq, magic, version, size, vm fields,
+ *                           container fields, container slots, containers
+ *   32   double vm[VM_STATS_VM_FIELDS]
+ *   144  slot[VM_STATS_CONTAINER_SLOTS], each 136 bytes:
+ *          double values[VM_STATS_CONTAINER_FIELDS], char id[16],
+ *          char name[48] (NUL-terminated)
+ */
+
+#ifndef VM_STATS_H
+#define VM_STATS_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <sys/types.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define VM_STATS_MAGIC    0x54534d56u   // "VMST"
+#define VM_STATS_VERSION  1
+
+// VM fields
+#define VM_STAT_UPDATED_AT      0   // ms since epoch of the last sample
+#define VM_STAT_PID             1
+#define VM_STAT_CPU_PCT         2   // of the host cores given to the VM
+#define VM_STAT_RSS_BYTES       3
+#define VM_STAT_MEM_PCT         4   // RSS of guest RAM
+#define VM_STAT_IO_READ_BYTES   5   // storage I/O of the QEMU process
+#define VM_STAT_IO_WRITE_BYTES  6
+#define VM_STAT_IO_READ_BPS     7
+#define VM_STAT_IO_WRITE_BPS    8
+#define VM_STAT_NET_RX_BYTES    9   // guest interface, from StatsSampler
+#define VM_STAT_NET_TX_BYTES    10
+#define VM_STAT_NET_RX_BPS      11
+#define VM_STAT_NET_TX_BPS      12
+#define VM_STAT_NET_UPDATED_AT  13
+#define VM_STATS_VM_FIELDS      14
+
+// Container slot fields
+#define CT_STAT_CPU_PCT         0
+#define CT_STAT_MEM_BYTES       1
+#define CT_STAT_MEM_LIMIT       2
+#define CT_STAT_NET_RX_BYTES    3
+#define CT_STAT_NET_TX_BYTES    4
+#define CT_STAT_BLK_READ_BYTES  5
+#define CT_STAT_BLK_WRITE_BYTES 6
+#define CT_STAT_PIDS            7
+#define CT_STAT_UPDATED_AT      8
+#define VM_STATS_CONTAINER_FIELDS 9
+
+#define VM_STATS_CONTAINER_SLOTS 16
+#define VM_STATS_ID_LEN          16
+#define VM_STATS_NAME_LEN        48
+
+typedef struct {
+    double values[VM_STATS_CONTAINER_FIELDS];
+    char id[VM_STATS_ID_LEN];
+    char name[VM_STATS_NAME_LEN];
+} vm_stats_container_t;
+
+typedef struct {
+    uint32_t seq;
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;
+    uint32_t vm_fields;
+    uint32_t container_fields;
+    uint32_t container_slots;
+    uint32_t container_count;
+    double vm[VM_STATS_VM_FIELDS];
+    vm_stats_container_t containers[VM_STATS_CONTAINER_SLOTS];
+} vm_stats_block_t;
+
+/**
+ * Copy a consistent snapshot into out without waiting for writers.
+ * Returns: the snapshot's sequence number, 0 if every attempt raced a
+ * write (out then holds the previous snapshot unchanged)
+ */
+uint32_t vm_stats_read(vm_stats_block_t* out);
+
+/**
+ * Sample pid once a second from now on (0 stops sampling and clears the
+ * VM fields). cores and ram_mb scale CPU and memory percentages.
+ */
+void vm_stats_track(pid_t pid, int cores, int ram_mb);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VM_STATS_H
@@ -0,0 +1,123 @@
+/**
+ * VM Status
+ * Mutex-guarded snapshot written by VmStatus.java, read by the JSI
+ * bindings without a trip through the bridge
+ */
+
+#include <jni.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <string.h>
+#include <android/log.h>
+
+#include "vm_status.h"
+#include "vm_stats.h"
+
+#define TAG "VmStatus"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, TAG, __VA_ARGS__)
+
+static pthread_mutex_t status_lock = PTHREAD_MUTEX_INITIALIZER;
+static vm_status_t current;
+static launcher_t* vm_launcher = NULL;
+
+void vm_status_snapshot(vm_status_t* out) {
+    pthread_mutex_lock(&status_lock);
+    memcpy(out, &current, sizeof(*out));
+    out->pid = vm_launcher != NULL && launcher_alive(vm_launcher) ? launcher_pid(vm_launcher) : 0;
+    pthread_mutex_unlock(&status_lock);
+}
+
+pid_t vm_status_pid(void) {
+    pthread_mutex_lock(&status_lock);
+    pid_t pid = vm_launcher != NULL && launcher_alive(vm_launcher) ? launcher_pid(vm_launcher) : 0;
+    pthread_mutex_unlock(&status_lock);
+    return pid;
+}
+
+void vm_status_attach(launcher_t* launcher, int cores, int ram_mb) {
+    pthread_mutex_lock(&status_lock);
+    vm_launcher = launcher;
+    pthread_mutex_unlock(&status_lock);
+    vm_stats_track(launcher != NULL ? launcher_pid(launcher) : 0, cores, ram_mb);
+}
+
+void vm_status_detach(launcher_t* launcher) {
+    int attached = 0;
+    pthread_mutex_lock(&status_lock);
+    if (vm_launcher == launcher) {
+        vm_launcher = NULL;
+        attached = 1;
+    }
+    pthread_mutex_unlock(&status_lock);
+    if (attached) {
+        vm_stats_track(0, 0, 0);
+    }
+}
+
+size_t vm_status_serial_tail(char* buf, size_t max) {
+    size_t len = 0;
+    pthread_mutex_lock(&status_lock);
+    // Held across the copy so the launcher cannot be freed under us
+    if (vm_launcher != NULL) {
+        len = launcher_tail(vm_launcher, LAUNCHER_STREAM_SERIAL, buf, max);
+    }
+    pthread_mutex_unlock(&status_lock);
+    return len;
+}
+
+/**
+ * Publish a snapshot: VM_STATUS_FIELDS numbers and VM_STATUS_TEXTS
+ * strings (null entries become "")
+ */
+JNIEXPORT void JNICALL
+Java_com_dockerandroid_app_qemu_VmStatus_nativePublish(
+    JNIEnv *env,
+    jclass clazz,
+    jdoubleArray values,
+    jobjectArray texts
+) {
+    (void)clazz;
+    if ((*env)->GetArrayLength(env, values) != VM_STATUS_FIELDS ||
+        (*env)->GetArrayLength(env, texts) != VM_STATUS_TEXTS) {
+        LOGE("Status layout mismatch");
+        return;
+    }
+
+    // Convert outside the lock; readers only wait for the copy
+    vm_status_t next;
+    (*env)->GetDoubleArrayRegion(env, values, 0, VM_STATUS_FIELDS, next.values);
+    for (int i = 0; i < VM_STATUS_TEXTS; i++) {
+        next.texts[i][0] = '\0';
+        jstring text = (jstring)(*env)->GetObjectArrayElement(env, texts, i);
+        if (text == NULL) {
+            continue;
+        }
+        const char* utf = (*env)->GetStringUTFChars(env, text, NULL);
+        strncpy(next.texts[i], utf, VM_TEXT_MAX - 1);
+        next.texts[i][VM_TEXT_MAX - 1] = '\0';
+        (*env)->ReleaseStringUTFChars(env, text, utf);
+        (*env)->DeleteLocalRef(env, text);
+    }
+
+    pthread_mutex_lock(&status_lock);
+    memcpy(current.values, next.values, sizeof(current.values));
+    memcpy(current.texts, next.texts, sizeof(current.texts));
+    current.generation++;
+    pthread_mutex_unlock(&status_lock);
+}
+
+/**
+ * Attach a QemuProcess launcher as the running VM
+ */
+JNIEXPORT void JNICALL
+Java_com_dockerandroid_app_qemu_QemuProcess_nativeAttachStatus(
+    JNIEnv *env,
+    jclass clazz,
+    jlong handle,
+    jint cores,
+    jint ram_mb
+) {
+    (void)env;
+    (void)clazz;
+    vm_status_attach((launcher_t*)(intptr_t)handle, cores, ram_mb);
+}
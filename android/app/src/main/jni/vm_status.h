@@ -0,0 +1,111 @@
+/**
+ * VM Status
+ * Process-wide snapshot of the running VM for synchronous readers (the
+ * JSI bindings in qemu_jsi.cpp). VmStatus.java publishes the Java side's
+ * status snapshots here; QemuService attaches the launcher that runs
+ * QEMU so readers can ask the process itself.
+ */
+
+#ifndef VM_STATUS_H
+#define VM_STATUS_H
+
+#include <stddef.h>
+#include <sys/types.h>
+
+#include "qemu_launcher.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Numeric fields, same order as the constants in VmStatus.java
+#define VM_STATUS_STARTED_AT               0
+#define VM_STATUS_RAM_MB                   1
+#define VM_STATUS_CPU_CORES                2
+#define VM_STATUS_SUSPENDED                3
+#define VM_STATUS_SECTIONS                 4   // VM_SECTION_* bits
+#define VM_STATUS_BALLOON_ACTUAL_MB        5
+#define VM_STATUS_BALLOON_TARGET_MB        6
+#define VM_STATUS_BALLOON_FLOOR_MB         7
+#define VM_STATUS_BALLOON_WORKING_SET_MB   8
+#define VM_STATUS_BALLOON_UPDATED_AT       9
+#define VM_STATUS_POWER_CORES              10
+#define VM_STATUS_POWER_TEMP_C             11
+#define VM_STATUS_POWER_CHARGING           12
+#define VM_STATUS_POWER_BATTERY_PCT        13
+#define VM_STATUS_POWER_SCREEN_ON          14
+#define VM_STATUS_POWER_CHANGED_AT         15
+#define VM_STATUS_POWER_CHANGES            16
+#define VM_STATUS_ACTIVATION_LISTENING     17
+#define VM_STATUS_ACTIVATION_WAITING       18
+#define VM_STATUS_ACTIVATION_COUNT         19
+#define VM_STATUS_ACTIVATION_LAST_WAIT_MS  20
+#define VM_STATUS_ACTIVATION_MAX_WAIT_MS   21
+#define VM_STATUS_SUPERVISOR_RESTARTS      22
+#define VM_STATUS_SUPERVISOR_RECENT        23
+#define VM_STATUS_SUPERVISOR_NEXT_RESTART  24
+#define VM_STATUS_CRASH_TIME               25
+#define VM_STATUS_CRASH_UPTIME_MS          26
+#define VM_STATUS_CRASH_EXIT_CODE          27
+#define VM_STATUS_CRASH_SIGNAL             28
+#define VM_STATUS_FIELDS                   29
+
+// Text fields
+#define VM_TEXT_BALLOON_PRESSURE   0
+#define VM_TEXT_POWER_POLICY       1
+#define VM_TEXT_POWER_TIER         2
+#define VM_TEXT_POWER_REASON       3
+#define VM_TEXT_POWER_THERMAL      4
+#define VM_TEXT_SUPERVISOR_STATE   5
+#define VM_TEXT_CRASH_REASON       6
+#define VM_TEXT_CRASH_FILE         7
+#define VM_STATUS_TEXTS            8
+#define VM_TEXT_MAX                256
+
+// Which optional sections VM_STATUS_SECTIONS says are present
+#define VM_SECTION_BALLOON     (1 << 0)
+#define VM_SECTION_POWER       (1 << 1)
+#define VM_SECTION_ACTIVATION  (1 << 2)
+#define VM_SECTION_SUPERVISOR  (1 << 3)
+#define VM_SECTION_CRASH       (1 << 4)
+
+typedef struct {
+    double values[VM_STATUS_FIELDS];
+    char texts[VM_STATUS_TEXTS][VM_TEXT_MAX];
+    unsigned long generation;   // bumped by every publish
+    pid_t pid;                  // 0 unless an attached QEMU is alive
+} vm_status_t;
+
+/**
+ * Copy the current snapshot; pid is checked against the launcher
+ */
+void vm_status_snapshot(vm_status_t* out);
+
+/**
+ * Pid of the attached QEMU if it is alive, else 0
+ */
+pid_t vm_status_pid(void);
+
+/**
+ * Make launcher the running VM and start sampling its stats (see
+ * vm_stats.h); cores and ram_mb are what the VM was given
+ */
+void vm_status_attach(launcher_t* launcher, int cores, int ram_mb);
+
+/**
+ * Forget launcher if it is the attached one and stop sampling it; call
+ * before freeing it
+ */
+void vm_status_detach(launcher_t* launcher);
+
+/**
+ * Copy the last max bytes of the attached VM's serial console
+ * Returns: bytes copied, 0 without a VM
+ */
+size_t vm_status_serial_tail(char* buf, size_t max);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VM_STATUS_H
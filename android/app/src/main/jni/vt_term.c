@@ -0,0 +1,1414 @@
+/**
+ * VT Terminal
+ * Parser after the DEC ANSI state machine (ground, escape, CSI, OSC and
+ * ignored strings), a subset of xterm's controls that covers shells,
+ * ncurses programs and colour output, and a line-pointer screen so
+ * scrolling moves pointers instead of cells.
+ */
+
+#include <errno.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vt_term.h"
+
+#define MAX_PARAMS 16
+#define MAX_INTERMEDIATES 2
+#define OSC_MAX 256
+#define TITLE_MAX 128
+#define REPLY_MAX 256
+#define TAB_WIDTH 8
+
+enum {
+    S_GROUND,
+    S_ESC,
+    S_ESC_INTER,
+    S_CSI,
+    S_CSI_IGNORE,
+    S_OSC,
+    S_OSC_ESC,
+    S_STRING,      // DCS, SOS, PM, APC: skipped up to ST
+    S_STRING_ESC,
+};
+
+typedef struct {
+    vt_cell_t* cells;
+    uint32_t id;
+    uint16_t dirty_lo;  // changed columns, dirty_lo .. dirty_hi-1
+    uint16_t dirty_hi;
+} line_t;
+
+typedef struct {
+    vt_cell_t* cells;  // rows * cols, owned
+    line_t* lines;     // screen order
+} screen_t;
+
+typedef struct {
+    int x;
+    int y;
+    vt_cell_t pen;
+    int charset[2];
+    int gl;
+    int origin;
+    int wrap_pending;
+} cursor_t;
+
+struct vt_term {
+    int rows;
+    int cols;
+    screen_t primary;
+    screen_t alternate;
+    screen_t* screen;
+
+    // Scrollback ring of history_cap lines of cols cells
+    vt_cell_t* history;
+    int history_cap;
+    int history_len;
+    int history_head;  // oldest line
+
+    cursor_t cur;
+    cursor_t saved;          // DECSC
+    cursor_t saved_primary;  // mode 1049
+    int top;
+    int bottom;
+    uint8_t* tabs;
+
+    int autowrap;
+    int insert;
+    int newline;  // LNM: LF also returns the carriage
+    unsigned flags;
+    uint32_t last_char;
+    uint32_t next_id;
+
+    // Parser
+    int state;
+    int params[MAX_PARAMS];
+    int nparams;
+    int param_started;
+    char intermediates[MAX_INTERMEDIATES + 1];
+    int ninter;
+    char marker;  // CSI private marker: ? > < =
+    char osc[OSC_MAX];
+    int osc_len;
+    uint32_t utf8_cp;
+    int utf8_need;
+
+    unsigned changes;
+    int cursor_reported_x;
+    int cursor_reported_y;
+    char title[TITLE_MAX];
+    char reply[REPLY_MAX];
+    size_t reply_len;
+};
+
+// DEC special graphics for 0x5f..0x7e, the line drawing set
+static const uint16_t dec_graphics[32] = {
+    0x00A0, 0x25C6, 0x2592, 0x2409, 0x240C, 0x240D, 0x240A, 0x00B0,
+    0x00B1, 0x2424, 0x240B, 0x2518, 0x2510, 0x250C, 0x2514, 0x253C,
+    0x23BA, 0x23BB, 0x2500, 0x23BC, 0x23BD, 0x251C, 0x2524, 0x2534,
+    0x252C, 0x2502, 0x2264, 0x2265, 0x03C0, 0x2260, 0x00A3, 0x00B7,
+};
+
+/**
+ * Columns a code point takes: 0 for combining marks, 2 for East Asian
+ * wide and emoji ranges, else 1
+ */
+static int char_width(uint32_t cp) {
+    if (cp < 0x300) {
+        return 1;
+    }
+    if ((cp >= 0x0300 && cp <= 0x036F) || (cp >= 0x200B && cp <= 0x200F) ||
+        (cp >= 0xFE00 && cp <= 0xFE0F) || (cp >= 0x20D0 && cp <= 0x20FF)) {
+        return 0;
+    }
+    if ((cp >= 0x1100 && cp <= 0x115F) || (cp >= 0x2E80 && cp <= 0xA4CF && cp != 0x303F) ||
+        (cp >= 0xAC00 && cp <= 0xD7A3) || (cp >= 0xF900 && cp <= 0xFAFF) ||
+        (cp >= 0xFE30 && cp <= 0xFE4F) || (cp >= 0xFF00 && cp <= 0xFF60) ||
+        (cp >= 0xFFE0 && cp <= 0xFFE6) || (cp >= 0x1F300 && cp <= 0x1F64F) ||
+        (cp >= 0x1F900 && cp <= 0x1F9FF) || (cp >= 0x20000 && cp <= 0x3FFFD)) {
+        return 2;
+    }
+    return 1;
+}
+
+static int clamp(int v, int lo, int hi) {
+    return v < lo ? lo : v > hi ? hi : v;
+}
+
+// ============================================
+// Damage
+// ============================================
+
+static void damage(vt_term_t* t, int y, int x0, int x1) {
+    line_t* line = &t->screen->lines[y];
+    if (line->dirty_hi <= line->dirty_lo) {
+        line->dirty_lo = (uint16_t)x0;
+        line->dirty_hi = (uint16_t)x1;
+        return;
+    }
+    if (x0 < line->dirty_lo) {
+        line->dirty_lo = (uint16_t)x0;
+    }
+    if (x1 > line->dirty_hi) {
+        line->dirty_hi = (uint16_t)x1;
+    }
+}
+
+static void damage_all(vt_term_t* t) {
+    for (int y = 0; y < t->rows; y++) {
+        t->screen->lines[y].dirty_lo = 0;
+        t->screen->lines[y].dirty_hi = (uint16_t)t->cols;
+    }
+}
+
+// ============================================
+// Screen
+// ============================================
+
+/**
+ * Erased cells keep the current background (xterm's bce)
+ */
+static vt_cell_t blank(const vt_term_t* t) {
+    vt_cell_t cell = { 0, 0, t->cur.pen.bg, (uint16_t)(t->cur.pen.attr & VT_ATTR_BG) };
+    return cell;
+}
+
+static void fill(vt_cell_t* cells, int count, vt_cell_t cell) {
+    for (int i = 0; i < count; i++) {
+        cells[i] = cell;
+    }
+}
+
+static void erase(vt_term_t* t, int y, int x0, int x1) {
+    x0 = clamp(x0, 0, t->cols);
+    x1 = clamp(x1, 0, t->cols);
+    if (x0 < x1) {
+        fill(t->screen->lines[y].cells + x0, x1 - x0, blank(t));
+        damage(t, y, x0, x1);
+    }
+}
+
+static int screen_alloc(screen_t* s, int rows, int cols, uint32_t* next_id) {
+    s->cells = calloc((size_t)rows * (size_t)cols, sizeof(vt_cell_t));
+    s->lines = calloc((size_t)rows, sizeof(line_t));
+    if (s->cells == NULL || s->lines == NULL) {
+        free(s->cells);
+        free(s->lines);
+        s->cells = NULL;
+        s->lines = NULL;
+        return -ENOMEM;
+    }
+    for (int y = 0; y < rows; y++) {
+        s->lines[y].cells = s->cells + (size_t)y * (size_t)cols;
+        s->lines[y].id = (*next_id)++;
+        s->lines[y].dirty_lo = 0;
+        s->lines[y].dirty_hi = (uint16_t)cols;
+    }
+    return 0;
+}
+
+static void screen_free(screen_t* s) {
+    free(s->cells);
+    free(s->lines);
+    s->cells = NULL;
+    s->lines = NULL;
+}
+
+static void push_history(vt_term_t* t, const vt_cell_t* cells) {
+    if (t->history_cap == 0) {
+        return;
+    }
+    int slot;
+    if (t->history_len < t->history_cap) {
+        slot = (t->history_head + t->history_len) % t->history_cap;
+        t->history_len++;
+    } else {
+        slot = t->history_head;
+        t->history_head = (t->history_head + 1) % t->history_cap;
+    }
+    memcpy(t->history + (size_t)slot * (size_t)t->cols, cells, (size_t)t->cols * sizeof(vt_cell_t));
+    t->changes |= VT_CHANGED_HISTORY;
+}
+
+/**
+ * Move lines top+n .. bottom up by n, blanking the n lines that come in
+ * at the bottom. Lines leaving the top of the primary screen go to
+ * scrollback when keep is set.
+ */
+static void scroll_up(vt_term_t* t, int top, int bottom, int n, int keep) {
+    n = clamp(n, 0, bottom - top + 1);
+    line_t* lines = t->screen->lines;
+    for (int i = 0; i < n; i++) {
+        line_t line = lines[top];
+        if (keep && top == 0 && t->screen == &t->primary) {
+            push_history(t, line.cells);
+        }
+        memmove(&lines[top], &lines[top + 1], (size_t)(bottom - top) * sizeof(line_t));
+        line.id = t->next_id++;
+        line.dirty_hi = 0;
+        lines[bottom] = line;
+        erase(t, bottom, 0, t->cols);
+    }
+    if (n > 0) {
+        t->changes |= VT_CHANGED_LINES;
+    }
+}
+
+static void scroll_down(vt_term_t* t, int top, int bottom, int n) {
+    n = clamp(n, 0, bottom - top + 1);
+    line_t* lines = t->screen->lines;
+    for (int i = 0; i < n; i++) {
+        line_t line = lines[bottom];
+        memmove(&lines[top + 1], &lines[top], (size_t)(bottom - top) * sizeof(line_t));
+        line.id = t->next_id++;
+        line.dirty_hi = 0;
+        lines[top] = line;
+        erase(t, top, 0, t->cols);
+    }
+    if (n > 0) {
+        t->changes |= VT_CHANGED_LINES;
+    }
+}
+
+static void linefeed(vt_term_t* t) {
+    if (t->cur.y == t->bottom) {
+        scroll_up(t, t->top, t->bottom, 1, 1);
+    } else if (t->cur.y < t->rows - 1) {
+        t->cur.y++;
+    }
+    t->cur.wrap_pending = 0;
+}
+
+static void reverse_index(vt_term_t* t) {
+    if (t->cur.y == t->top) {
+        scroll_down(t, t->top, t->bottom, 1);
+    } else if (t->cur.y > 0) {
+        t->cur.y--;
+    }
+    t->cur.wrap_pending = 0;
+}
+
+static void move_to(vt_term_t* t, int x, int y) {
+    int top = t->cur.origin ? t->top : 0;
+    int bottom = t->cur.origin ? t->bottom : t->rows - 1;
+    t->cur.x = clamp(x, 0, t->cols - 1);
+    t->cur.y = clamp(y, top, bottom);
+    t->cur.wrap_pending = 0;
+}
+
+static void reset_tabs(vt_term_t* t) {
+    for (int x = 0; x < t->cols; x++) {
+        t->tabs[x] = x % TAB_WIDTH == 0;
+    }
+}
+
+static void tab(vt_term_t* t, int n) {
+    int x = t->cur.x;
+    while (n-- > 0 && x < t->cols - 1) {
+        x++;
+        while (x < t->cols - 1 && !t->tabs[x]) {
+            x++;
+        }
+    }
+    t->cur.x = x;
+    t->cur.wrap_pending = 0;
+}
+
+static void back_tab(vt_term_t* t, int n) {
+    int x = t->cur.x;
+    while (n-- > 0 && x > 0) {
+        x--;
+        while (x > 0 && !t->tabs[x]) {
+            x--;
+        }
+    }
+    t->cur.x = x;
+    t->cur.wrap_pending = 0;
+}
+
+static void insert_cells(vt_term_t* t, int n) {
+    vt_cell_t* cells = t->screen->lines[t->cur.y].cells;
+    n = clamp(n, 0, t->cols - t->cur.x);
+    memmove(cells + t->cur.x + n, cells + t->cur.x, (size_t)(t->cols - t->cur.x - n) * sizeof(vt_cell_t));
+    fill(cells + t->cur.x, n, blank(t));
+    damage(t, t->cur.y, t->cur.x, t->cols);
+}
+
+static void delete_cells(vt_term_t* t, int n) {
+    vt_cell_t* cells = t->screen->lines[t->cur.y].cells;
+    n = clamp(n, 0, t->cols - t->cur.x);
+    memmove(cells + t->cur.x, cells + t->cur.x + n, (size_t)(t->cols - t->cur.x - n) * sizeof(vt_cell_t));
+    fill(cells + t->cols - n, n, blank(t));
+    damage(t, t->cur.y, t->cur.x, t->cols);
+}
+
+static void switch_screen(vt_term_t* t, int alternate) {
+    screen_t* target = alternate ? &t->alternate : &t->primary;
+    if (t->screen == target) {
+        return;
+    }
+    t->screen = target;
+    if (alternate) {
+        t->flags |= VT_FLAG_ALT_SCREEN;
+    } else {
+        t->flags &= ~VT_FLAG_ALT_SCREEN;
+    }
+    damage_all(t);
+    t->changes |= VT_CHANGED_LINES;
+}
+
+static void clear_screen(vt_term_t* t) {
+    for (int y = 0; y < t->rows; y++) {
+        erase(t, y, 0, t->cols);
+    }
+}
+
+// ============================================
+// Printing
+// ============================================
+
+static void put_char(vt_term_t* t, uint32_t cp) {
+    if (cp >= 0x5f && cp <= 0x7e && t->cur.charset[t->cur.gl]) {
+        cp = dec_graphics[cp - 0x5f];
+    }
+    int width = char_width(cp);
+    if (width == 0) {
+        return;
+    }
+    if (width > t->cols) {
+        width = 1;
+    }
+    if (t->cur.wrap_pending) {
+        t->cur.x = 0;
+        linefeed(t);
+    }
+    if (width == 2 && t->cur.x == t->cols - 1) {
+        if (!t->autowrap) {
+            return;
+        }
+        erase(t, t->cur.y, t->cur.x, t->cols);
+        t->cur.x = 0;
+        linefeed(t);
+    }
+    if (t->insert) {
+        insert_cells(t, width);
+    }
+
+    vt_cell_t* cells = t->screen->lines[t->cur.y].cells;
+    vt_cell_t cell = t->cur.pen;
+    cell.ch = cp;
+    if (width == 2) {
+        cell.attr |= VT_ATTR_WIDE;
+        cells[t->cur.x] = cell;
+        cell.ch = 0;
+        cell.attr = (uint16_t)((cell.attr & ~VT_ATTR_WIDE) | VT_ATTR_WIDE_CONT);
+        cells[t->cur.x + 1] = cell;
+    } else {
+        cells[t->cur.x] = cell;
+    }
+    damage(t, t->cur.y, t->cur.x, t->cur.x + width);
+    t->last_char = cp;
+
+    if (t->cur.x + width >= t->cols) {
+        t->cur.x = t->cols - 1;
+        t->cur.wrap_pending = t->autowrap;
+    } else {
+        t->cur.x += width;
+    }
+}
+
+/**
+ * Fast path for runs of printable ASCII in the ground state
+ */
+static void put_ascii(vt_term_t* t, const char* text, size_t len) {
+    if (t->insert || t->cur.charset[t->cur.gl]) {
+        for (size_t i = 0; i < len; i++) {
+            put_char(t, (unsigned char)text[i]);
+        }
+        return;
+    }
+    vt_cell_t cell = t->cur.pen;
+    while (len > 0) {
+        if (t->cur.wrap_pending) {
+            t->cur.x = 0;
+            linefeed(t);
+        }
+        vt_cell_t* cells = t->screen->lines[t->cur.y].cells;
+        int x = t->cur.x;
+        size_t n = (size_t)(t->cols - x);
+        if (n > len) {
+            n = len;
+        }
+        for (size_t i = 0; i < n; i++) {
+            cell.ch = (unsigned char)text[i];
+            cells[x + (int)i] = cell;
+        }
+        damage(t, t->cur.y, x, x + (int)n);
+        t->last_char = (unsigned char)text[n - 1];
+        text += n;
+        len -= n;
+        if (x + (int)n >= t->cols) {
+            t->cur.x = t->cols - 1;
+            t->cur.wrap_pending = t->autowrap;
+            if (!t->autowrap && len > 0) {
+                // Without wrap the rest overwrites the last column
+                cells[t->cols - 1].ch = (unsigned char)text[len - 1];
+                t->last_char = (unsigned char)text[len - 1];
+                len = 0;
+            }
+        } else {
+            t->cur.x = x + (int)n;
+        }
+    }
+}
+
+static void add_reply(vt_term_t* t, const char* text) {
+    size_t len = strlen(text);
+    if (t->reply_len + len <= sizeof(t->reply)) {
+        memcpy(t->reply + t->reply_len, text, len);
+        t->reply_len += len;
+    }
+}
+
+// ============================================
+// Controls
+// ============================================
+
+static void save_cursor(vt_term_t* t, cursor_t* into) {
+    *into = t->cur;
+}
+
+static void restore_cursor(vt_term_t* t, const cursor_t* from) {
+    t->cur = *from;
+    t->cur.x = clamp(t->cur.x, 0, t->cols - 1);
+    t->cur.y = clamp(t->cur.y, 0, t->rows - 1);
+}
+
+static void reset_state(vt_term_t* t) {
+    memset(&t->cur, 0, sizeof(t->cur));
+    t->saved = t->cur;
+    t->saved_primary = t->cur;
+    t->top = 0;
+    t->bottom = t->rows - 1;
+    t->autowrap = 1;
+    t->insert = 0;
+    t->newline = 0;
+    t->flags = VT_FLAG_CURSOR_VISIBLE;
+    t->last_char = ' ';
+    t->state = S_GROUND;
+    t->utf8_need = 0;
+    t->title[0] = '\0';
+    t->reply_len = 0;
+    reset_tabs(t);
+}
+
+static void control(vt_term_t* t, unsigned char c) {
+    switch (c) {
+        case 0x08:  // BS
+            if (t->cur.x > 0) {
+                t->cur.x--;
+            }
+            t->cur.wrap_pending = 0;
+            break;
+        case 0x09:  // HT
+            tab(t, 1);
+            break;
+        case 0x0a:  // LF
+        case 0x0b:  // VT
+        case 0x0c:  // FF
+            linefeed(t);
+            if (t->newline) {
+                t->cur.x = 0;
+            }
+            break;
+        case 0x0d:  // CR
+            t->cur.x = 0;
+            t->cur.wrap_pending = 0;
+            break;
+        case 0x0e:  // SO
+            t->cur.gl = 1;
+            break;
+        case 0x0f:  // SI
+            t->cur.gl = 0;
+            break;
+        default:    // BEL, NUL and the rest
+            break;
+    }
+}
+
+static int param(const vt_term_t* t, int i, int fallback) {
+    return i < t->nparams && t->params[i] > 0 ? t->params[i] : fallback;
+}
+
+/**
+ * Nearest palette entry to a 24-bit colour, from the 6x6x6 cube or the
+ * grey ramp
+ */
+static uint8_t rgb_index(int r, int g, int b) {
+    static const int levels[6] = { 0, 95, 135, 175, 215, 255 };
+    int q[3];
+    int rgb[3] = { r, g, b };
+    int cube_dist = 0;
+    for (int i = 0; i < 3; i++) {
+        int v = clamp(rgb[i], 0, 255);
+        q[i] = v < 48 ? 0 : v < 115 ? 1 : (v - 35) / 40;
+        int d = v - levels[q[i]];
+        cube_dist += d * d;
+    }
+    int avg = (r + g + b) / 3;
+    int grey = avg > 238 ? 23 : avg < 8 ? 0 : (avg - 8) / 10;
+    int grey_level = 8 + grey * 10;
+    int grey_dist = (r - grey_level) * (r - grey_level) + (g - grey_level) * (g - grey_level) +
+                    (b - grey_level) * (b - grey_level);
+    if (grey_dist < cube_dist) {
+        return (uint8_t)(232 + grey);
+    }
+    return (uint8_t)(16 + 36 * q[0] + 6 * q[1] + q[2]);
+}
+
+/**
+ * 38/48 ; 5 ; n or 38/48 ; 2 ; r ; g ; b starting at params[i]
+ * Returns: params consumed after the 38/48
+ */
+static int extended_color(vt_term_t* t, int i, int background) {
+    vt_cell_t* pen = &t->cur.pen;
+    int index = -1;
+    int used = 0;
+    if (i + 1 < t->nparams && t->params[i + 1] == 5 && i + 2 < t->nparams) {
+        index = clamp(t->params[i + 2], 0, 255);
+        used = 2;
+    } else if (i + 1 < t->nparams && t->params[i + 1] == 2 && i + 4 < t->nparams) {
+        index = rgb_index(t->params[i + 2], t->params[i + 3], t->params[i + 4]);
+        used = 4;
+    }
+    if (index >= 0) {
+        if (background) {
+            pen->bg = (uint8_t)index;
+            pen->attr |= VT_ATTR_BG;
+        } else {
+            pen->fg = (uint8_t)index;
+            pen->attr |= VT_ATTR_FG;
+        }
+    }
+    return used;
+}
+
+static void sgr(vt_term_t* t) {
+    vt_cell_t* pen = &t->cur.pen;
+    if (t->nparams == 0) {
+        pen->attr = 0;
+        return;
+    }
+    for (int i = 0; i < t->nparams; i++) {
+        int p = t->params[i] < 0 ? 0 : t->params[i];
+        if (p == 0) {
+            pen->attr = 0;
+        } else if (p == 1) {
+            pen->attr |= VT_ATTR_BOLD;
+        } else if (p == 2) {
+            pen->attr |= VT_ATTR_DIM;
+        } else if (p == 3) {
+            pen->attr |= VT_ATTR_ITALIC;
+        } else if (p == 4 || p == 21) {
+            pen->attr |= VT_ATTR_UNDERLINE;
+        } else if (p == 5 || p == 6) {
+            pen->attr |= VT_ATTR_BLINK;
+        } else if (p == 7) {
+            pen->attr |= VT_ATTR_INVERSE;
+        } else if (p == 8) {
+            pen->attr |= VT_ATTR_HIDDEN;
+        } else if (p == 9) {
+            pen->attr |= VT_ATTR_STRIKE;
+        } else if (p == 22) {
+            pen->attr &= ~(VT_ATTR_BOLD | VT_ATTR_DIM);
+        } else if (p == 23) {
+            pen->attr &= ~VT_ATTR_ITALIC;
+        } else if (p == 24) {
+            pen->attr &= ~VT_ATTR_UNDERLINE;
+        } else if (p == 25) {
+            pen->attr &= ~VT_ATTR_BLINK;
+        } else if (p == 27) {
+            pen->attr &= ~VT_ATTR_INVERSE;
+        } else if (p == 28) {
+            pen->attr &= ~VT_ATTR_HIDDEN;
+        } else if (p == 29) {
+            pen->attr &= ~VT_ATTR_STRIKE;
+        } else if (p >= 30 && p <= 37) {
+            pen->fg = (uint8_t)(p - 30);
+            pen->attr |= VT_ATTR_FG;
+        } else if (p == 38) {
+            i += extended_color(t, i, 0);
+        } else if (p == 39) {
+            pen->attr &= ~VT_ATTR_FG;
+        } else if (p >= 40 && p <= 47) {
+            pen->bg = (uint8_t)(p - 40);
+            pen->attr |= VT_ATTR_BG;
+        } else if (p == 48) {
+            i += extended_color(t, i, 1);
+        } else if (p == 49) {
+            pen->attr &= ~VT_ATTR_BG;
+        } else if (p >= 90 && p <= 97) {
+            pen->fg = (uint8_t)(p - 90 + 8);
+            pen->attr |= VT_ATTR_FG;
+        } else if (p >= 100 && p <= 107) {
+            pen->bg = (uint8_t)(p - 100 + 8);
+            pen->attr |= VT_ATTR_BG;
+        }
+    }
+}
+
+static void set_mode(vt_term_t* t, int on) {
+    for (int i = 0; i < t->nparams; i++) {
+        int p = t->params[i];
+        if (t->marker != '?') {
+            if (p == 4) {
+                t->insert = on;
+            } else if (p == 20) {
+                t->newline = on;
+            }
+            continue;
+        }
+        switch (p) {
+            case 1:
+                t->flags = on ? t->flags | VT_FLAG_APP_CURSOR : t->flags & ~VT_FLAG_APP_CURSOR;
+                break;
+            case 6:
+                t->cur.origin = on;
+                move_to(t, 0, on ? t->top : 0);
+                break;
+            case 7:
+                t->autowrap = on;
+                break;
+            case 25:
+                t->flags = on ? t->flags | VT_FLAG_CURSOR_VISIBLE : t->flags & ~VT_FLAG_CURSOR_VISIBLE;
+                t->changes |= VT_CHANGED_CURSOR;
+                break;
+            case 47:
+            case 1047:
+                if (!on && t->screen == &t->alternate && p == 1047) {
+                    clear_screen(t);
+                }
+                switch_screen(t, on);
+                break;
+            case 1048:
+                if (on) {
+                    save_cursor(t, &t->saved);
+                } else {
+                    restore_cursor(t, &t->saved);
+                }
+                break;
+            case 1049:
+                if (on && t->screen == &t->primary) {
+                    save_cursor(t, &t->saved_primary);
+                    switch_screen(t, 1);
+                    clear_screen(t);
+                } else if (!on && t->screen == &t->alternate) {
+                    switch_screen(t, 0);
+                    restore_cursor(t, &t->saved_primary);
+                }
+                break;
+            case 2004:
+                t->flags = on ? t->flags | VT_FLAG_BRACKETED_PASTE : t->flags & ~VT_FLAG_BRACKETED_PASTE;
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+static void csi_dispatch(vt_term_t* t, char final) {
+    int y = t->cur.y;
+    int x = t->cur.x;
+    int top = t->cur.origin ? t->top : 0;
+    char reply[48];
+
+    if (t->ninter > 0) {
+        return;  // DECSCUSR, DECSTR and friends: nothing to draw
+    }
+    if (t->marker != 0 && t->marker != '?' && !(t->marker == '>' && final == 'c')) {
+        return;
+    }
+
+    switch (final) {
+        case '@':  // ICH
+            insert_cells(t, param(t, 0, 1));
+            break;
+        case 'A':  // CUU
+            t->cur.y = clamp(y - param(t, 0, 1), y >= t->top ? t->top : 0, t->rows - 1);
+            t->cur.wrap_pending = 0;
+            break;
+        case 'B':  // CUD
+        case 'e':  // VPR
+            t->cur.y = clamp(y + param(t, 0, 1), 0, y <= t->bottom ? t->bottom : t->rows - 1);
+            t->cur.wrap_pending = 0;
+            break;
+        case 'C':  // CUF
+        case 'a':  // HPR
+            move_to(t, x + param(t, 0, 1), y);
+            t->cur.y = y;
+            break;
+        case 'D':  // CUB
+            move_to(t, x - param(t, 0, 1), y);
+            t->cur.y = y;
+            break;
+        case 'E':  // CNL
+            t->cur.y = clamp(y + param(t, 0, 1), 0, t->rows - 1);
+            t->cur.x = 0;
+            t->cur.wrap_pending = 0;
+            break;
+        case 'F':  // CPL
+            t->cur.y = clamp(y - param(t, 0, 1), 0, t->rows - 1);
+            t->cur.x = 0;
+            t->cur.wrap_pending = 0;
+            break;
+        case 'G':  // CHA
+        case '`':  // HPA
+            t->cur.x = clamp(param(t, 0, 1) - 1, 0, t->cols - 1);
+            t->cur.wrap_pending = 0;
+            break;
+        case 'H':  // CUP
+        case 'f':  // HVP
+            move_to(t, param(t, 1, 1) - 1, top + param(t, 0, 1) - 1);
+            break;
+        case 'I':  // CHT
+            tab(t, param(t, 0, 1));
+            break;
+        case 'J':  // ED
+            switch (param(t, 0, 0)) {
+                case 0:
+                    erase(t, y, x, t->cols);
+                    for (int row = y + 1; row < t->rows; row++) {
+                        erase(t, row, 0, t->cols);
+                    }
+                    break;
+                case 1:
+                    for (int row = 0; row < y; row++) {
+                        erase(t, row, 0, t->cols);
+                    }
+                    erase(t, y, 0, x + 1);
+                    break;
+                case 2:
+                    clear_screen(t);
+                    break;
+                case 3:
+                    t->history_len = 0;
+                    t->history_head = 0;
+                    t->changes |= VT_CHANGED_HISTORY;
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case 'K':  // EL
+            switch (param(t, 0, 0)) {
+                case 0:
+                    erase(t, y, x, t->cols);
+                    break;
+                case 1:
+                    erase(t, y, 0, x + 1);
+                    break;
+                case 2:
+                    erase(t, y, 0, t->cols);
+                    break;
+                default:
+                    break;
+            }
+            break;
+        case 'L':  // IL
+            if (y >= t->top && y <= t->bottom) {
+                scroll_down(t, y, t->bottom, param(t, 0, 1));
+                t->cur.x = 0;
+            }
+            break;
+        case 'M':  // DL
+            if (y >= t->top && y <= t->bottom) {
+                scroll_up(t, y, t->bottom, param(t, 0, 1), 0);
+                t->cur.x = 0;
+            }
+            break;
+        case 'P':  // DCH
+            delete_cells(t, param(t, 0, 1));
+            break;
+        case 'S':  // SU
+            scroll_up(t, t->top, t->bottom, param(t, 0, 1), 1);
+            break;
+        case 'T':  // SD
+            if (t->nparams <= 1) {
+                scroll_down(t, t->top, t->bottom, param(t, 0, 1));
+            }
+            break;
+        case 'X':  // ECH
+            erase(t, y, x, x + param(t, 0, 1));
+            break;
+        case 'Z':  // CBT
+            back_tab(t, param(t, 0, 1));
+            break;
+        case 'b':  // REP
+            for (int n = clamp(param(t, 0, 1), 1, t->rows * t->cols); n > 0; n--) {
+                put_char(t, t->last_char);
+            }
+            break;
+        case 'c':  // DA
+            if (param(t, 0, 0) == 0) {
+                add_reply(t, t->marker == '>' ? "\x1b[>0;10;0c" : "\x1b[?6c");
+            }
+            break;
+        case 'd':  // VPA
+            move_to(t, x, top + param(t, 0, 1) - 1);
+            break;
+        case 'g':  // TBC
+            if (param(t, 0, 0) == 0) {
+                t->tabs[x] = 0;
+            } else if (param(t, 0, 0) == 3) {
+                memset(t->tabs, 0, (size_t)t->cols);
+            }
+            break;
+        case 'h':  // SM
+            set_mode(t, 1);
+            break;
+        case 'l':  // RM
+            set_mode(t, 0);
+            break;
+        case 'm':  // SGR
+            if (t->marker == 0) {
+                sgr(t);
+            }
+            break;
+        case 'n':  // DSR
+            if (t->marker == 0 && param(t, 0, 0) == 5) {
+                add_reply(t, "\x1b[0n");
+            } else if (param(t, 0, 0) == 6) {
+                snprintf(reply, sizeof(reply), "\x1b[%d;%dR", y - top + 1, x + 1);
+                add_reply(t, reply);
+            }
+            break;
+        case 'r':  // DECSTBM
+            if (t->marker == 0) {
+                int new_top = param(t, 0, 1) - 1;
+                int new_bottom = param(t, 1, t->rows) - 1;
+                new_bottom = clamp(new_bottom, 0, t->rows - 1);
+                if (new_top < new_bottom) {
+                    t->top = new_top;
+                    t->bottom = new_bottom;
+                    move_to(t, 0, t->cur.origin ? t->top : 0);
+                }
+            }
+            break;
+        case 's':  // SCOSC
+            save_cursor(t, &t->saved);
+            break;
+        case 'u':  // SCORC
+            restore_cursor(t, &t->saved);
+            break;
+        default:
+            break;
+    }
+}
+
+static void esc_dispatch(vt_term_t* t, unsigned char c) {
+    if (t->ninter > 0) {
+        char inter = t->intermediates[0];
+        if (inter == '(' || inter == ')') {
+            t->cur.charset[inter == ')'] = c == '0';
+        } else if (inter == '#' && c == '8') {
+            // DECALN: fill the screen with E
+            vt_cell_t cell = { 'E', 0, 0, 0 };
+            for (int y = 0; y < t->rows; y++) {
+                fill(t->screen->lines[y].cells, t->cols, cell);
+            }
+            damage_all(t);
+        }
+        return;
+    }
+    switch (c) {
+        case '7':  // DECSC
+            save_cursor(t, &t->saved);
+            break;
+        case '8':  // DECRC
+            restore_cursor(t, &t->saved);
+            break;
+        case 'D':  // IND
+            linefeed(t);
+            break;
+        case 'E':  // NEL
+            linefeed(t);
+            t->cur.x = 0;
+            break;
+        case 'H':  // HTS
+            t->tabs[t->cur.x] = 1;
+            break;
+        case 'M':  // RI
+            reverse_index(t);
+            break;
+        case 'c':  // RIS
+            vt_term_reset(t);
+            break;
+        default:   // DECKPAM, DECKPNM and the rest
+            break;
+    }
+}
+
+static void osc_dispatch(vt_term_t* t) {
+    t->osc[t->osc_len] = '\0';
+    // 0 and 2 set the title; 1 (icon name) and the rest are ignored
+    if ((t->osc[0] == '0' || t->osc[0] == '2') && t->osc[1] == ';') {
+        snprintf(t->title, sizeof(t->title), "%s", t->osc + 2);
+        t->changes |= VT_CHANGED_TITLE;
+    }
+}
+
+static void clear_params(vt_term_t* t) {
+    t->nparams = 0;
+    t->param_started = 0;
+    t->ninter = 0;
+    t->marker = 0;
+}
+
+// ============================================
+// Parser
+// ============================================
+
+static void process(vt_term_t* t, unsigned char c) {
+    // CAN and SUB abort a sequence; ESC starts a new one anywhere
+    // except inside strings, where it may begin ST
+    if (c == 0x18 || c == 0x1a) {
+        t->state = S_GROUND;
+        return;
+    }
+    if (c == 0x1b) {
+        if (t->state == S_OSC) {
+            t->state = S_OSC_ESC;
+        } else if (t->state == S_STRING) {
+            t->state = S_STRING_ESC;
+        } else {
+            t->state = S_ESC;
+            clear_params(t);
+        }
+        return;
+    }
+
+    switch (t->state) {
+        case S_GROUND:
+            if (c < 0x20 || c == 0x7f) {
+                control(t, c);
+            } else {
+                put_char(t, c);
+            }
+            break;
+
+        case S_ESC:
+            if (c < 0x20) {
+                control(t, c);
+            } else if (c >= 0x20 && c <= 0x2f) {
+                t->intermediates[t->ninter++] = (char)c;
+                t->state = S_ESC_INTER;
+            } else if (c == '[') {
+                t->state = S_CSI;
+            } else if (c == ']') {
+                t->osc_len = 0;
+                t->state = S_OSC;
+            } else if (c == 'P' || c == 'X' || c == '^' || c == '_') {
+                t->state = S_STRING;
+            } else {
+                esc_dispatch(t, c);
+                t->state = S_GROUND;
+            }
+            break;
+
+        case S_ESC_INTER:
+            if (c < 0x20) {
+                control(t, c);
+            } else if (c <= 0x2f) {
+                if (t->ninter < MAX_INTERMEDIATES) {
+                    t->intermediates[t->ninter++] = (char)c;
+                }
+            } else {
+                esc_dispatch(t, c);
+                t->state = S_GROUND;
+            }
+            break;
+
+        case S_CSI:
+            if (c < 0x20) {
+                control(t, c);
+            } else if (c >= '0' && c <= '9') {
+                if (!t->param_started) {
+                    if (t->nparams < MAX_PARAMS) {
+                        t->params[t->nparams++] = 0;
+                    }
+                    t->param_started = 1;
+                }
+                int* p = &t->params[t->nparams - 1];
+                if (*p < 100000) {
+                    *p = *p * 10 + (c - '0');
+                }
+            } else if (c == ';' || c == ':') {
+                // Sub-parameters (38:2:r:g:b) are read as parameters
+                if (!t->param_started && t->nparams < MAX_PARAMS) {
+                    t->params[t->nparams++] = -1;
+                }
+                t->param_started = 0;
+            } else if (c >= '<' && c <= '?') {
+                if (t->nparams == 0 && !t->param_started && t->marker == 0) {
+                    t->marker = (char)c;
+                } else {
+                    t->state = S_CSI_IGNORE;
+                }
+            } else if (c >= 0x20 && c <= 0x2f) {
+                if (t->ninter < MAX_INTERMEDIATES) {
+                    t->intermediates[t->ninter++] = (char)c;
+                }
+            } else if (c >= 0x40 && c <= 0x7e) {
+                csi_dispatch(t, (char)c);
+                t->state = S_GROUND;
+            }
+            break;
+
+        case S_CSI_IGNORE:
+            if (c < 0x20) {
+                control(t, c);
+            } else if (c >= 0x40 && c <= 0x7e) {
+                t->state = S_GROUND;
+            }
+            break;
+
+        case S_OSC:
+            if (c == 0x07) {
+                osc_dispatch(t);
+                t->state = S_GROUND;
+            } else if (c >= 0x20 && t->osc_len < OSC_MAX - 1) {
+                t->osc[t->osc_len++] = (char)c;
+            }
+            break;
+
+        case S_OSC_ESC:
+            // ESC \ is ST; anything else ends the string as well
+            osc_dispatch(t);
+            t->state = S_GROUND;
+            if (c != '\\') {
+                t->state = S_ESC;
+                clear_params(t);
+                process(t, c);
+            }
+            break;
+
+        case S_STRING:
+            if (c == 0x07) {
+                t->state = S_GROUND;
+            }
+            break;
+
+        case S_STRING_ESC:
+            t->state = c == '\\' ? S_GROUND : S_STRING;
+            break;
+
+        default:
+            t->state = S_GROUND;
+            break;
+    }
+}
+
+/**
+ * Decode UTF-8 in the ground state; bytes of sequences and strings go
+ * to the parser as they are
+ */
+static void feed(vt_term_t* t, unsigned char c) {
+    if (t->utf8_need > 0) {
+        if ((c & 0xC0) == 0x80) {
+            t->utf8_cp = (t->utf8_cp << 6) | (c & 0x3F);
+            if (--t->utf8_need == 0) {
+                uint32_t cp = t->utf8_cp;
+                put_char(t, cp > 0x10FFFF || (cp >= 0xD800 && cp <= 0xDFFF) ? 0xFFFD : cp);
+            }
+            return;
+        }
+        t->utf8_need = 0;
+        put_char(t, 0xFFFD);
+    }
+    if (c >= 0x80 && t->state == S_GROUND) {
+        if (c >= 0xC2 && c <= 0xDF) {
+            t->utf8_cp = c & 0x1F;
+            t->utf8_need = 1;
+        } else if (c >= 0xE0 && c <= 0xEF) {
+            t->utf8_cp = c & 0x0F;
+            t->utf8_need = 2;
+        } else if (c >= 0xF0 && c <= 0xF4) {
+            t->utf8_cp = c & 0x07;
+            t->utf8_need = 3;
+        } else {
+            put_char(t, 0xFFFD);
+        }
+        return;
+    }
+    if (c >= 0x80) {
+        if (t->state == S_OSC && t->osc_len < OSC_MAX - 1) {
+            t->osc[t->osc_len++] = (char)c;
+        }
+        return;
+    }
+    process(t, c);
+}
+
+void vt_term_write(vt_term_t* term, const char* data, size_t len) {
+    size_t i = 0;
+    while (i < len) {
+        if (term->state == S_GROUND && term->utf8_need == 0) {
+            size_t run = i;
+            while (run < len && (unsigned char)data[run] >= 0x20 && (unsigned char)data[run] < 0x7f) {
+                run++;
+            }
+            if (run > i) {
+                put_ascii(term, data + i, run - i);
+                i = run;
+                continue;
+            }
+        }
+        feed(term, (unsigned char)data[i]);
+        i++;
+    }
+}
+
+// ============================================
+// Lifecycle
+// ============================================
+
+vt_term_t* vt_term_open(int rows, int cols, int history) {
+    if (rows < 1 || cols < 1 || cols > UINT16_MAX || history < 0) {
+        errno = EINVAL;
+        return NULL;
+    }
+    vt_term_t* t = calloc(1, sizeof(*t));
+    if (t == NULL) {
+        return NULL;
+    }
+    t->rows = rows;
+    t->cols = cols;
+    t->next_id = 1;
+    t->history_cap = history;
+    t->history = history > 0 ? calloc((size_t)history * (size_t)cols, sizeof(vt_cell_t)) : NULL;
+    t->tabs = calloc((size_t)cols, 1);
+    if ((history > 0 && t->history == NULL) || t->tabs == NULL ||
+        screen_alloc(&t->primary, rows, cols, &t->next_id) < 0 ||
+        screen_alloc(&t->alternate, rows, cols, &t->next_id) < 0) {
+        vt_term_close(t);
+        return NULL;
+    }
+    t->screen = &t->primary;
+    reset_state(t);
+    t->changes = VT_CHANGED_LINES | VT_CHANGED_CURSOR;
+    return t;
+}
+
+void vt_term_close(vt_term_t* term) {
+    if (term == NULL) {
+        return;
+    }
+    screen_free(&term->primary);
+    screen_free(&term->alternate);
+    free(term->history);
+    free(term->tabs);
+    free(term);
+}
+
+void vt_term_reset(vt_term_t* term) {
+    term->screen = &term->primary;
+    reset_state(term);
+    clear_screen(term);
+    term->screen = &term->alternate;
+    clear_screen(term);
+    term->screen = &term->primary;
+    term->history_len = 0;
+    term->history_head = 0;
+    damage_all(term);
+    term->changes |= VT_CHANGED_LINES | VT_CHANGED_CURSOR | VT_CHANGED_TITLE | VT_CHANGED_HISTORY;
+}
+
+/**
+ * Copy a screen into a new size, top-left aligned; shift drops that many
+ * lines from the top
+ */
+static void copy_screen(const screen_t* from, screen_t* to, int rows, int cols,
+                        int old_rows, int old_cols, int shift) {
+    int width = cols < old_cols ? cols : old_cols;
+    for (int y = 0; y < rows && y + shift < old_rows; y++) {
+        memcpy(to->lines[y].cells, from->lines[y + shift].cells, (size_t)width * sizeof(vt_cell_t));
+        to->lines[y].id = from->lines[y + shift].id;
+    }
+}
+
+int vt_term_resize(vt_term_t* term, int rows, int cols) {
+    if (rows < 1 || cols < 1 || cols > UINT16_MAX) {
+        return -EINVAL;
+    }
+    if (rows == term->rows && cols == term->cols) {
+        return 0;
+    }
+
+    // Lines below the new bottom push the top into scrollback, so the
+    // cursor's line stays on screen
+    int shift = term->cur.y >= rows ? term->cur.y - rows + 1 : 0;
+
+    screen_t primary;
+    screen_t alternate;
+    uint32_t next_id = term->next_id;
+    vt_cell_t* history = term->history_cap > 0
+        ? calloc((size_t)term->history_cap * (size_t)cols, sizeof(vt_cell_t)) : NULL;
+    uint8_t* tabs = calloc((size_t)cols, 1);
+    if ((term->history_cap > 0 && history == NULL) || tabs == NULL ||
+        screen_alloc(&primary, rows, cols, &next_id) < 0) {
+        free(history);
+        free(tabs);
+        return -ENOMEM;
+    }
+    if (screen_alloc(&alternate, rows, cols, &next_id) < 0) {
+        screen_free(&primary);
+        free(history);
+        free(tabs);
+        return -ENOMEM;
+    }
+
+    if (term->screen == &term->primary) {
+        for (int y = 0; y < shift; y++) {
+            push_history(term, term->primary.lines[y].cells);
+        }
+    }
+    copy_screen(&term->primary, &primary, rows, cols, term->rows, term->cols,
+                term->screen == &term->primary ? shift : 0);
+    copy_screen(&term->alternate, &alternate, rows, cols, term->rows, term->cols,
+                term->screen == &term->alternate ? shift : 0);
+
+    // Scrollback keeps its lines, cut or padded to the new width
+    int width = cols < term->cols ? cols : term->cols;
+    for (int k = 0; k < term->history_len; k++) {
+        int slot = (term->history_head + k) % term->history_cap;
+        memcpy(history + (size_t)k * (size_t)cols, term->history + (size_t)slot * (size_t)term->cols,
+               (size_t)width * sizeof(vt_cell_t));
+    }
+
+    int alternate_active = term->screen == &term->alternate;
+    screen_free(&term->primary);
+    screen_free(&term->alternate);
+    free(term->history);
+    free(term->tabs);
+    term->primary = primary;
+    term->alternate = alternate;
+    term->screen = alternate_active ? &term->alternate : &term->primary;
+    term->history = history;
+    term->history_head = 0;
+    term->tabs = tabs;
+    term->next_id = next_id;
+    term->rows = rows;
+    term->cols = cols;
+    reset_tabs(term);
+
+    term->top = 0;
+    term->bottom = rows - 1;
+    term->cur.y = clamp(term->cur.y - shift, 0, rows - 1);
+    term->cur.x = clamp(term->cur.x, 0, cols - 1);
+    term->cur.wrap_pending = 0;
+    term->saved.y = clamp(term->saved.y - shift, 0, rows - 1);
+    term->saved.x = clamp(term->saved.x, 0, cols - 1);
+    term->saved_primary.y = clamp(term->saved_primary.y, 0, rows - 1);
+    term->saved_primary.x = clamp(term->saved_primary.x, 0, cols - 1);
+    term->changes |= VT_CHANGED_LINES | VT_CHANGED_CURSOR | VT_CHANGED_HISTORY;
+    return 0;
+}
+
+// ============================================
+// Readers
+// ============================================
+
+int vt_term_rows(const vt_term_t* term) {
+    return term->rows;
+}
+
+int vt_term_cols(const vt_term_t* term) {
+    return term->cols;
+}
+
+int vt_term_history(const vt_term_t* term) {
+    return term->history_len;
+}
+
+const vt_cell_t* vt_term_line(const vt_term_t* term, int row) {
+    if (row >= 0) {
+        return row < term->rows ? term->screen->lines[row].cells : NULL;
+    }
+    if (-row > term->history_len) {
+        return NULL;
+    }
+    int slot = (term->history_head + term->history_len + row) % term->history_cap;
+    return term->history + (size_t)slot * (size_t)term->cols;
+}
+
+uint32_t vt_term_line_id(const vt_term_t* term, int row) {
+    return row >= 0 && row < term->rows ? term->screen->lines[row].id : 0;
+}
+
+int vt_term_damage(vt_term_t* term, vt_rect_t* rects, int max) {
+    int count = 0;
+    for (int y = 0; y < term->rows; y++) {
+        line_t* line = &term->screen->lines[y];
+        if (line->dirty_hi <= line->dirty_lo) {
+            continue;
+        }
+        int lo = line->dirty_lo;
+        int hi = line->dirty_hi;
+        line->dirty_lo = 0;
+        line->dirty_hi = 0;
+        if (max <= 0) {
+            continue;
+        }
+
+        vt_rect_t* last = count > 0 ? &rects[count - 1] : NULL;
+        if (last != NULL && last->row + last->rows == y && last->col == lo && last->cols == hi - lo) {
+            last->rows++;
+        } else if (count < max) {
+            rects[count].row = y;
+            rects[count].col = lo;
+            rects[count].rows = 1;
+            rects[count].cols = hi - lo;
+            count++;
+        } else {
+            // Out of room: grow the last rectangle over this line
+            int right = last->col + last->cols > hi ? last->col + last->cols : hi;
+            last->col = last->col < lo ? last->col : lo;
+            last->cols = right - last->col;
+            last->rows = y - last->row + 1;
+        }
+    }
+    return count;
+}
+
+unsigned vt_term_take_changes(vt_term_t* term) {
+    unsigned changes = term->changes;
+    if (term->cur.x != term->cursor_reported_x || term->cur.y != term->cursor_reported_y) {
+        changes |= VT_CHANGED_CURSOR;
+        term->cursor_reported_x = term->cur.x;
+        term->cursor_reported_y = term->cur.y;
+    }
+    term->changes = 0;
+    return changes;
+}
+
+void vt_term_cursor(const vt_term_t* term, int* row, int* col) {
+    *row = term->cur.y;
+    *col = term->cur.x;
+}
+
+unsigned vt_term_flags(const vt_term_t* term) {
+    return term->flags;
+}
+
+const char* vt_term_title(const vt_term_t* term) {
+    return term->title;
+}
+
+size_t vt_term_take_reply(vt_term_t* term, char* buf, size_t len) {
+    size_t n = term->reply_len < len ? term->reply_len : len;
+    memcpy(buf, term->reply, n);
+    memmove(term->reply, term->reply + n, term->reply_len - n);
+    term->reply_len -= n;
+    return n;
+}
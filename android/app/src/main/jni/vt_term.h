@@ -0,0 +1,151 @@
+/**
+ * VT Terminal
+ * VT100/xterm terminal emulation for the Terminal screen: an escape
+ * sequence parser driving a screen grid of compact cells, an alternate
+ * screen for full-screen programs, a scrollback ring and damage tracking,
+ * so a renderer only redraws what changed since its last frame.
+ *
+ * Screen lines carry ids: scrolling moves lines (and their ids) instead
+ * of changing every row, so a renderer keyed by id only draws the line
+ * that scrolled in. Not thread-safe: one user at a time.
+ */
+
+#ifndef VT_TERM_H
+#define VT_TERM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cell attributes
+#define VT_ATTR_BOLD       0x0001
+#define VT_ATTR_DIM        0x0002
+#define VT_ATTR_ITALIC     0x0004
+#define VT_ATTR_UNDERLINE  0x0008
+#define VT_ATTR_BLINK      0x0010
+#define VT_ATTR_INVERSE    0x0020
+#define VT_ATTR_HIDDEN     0x0040
+#define VT_ATTR_STRIKE     0x0080
+#define VT_ATTR_FG         0x0100  // fg holds a palette index, else default
+#define VT_ATTR_BG         0x0200  // bg holds a palette index, else default
+#define VT_ATTR_WIDE       0x0400  // first half of a double-width character
+#define VT_ATTR_WIDE_CONT  0x0800  // second half, no character of its own
+
+// vt_term_take_changes
+#define VT_CHANGED_LINES   0x01  // line ids moved (scroll, screen switch, resize)
+#define VT_CHANGED_CURSOR  0x02
+#define VT_CHANGED_TITLE   0x04
+#define VT_CHANGED_HISTORY 0x08
+
+// vt_term_flags
+#define VT_FLAG_CURSOR_VISIBLE  0x01
+#define VT_FLAG_APP_CURSOR      0x02  // arrow keys send ESC O x
+#define VT_FLAG_ALT_SCREEN      0x04
+#define VT_FLAG_BRACKETED_PASTE 0x08
+
+/**
+ * One character cell; ch 0 is blank. Colours index the xterm 256-colour
+ * palette (24-bit colours are mapped to the nearest entry).
+ */
+typedef struct {
+    uint32_t ch;
+    uint8_t fg;
+    uint8_t bg;
+    uint16_t attr;
+} vt_cell_t;
+
+/**
+ * Changed cells: rows row .. row+rows-1, columns col .. col+cols-1
+ */
+typedef struct {
+    int row;
+    int col;
+    int rows;
+    int cols;
+} vt_rect_t;
+
+typedef struct vt_term vt_term_t;
+
+/**
+ * Open a blank terminal keeping up to history lines of scrollback
+ * Returns: the terminal, NULL if out of memory
+ */
+vt_term_t* vt_term_open(int rows, int cols, int history);
+
+void vt_term_close(vt_term_t* term);
+
+/**
+ * Feed program output; sequences and UTF-8 may be split across writes
+ */
+void vt_term_write(vt_term_t* term, const char* data, size_t len);
+
+/**
+ * Change the screen size; lines pushed off the top go to scrollback
+ * Returns: 0 or -ENOMEM (the terminal is unchanged)
+ */
+int vt_term_resize(vt_term_t* term, int rows, int cols);
+
+/**
+ * Full reset (RIS), scrollback included
+ */
+void vt_term_reset(vt_term_t* term);
+
+int vt_term_rows(const vt_term_t* term);
+int vt_term_cols(const vt_term_t* term);
+
+/**
+ * Lines in scrollback
+ */
+int vt_term_history(const vt_term_t* term);
+
+/**
+ * cols cells of a line: rows 0 .. rows-1 are the screen, -1 the newest
+ * scrollback line, -history the oldest
+ * Returns: the cells, NULL if out of range
+ */
+const vt_cell_t* vt_term_line(const vt_term_t* term, int row);
+
+/**
+ * Id of a screen line, unique for the terminal's lifetime
+ */
+uint32_t vt_term_line_id(const vt_term_t* term, int row);
+
+/**
+ * Take the damage since the last call: rectangles in screen
+ * coordinates, after line moves. More than max are merged into the last.
+ * Returns: rectangles written
+ */
+int vt_term_damage(vt_term_t* term, vt_rect_t* rects, int max);
+
+/**
+ * VT_CHANGED_* since the last call
+ */
+unsigned vt_term_take_changes(vt_term_t* term);
+
+void vt_term_cursor(const vt_term_t* term, int* row, int* col);
+
+/**
+ * VT_FLAG_*
+ */
+unsigned vt_term_flags(const vt_term_t* term);
+
+/**
+ * Window title from OSC 0/2, "" if none
+ */
+const char* vt_term_title(const vt_term_t* term);
+
+/**
+ * Take replies the terminal owes the program (status and attribute
+ * reports), to be written to its input
+ * Returns: bytes copied
+ */
+size_t vt_term_take_reply(vt_term_t* term, char* buf, size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // VT_TERM_H
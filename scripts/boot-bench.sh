@@ -0,0 +1,206 @@
+#!/bin/bash
+# boot-bench.sh
+# Boots the provisioned image under TCG in each boot mode and breaks the
+# boot time down into the same phases as the app's BootTimer:
+#
+#   qemu      process start -> QMP socket accepts connections
+#   firmware  QMP ready -> guest kernel entry (BIOS, bootloader, kernel load)
+#   kernel    kernel entry -> "Run /init" in the guest's dmesg
+#   userspace /init -> guest agent answers (initramfs, OpenRC)
+#   docker    guest agent -> Docker API answers /_ping
+#
+# Run on a Linux host after build-alpine-image.sh. Each run boots a
+# throwaway overlay, so deps/alpine-disk.qcow2 is not modified.
+# Needs qemu-system-x86_64, qemu-img, socat, jq and curl.
+#
+# Usage: scripts/boot-bench.sh [mode...]     (default: firmware kernel microvm)
+#   RUNS=3 SMP=2 RAM_MB=2048 scripts/boot-bench.sh
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_DIR="$(dirname "$SCRIPT_DIR")"
+DEPS_DIR="${PROJECT_DIR}/deps"
+
+RUNS="${RUNS:-1}"
+SMP="${SMP:-2}"
+RAM_MB="${RAM_MB:-2048}"
+DOCKER_PORT="${DOCKER_PORT:-12375}"
+BOOT_TIMEOUT_S="${BOOT_TIMEOUT_S:-600}"
+QEMU="${QEMU:-qemu-system-x86_64}"
+
+DISK_FILE="${DEPS_DIR}/alpine-disk.qcow2"
+MANIFEST_FILE="${DEPS_DIR}/alpine-disk.json"
+KERNEL_FILE="${DEPS_DIR}/vmlinuz-virt"
+INITRD_FILE="${DEPS_DIR}/initramfs-virt"
+
+MODES=("$@")
+if [ ${#MODES[@]} -eq 0 ]; then
+    MODES=(firmware kernel microvm)
+fi
+
+for tool in "${QEMU}" qemu-img socat jq curl; do
+    if ! command -v "${tool}" &> /dev/null; then
+        echo "[ERROR] ${tool} not found" >&2
+        exit 1
+    fi
+done
+for file in "${DISK_FILE}" "${MANIFEST_FILE}" "${KERNEL_FILE}" "${INITRD_FILE}"; do
+    if [ ! -f "${file}" ]; then
+        echo "[ERROR] ${file} missing, run scripts/build-alpine-image.sh first" >&2
+        exit 1
+    fi
+done
+CMDLINE="$(jq -r .cmdline "${MANIFEST_FILE}")"
+
+WORK_DIR="$(mktemp -d)"
+QEMU_PID=""
+cleanup() {
+    if [ -n "${QEMU_PID}" ]; then
+        kill "${QEMU_PID}" 2>/dev/null || true
+        wait "${QEMU_PID}" 2>/dev/null || true
+    fi
+    rm -rf "${WORK_DIR}"
+}
+trap cleanup EXIT
+
+QMP_SOCK="${WORK_DIR}/qmp.sock"
+QGA_SOCK="${WORK_DIR}/qga.sock"
+
+now_ms() {
+    date +%s%3N
+}
+
+# Send one guest agent command; prints the last reply line
+qga() {
+    printf '%s\n' "$1" | socat -t 0.3 - "UNIX-CONNECT:${QGA_SOCK}" 2>/dev/null | tail -n 1
+}
+
+# Run a program in the guest and print its stdout
+qga_exec() {
+    local args pid status
+    args="$(jq -cn --arg path "$1" '$ARGS.positional as $a | {path: $path, arguments: $a, "capture-output": true}' \
+        --args "${@:2}")"
+    pid="$(qga "{\"execute\":\"guest-exec\",\"arguments\":${args}}" | jq -r '.return.pid')"
+    for _ in $(seq 50); do
+        status="$(qga "{\"execute\":\"guest-exec-status\",\"arguments\":{\"pid\":${pid}}}")"
+        if [ "$(jq -r '.return.exited' <<< "${status}")" = "true" ]; then
+            jq -r '.return["out-data"] // ""' <<< "${status}" | base64 -d
+            return 0
+        fi
+        sleep 0.1
+    done
+    return 1
+}
+
+# Poll a command until it succeeds; prints the time it first did
+wait_until() {
+    local deadline=$(( $(now_ms) + BOOT_TIMEOUT_S * 1000 ))
+    while [ "$(now_ms)" -lt "${deadline}" ]; do
+        if "$@"; then
+            now_ms
+            return 0
+        fi
+        sleep 0.1
+    done
+    return 1
+}
+
+qmp_ready() {
+    socat -u OPEN:/dev/null "UNIX-CONNECT:${QMP_SOCK}" 2>/dev/null
+}
+
+agent_ready() {
+    qga '{"execute":"guest-ping"}' | grep -q '"return"'
+}
+
+docker_ready() {
+    curl -sf -m 1 "http://127.0.0.1:${DOCKER_PORT}/_ping" > /dev/null
+}
+
+# Machine and transport per mode; kept in sync with BootConfig/TcgConfig/MemoryConfig.java
+qemu_args() {
+    local mode="$1" transport="pci"
+    case "${mode}" in
+        firmware)
+            ARGS=(-machine q35)
+            ;;
+        kernel)
+            ARGS=(-machine q35,sata=off,smbus=off,vmport=off,smm=off,graphics=off
+                  -nodefaults -no-user-config)
+            ;;
+        microvm)
+            ARGS=(-machine microvm,acpi=off,x-option-roms=off,pic=off,rtc=off,isa-serial=on
+                  -nodefaults -no-user-config)
+            transport="device"
+            ;;
+        *)
+            echo "[ERROR] Unknown mode ${mode} (firmware, kernel, microvm)" >&2
+            exit 1
+            ;;
+    esac
+    if [ "${mode}" != "firmware" ]; then
+        ARGS+=(-kernel "${KERNEL_FILE}" -initrd "${INITRD_FILE}" -append "${CMDLINE}")
+    fi
+    ARGS[1]+=",memory-backend=ram0"
+    ARGS+=(-accel tcg,thread=multi -cpu max -smp "${SMP}" -m "${RAM_MB}" -display none
+           -object "memory-backend-ram,id=ram0,size=${RAM_MB}M,merge=off,dump=off"
+           -serial "file:${WORK_DIR}/serial.log"
+           -object iothread,id=iothread0
+           -drive "file=${WORK_DIR}/overlay.qcow2,if=none,id=disk0,format=qcow2,cache=writeback,aio=threads"
+           -device "virtio-blk-${transport},drive=disk0,iothread=iothread0"
+           -netdev "user,id=net0,hostfwd=tcp:127.0.0.1:${DOCKER_PORT}-:2375"
+           -device "virtio-net-${transport},netdev=net0"
+           -chardev "socket,id=qga0,path=${QGA_SOCK},server=on,wait=off"
+           -device "virtio-serial-${transport}"
+           -device virtserialport,chardev=qga0,name=org.qemu.guest_agent.0
+           -qmp "unix:${QMP_SOCK},server=on,wait=off")
+}
+
+boot_once() {
+    local mode="$1"
+    local start qmp agent uptime_ms entry init_s init_ms docker
+
+    rm -f "${WORK_DIR}/overlay.qcow2" "${QMP_SOCK}" "${QGA_SOCK}"
+    qemu-img create -q -f qcow2 -b "${DISK_FILE}" -F qcow2 "${WORK_DIR}/overlay.qcow2"
+    qemu_args "${mode}"
+
+    start="$(now_ms)"
+    "${QEMU}" "${ARGS[@]}" &
+    QEMU_PID=$!
+
+    qmp="$(wait_until qmp_ready)"
+    agent="$(wait_until agent_ready)"
+    # The agent answers within milliseconds, so uptime is read at ~agent time
+    uptime_ms="$(qga_exec /bin/cat /proc/uptime | awk '{ printf "%d", $1 * 1000 }')"
+    entry=$(( agent - uptime_ms ))
+    if [ "${entry}" -lt "${qmp}" ]; then
+        entry="${qmp}"
+    fi
+    init_s="$(qga_exec /bin/dmesg | sed -n 's/^\[ *\([0-9.]*\)\] Run \/init.*/\1/p' | head -n 1)"
+    init_ms=-1
+    if [ -n "${init_s}" ]; then
+        init_ms="$(awk -v s="${init_s}" 'BEGIN { printf "%d", s * 1000 }')"
+    fi
+    docker="$(wait_until docker_ready)"
+
+    kill "${QEMU_PID}"
+    wait "${QEMU_PID}" 2>/dev/null || true
+    QEMU_PID=""
+
+    local userspace=-1
+    if [ "${init_ms}" -ge 0 ]; then
+        userspace=$(( agent - entry - init_ms ))
+    fi
+    printf "%-10s %8d %9d %8d %10d %8d %8d\n" "${mode}" \
+        $(( qmp - start )) $(( entry - qmp )) "${init_ms}" "${userspace}" \
+        $(( docker - agent )) $(( docker - start ))
+}
+
+echo "[BENCH] ${SMP} vCPUs, ${RAM_MB}MB, TCG, ${RUNS} run(s) per mode (times in ms, ±300 ms agent polling)"
+printf "%-10s %8s %9s %8s %10s %8s %8s\n" "MODE" "QEMU" "FIRMWARE" "KERNEL" "USERSPACE" "DOCKER" "TOTAL"
+for mode in "${MODES[@]}"; do
+    for _ in $(seq "${RUNS}"); do
+        boot_once "${mode}"
+    done
+done
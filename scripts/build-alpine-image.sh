@@ -0,0 +1,107 @@
+#!/bin/bash
+# build-alpine-image.sh
+# Builds a pre-provisioned Alpine qcow2 (Docker, sshd, qemu-guest-agent)
+# so the VM is ready on its first boot without the installer ISO.
+# Needs root and qemu-nbd; run on Linux (CI or a dev machine).
+#
+# Output: deps/alpine-disk.qcow2, deps/alpine-disk.json (image manifest)
+# and deps/vmlinuz-virt + deps/initramfs-virt for direct kernel boot
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_DIR="$(dirname "$SCRIPT_DIR")"
+
+ALPINE_BRANCH="${ALPINE_BRANCH:-v3.19}"
+DISK_SIZE_GB="${DISK_SIZE_GB:-10}"
+MAKE_VM_IMAGE_VERSION="${MAKE_VM_IMAGE_VERSION:-v0.13.0}"
+MAKE_VM_IMAGE_URL="https://raw.githubusercontent.com/alpinelinux/alpine-make-vm-image/${MAKE_VM_IMAGE_VERSION}/alpine-make-vm-image"
+PACKAGES="docker docker-cli-compose openssh qemu-guest-agent chrony e2fsprogs-extra util-linux"
+
+DEPS_DIR="${PROJECT_DIR}/deps"
+DISK_FILE="${DEPS_DIR}/alpine-disk.qcow2"
+MANIFEST_FILE="${DEPS_DIR}/alpine-disk.json"
+KERNEL_FILE="${DEPS_DIR}/vmlinuz-virt"
+INITRD_FILE="${DEPS_DIR}/initramfs-virt"
+# Same options as provision.sh writes to extlinux, plus the root device and
+# the virtio transports (microvm has no PCI bus, only virtio-mmio)
+KERNEL_OPTS="modules=virtio_pci,virtio_mmio,virtio_blk,ext4 console=ttyS0,115200 quiet mitigations=off random.trust_cpu=on rootfstype=ext4"
+
+if [ "$(id -u)" -ne 0 ]; then
+    exec sudo -E "$0" "$@"
+fi
+
+mkdir -p "${DEPS_DIR}"
+
+if [ -f "${DISK_FILE}" ] && [ -f "${MANIFEST_FILE}" ] && [ -f "${KERNEL_FILE}" ]; then
+    echo "[SKIP] Provisioned disk image already exists"
+    exit 0
+fi
+
+if ! command -v qemu-nbd &> /dev/null; then
+    echo "[INSTALL] qemu-utils"
+    apt-get update && apt-get install -y qemu-utils
+fi
+modprobe nbd max_part=16 || true
+
+MAKE_VM_IMAGE="${DEPS_DIR}/alpine-make-vm-image"
+if [ ! -x "${MAKE_VM_IMAGE}" ]; then
+    echo "[DOWNLOAD] alpine-make-vm-image ${MAKE_VM_IMAGE_VERSION}"
+    curl -fL -o "${MAKE_VM_IMAGE}" "${MAKE_VM_IMAGE_URL}"
+    chmod +x "${MAKE_VM_IMAGE}"
+fi
+
+echo "[BUILD] Alpine ${ALPINE_BRANCH} image (${DISK_SIZE_GB}GB) with Docker..."
+rm -f "${DISK_FILE}" "${MANIFEST_FILE}" "${KERNEL_FILE}" "${INITRD_FILE}"
+"${MAKE_VM_IMAGE}" \
+    --image-format qcow2 \
+    --image-size "${DISK_SIZE_GB}G" \
+    --branch "${ALPINE_BRANCH}" \
+    --kernel-flavor virt \
+    --packages "${PACKAGES}" \
+    --serial-console \
+    --script-chroot \
+    "${DISK_FILE}" "${SCRIPT_DIR}/guest/provision.sh"
+
+# Copy the kernel and initramfs out of the image so QEMU can boot them with
+# -kernel/-initrd, skipping firmware and the extlinux menu
+echo "[EXTRACT] Kernel and initramfs for direct boot"
+NBD_DEV="/dev/nbd0"
+MOUNT_DIR="$(mktemp -d)"
+qemu-nbd --connect="${NBD_DEV}" "${DISK_FILE}"
+trap 'umount "${MOUNT_DIR}" 2>/dev/null || true; qemu-nbd --disconnect "${NBD_DEV}" >/dev/null 2>&1 || true' EXIT
+sleep 1
+ROOT_DEV="${NBD_DEV}"
+if [ -b "${NBD_DEV}p1" ]; then
+    ROOT_DEV="${NBD_DEV}p1"
+fi
+mount -o ro "${ROOT_DEV}" "${MOUNT_DIR}"
+cp "${MOUNT_DIR}/boot/vmlinuz-virt" "${KERNEL_FILE}"
+cp "${MOUNT_DIR}/boot/initramfs-virt" "${INITRD_FILE}"
+ROOT_UUID="$(blkid -s UUID -o value "${ROOT_DEV}")"
+umount "${MOUNT_DIR}"
+qemu-nbd --disconnect "${NBD_DEV}" >/dev/null
+trap - EXIT
+rmdir "${MOUNT_DIR}"
+
+# Recompress as a standalone image: no backing file, no stale clusters
+qemu-img convert -O qcow2 -o cluster_size=64k "${DISK_FILE}" "${DISK_FILE}.tmp"
+mv "${DISK_FILE}.tmp" "${DISK_FILE}"
+
+# The app reads this to boot straight from the disk (no -cdrom)
+cat > "${MANIFEST_FILE}" <<JSON
+{
+  "provisioned": true,
+  "alpineBranch": "${ALPINE_BRANCH}",
+  "kernelFlavor": "virt",
+  "docker": true,
+  "guestAgent": true,
+  "kernel": "vmlinuz-virt",
+  "initrd": "initramfs-virt",
+  "cmdline": "root=UUID=${ROOT_UUID} ${KERNEL_OPTS}",
+  "builtAt": "$(date -u +%Y-%m-%dT%H:%M:%SZ)"
+}
+JSON
+
+echo "[OK] Provisioned disk image ($(du -h "${DISK_FILE}" | cut -f1) allocated)"
+echo "[OK] Kernel $(du -h "${KERNEL_FILE}" | cut -f1), initramfs $(du -h "${INITRD_FILE}" | cut -f1)"
@@ -12,6 +12,8 @@ PROJECT_DIR="$(dirname "$SCRIPT_DIR")"
 ALPINE_VERSION="${ALPINE_VERSION:-3.19.1}"
 ALPINE_ISO_URL="https://dl-cdn.alpinelinux.org/alpine/v3.19/releases/x86_64/alpine-virt-${ALPINE_VERSION}-x86_64.iso"
 DISK_SIZE_GB="${DISK_SIZE_GB:-10}"
+PROVISION_IMAGE="${PROVISION_IMAGE:-1}"   # 1 = build a ready-to-run disk with Docker (Linux only)
+KEEP_ISO="${KEEP_ISO:-0}"                 # 1 = package the installer ISO even with a provisioned disk
 
 # Directories
 DEPS_DIR="${PROJECT_DIR}/deps"
@@ -24,6 +26,7 @@ echo "================================================"
 echo ""
 echo "Alpine Version: ${ALPINE_VERSION}"
 echo "Disk Size: ${DISK_SIZE_GB}GB"
+echo "Provisioned Disk: ${PROVISION_IMAGE}"
 echo "Project Dir: ${PROJECT_DIR}"
 echo ""
 
@@ -63,6 +66,15 @@ create_disk_image() {
         return 0
     fi
     
+    # Preferred: Alpine preinstalled with Docker, no ISO install needed
+    if [ "${PROVISION_IMAGE}" = "1" ] && [ "$(uname -s)" = "Linux" ]; then
+        if "${SCRIPT_DIR}/build-alpine-image.sh"; then
+            return 0
+        fi
+        echo "[WARN] Provisioned image build failed, falling back to a blank disk"
+        rm -f "${DISK_FILE}" "${DEPS_DIR}/alpine-disk.json"
+    fi
+    
     # Check for qemu-img
     if ! command -v qemu-img &> /dev/null; then
         echo "[WARN] qemu-img not found, attempting to install..."
@@ -144,22 +156,53 @@ download_qemu_binary() {
     fi
 }
 
+# Function: Copy a VM image into assets, BGZF-compressed when bgzip is available
+# (the app inflates <name>.gz in parallel on first launch)
+copy_vm_asset() {
+    local NAME="$1"
+    
+    rm -f "${ASSETS_DIR}/${NAME}" "${ASSETS_DIR}/${NAME}.gz"
+    
+    if command -v bgzip &> /dev/null; then
+        bgzip -@ "$(nproc 2>/dev/null || echo 4)" -l 9 -c "${DEPS_DIR}/${NAME}" > "${ASSETS_DIR}/${NAME}.gz"
+        echo "  ✓ ${NAME} -> assets/${NAME}.gz ($(du -h "${ASSETS_DIR}/${NAME}.gz" | cut -f1))"
+    else
+        cp "${DEPS_DIR}/${NAME}" "${ASSETS_DIR}/"
+        echo "  ✓ ${NAME} -> assets/ (bgzip not found, uncompressed)"
+    fi
+}
+
 # Function: Copy to Android project
 copy_to_android() {
     echo ""
     echo "[COPY] Dependencies to Android project..."
     
-    # Copy ISO
-    if [ -f "${DEPS_DIR}/alpine-virt.iso" ]; then
-        cp "${DEPS_DIR}/alpine-virt.iso" "${ASSETS_DIR}/"
-        echo "  ✓ alpine-virt.iso -> assets/"
+    # Copy ISO (not needed when the disk is provisioned)
+    if [ -f "${DEPS_DIR}/alpine-disk.json" ] && [ "${KEEP_ISO}" != "1" ]; then
+        rm -f "${ASSETS_DIR}/alpine-virt.iso" "${ASSETS_DIR}/alpine-virt.iso.gz"
+        echo "  - alpine-virt.iso skipped (provisioned disk)"
+    elif [ -f "${DEPS_DIR}/alpine-virt.iso" ]; then
+        copy_vm_asset "alpine-virt.iso"
     fi
     
-    # Copy disk
+    # Copy disk and its manifest
     if [ -f "${DEPS_DIR}/alpine-disk.qcow2" ]; then
-        cp "${DEPS_DIR}/alpine-disk.qcow2" "${ASSETS_DIR}/"
-        echo "  ✓ alpine-disk.qcow2 -> assets/"
+        copy_vm_asset "alpine-disk.qcow2"
     fi
+    rm -f "${ASSETS_DIR}/alpine-disk.json"
+    if [ -f "${DEPS_DIR}/alpine-disk.json" ]; then
+        cp "${DEPS_DIR}/alpine-disk.json" "${ASSETS_DIR}/"
+        echo "  ✓ alpine-disk.json -> assets/"
+    fi
+    
+    # Kernel and initramfs for direct kernel boot (already compressed)
+    for BOOT_FILE in vmlinuz-virt initramfs-virt; do
+        rm -f "${ASSETS_DIR}/${BOOT_FILE}"
+        if [ -f "${DEPS_DIR}/alpine-disk.json" ] && [ -f "${DEPS_DIR}/${BOOT_FILE}" ]; then
+            cp "${DEPS_DIR}/${BOOT_FILE}" "${ASSETS_DIR}/"
+            echo "  ✓ ${BOOT_FILE} -> assets/"
+        fi
+    done
     
     # Copy QEMU binary
     if [ -f "${DEPS_DIR}/libqemu-system-x86_64.so" ] && [ -s "${DEPS_DIR}/libqemu-system-x86_64.so" ]; then
@@ -184,14 +227,16 @@ verify_setup() {
     
     local ALL_OK=true
     
-    if [ -f "${ASSETS_DIR}/alpine-virt.iso" ]; then
+    if [ -f "${ASSETS_DIR}/alpine-virt.iso" ] || [ -f "${ASSETS_DIR}/alpine-virt.iso.gz" ]; then
         echo "✓ Alpine ISO ready"
+    elif [ -f "${ASSETS_DIR}/alpine-disk.json" ]; then
+        echo "✓ Alpine ISO not needed (provisioned disk)"
     else
         echo "✗ Alpine ISO missing"
         ALL_OK=false
     fi
     
-    if [ -f "${ASSETS_DIR}/alpine-disk.qcow2" ]; then
+    if [ -f "${ASSETS_DIR}/alpine-disk.qcow2" ] || [ -f "${ASSETS_DIR}/alpine-disk.qcow2.gz" ]; then
         echo "✓ Disk image ready"
     else
         echo "✗ Disk image missing"
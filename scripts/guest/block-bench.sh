@@ -0,0 +1,59 @@
+#!/bin/sh
+# block-bench.sh
+# Runs block-bench.fio inside the Alpine guest and records the result
+# under a label, so runs with different qemu-config.json block settings
+# can be compared.
+#
+# Usage (in the guest, e.g. over ssh -p 2222 root@localhost):
+#   sh block-bench.sh <label>      run the profile, e.g. "iothread-threads-writeback"
+#   sh block-bench.sh --compare    print all recorded runs side by side
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "$0")" && pwd)"
+PROFILE="${SCRIPT_DIR}/block-bench.fio"
+RESULTS_DIR="${RESULTS_DIR:-/var/lib/block-bench}"
+
+print_summary() {
+    # label, then per job: read/write IOPS, bandwidth and mean latency
+    jq -r --arg label "$2" '
+        .jobs[] |
+        [$label, .jobname,
+         ((.read.iops + .write.iops) | floor),
+         (((.read.bw + .write.bw) / 1024) | floor),
+         (([.read.lat_ns.mean, .write.lat_ns.mean] | max) / 1000 | floor)] |
+        @tsv' "$1"
+}
+
+if [ "$1" = "--compare" ]; then
+    printf "%-28s %-18s %10s %10s %12s\n" "LABEL" "JOB" "IOPS" "MB/s" "LAT(us)"
+    for result in "${RESULTS_DIR}"/*.json; do
+        [ -f "${result}" ] || continue
+        print_summary "${result}" "$(basename "${result}" .json)"
+    done | awk -F '\t' '{ printf "%-28s %-18s %10s %10s %12s\n", $1, $2, $3, $4, $5 }'
+    exit 0
+fi
+
+LABEL="$1"
+if [ -z "${LABEL}" ]; then
+    echo "Usage: $0 <label> | --compare" >&2
+    exit 1
+fi
+
+if ! command -v fio >/dev/null 2>&1 || ! command -v jq >/dev/null 2>&1; then
+    echo "[INSTALL] fio jq"
+    apk add --no-cache fio jq
+fi
+
+mkdir -p /var/tmp/block-bench "${RESULTS_DIR}"
+
+echo "[RUN] ${LABEL} ($(nproc) vCPUs)"
+fio --output-format=json --output="${RESULTS_DIR}/${LABEL}.json" "${PROFILE}"
+rm -rf /var/tmp/block-bench
+
+# Give the freed scratch space back to the host overlay
+fstrim -a >/dev/null 2>&1 || true
+
+print_summary "${RESULTS_DIR}/${LABEL}.json" "${LABEL}" |
+    awk -F '\t' '{ printf "%-28s %-18s %10s IOPS %8s MB/s %10s us\n", $1, $2, $3, $4, $5 }'
+echo "[OK] Saved ${RESULTS_DIR}/${LABEL}.json"
@@ -0,0 +1,92 @@
+#!/bin/sh
+# cpu-bench.sh
+# Times multi-core workloads inside the Alpine guest and records them
+# under a label, so runs with different qemu-config.json "tcg" settings
+# (mttcg, pinVcpus) can be compared:
+#
+#   compress  xz -T0 and zstd -T0 over 256MB of mixed data
+#   build     docker build that compiles zlib with make -j<vCPUs>
+#
+# Usage (in the guest, e.g. over ssh -p 2222 root@localhost):
+#   sh cpu-bench.sh <label>      run the workloads, e.g. "mttcg-pinned"
+#   sh cpu-bench.sh --compare    print all recorded runs side by side
+
+set -e
+
+RESULTS_DIR="${RESULTS_DIR:-/var/lib/cpu-bench}"
+WORK_DIR=/var/tmp/cpu-bench
+ZLIB_VERSION=1.3.1
+
+if [ "$1" = "--compare" ]; then
+    printf "%-28s %6s %10s %10s %10s\n" "LABEL" "VCPUS" "XZ(s)" "ZSTD(s)" "BUILD(s)"
+    for result in "${RESULTS_DIR}"/*.tsv; do
+        [ -f "${result}" ] || continue
+        awk -F '\t' -v label="$(basename "${result}" .tsv)" \
+            '{ printf "%-28s %6s %10s %10s %10s\n", label, $1, $2, $3, $4 }' "${result}"
+    done
+    exit 0
+fi
+
+LABEL="$1"
+if [ -z "${LABEL}" ]; then
+    echo "Usage: $0 <label> | --compare" >&2
+    exit 1
+fi
+
+if ! command -v xz >/dev/null 2>&1 || ! command -v zstd >/dev/null 2>&1; then
+    echo "[INSTALL] xz zstd"
+    apk add --no-cache xz zstd
+fi
+
+# Wall-clock seconds a command takes, with millisecond resolution
+elapsed() {
+    start=$(date +%s%N)
+    "$@" >/dev/null 2>&1
+    end=$(date +%s%N)
+    awk -v ns=$((end - start)) 'BEGIN { printf "%.2f", ns / 1e9 }'
+}
+
+mkdir -p "${WORK_DIR}" "${RESULTS_DIR}"
+VCPUS=$(nproc)
+echo "[RUN] ${LABEL} (${VCPUS} vCPUs)"
+
+# Half compressible text, half random, so neither codec takes a shortcut
+echo "[PREP] Test data"
+head -c 134217728 /dev/urandom > "${WORK_DIR}/random.bin"
+yes "docker-android cpu-bench $(date)" | head -c 134217728 > "${WORK_DIR}/text.bin"
+cat "${WORK_DIR}/random.bin" "${WORK_DIR}/text.bin" > "${WORK_DIR}/data.bin"
+rm -f "${WORK_DIR}/random.bin" "${WORK_DIR}/text.bin"
+
+echo "[RUN] compress"
+XZ_S=$(elapsed xz -T0 -6 -k -f "${WORK_DIR}/data.bin")
+ZSTD_S=$(elapsed zstd -T0 -9 -f "${WORK_DIR}/data.bin" -o "${WORK_DIR}/data.zst")
+echo "  xz ${XZ_S}s, zstd ${ZSTD_S}s"
+
+# The toolchain and sources are fetched into a base image once, so only
+# the compile is timed
+echo "[RUN] build"
+if ! docker image inspect cpu-bench-base >/dev/null 2>&1; then
+    echo "[PREP] cpu-bench-base image (network)"
+    docker build -q -t cpu-bench-base - >/dev/null <<DOCKERFILE
+FROM alpine:3.19
+RUN apk add --no-cache build-base && \\
+    wget -q -O /tmp/zlib.tar.gz https://zlib.net/fossils/zlib-${ZLIB_VERSION}.tar.gz && \\
+    mkdir /src && tar -xzf /tmp/zlib.tar.gz -C /src --strip-components=1
+DOCKERFILE
+fi
+cat > "${WORK_DIR}/Dockerfile" <<DOCKERFILE
+FROM cpu-bench-base
+WORKDIR /src
+RUN ./configure && make -j${VCPUS} && make -j${VCPUS} test
+DOCKERFILE
+BUILD_S=$(elapsed docker build --no-cache -t cpu-bench-build "${WORK_DIR}")
+docker image rm -f cpu-bench-build >/dev/null 2>&1 || true
+echo "  docker build ${BUILD_S}s"
+
+printf "%s\t%s\t%s\t%s\n" "${VCPUS}" "${XZ_S}" "${ZSTD_S}" "${BUILD_S}" > "${RESULTS_DIR}/${LABEL}.tsv"
+rm -rf "${WORK_DIR}"
+
+# Give the freed scratch space back to the host overlay
+fstrim -a >/dev/null 2>&1 || true
+
+echo "[OK] Saved ${RESULTS_DIR}/${LABEL}.tsv"
@@ -0,0 +1,69 @@
+#!/bin/sh
+# provision.sh
+# Runs inside the image chroot (alpine-make-vm-image --script-chroot) and
+# turns a bare Alpine install into a ready-to-run Docker host:
+# dockerd on tcp 2375, sshd, qemu-guest-agent, and a kernel command line
+# tuned for running under TCG on a phone.
+
+set -eu
+
+echo "[PROVISION] Services"
+cat > /etc/network/interfaces <<'NET'
+auto lo
+iface lo inet loopback
+
+auto eth0
+iface eth0 inet dhcp
+NET
+echo "docker-android" > /etc/hostname
+
+rc-update add networking boot
+rc-update add hostname boot
+rc-update add sshd default
+rc-update add docker default
+rc-update add qemu-guest-agent default
+rc-update add chronyd default
+
+# QEMU only exposes the agent on the virtio-serial port
+sed -i 's|^#*GA_PATH=.*|GA_PATH="/dev/virtio-ports/org.qemu.guest_agent.0"|' /etc/conf.d/qemu-guest-agent
+
+# Load the balloon driver at boot: the app inflates it under Android memory
+# pressure and reads the guest memory stats through it
+echo virtio_balloon >> /etc/modules
+
+echo "[PROVISION] Docker"
+# The app reaches the daemon through the hostfwd on port 2375
+cat > /etc/conf.d/docker <<'CONF'
+DOCKER_OPTS="-H unix:///var/run/docker.sock -H tcp://0.0.0.0:2375"
+CONF
+mkdir -p /etc/docker
+cat > /etc/docker/daemon.json <<'JSON'
+{
+  "storage-driver": "overlay2",
+  "log-driver": "json-file",
+  "log-opts": { "max-size": "10m", "max-file": "2" }
+}
+JSON
+
+echo "[PROVISION] Filesystem"
+# Continuous discard keeps the overlay on the phone from only ever growing
+sed -i 's|\(\sext4\s\+\)\(\S\+\)|\1\2,discard,noatime|' /etc/fstab
+
+# Root login over ssh (port 2222 on the phone) without a password prompt
+sed -i 's|^#*PermitRootLogin.*|PermitRootLogin prohibit-password|' /etc/ssh/sshd_config
+passwd -d root
+
+echo "[PROVISION] Kernel"
+# No CPU vulnerability mitigations: every barrier is expensive under TCG
+sed -i 's|^default_kernel_opts=.*|default_kernel_opts="console=ttyS0,115200 quiet mitigations=off random.trust_cpu=on rootfstype=ext4"|' \
+    /etc/update-extlinux.conf
+sed -i 's|^timeout=.*|timeout=1|' /etc/update-extlinux.conf
+update-extlinux
+
+# Boot straight from virtio-blk without probing other drivers
+sed -i 's|^features=.*|features="base ext4 virtio"|' /etc/mkinitfs/mkinitfs.conf
+for kernel in /lib/modules/*; do
+    mkinitfs "$(basename "${kernel}")"
+done
+
+echo "[PROVISION] Done"
@@ -0,0 +1,112 @@
+#!/bin/bash
+# kv-bench.sh
+# Speed of the settings store (android/app/src/main/jni/kv_store.c) on
+# the host: open (replaying the log into the index) for KEYS keys, reads,
+# writes with the compaction they trigger, and an explicit compaction.
+#
+# Usage: scripts/kv-bench.sh
+#   KEYS=1000 VALUE_BYTES=64 scripts/kv-bench.sh
+# Needs a C compiler and zlib.
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_DIR="$(dirname "$SCRIPT_DIR")"
+JNI_DIR="${PROJECT_DIR}/android/app/src/main/jni"
+
+KEYS="${KEYS:-1000}"
+VALUE_BYTES="${VALUE_BYTES:-64}"
+CC="${CC:-cc}"
+
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+cat > "${WORK_DIR}/bench.c" << 'EOF'
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "kv_store.h"
+
+#define OPENS 20
+#define GETS 1000000
+#define SETS 100000
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+static void fill(char* value, int len, int seed) {
+    for (int i = 0; i < len; i++) {
+        value[i] = 'a' + (seed + i) % 26;
+    }
+}
+
+int main(int argc, char** argv) {
+    const char* path = argv[1];
+    int keys = atoi(argv[2]);
+    int value_len = atoi(argv[3]);
+    char key[32];
+    char* value = malloc((size_t)value_len);
+
+    kv_store_t* store = kv_store_open(path);
+    if (store == NULL) {
+        perror(path);
+        return 1;
+    }
+    for (int i = 0; i < keys; i++) {
+        int key_len = snprintf(key, sizeof(key), "@setting_%d", i);
+        fill(value, value_len, i);
+        kv_store_set(store, key, (size_t)key_len, value, (size_t)value_len);
+    }
+    uint64_t used, dead;
+    kv_store_usage(store, &used, &dead);
+    kv_store_close(store);
+
+    double started = now();
+    for (int i = 0; i < OPENS; i++) {
+        kv_store_close(kv_store_open(path));
+    }
+    printf("open      %8.3f ms  (%d keys, %.1f KB log)\n",
+           (now() - started) / OPENS * 1e3, keys, used / 1024.0);
+
+    store = kv_store_open(path);
+    started = now();
+    size_t sum = 0;
+    for (int i = 0; i < GETS; i++) {
+        int key_len = snprintf(key, sizeof(key), "@setting_%d", i % keys);
+        const char* found;
+        size_t found_len;
+        if (kv_store_get(store, key, (size_t)key_len, &found, &found_len)) {
+            sum += found_len;
+        }
+    }
+    printf("get       %8.3f us  (%zu bytes read)\n", (now() - started) / GETS * 1e6, sum);
+
+    started = now();
+    for (int i = 0; i < SETS; i++) {
+        int key_len = snprintf(key, sizeof(key), "@setting_%d", i % keys);
+        fill(value, value_len, i + 1);
+        kv_store_set(store, key, (size_t)key_len, value, (size_t)value_len);
+    }
+    double elapsed = now() - started;
+    kv_store_usage(store, &used, &dead);
+    printf("set       %8.3f us  (compacting as it goes; log now %.1f KB, %.1f KB dead)\n",
+           elapsed / SETS * 1e6, used / 1024.0, dead / 1024.0);
+
+    started = now();
+    kv_store_compact(store);
+    printf("compact   %8.3f ms\n", (now() - started) * 1e3);
+    kv_store_close(store);
+    free(value);
+    return 0;
+}
+EOF
+
+"${CC}" -O2 -I"${JNI_DIR}" -o "${WORK_DIR}/bench" "${WORK_DIR}/bench.c" "${JNI_DIR}/kv_store.c" -lz
+
+echo "Settings store: ${KEYS} keys, ${VALUE_BYTES}-byte values"
+"${WORK_DIR}/bench" "${WORK_DIR}/settings.kv" "${KEYS}" "${VALUE_BYTES}"
@@ -0,0 +1,143 @@
+#!/bin/bash
+# store-bench.sh
+# Times a single container state change in a list of synthetic
+# containers: the old array update (startsWith scan, new array) against
+# the entity table in src/store/entityTable.js (one entity replaced).
+# Cards re-rendered per change are counted by replaying each screen's
+# row props and applying React.memo's rule (a row renders when a prop or
+# the entity it selects is no longer the same object): the old screen
+# built fresh callbacks for every card, the new rows take an ID and
+# stable callbacks and select their own container. Also checks that a
+# refresh with identical data keeps the table as is.
+#
+# Usage: scripts/store-bench.sh [containers] [iterations]   (default: 1000 1000)
+# Needs node.
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_DIR="$(dirname "$SCRIPT_DIR")"
+
+COUNT="${1:-1000}"
+ITERATIONS="${2:-1000}"
+
+# entityTable.js has no imports; as .mjs node loads it as a module
+# whatever the package type
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+cp "${PROJECT_DIR}/src/store/entityTable.js" "${WORK_DIR}/entityTable.mjs"
+
+cat > "${WORK_DIR}/bench.mjs" << 'EOF'
+import { createTable, replaceAll, updateEntity, getEntity, listOf } from './entityTable.mjs';
+
+const count = Number(process.argv[2]);
+const iterations = Number(process.argv[3]);
+
+const synthesizeContainers = () => {
+  const containers = [];
+  for (let i = 0; i < count; i++) {
+    const hex = i.toString(16).padStart(12, '0');
+    containers.push({
+      Id: `${hex}${'f'.repeat(52)}`,
+      Names: [`/bench-${i}`],
+      Image: 'nginx:alpine',
+      State: i % 2 === 0 ? 'running' : 'exited',
+      Status: i % 2 === 0 ? 'Up 2 hours' : 'Exited (0) 1 hour ago',
+      Created: 1700000000 + i,
+      Ports: [{ PrivatePort: 80, Type: 'tcp' }],
+      Labels: { bench: 'true' },
+    });
+  }
+  return containers;
+};
+
+const timeOps = (n, op) => {
+  const started = performance.now();
+  for (let i = 0; i < n; i++) {
+    op(i);
+  }
+  return (performance.now() - started) / n;
+};
+
+const shallowEqual = (a, b) => {
+  const keys = Object.keys(a);
+  return keys.length === Object.keys(b).length && keys.every((key) => a[key] === b[key]);
+};
+
+// Rows whose props or selected entity changed between two renders
+const countRendered = (before, after) => {
+  let rendered = 0;
+  for (let i = 0; i < after.length; i++) {
+    const a = before[i];
+    const b = after[i];
+    if (!a || !shallowEqual(a.props, b.props) || a.selected !== b.selected) rendered++;
+  }
+  return rendered;
+};
+
+// Old ContainersScreen: every card gets the item and new closures
+const renderArrayScreen = (containers) => containers.map((item) => ({
+  props: {
+    container: item,
+    onPress: () => item.Id,
+    onStart: () => item.Id,
+    onStop: () => item.Id,
+    onRestart: () => item.Id,
+    onToggleFavorite: () => item.Id,
+  },
+  selected: null,
+}));
+
+// ContainerRow: an ID and the screen's stable callbacks; the row
+// selects its own container
+const callbacks = { onOpen() {}, onStart() {}, onStop() {}, onRestart() {}, onToggleFavorite() {} };
+const renderTableScreen = (table) => table.ids.map((id) => ({
+  props: { id, ...callbacks },
+  selected: getEntity(table, id),
+}));
+
+const source = synthesizeContainers();
+const pick = (i) => source[(i * 7919) % count].Id.substring(0, 12);
+const state = (i) => (i % 2 === 0 ? 'running' : 'exited');
+
+let array = source;
+const arrayMs = timeOps(iterations, (i) => {
+  const id = pick(i);
+  array = array.map((c) => (c.Id.startsWith(id) ? { ...c, State: state(i) } : c));
+});
+
+let table = replaceAll(createTable(), source);
+const tableMs = timeOps(iterations, (i) => {
+  table = updateEntity(table, pick(i), { State: state(i) });
+});
+
+let arrayCards = 0;
+let tableCards = 0;
+let arrayRows = renderArrayScreen(array);
+let tableRows = renderTableScreen(table);
+for (let i = 0; i < iterations; i++) {
+  const id = pick(i);
+  array = array.map((c) => (c.Id.startsWith(id) ? { ...c, State: state(i + 1) } : c));
+  const nextArrayRows = renderArrayScreen(array);
+  arrayCards += countRendered(arrayRows, nextArrayRows);
+  arrayRows = nextArrayRows;
+
+  table = updateEntity(table, id, { State: state(i + 1) });
+  const nextTableRows = renderTableScreen(table);
+  tableCards += countRendered(tableRows, nextTableRows);
+  tableRows = nextTableRows;
+}
+
+const refreshed = replaceAll(table, listOf(table).map((c) => ({ ...c })));
+const refreshMs = timeOps(10, () => replaceAll(table, listOf(table).map((c) => ({ ...c }))));
+const lookupMs = timeOps(iterations, (i) => getEntity(table, pick(i)));
+
+const ms = (v) => v.toFixed(4) + ' ms';
+console.log('Containers:           ' + count + ' (' + iterations + ' changes)');
+console.log('Array update:         ' + ms(arrayMs) + ', ' + arrayCards / iterations + ' cards re-rendered');
+console.log('Entity table update:  ' + ms(tableMs) + ', ' + tableCards / iterations + ' cards re-rendered');
+console.log('Short ID lookup:      ' + ms(lookupMs));
+console.log('Unchanged refresh:    ' + ms(refreshMs) + (refreshed === table ? ', table kept' : ', TABLE REPLACED'));
+EOF
+
+node "${WORK_DIR}/bench.mjs" "$COUNT" "$ITERATIONS"
@@ -0,0 +1,126 @@
+#!/bin/bash
+# term-bench.sh
+# Throughput of the terminal core (android/app/src/main/jni/vt_term.c):
+# MB/s for `cat` of a large file through the parser and screen, with a
+# renderer frame (damage taken, damaged lines read) every 16 ms worth
+# of 64 KB reads. Without a file it generates plain, coloured and UTF-8
+# samples of SIZE_MB each.
+#
+# Usage: scripts/term-bench.sh [file...]
+#   SIZE_MB=64 ROWS=40 COLS=100 scripts/term-bench.sh
+# Needs a C compiler.
+
+set -e
+
+SCRIPT_DIR="$(cd "$(dirname "${BASH_SOURCE[0]}")" && pwd)"
+PROJECT_DIR="$(dirname "$SCRIPT_DIR")"
+JNI_DIR="${PROJECT_DIR}/android/app/src/main/jni"
+
+SIZE_MB="${SIZE_MB:-64}"
+ROWS="${ROWS:-40}"
+COLS="${COLS:-100}"
+CC="${CC:-cc}"
+
+WORK_DIR="$(mktemp -d)"
+trap 'rm -rf "$WORK_DIR"' EXIT
+
+cat > "${WORK_DIR}/bench.c" << 'EOF'
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "vt_term.h"
+
+#define CHUNK (64 * 1024)
+#define FRAME_NS 16666667L
+
+static double now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+int main(int argc, char** argv) {
+    int rows = atoi(argv[2]);
+    int cols = atoi(argv[3]);
+    int fd = open(argv[1], O_RDONLY);
+    if (fd < 0) {
+        perror(argv[1]);
+        return 1;
+    }
+    off_t size = lseek(fd, 0, SEEK_END);
+    char* data = malloc((size_t)size);
+    if (data == NULL || pread(fd, data, (size_t)size, 0) != size) {
+        perror("read");
+        return 1;
+    }
+    close(fd);
+
+    vt_term_t* term = vt_term_open(rows, cols, 2000);
+    vt_rect_t rects[64];
+    long frames = 0;
+    long lines_drawn = 0;
+    double started = now();
+    double next_frame = started + FRAME_NS / 1e9;
+    for (off_t at = 0; at < size; at += CHUNK) {
+        size_t len = size - at < CHUNK ? (size_t)(size - at) : CHUNK;
+        vt_term_write(term, data + at, len);
+        if (now() >= next_frame || at + CHUNK >= size) {
+            // A frame: take the damage and touch every damaged cell
+            vt_term_take_changes(term);
+            int n = vt_term_damage(term, rects, 64);
+            unsigned sum = 0;
+            for (int i = 0; i < n; i++) {
+                for (int y = rects[i].row; y < rects[i].row + rects[i].rows; y++) {
+                    const vt_cell_t* cells = vt_term_line(term, y);
+                    for (int x = rects[i].col; x < rects[i].col + rects[i].cols; x++) {
+                        sum += cells[x].ch;
+                    }
+                    lines_drawn++;
+                }
+            }
+            if (sum == 1) {
+                putchar(' ');
+            }
+            frames++;
+            next_frame = now() + FRAME_NS / 1e9;
+        }
+    }
+    double elapsed = now() - started;
+    printf("%8.1f MB/s  %6.1f MB in %.3f s, %ld frames, %.1f lines drawn per frame\n",
+           size / elapsed / 1e6, size / 1e6, elapsed, frames, frames ? (double)lines_drawn / frames : 0);
+    vt_term_close(term);
+    free(data);
+    return 0;
+}
+EOF
+
+"${CC}" -O2 -I"${JNI_DIR}" -o "${WORK_DIR}/bench" "${WORK_DIR}/bench.c" "${JNI_DIR}/vt_term.c"
+
+FILES=("$@")
+if [ ${#FILES[@]} -eq 0 ]; then
+    BYTES=$((SIZE_MB * 1024 * 1024))
+    # Plain: log-like lines of varying length
+    awk -v n="${BYTES}" 'BEGIN { srand(1); while (s < n) {
+        l = sprintf("%06d 2024-01-01T00:00:%02d.%03d INFO worker-%d handled request /api/v1/items/%d in %d ms\n",
+                    i, i % 60, i % 1000, i % 8, i * 7, int(rand() * 900)); i++; s += length(l); printf "%s", l } }' \
+        > "${WORK_DIR}/plain.txt"
+    # Coloured: ls --color and compiler style SGR runs
+    awk -v n="${BYTES}" 'BEGIN { while (s < n) {
+        l = sprintf("\033[01;34mdir%d\033[0m  \033[01;32mexec%d\033[0m  file%d.txt  \033[38;5;%dmcolour\033[0m \033[1;31merror:\033[0m line %d\n",
+                    i, i, i, i % 256, i); i++; s += length(l); printf "%s", l } }' \
+        > "${WORK_DIR}/colour.txt"
+    # UTF-8: box drawing, accents and CJK
+    awk -v n="${BYTES}" 'BEGIN { while (s < n) {
+        l = sprintf("│ %6d │ café naïve résumé │ 日本語のテキスト │ ✓ done │\n", i); i++; s += length(l); printf "%s", l } }' \
+        > "${WORK_DIR}/utf8.txt"
+    FILES=("${WORK_DIR}/plain.txt" "${WORK_DIR}/colour.txt" "${WORK_DIR}/utf8.txt")
+fi
+
+echo "Terminal ${ROWS}x${COLS}, 64 KB reads, a frame per 16 ms"
+for file in "${FILES[@]}"; do
+    printf '%-12s' "$(basename "$file")"
+    "${WORK_DIR}/bench" "$file" "${ROWS}" "${COLS}"
+done
@@ -1,18 +1,88 @@
 /**
  * LogViewer Component
- * Displays container or VM logs with auto-scroll
+ * Displays container or VM logs with auto-scroll and search.
+ * The text goes into a line index (services/LogIndex), native when the
+ * JSI bindings are there: new output is appended without re-splitting the
+ * log, and only the lines on screen are read back, a page at a time, with
+ * search matches already marked. Rows are one line high so the list never
+ * has to measure them.
  */
 
-import React, { useRef, useEffect, useState } from 'react';
+import React, { memo, useCallback, useEffect, useRef, useState } from 'react';
 import {
   View,
   Text,
+  TextInput,
   StyleSheet,
-  ScrollView,
+  VirtualizedList,
   TouchableOpacity,
 } from 'react-native';
 import { MaterialCommunityIcons } from '@expo/vector-icons';
 import { ColorTokens, SpaceTokens, RadiusTokens, FontTokens } from '../theme';
+import { createLogIndex } from '../services/LogIndex';
+
+const ROW_HEIGHT = 22;
+const PAGE_LINES = 128;
+const MAX_PAGES = 8;
+
+const getLogLevel = (line) => {
+  const lowerLine = line.toLowerCase();
+  if (lowerLine.includes('error') || lowerLine.includes('fatal')) return 'error';
+  if (lowerLine.includes('warn')) return 'warning';
+  if (lowerLine.includes('info')) return 'info';
+  if (lowerLine.includes('debug')) return 'debug';
+  return 'default';
+};
+
+const getLevelColor = (level) => {
+  switch (level) {
+    case 'error':
+      return ColorTokens.state.error;
+    case 'warning':
+      return ColorTokens.state.warning;
+    case 'info':
+      return ColorTokens.accent.mauve;
+    case 'debug':
+      return ColorTokens.text.muted;
+    default:
+      return ColorTokens.text.secondary;
+  }
+};
+
+const itemText = (item) => String(item?.message ?? item);
+
+/**
+ * One log line; spans are [start, length] pairs of search matches
+ */
+const LogLine = memo(({ number, text, spans, current, numberWidth }) => {
+  const color = getLevelColor(getLogLevel(text));
+  let content = text;
+  if (spans.length > 0) {
+    content = [];
+    let at = 0;
+    for (let i = 0; i < spans.length; i += 2) {
+      if (spans[i] > at) content.push(text.substring(at, spans[i]));
+      content.push(
+        <Text key={i} style={styles.match}>
+          {text.substring(spans[i], spans[i] + spans[i + 1])}
+        </Text>
+      );
+      at = spans[i] + spans[i + 1];
+    }
+    if (at < text.length) content.push(text.substring(at));
+  }
+
+  return (
+    <View style={[styles.logLine, current && styles.logLineCurrent]}>
+      <Text style={[styles.lineNumber, { width: numberWidth }]}>{number}</Text>
+      <Text style={[styles.logText, { color }]} numberOfLines={1}>
+        {content}
+      </Text>
+    </View>
+  );
+});
+
+const NO_SPANS = [];
 
 const LogViewer = ({
   logs = '',
@@ -23,43 +93,158 @@ const LogViewer = ({
   onClear,
   isLoading = false,
 }) => {
-  const scrollRef = useRef(null);
+  const listRef = useRef(null);
+  const indexRef = useRef(null);
+  // What the index holds: the string fed, or the array and its last item
+  const fedRef = useRef({ text: null, items: null, last: undefined });
+  // Pages of { lines, spans } by page number, least recently used first,
+  // marked for one query
+  const pagesRef = useRef({ query: '', pages: new Map() });
   const [isAutoScroll, setIsAutoScroll] = useState(autoScroll);
+  const [lineCount, setLineCount] = useState(0);
+  const [query, setQuery] = useState('');
+  const [matchLine, setMatchLine] = useState(-1);
+  const [version, setVersion] = useState(0);
 
+  // Made on first use and again after an unmount closed it
+  const getIndex = useCallback(() => {
+    if (indexRef.current === null) {
+      indexRef.current = createLogIndex();
+      fedRef.current = { text: null, items: null, last: undefined };
+      pagesRef.current = { query: '', pages: new Map() };
+    }
+    return indexRef.current;
+  }, []);
+
+  useEffect(() => () => {
+    indexRef.current?.close();
+    indexRef.current = null;
+  }, []);
+
+  // Feed only what is new since the last render; anything else resets
   useEffect(() => {
-    if (isAutoScroll && scrollRef.current) {
-      scrollRef.current.scrollToEnd({ animated: true });
+    const index = getIndex();
+    const fed = fedRef.current;
+    const before = index.lineCount();
+    let reset = false;
+
+    if (typeof logs === 'string') {
+      if (fed.text !== null && logs.startsWith(fed.text)) {
+        if (logs.length > fed.text.length) index.append(logs.substring(fed.text.length));
+      } else {
+        index.clear();
+        index.append(logs);
+        reset = true;
+      }
+      fedRef.current = { text: logs, items: null, last: undefined };
+    } else if (Array.isArray(logs)) {
+      // Arrays may drop items from the front; continue after the last one fed
+      const from = fed.items !== null && fed.items.length > 0
+        ? logs.lastIndexOf(fed.last) + 1
+        : 0;
+      if (fed.items === null || (from === 0 && fed.items.length > 0)) {
+        index.clear();
+        reset = true;
+      }
+      const added = logs.slice(from).map(itemText);
+      if (added.length > 0) index.append(`${added.join('\n')}\n`);
+      fedRef.current = { text: null, items: logs, last: logs[logs.length - 1] };
+    } else {
+      index.clear();
+      reset = true;
+      fedRef.current = { text: null, items: null, last: undefined };
     }
-  }, [logs, isAutoScroll]);
-
-  const logLines = typeof logs === 'string' 
-    ? logs.split('\n').filter(line => line.trim())
-    : Array.isArray(logs) 
-      ? logs.map(l => l.message || l)
-      : [];
-
-  const getLogLevel = (line) => {
-    const lowerLine = line.toLowerCase();
-    if (lowerLine.includes('error') || lowerLine.includes('fatal')) return 'error';
-    if (lowerLine.includes('warn')) return 'warning';
-    if (lowerLine.includes('info')) return 'info';
-    if (lowerLine.includes('debug')) return 'debug';
-    return 'default';
-  };
 
-  const getLevelColor = (level) => {
-    switch (level) {
-      case 'error':
-        return ColorTokens.state.error;
-      case 'warning':
-        return ColorTokens.state.warning;
-      case 'info':
-        return ColorTokens.accent.mauve;
-      case 'debug':
-        return ColorTokens.text.muted;
-      default:
-        return ColorTokens.text.secondary;
+    // Earlier pages cannot change on append; the last one can grow
+    const count = index.lineCount();
+    if (reset) {
+      pagesRef.current.pages.clear();
+      setMatchLine(-1);
+    } else if (count !== before) {
+      pagesRef.current.pages.delete(Math.floor(Math.max(before - 1, 0) / PAGE_LINES));
     }
+    setLineCount(count);
+    setVersion((v) => v + 1);
+  }, [logs, getIndex]);
+
+  useEffect(() => {
+    setMatchLine(-1);
+  }, [query]);
+
+  useEffect(() => {
+    if (isAutoScroll && listRef.current && lineCount > 0) {
+      listRef.current.scrollToEnd({ animated: false });
+    }
+  }, [lineCount, isAutoScroll]);
+
+  const getPage = useCallback((page) => {
+    // Matches are marked per page; a new query re-reads what is on screen
+    getIndex();
+    if (pagesRef.current.query !== query) {
+      pagesRef.current = { query, pages: new Map() };
+    }
+    const { pages } = pagesRef.current;
+    let entry = pages.get(page);
+    if (entry) {
+      pages.delete(page);
+    } else {
+      const view = getIndex().window(page * PAGE_LINES, PAGE_LINES, query);
+      const spans = new Array(view.lines.length).fill(NO_SPANS);
+      for (let i = 0; i < view.spans.length; i += 3) {
+        const row = view.spans[i];
+        if (spans[row] === NO_SPANS) spans[row] = [];
+        spans[row].push(view.spans[i + 1], view.spans[i + 2]);
+      }
+      entry = { lines: view.lines, spans };
+      if (pages.size >= MAX_PAGES) {
+        pages.delete(pages.keys().next().value);
+      }
+    }
+    pages.set(page, entry);
+    return entry;
+  }, [query, getIndex]);
+
+  const getItem = useCallback((_data, i) => {
+    const entry = getPage(Math.floor(i / PAGE_LINES));
+    const row = i % PAGE_LINES;
+    return { line: i, text: entry.lines[row] ?? '', spans: entry.spans[row] ?? NO_SPANS };
+  }, [getPage]);
+
+  const getItemCount = useCallback(() => lineCount, [lineCount]);
+
+  const getItemLayout = useCallback((_data, i) => ({
+    length: ROW_HEIGHT,
+    offset: ROW_HEIGHT * i,
+    index: i,
+  }), []);
+
+  const keyExtractor = useCallback((item) => String(item.line), []);
+
+  const numberWidth = Math.max(36, String(lineCount).length * 7 + 4);
+
+  const renderItem = useCallback(({ item }) => (
+    <LogLine
+      number={item.line + 1}
+      text={item.text}
+      spans={item.spans}
+      current={item.line === matchLine}
+      numberWidth={numberWidth}
+    />
+  ), [matchLine, numberWidth]);
+
+  const findMatch = (backwards) => {
+    if (!query) return;
+    const index = getIndex();
+    const from = matchLine < 0 ? (backwards ? lineCount : 0) : matchLine + (backwards ? 0 : 1);
+    let line = index.find(query, from, backwards);
+    // Wrap around once
+    if (line < 0 && matchLine >= 0) {
+      line = index.find(query, backwards ? lineCount : 0, backwards);
+    }
+    if (line < 0) return;
+    setIsAutoScroll(false);
+    setMatchLine(line);
+    listRef.current?.scrollToIndex({ index: line, animated: false, viewPosition: 0.5 });
   };
 
   return (
@@ -119,35 +304,77 @@ const LogViewer = ({
         </View>
       )}
 
-      <ScrollView
-        ref={scrollRef}
-        style={[styles.logContainer, { maxHeight }]}
-        contentContainerStyle={styles.logContent}
-        showsVerticalScrollIndicator={true}
-        onScrollBeginDrag={() => setIsAutoScroll(false)}
-      >
-        {logLines.length === 0 ? (
+      {showControls && (
+        <View style={styles.search}>
+          <MaterialCommunityIcons
+            name="magnify"
+            size={16}
+            color={ColorTokens.text.muted}
+          />
+          <TextInput
+            style={styles.searchInput}
+            value={query}
+            onChangeText={setQuery}
+            onSubmitEditing={() => findMatch(false)}
+            placeholder="Search logs"
+            placeholderTextColor="#666"
+            autoCapitalize="none"
+            autoCorrect={false}
+            returnKeyType="search"
+          />
+          <TouchableOpacity
+            style={styles.controlButton}
+            onPress={() => findMatch(true)}
+            disabled={!query}
+          >
+            <MaterialCommunityIcons
+              name="chevron-up"
+              size={18}
+              color={ColorTokens.text.muted}
+            />
+          </TouchableOpacity>
+          <TouchableOpacity
+            style={styles.controlButton}
+            onPress={() => findMatch(false)}
+            disabled={!query}
+          >
+            <MaterialCommunityIcons
+              name="chevron-down"
+              size={18}
+              color={ColorTokens.text.muted}
+            />
+          </TouchableOpacity>
+        </View>
+      )}
+
+      {lineCount === 0 ? (
+        <View style={[styles.logContainer, styles.logContent]}>
           <Text style={styles.emptyText}>No logs available</Text>
-        ) : (
-          logLines.map((line, index) => {
-            const level = getLogLevel(line);
-            const color = getLevelColor(level);
-            
-            return (
-              <View key={index} style={styles.logLine}>
-                <Text style={styles.lineNumber}>{index + 1}</Text>
-                <Text style={[styles.logText, { color }]}>
-                  {line}
-                </Text>
-              </View>
-            );
-          })
-        )}
-      </ScrollView>
+        </View>
+      ) : (
+        <VirtualizedList
+          ref={listRef}
+          style={[styles.logContainer, { maxHeight }]}
+          contentContainerStyle={styles.logContent}
+          data={version}
+          extraData={renderItem}
+          getItem={getItem}
+          getItemCount={getItemCount}
+          getItemLayout={getItemLayout}
+          keyExtractor={keyExtractor}
+          renderItem={renderItem}
+          initialNumToRender={Math.ceil(maxHeight / ROW_HEIGHT)}
+          windowSize={5}
+          maxToRenderPerBatch={PAGE_LINES}
+          showsVerticalScrollIndicator={true}
+          onScrollBeginDrag={() => setIsAutoScroll(false)}
+        />
+      )}
 
       <View style={styles.footer}>
         <Text style={styles.footerText}>
-          {logLines.length} line{logLines.length !== 1 ? 's' : ''}
+          {matchLine >= 0 ? `match at line ${matchLine + 1} · ` : ''}
+          {lineCount} line{lineCount !== 1 ? 's' : ''}
         </Text>
       </View>
     </View>
@@ -190,10 +417,33 @@ const styles = StyleSheet.create({
   logContent: {
     padding: SpaceTokens.sm,
   },
+  search: {
+    flexDirection: 'row',
+    alignItems: 'center',
+    paddingHorizontal: SpaceTokens.sm,
+    borderBottomWidth: 1,
+    borderBottomColor: '#333',
+  },
+  searchInput: {
+    flex: 1,
+    fontSize: FontTokens.size.caption,
+    fontFamily: 'monospace',
+    color: ColorTokens.text.secondary,
+    paddingVertical: SpaceTokens.xs,
+    marginLeft: SpaceTokens.xs,
+  },
   logLine: {
     flexDirection: 'row',
+    height: ROW_HEIGHT,
     paddingVertical: 2,
   },
+  logLineCurrent: {
+    backgroundColor: '#333',
+  },
+  match: {
+    backgroundColor: `${ColorTokens.state.warning}60`,
+    color: '#FFF',
+  },
   lineNumber: {
     width: 36,
     fontSize: 11,
@@ -1,159 +1,225 @@
 /**
  * Terminal Component
- * Terminal emulator using WebView with xterm.js
+ * Terminal emulator over services/TerminalEmulator: output goes through a
+ * VT100/xterm core (native with JSI), and once per display frame only the
+ * lines it reports as damaged are re-rendered. Rows are keyed by line id,
+ * so scrolling moves rows instead of redrawing them.
  */
 
-import React, { useRef, useState } from 'react';
+import React, { memo, useCallback, useEffect, useMemo, useRef, useState } from 'react';
 import { View, StyleSheet, TextInput, TouchableOpacity, Text } from 'react-native';
-import { WebView } from 'react-native-webview';
 import { MaterialCommunityIcons } from '@expo/vector-icons';
 import { ColorTokens, SpaceTokens, RadiusTokens, FontTokens } from '../theme';
+import { createTerminal, TERM_ATTR, TERM_FLAG } from '../services/TerminalEmulator';
 
-const terminalHTML = `
-<!DOCTYPE html>
-<html>
-<head>
-  <meta name="viewport" content="width=device-width, initial-scale=1.0, maximum-scale=1.0, user-scalable=no">
-  <style>
-    * { margin: 0; padding: 0; box-sizing: border-box; }
-    body {
-      background: #1E1E1E;
-      font-family: 'Courier New', monospace;
-      font-size: 14px;
-      color: #D4D4D4;
-      padding: 8px;
-      height: 100vh;
-      overflow-y: auto;
-    }
-    #terminal {
-      white-space: pre-wrap;
-      word-wrap: break-word;
-    }
-    .line {
-      padding: 2px 0;
-      line-height: 1.4;
-    }
-    .prompt {
-      color: #7A6EAA;
-    }
-    .command {
-      color: #FFFFFF;
-    }
-    .output {
-      color: #D4D4D4;
-    }
-    .error {
-      color: #D17C7C;
-    }
-    .success {
-      color: #7FAF9B;
-    }
-    .cursor {
-      display: inline-block;
-      width: 8px;
-      height: 14px;
-      background: #7A6EAA;
-      animation: blink 1s infinite;
-    }
-    @keyframes blink {
-      0%, 50% { opacity: 1; }
-      51%, 100% { opacity: 0; }
-    }
-  </style>
-</head>
-<body>
-  <div id="terminal"></div>
-  <script>
-    const terminal = document.getElementById('terminal');
-    let history = [];
-    let historyIndex = -1;
-    
-    function addLine(text, type = 'output') {
-      const line = document.createElement('div');
-      line.className = 'line ' + type;
-      line.textContent = text;
-      terminal.appendChild(line);
-      window.scrollTo(0, document.body.scrollHeight);
-    }
-    
-    function showPrompt() {
-      addLine('root@alpine:~# ', 'prompt');
-    }
-    
-    // Initial message
-    addLine('Alpine Linux VM Terminal', 'success');
-    addLine('Connected to Docker host', 'output');
-    addLine('', 'output');
-    showPrompt();
-    
-    // Listen for commands from React Native
-    window.executeCommand = function(cmd) {
-      addLine(cmd, 'command');
-      history.push(cmd);
-      historyIndex = history.length;
-      
-      // Send to React Native
-      window.ReactNativeWebView.postMessage(JSON.stringify({
-        type: 'command',
-        data: cmd
-      }));
-    };
-    
-    // Receive output from React Native
-    window.addOutput = function(text, isError) {
-      addLine(text, isError ? 'error' : 'output');
-      showPrompt();
-    };
-  </script>
-</body>
-</html>
-`;
+const FONT_SIZE = 13;
+const LINE_HEIGHT = 18;
+const PADDING = 8;
+const DEFAULT_FG = '#D4D4D4';
+const DEFAULT_BG = '#1E1E1E';
+const PROMPT = '\x1b[35mroot@alpine:~# \x1b[0m';
+const BANNER = '\x1b[32mAlpine Linux VM Terminal\x1b[0m\r\nConnected to Docker host\r\n\r\n';
+
+// xterm 256-colour palette: 16 base colours, the 6x6x6 cube, 24 greys
+const PALETTE = (() => {
+  const base = [
+    '#000000', '#CD3131', '#0DBC79', '#E5E510', '#2472C8', '#BC3FBC', '#11A8CD', '#E5E5E5',
+    '#666666', '#F14C4C', '#23D18B', '#F5F543', '#3B8EEA', '#D670D6', '#29B8DB', '#FFFFFF',
+  ];
+  const hex = (v) => v.toString(16).padStart(2, '0');
+  const levels = [0, 95, 135, 175, 215, 255];
+  for (let i = 0; i < 216; i++) {
+    base.push(`#${hex(levels[Math.floor(i / 36)])}${hex(levels[Math.floor(i / 6) % 6])}${hex(levels[i % 6])}`);
+  }
+  for (let i = 0; i < 24; i++) {
+    const v = hex(8 + i * 10);
+    base.push(`#${v}${v}${v}`);
+  }
+  return base;
+})();
+
+const runStyles = new Map();
+
+/**
+ * Text style for a packed run style, made once per style
+ */
+const styleFor = (style) => {
+  let result = runStyles.get(style);
+  if (result) return result;
+
+  const attr = style >>> 16;
+  let color = attr & TERM_ATTR.FG ? PALETTE[style & 0xff] : DEFAULT_FG;
+  let backgroundColor = attr & TERM_ATTR.BG ? PALETTE[(style >> 8) & 0xff] : undefined;
+  if (attr & TERM_ATTR.INVERSE) {
+    [color, backgroundColor] = [backgroundColor || DEFAULT_BG, color];
+  }
+  if (attr & TERM_ATTR.HIDDEN) {
+    color = backgroundColor || DEFAULT_BG;
+  } else if (attr & TERM_ATTR.DIM) {
+    color = `${color}99`;
+  }
+  const decorations = [];
+  if (attr & TERM_ATTR.UNDERLINE) decorations.push('underline');
+  if (attr & TERM_ATTR.STRIKE) decorations.push('line-through');
+
+  result = {
+    color,
+    backgroundColor,
+    fontWeight: attr & TERM_ATTR.BOLD ? 'bold' : undefined,
+    fontStyle: attr & TERM_ATTR.ITALIC ? 'italic' : undefined,
+    textDecorationLine: decorations.length > 0 ? decorations.join(' ') : undefined,
+  };
+  runStyles.set(style, result);
+  return result;
+};
+
+/**
+ * Output from a command: newlines as CRLF, ending in one
+ */
+const toTerminal = (text) => {
+  const crlf = text.replace(/\r?\n/g, '\r\n');
+  return crlf.endsWith('\n') ? crlf : `${crlf}\r\n`;
+};
+
+const EMPTY_RUNS = [];
+
+/**
+ * One screen line; runs is [text, style, ...]
+ */
+const TerminalRow = memo(({ runs }) => {
+  const parts = [];
+  for (let i = 0; i < runs.length; i += 2) {
+    parts.push(runs[i + 1] === 0 ? runs[i] : (
+      <Text key={i} style={styleFor(runs[i + 1])}>{runs[i]}</Text>
+    ));
+  }
+  return (
+    <Text style={styles.row} numberOfLines={1}>
+      {parts}
+    </Text>
+  );
+});
 
 const Terminal = ({
   onCommand,
+  onData,
   initialOutput,
   height = 300,
 }) => {
-  const webViewRef = useRef(null);
+  const termRef = useRef(null);
+  const frameRef = useRef(null);
+  // Screen line ids and the runs last drawn for each
+  const idsRef = useRef([]);
+  const runsRef = useRef(new Map());
   const [input, setInput] = useState('');
-  const [isConnected, setIsConnected] = useState(true);
+  const [screen, setScreen] = useState({ ids: [], cursor: [0, 0, true], history: 0, title: '' });
+  const [scrollback, setScrollback] = useState(0);
+  const [charWidth, setCharWidth] = useState(FONT_SIZE * 0.6);
+  const [area, setArea] = useState(null);
 
-  const handleMessage = (event) => {
-    try {
-      const message = JSON.parse(event.nativeEvent.data);
-      if (message.type === 'command' && onCommand) {
-        onCommand(message.data);
+  /**
+   * Take the frame's damage: runs for damaged lines by id, and the new
+   * line order when lines moved
+   */
+  const drawFrame = useCallback(() => {
+    frameRef.current = null;
+    const term = termRef.current;
+    const frame = term && term.frame();
+    if (!frame) return;
+
+    const runs = runsRef.current;
+    if (frame.ids) {
+      idsRef.current = frame.ids;
+      const live = new Set(frame.ids);
+      for (const id of runs.keys()) {
+        if (!live.has(id)) runs.delete(id);
       }
-    } catch (error) {
-      console.error('Terminal message error:', error);
     }
+    const ids = idsRef.current;
+    for (let i = 0; i < frame.damaged.length; i += 2) {
+      runs.set(ids[frame.damaged[i]], frame.damaged[i + 1]);
+    }
+    if (frame.reply && onData) {
+      onData(frame.reply);
+    }
+    setScreen((previous) => ({
+      ids,
+      cursor: frame.cursor,
+      history: frame.history,
+      title: frame.title !== undefined ? frame.title : previous.title,
+    }));
+  }, [onData]);
+
+  // Writes between two frames are drawn together
+  const write = useCallback((text) => {
+    if (!termRef.current) return;
+    termRef.current.write(text);
+    if (frameRef.current === null) {
+      frameRef.current = requestAnimationFrame(drawFrame);
+    }
+  }, [drawFrame]);
+
+  useEffect(() => {
+    termRef.current = createTerminal(24, 80);
+    write(BANNER + (initialOutput ? toTerminal(initialOutput) : '') + PROMPT);
+    return () => {
+      if (frameRef.current !== null) cancelAnimationFrame(frameRef.current);
+      frameRef.current = null;
+      termRef.current.close();
+      termRef.current = null;
+    };
+  }, []);
+
+  // Fit the terminal to the space it has
+  const rows = area ? Math.max(1, Math.floor((area.height - PADDING * 2) / LINE_HEIGHT)) : 0;
+  const cols = area ? Math.max(1, Math.floor((area.width - PADDING * 2) / charWidth)) : 0;
+  useEffect(() => {
+    if (rows > 0 && cols > 0 && termRef.current) {
+      termRef.current.resize(rows, cols);
+      write('');
+    }
+  }, [rows, cols, write]);
+
+  // Scrollback view: rows lines starting that far above the screen
+  const scrolledLines = useMemo(() => {
+    if (scrollback === 0 || !termRef.current) return null;
+    return termRef.current.lines(-scrollback, rows);
+  }, [scrollback, rows, screen]);
+
+  const pageUp = () => {
+    setScrollback((offset) => Math.min(screen.history, offset + Math.max(1, rows - 1)));
   };
 
-  const sendCommand = () => {
-    if (!input.trim()) return;
-    
-    webViewRef.current?.injectJavaScript(`
-      window.executeCommand(${JSON.stringify(input)});
-      true;
-    `);
-    setInput('');
+  const pageDown = () => {
+    setScrollback((offset) => Math.max(0, offset - Math.max(1, rows - 1)));
   };
 
-  const addOutput = (text, isError = false) => {
-    webViewRef.current?.injectJavaScript(`
-      window.addOutput(${JSON.stringify(text)}, ${isError});
-      true;
-    `);
+  const sendCommand = async () => {
+    const command = input;
+    if (!command.trim()) return;
+    setInput('');
+    setScrollback(0);
+    write(`${command}\r\n`);
+    try {
+      const output = onCommand ? await onCommand(command) : undefined;
+      if (typeof output === 'string' && output) {
+        write(toTerminal(output));
+      }
+    } catch (error) {
+      write(`\x1b[31m${toTerminal(error.message || String(error))}\x1b[0m`);
+    }
+    write(PROMPT);
   };
 
   const clearTerminal = () => {
-    webViewRef.current?.injectJavaScript(`
-      document.getElementById('terminal').innerHTML = '';
-      window.addOutput('Terminal cleared', false);
-      true;
-    `);
+    if (!termRef.current) return;
+    termRef.current.reset();
+    setScrollback(0);
+    write(`Terminal cleared\r\n${PROMPT}`);
   };
 
+  const [cursorRow, cursorCol, cursorVisible] = screen.cursor;
+
   return (
     <View style={[styles.container, { height }]}>
       <View style={styles.header}>
@@ -163,9 +229,33 @@ const Terminal = ({
             size={18}
             color={ColorTokens.accent.mauve}
           />
-          <Text style={styles.title}>Terminal</Text>
+          <Text style={styles.title} numberOfLines={1}>
+            {screen.title || 'Terminal'}
+          </Text>
         </View>
         <View style={styles.headerActions}>
+          <TouchableOpacity
+            style={styles.headerButton}
+            onPress={pageUp}
+            disabled={scrollback >= screen.history}
+          >
+            <MaterialCommunityIcons
+              name="chevron-double-up"
+              size={18}
+              color={ColorTokens.text.muted}
+            />
+          </TouchableOpacity>
+          <TouchableOpacity
+            style={styles.headerButton}
+            onPress={pageDown}
+            disabled={scrollback === 0}
+          >
+            <MaterialCommunityIcons
+              name="chevron-double-down"
+              size={18}
+              color={ColorTokens.text.muted}
+            />
+          </TouchableOpacity>
           <TouchableOpacity
             style={styles.headerButton}
             onPress={clearTerminal}
@@ -179,16 +269,34 @@ const Terminal = ({
         </View>
       </View>
 
-      <View style={styles.webviewContainer}>
-        <WebView
-          ref={webViewRef}
-          source={{ html: terminalHTML }}
-          style={styles.webview}
-          onMessage={handleMessage}
-          javaScriptEnabled={true}
-          onLoad={() => setIsConnected(true)}
-          onError={() => setIsConnected(false)}
-        />
+      <View
+        style={styles.screen}
+        onLayout={(event) => setArea(event.nativeEvent.layout)}
+      >
+        <Text
+          style={[styles.row, styles.measure]}
+          onLayout={(event) => setCharWidth(event.nativeEvent.layout.width / 10)}
+        >
+          MMMMMMMMMM
+        </Text>
+        {scrolledLines
+          ? scrolledLines.map((runs, i) => <TerminalRow key={`s${i}`} runs={runs} />)
+          : screen.ids.map((id) => (
+            <TerminalRow key={id} runs={runsRef.current.get(id) || EMPTY_RUNS} />
+          ))}
+        {!scrolledLines && cursorVisible && (
+          <View
+            pointerEvents="none"
+            style={[
+              styles.cursor,
+              {
+                left: PADDING + cursorCol * charWidth,
+                top: PADDING + cursorRow * LINE_HEIGHT,
+                width: charWidth,
+              },
+            ]}
+          />
+        )}
       </View>
 
       <View style={styles.inputRow}>
@@ -234,6 +342,7 @@ const styles = StyleSheet.create({
     borderBottomColor: '#333',
   },
   titleRow: {
+    flex: 1,
     flexDirection: 'row',
     alignItems: 'center',
   },
@@ -250,12 +359,28 @@ const styles = StyleSheet.create({
   headerButton: {
     padding: SpaceTokens.xs,
   },
-  webviewContainer: {
+  screen: {
     flex: 1,
+    padding: PADDING,
+    backgroundColor: DEFAULT_BG,
+    overflow: 'hidden',
   },
-  webview: {
-    flex: 1,
-    backgroundColor: '#1E1E1E',
+  row: {
+    height: LINE_HEIGHT,
+    fontSize: FONT_SIZE,
+    lineHeight: LINE_HEIGHT,
+    fontFamily: 'monospace',
+    color: DEFAULT_FG,
+  },
+  measure: {
+    position: 'absolute',
+    opacity: 0,
+  },
+  cursor: {
+    position: 'absolute',
+    height: LINE_HEIGHT,
+    backgroundColor: ColorTokens.accent.mauve,
+    opacity: 0.7,
   },
   inputRow: {
     flexDirection: 'row',
@@ -0,0 +1,49 @@
+/**
+ * Settings Load Benchmark
+ * Development only: nothing in the app imports this module, so it stays
+ * out of the release bundle. Run it from the debugger console:
+ *
+ *   require('./src/dev/settingsBench').benchmarkSettingsLoad().then(console.log)
+ */
+
+import AsyncStorage from '@react-native-async-storage/async-storage';
+import { STORAGE_KEYS } from '../utils/constants';
+import StorageService, { SETTINGS_KEYS } from '../services/StorageService';
+
+const median = (times) => {
+  const sorted = [...times].sort((a, b) => a - b);
+  return sorted[Math.floor(sorted.length / 2)];
+};
+
+/**
+ * Time the startup settings read both ways: the AsyncStorage reads the
+ * stores used to make (seven in parallel, then four one after another)
+ * against StorageService.getSettingsSync(). AsyncStorage still holds its
+ * pre-migration copy, so both read real data.
+ * @param {number} runs - Runs per backend
+ * @returns {Promise<Object>} { asyncStorageMs, nativeMs } medians, nativeMs
+ *   null without the native store
+ */
+export const benchmarkSettingsLoad = async (runs = 20) => {
+  const asyncTimes = [];
+  for (let i = 0; i < runs; i++) {
+    const started = performance.now();
+    await Promise.all(SETTINGS_KEYS.map((key) => AsyncStorage.getItem(key)));
+    await AsyncStorage.getItem(STORAGE_KEYS.MOCK_MODE);
+    await AsyncStorage.getItem(STORAGE_KEYS.DOCKER_URL);
+    await AsyncStorage.getItem(STORAGE_KEYS.VM_RAM);
+    await AsyncStorage.getItem(STORAGE_KEYS.VM_CPU);
+    asyncTimes.push(performance.now() - started);
+  }
+  let nativeMs = null;
+  if (await StorageService.ready()) {
+    const nativeTimes = [];
+    for (let i = 0; i < runs; i++) {
+      const started = performance.now();
+      StorageService.getSettingsSync();
+      nativeTimes.push(performance.now() - started);
+    }
+    nativeMs = median(nativeTimes);
+  }
+  return { asyncStorageMs: median(asyncTimes), nativeMs };
+};
@@ -23,6 +23,7 @@ import {
   ShadowTokens,
 } from '../theme';
 import { useDockerStore } from '../store/useDockerStore';
+import { useLiveContainerStats } from '../services/StatsChannel';
 import {
   StatusBadge,
   ActionButton,
@@ -54,6 +55,8 @@ const ContainerDetailScreen = () => {
   const { containerId, containerName } = route.params;
   
   const [activeTab, setActiveTab] = useState('info');
+  // Live slot from the shared stats block while the Stats tab is open
+  const liveStats = useLiveContainerStats(containerId, activeTab === 'stats');
   
   const {
     selectedContainer,
@@ -163,9 +166,16 @@ const ContainerDetailScreen = () => {
   const logs = containerLogs[containerId] || '';
   const ports = parsePortMappings(selectedContainer.NetworkSettings?.Ports || {});
 
-  const cpuPercent = stats ? calculateCpuPercent(stats) : 0;
-  const memPercent = stats ? calculateMemoryPercent(stats) : 0;
-  const memUsage = stats?.memory_stats?.usage || 0;
+  let cpuPercent = stats ? calculateCpuPercent(stats) : 0;
+  let memPercent = stats ? calculateMemoryPercent(stats) : 0;
+  let memUsage = stats?.memory_stats?.usage || 0;
+  if (liveStats) {
+    cpuPercent = liveStats.cpuPercent.toFixed(2);
+    memPercent = liveStats.memoryLimit > 0
+      ? ((liveStats.memoryBytes / liveStats.memoryLimit) * 100).toFixed(2)
+      : 0;
+    memUsage = liveStats.memoryBytes;
+  }
 
   const tabs = [
     { key: 'info', label: 'Info' },
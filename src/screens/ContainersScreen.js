@@ -3,7 +3,7 @@
  * List all Docker containers with actions
  */
 
-import React, { useEffect, useCallback, useState } from 'react';
+import React, { useEffect, useCallback, useState, memo } from 'react';
 import {
   View,
   Text,
@@ -22,7 +22,12 @@ import {
   RadiusTokens,
   FontTokens,
 } from '../theme';
-import { useDockerStore } from '../store/useDockerStore';
+import {
+  useDockerStore,
+  useContainer,
+  useContainerIds,
+  useContainerCounts,
+} from '../store/useDockerStore';
 import { useSettingsStore } from '../store/useSettingsStore';
 import {
   ContainerCard,
@@ -43,24 +48,48 @@ const FilterChip = ({ label, active, onPress }) => (
   </TouchableOpacity>
 );
 
+/**
+ * One list row. Subscribes to its own container, so a change to another
+ * container does not re-render it.
+ */
+const ContainerRow = memo(({ id, onOpen, onStart, onStop, onRestart, onToggleFavorite }) => {
+  const container = useContainer(id);
+  const favorite = useSettingsStore((state) => state.favoriteContainers.includes(id));
+
+  if (!container) {
+    return null;
+  }
+  return (
+    <ContainerCard
+      container={container}
+      onPress={() => onOpen(container)}
+      onStart={() => onStart(container)}
+      onStop={() => onStop(container)}
+      onRestart={() => onRestart(container)}
+      isFavorite={favorite}
+      onToggleFavorite={() => onToggleFavorite(container)}
+    />
+  );
+});
+
 const ContainersScreen = () => {
   const navigation = useNavigation();
   const [filter, setFilter] = useState('all');
   
-  const {
-    containers,
-    isLoading,
-    isRefreshing,
-    error,
-    fetchContainers,
-    refreshContainers,
-    startContainer,
-    stopContainer,
-    restartContainer,
-    removeContainer,
-  } = useDockerStore();
+  // Narrow selectors: the screen re-renders when the visible IDs or the
+  // counts change, not when one container does
+  const containerIds = useContainerIds(filter);
+  const { total, running: runningCount, stopped: stoppedCount } = useContainerCounts();
+  const isLoading = useDockerStore((state) => state.isLoading);
+  const isRefreshing = useDockerStore((state) => state.isRefreshing);
+  const fetchContainers = useDockerStore((state) => state.fetchContainers);
+  const refreshContainers = useDockerStore((state) => state.refreshContainers);
+  const startContainer = useDockerStore((state) => state.startContainer);
+  const stopContainer = useDockerStore((state) => state.stopContainer);
+  const restartContainer = useDockerStore((state) => state.restartContainer);
+  const removeContainer = useDockerStore((state) => state.removeContainer);
 
-  const { isFavorite, toggleFavorite } = useSettingsStore();
+  const toggleFavorite = useSettingsStore((state) => state.toggleFavorite);
 
   useEffect(() => {
     fetchContainers();
@@ -70,35 +99,40 @@ const ContainersScreen = () => {
     await refreshContainers();
   }, []);
 
-  const filteredContainers = containers.filter(c => {
-    if (filter === 'running') return c.State === 'running';
-    if (filter === 'stopped') return c.State !== 'running';
-    return true;
-  });
+  const handleOpen = useCallback((container) => {
+    navigation.navigate(ROUTES.CONTAINER_DETAIL, {
+      containerId: container.Id,
+      containerName: container.Names[0].replace('/', ''),
+    });
+  }, [navigation]);
 
-  const handleStart = async (container) => {
+  const handleStart = useCallback(async (container) => {
     try {
       await startContainer(container.Id);
     } catch (error) {
       Alert.alert('Error', error.message);
     }
-  };
+  }, [startContainer]);
 
-  const handleStop = async (container) => {
+  const handleStop = useCallback(async (container) => {
     try {
       await stopContainer(container.Id);
     } catch (error) {
       Alert.alert('Error', error.message);
     }
-  };
+  }, [stopContainer]);
 
-  const handleRestart = async (container) => {
+  const handleRestart = useCallback(async (container) => {
     try {
       await restartContainer(container.Id);
     } catch (error) {
       Alert.alert('Error', error.message);
     }
-  };
+  }, [restartContainer]);
+
+  const handleToggleFavorite = useCallback((container) => {
+    toggleFavorite(container.Id);
+  }, [toggleFavorite]);
 
   const handleRemove = (container) => {
     Alert.alert(
@@ -121,25 +155,18 @@ const ContainersScreen = () => {
     );
   };
 
-  const renderContainer = ({ item }) => (
-    <ContainerCard
-      container={item}
-      onPress={() => navigation.navigate(ROUTES.CONTAINER_DETAIL, { 
-        containerId: item.Id,
-        containerName: item.Names[0].replace('/', ''),
-      })}
-      onStart={() => handleStart(item)}
-      onStop={() => handleStop(item)}
-      onRestart={() => handleRestart(item)}
-      isFavorite={isFavorite(item.Id)}
-      onToggleFavorite={() => toggleFavorite(item.Id)}
+  const renderContainer = useCallback(({ item }) => (
+    <ContainerRow
+      id={item}
+      onOpen={handleOpen}
+      onStart={handleStart}
+      onStop={handleStop}
+      onRestart={handleRestart}
+      onToggleFavorite={handleToggleFavorite}
     />
-  );
-
-  const runningCount = containers.filter(c => c.State === 'running').length;
-  const stoppedCount = containers.length - runningCount;
+  ), [handleOpen, handleStart, handleStop, handleRestart, handleToggleFavorite]);
 
-  if (isLoading && containers.length === 0) {
+  if (isLoading && total === 0) {
     return <LoadingSpinner fullScreen message="Loading containers..." />;
   }
 
@@ -148,7 +175,7 @@ const ContainersScreen = () => {
       <View style={styles.header}>
         <View style={styles.filters}>
           <FilterChip
-            label={`All (${containers.length})`}
+            label={`All (${total})`}
             active={filter === 'all'}
             onPress={() => setFilter('all')}
           />
@@ -176,8 +203,8 @@ const ContainersScreen = () => {
       </View>
 
       <FlatList
-        data={filteredContainers}
-        keyExtractor={(item) => item.Id}
+        data={containerIds}
+        keyExtractor={(item) => item}
         renderItem={renderContainer}
         contentContainerStyle={styles.list}
         refreshControl={
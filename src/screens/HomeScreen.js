@@ -24,6 +24,7 @@ import {
 } from '../theme';
 import { useDockerStore } from '../store/useDockerStore';
 import { useQemuStore } from '../store/useQemuStore';
+import { useLiveStats } from '../services/StatsChannel';
 import { StatusBadge, ActionButton, LoadingSpinner } from '../components';
 import { ROUTES, VM_STATUS } from '../utils/constants';
 import { formatUptime, formatBytes } from '../utils/helpers';
@@ -98,6 +99,10 @@ const HomeScreen = () => {
   const stoppedContainers = containers.length - runningContainers;
   const isVmRunning = vmStatus === VM_STATUS.RUNNING;
   const isBusy = isVmBusy();
+  // Per-frame stats when the JSI bindings are there, else the store's poll
+  const liveStats = useLiveStats(isVmRunning);
+  const cpuUsage = liveStats ? liveStats.cpuUsage : vmStats.cpuUsage;
+  const memoryUsage = liveStats ? liveStats.memoryUsage : vmStats.memoryUsage;
 
   const handleVmToggle = async () => {
     try {
@@ -164,14 +169,14 @@ const HomeScreen = () => {
               <View style={styles.vmStatItem}>
                 <Text style={styles.vmStatLabel}>CPU</Text>
                 <Text style={styles.vmStatValue}>
-                  {vmStats.cpuUsage.toFixed(1)}%
+                  {cpuUsage.toFixed(1)}%
                 </Text>
               </View>
               <View style={styles.vmStatDivider} />
               <View style={styles.vmStatItem}>
                 <Text style={styles.vmStatLabel}>Memory</Text>
                 <Text style={styles.vmStatValue}>
-                  {vmStats.memoryUsage.toFixed(1)}%
+                  {memoryUsage.toFixed(1)}%
                 </Text>
               </View>
             </View>
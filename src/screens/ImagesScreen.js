@@ -3,7 +3,7 @@
  * List all Docker images
  */
 
-import React, { useEffect, useCallback } from 'react';
+import React, { useEffect, useCallback, memo } from 'react';
 import {
   View,
   StyleSheet,
@@ -16,21 +16,38 @@ import { SafeAreaView } from 'react-native-safe-area-context';
 import { MaterialCommunityIcons } from '@expo/vector-icons';
 import { useNavigation } from '@react-navigation/native';
 import { ColorTokens, SpaceTokens, RadiusTokens } from '../theme';
-import { useDockerStore } from '../store/useDockerStore';
+import { useDockerStore, useImage, useImageIds } from '../store/useDockerStore';
 import { ImageCard, LoadingSpinner, EmptyState } from '../components';
 import { ROUTES } from '../utils/constants';
 
+/**
+ * One list row, subscribed to its own image
+ */
+const ImageRow = memo(({ id, onOpen, onDelete, onCreateContainer }) => {
+  const image = useImage(id);
+
+  if (!image) {
+    return null;
+  }
+  return (
+    <ImageCard
+      image={image}
+      onPress={() => onOpen(image)}
+      onDelete={() => onDelete(image)}
+      onCreateContainer={() => onCreateContainer(image)}
+    />
+  );
+});
+
 const ImagesScreen = () => {
   const navigation = useNavigation();
   
-  const {
-    images,
-    isLoading,
-    isRefreshing,
-    fetchImages,
-    refreshImages,
-    removeImage,
-  } = useDockerStore();
+  const imageIds = useImageIds();
+  const isLoading = useDockerStore((state) => state.isLoading);
+  const isRefreshing = useDockerStore((state) => state.isRefreshing);
+  const fetchImages = useDockerStore((state) => state.fetchImages);
+  const refreshImages = useDockerStore((state) => state.refreshImages);
+  const removeImage = useDockerStore((state) => state.removeImage);
 
   useEffect(() => {
     fetchImages();
@@ -40,7 +57,13 @@ const ImagesScreen = () => {
     await refreshImages();
   }, []);
 
-  const handleDelete = (image) => {
+  const handleOpen = useCallback((image) => {
+    navigation.navigate(ROUTES.IMAGE_DETAIL, {
+      imageId: image.Id,
+    });
+  }, [navigation]);
+
+  const handleDelete = useCallback((image) => {
     const imageName = image.RepoTags?.[0] || 'Unknown';
     const hasContainers = (image.Containers || 0) > 0;
     
@@ -71,26 +94,24 @@ const ImagesScreen = () => {
         },
       ]
     );
-  };
+  }, [removeImage]);
 
-  const handleCreateContainer = (image) => {
+  const handleCreateContainer = useCallback((image) => {
     navigation.navigate(ROUTES.CREATE_CONTAINER, {
       selectedImage: image.RepoTags?.[0] || image.Id,
     });
-  };
+  }, [navigation]);
 
-  const renderImage = ({ item }) => (
-    <ImageCard
-      image={item}
-      onPress={() => navigation.navigate(ROUTES.IMAGE_DETAIL, {
-        imageId: item.Id,
-      })}
-      onDelete={() => handleDelete(item)}
-      onCreateContainer={() => handleCreateContainer(item)}
+  const renderImage = useCallback(({ item }) => (
+    <ImageRow
+      id={item}
+      onOpen={handleOpen}
+      onDelete={handleDelete}
+      onCreateContainer={handleCreateContainer}
     />
-  );
+  ), [handleOpen, handleDelete, handleCreateContainer]);
 
-  if (isLoading && images.length === 0) {
+  if (isLoading && imageIds.length === 0) {
     return <LoadingSpinner fullScreen message="Loading images..." />;
   }
 
@@ -110,8 +131,8 @@ const ImagesScreen = () => {
       </View>
 
       <FlatList
-        data={images}
-        keyExtractor={(item) => item.Id}
+        data={imageIds}
+        keyExtractor={(item) => item}
         renderItem={renderImage}
         contentContainerStyle={styles.list}
         refreshControl={
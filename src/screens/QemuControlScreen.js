@@ -20,7 +20,7 @@ import {
 } from '../theme';
 import { useQemuStore } from '../store/useQemuStore';
 import { StatusBadge, ActionButton, LogViewer } from '../components';
-import { formatUptime } from '../utils/helpers';
+import { formatBytes, formatUptime } from '../utils/helpers';
 import { VM_STATUS } from '../utils/constants';
 
 const StatBox = ({ icon, label, value, color }) => (
@@ -113,8 +113,8 @@ const QemuControlScreen = () => {
         {isRunning && (
           <View style={styles.statsRow}>
             <StatBox
-              icon="clock-outline"
-              label="Uptime"
+              icon={vmStats.suspended ? 'pause-circle-outline' : 'clock-outline'}
+              label={vmStats.suspended ? 'Suspended' : 'Uptime'}
               value={formatUptime(vmStats.uptime)}
               color={ColorTokens.accent.mauve}
             />
@@ -133,6 +133,102 @@ const QemuControlScreen = () => {
           </View>
         )}
 
+        {/* TCG translation cache: steadily rising flushes mean tb-size is too small */}
+        {isRunning && vmStats.jit && vmStats.jit.codeSizeBytes > 0 && (
+          <View style={styles.statsRow}>
+            <StatBox
+              icon="database-outline"
+              label="JIT Cache"
+              value={`${formatBytes(vmStats.jit.codeUsedBytes, 0)} / ${formatBytes(vmStats.jit.codeSizeBytes, 0)}`}
+              color={ColorTokens.accent.mint}
+            />
+            <StatBox
+              icon="refresh"
+              label="TB Flushes"
+              value={vmStats.jit.tbFlushesPerMin >= 0
+                ? `${vmStats.jit.tbFlushes} (${vmStats.jit.tbFlushesPerMin.toFixed(1)}/min)`
+                : `${vmStats.jit.tbFlushes}`}
+              color={ColorTokens.accent.mauve}
+            />
+          </View>
+        )}
+
+        {/* Balloon: memory handed back to Android under pressure */}
+        {isRunning && vmStats.balloon && (
+          <View style={styles.statsRow}>
+            <StatBox
+              icon="arrow-collapse-vertical"
+              label="Balloon"
+              value={`${vmStats.balloon.sizeMB} MB (${vmStats.balloon.pressure})`}
+              color={ColorTokens.accent.olive}
+            />
+            <StatBox
+              icon="memory"
+              label="Guest RAM"
+              value={`${vmStats.balloon.actualMB} / ${vmStats.balloon.ramMB} MB`}
+              color={ColorTokens.accent.terracotta}
+            />
+          </View>
+        )}
+
+        {/* Battery/thermal governor: where the vCPUs run and why */}
+        {isRunning && vmStats.power && (
+          <View style={styles.statsRow}>
+            <StatBox
+              icon="speedometer"
+              label={`Speed (${vmStats.power.policy})`}
+              value={`${vmStats.power.tier}, ${vmStats.power.cores} cores`}
+              color={ColorTokens.accent.olive}
+            />
+            <StatBox
+              icon="thermometer"
+              label="Device"
+              value={`${vmStats.power.tempC >= 0 ? `${vmStats.power.tempC.toFixed(0)}°C, ` : ''}${vmStats.power.batteryPct}%${vmStats.power.charging ? ' ⚡' : ''}`}
+              color={ColorTokens.accent.terracotta}
+            />
+          </View>
+        )}
+
+        {/* Socket activation: connections held while the VM boots on demand */}
+        {isRunning && vmStats.activation && vmStats.activation.activations > 0 && (
+          <View style={styles.statsRow}>
+            <StatBox
+              icon="timer-sand"
+              label="Waiting"
+              value={`${vmStats.activation.waiting}`}
+              color={ColorTokens.accent.mint}
+            />
+            <StatBox
+              icon="lightning-bolt-outline"
+              label="Last Wake"
+              value={`${(vmStats.activation.lastWaitMs / 1000).toFixed(1)}s`}
+              color={ColorTokens.accent.mauve}
+            />
+          </View>
+        )}
+
+        {/* Crash supervisor: a dead QEMU comes back after a backoff */}
+        {isRunning && vmStats.supervisor && vmStats.supervisor.restarts > 0 && (
+          <View style={styles.statsRow}>
+            <StatBox
+              icon={vmStats.supervisor.state === 'restarting' ? 'restart-alert' : 'lifebuoy'}
+              label={vmStats.supervisor.state === 'restarting' ? 'Restarting' : 'Restarts'}
+              value={`${vmStats.supervisor.restarts}`}
+              color={ColorTokens.accent.terracotta}
+            />
+            {vmStats.supervisor.lastCrash && (
+              <StatBox
+                icon="alert-octagon-outline"
+                label="Last Crash"
+                value={vmStats.supervisor.lastCrash.signal > 0
+                  ? `signal ${vmStats.supervisor.lastCrash.signal}`
+                  : `exit ${vmStats.supervisor.lastCrash.exitCode}`}
+                color={ColorTokens.accent.mauve}
+              />
+            )}
+          </View>
+        )}
+
         {/* Controls */}
         <View style={styles.controls}>
           {isRunning ? (
@@ -16,6 +16,7 @@ const TerminalScreen = () => {
   
   const { sendCommand, addLog } = useQemuStore();
 
+  // Returns the output for the terminal to show
   const handleCommand = async (command) => {
     try {
       if (containerId) {
@@ -24,12 +25,14 @@ const TerminalScreen = () => {
         // In real implementation, this would use docker exec
         await new Promise(resolve => setTimeout(resolve, 500));
         addLog('Command executed successfully');
-      } else {
-        // Execute command in VM
-        await sendCommand(command);
+        return 'Command executed successfully';
       }
+      // Execute command in VM
+      const result = await sendCommand(command);
+      return result?.output || '';
     } catch (error) {
       addLog(`Error: ${error.message}`);
+      throw error;
     }
   };
 
@@ -0,0 +1,144 @@
+/**
+ * Log Index
+ * Line-indexed log buffers for LogViewer. With the JSI bindings the text
+ * and its line offsets live in native files (android/app/src/main/jni/
+ * log_index.h), so JS holds no copy of the log: it appends new text and
+ * asks for the window of lines on screen, with search matches as spans.
+ * Without them (iOS, remote debugger, tests) a JS array of lines does the
+ * same job behind the same interface.
+ */
+
+import QemuService from './QemuService';
+
+// Longest line handed to a row, like LOG_LINE_MAX_BYTES in qemu_jsi.cpp
+const LINE_MAX_CHARS = 4096;
+
+/**
+ * Index backed by global.__QemuNative.log*
+ */
+class NativeLogIndex {
+  constructor(jsi, handle) {
+    this.jsi = jsi;
+    this.handle = handle;
+  }
+
+  append(text) {
+    return this.jsi.logAppend(this.handle, text);
+  }
+
+  lineCount() {
+    return this.jsi.logLineCount(this.handle);
+  }
+
+  window(first, count, query = '') {
+    return this.jsi.logWindow(this.handle, first, count, query);
+  }
+
+  find(query, from, backwards = false) {
+    return this.jsi.logFind(this.handle, query, from, backwards);
+  }
+
+  clear() {
+    this.jsi.logClear(this.handle);
+  }
+
+  close() {
+    this.jsi.logClose(this.handle);
+  }
+}
+
+/**
+ * Index over a JS array of lines
+ */
+class MemoryLogIndex {
+  constructor() {
+    this.lines = [];
+    // The last line is still open until a '\n' ends it
+    this.open = false;
+  }
+
+  append(text) {
+    if (!text) return this.lines.length;
+    const parts = text.split('\n');
+    let start = 0;
+    if (this.open) {
+      this.lines[this.lines.length - 1] += parts[0];
+      start = 1;
+    }
+    for (let i = start; i < parts.length; i++) {
+      this.lines.push(parts[i]);
+    }
+    // A trailing '\n' leaves an empty part that is not a line yet
+    this.open = parts[parts.length - 1] !== '';
+    if (!this.open) {
+      this.lines.pop();
+    }
+    return this.lines.length;
+  }
+
+  lineCount() {
+    return this.lines.length;
+  }
+
+  window(first, count, query = '') {
+    const needle = query.toLowerCase();
+    const lines = [];
+    const spans = [];
+    const end = Math.min(first + count, this.lines.length);
+    for (let i = first; i < end; i++) {
+      let line = this.lines[i].substring(0, LINE_MAX_CHARS);
+      if (line.endsWith('\r')) line = line.substring(0, line.length - 1);
+      lines.push(line);
+      if (needle) {
+        const lower = line.toLowerCase();
+        let at = lower.indexOf(needle);
+        while (at >= 0) {
+          spans.push(i - first, at, needle.length);
+          at = lower.indexOf(needle, at + needle.length);
+        }
+      }
+    }
+    return { first, lines, spans };
+  }
+
+  find(query, from, backwards = false) {
+    const needle = query.toLowerCase();
+    if (!needle) return -1;
+    if (backwards) {
+      for (let i = Math.min(from, this.lines.length) - 1; i >= 0; i--) {
+        if (this.lines[i].toLowerCase().includes(needle)) return i;
+      }
+    } else {
+      for (let i = Math.max(from, 0); i < this.lines.length; i++) {
+        if (this.lines[i].toLowerCase().includes(needle)) return i;
+      }
+    }
+    return -1;
+  }
+
+  clear() {
+    this.lines = [];
+    this.open = false;
+  }
+
+  close() {
+    this.clear();
+  }
+}
+
+/**
+ * A new, empty log index; close() it when done
+ * @returns {NativeLogIndex|MemoryLogIndex}
+ */
+export const createLogIndex = () => {
+  const jsi = QemuService.jsi;
+  if (jsi && jsi.logOpen) {
+    const handle = jsi.logOpen();
+    if (handle > 0) {
+      return new NativeLogIndex(jsi, handle);
+    }
+  }
+  return new MemoryLogIndex();
+};
+
+export default createLogIndex;
@@ -17,8 +17,10 @@ const MockQemuModule = {
     return {
       success: true,
       qemuDir: '/data/data/com.dockerandroid/files/qemu',
-      isoPath: '/data/data/com.dockerandroid/files/qemu/alpine-virt.iso',
-      diskPath: '/data/data/com.dockerandroid/files/qemu/alpine-disk.qcow2',
+      isoPath: null,
+      provisioned: true,
+      kernelBoot: true,
+      diskPath: '/data/data/com.dockerandroid/files/qemu/overlays/default.qcow2',
     };
   },
   startVM: async (ramMB, cpuCores) => {
@@ -29,17 +31,147 @@ const MockQemuModule = {
     await new Promise(resolve => setTimeout(resolve, 500));
     return { success: true };
   },
+  listenVM: async (ramMB, cpuCores) => {
+    return { success: true, port: 2375 };
+  },
+  setPowerPolicy: async (policy) => {
+    return { success: true, policy };
+  },
   getStatus: async () => {
     return {
       status: 'running',
       uptime: 3600,
       cpuUsage: 15.5,
       memoryUsage: 45.2,
+      suspended: false,
+      jit: {
+        codeUsedBytes: 48 * 1024 * 1024,
+        codeSizeBytes: 256 * 1024 * 1024,
+        tbCount: 120000,
+        tbFlushes: 0,
+        tbFlushesPerMin: 0,
+        tbInvalidations: 3500,
+        tlbFullFlushes: 900,
+        sampledAt: Date.now(),
+      },
+      balloon: {
+        ramMB: 2048,
+        actualMB: 1536,
+        sizeMB: 512,
+        targetMB: 1536,
+        floorMB: 896,
+        workingSetMB: 640,
+        pressure: 'moderate',
+        updatedAt: Date.now(),
+      },
+      power: {
+        policy: 'balanced',
+        tier: 'reduced',
+        reason: 'on battery, screen off',
+        cores: 4,
+        tempC: 38.5,
+        thermal: 'normal',
+        charging: false,
+        batteryPct: 64,
+        screenOn: false,
+        changedAt: Date.now(),
+        changes: 3,
+      },
+      health: {
+        processAlive: true,
+        runState: 'running',
+        qmpResponsive: true,
+        qmpLatencyMs: 0.4,
+        qmpCheckedAt: Date.now(),
+        qmpFailures: 0,
+        dockerResponsive: true,
+        dockerLatencyMs: 2.1,
+        dockerCheckedAt: Date.now(),
+        dockerFailures: 0,
+      },
+      activation: {
+        listening: true,
+        waiting: 0,
+        activations: 1,
+        lastWaitMs: 14200,
+        maxWaitMs: 14200,
+      },
+      supervisor: {
+        state: 'running',
+        restarts: 0,
+        recentCrashes: 0,
+        nextRestartAt: 0,
+      },
     };
   },
+  installJsi: () => false,
   sendCommand: async (command) => {
     return { output: `Executed: ${command}` };
   },
+  listOverlays: async () => {
+    return [
+      { name: 'default', path: '/data/data/com.dockerandroid/files/qemu/overlays/default.qcow2', size: 262144, modified: Date.now() },
+    ];
+  },
+  createOverlay: async (name) => {
+    return { success: true, path: `/data/data/com.dockerandroid/files/qemu/overlays/${name}.qcow2` };
+  },
+  resetOverlay: async () => {
+    return { success: true };
+  },
+  cloneOverlay: async (source, name) => {
+    return { success: true, path: `/data/data/com.dockerandroid/files/qemu/overlays/${name}.qcow2` };
+  },
+  deleteOverlay: async () => {
+    return { success: true };
+  },
+  commitOverlay: async () => {
+    await new Promise(resolve => setTimeout(resolve, 1000));
+    return { success: true, overlayBytes: 0, baseBytes: 0 };
+  },
+  trimDisk: async () => {
+    return { success: true, trimmedBytes: 0 };
+  },
+  compactOverlay: async () => {
+    await new Promise(resolve => setTimeout(resolve, 1000));
+    return { success: true, bytesBefore: 0, bytesAfter: 0, reclaimedBytes: 0 };
+  },
+  verifyDisk: async () => {
+    await new Promise(resolve => setTimeout(resolve, 1000));
+    return { isoOk: true, baseOk: true };
+  },
+  benchmarkHash: async () => {
+    return { file: 'alpine-base.qcow2', sizeBytes: 0, md5MBps: 0, treeHashMBps: 0 };
+  },
+  getCrashRecords: async () => {
+    return [];
+  },
+  getBootTimings: async () => {
+    return {
+      mode: 'kernel',
+      startedAt: Date.now(),
+      qemuMs: 300,
+      firmwareMs: 400,
+      kernelMs: 2500,
+      userspaceMs: 6000,
+      guestMs: 8500,
+      dockerMs: 4000,
+      totalMs: 13200,
+    };
+  },
+};
+
+const now = () => (global.performance && global.performance.now ? global.performance.now() : Date.now());
+
+const summarizeTimings = (times) => {
+  const sorted = [...times].sort((a, b) => a - b);
+  const pick = (q) => sorted[Math.min(sorted.length - 1, Math.floor(q * sorted.length))];
+  return {
+    avgMs: sorted.reduce((sum, t) => sum + t, 0) / sorted.length,
+    p50Ms: pick(0.5),
+    p95Ms: pick(0.95),
+    maxMs: sorted[sorted.length - 1],
+  };
 };
 
 class QemuServiceClass {
@@ -47,6 +179,25 @@ class QemuServiceClass {
     this.listeners = [];
     this.isNativeAvailable = Platform.OS === 'android' && QemuModule !== null;
     this.module = this.isNativeAvailable ? QemuModule : MockQemuModule;
+    this.jsi = this.isNativeAvailable ? this.installJsi() : null;
+  }
+
+  /**
+   * Install the JSI bindings (global.__QemuNative). Synchronous native
+   * calls do not work under the remote JS debugger, so this falls back to
+   * the bridge there.
+   * @returns {Object|null} The bindings, or null
+   */
+  installJsi() {
+    try {
+      if (!global.__QemuNative && !this.module.installJsi()) {
+        return null;
+      }
+      return global.__QemuNative || null;
+    } catch (error) {
+      console.warn('QEMU JSI bindings unavailable:', error.message);
+      return null;
+    }
   }
 
   /**
@@ -59,7 +210,7 @@ class QemuServiceClass {
 
   /**
    * Initialize QEMU environment
-   * Copies Alpine ISO and creates disk image
+   * Copies Alpine ISO and sets up the base disk image and default overlay
    * @returns {Promise<Object>}
    */
   async initialize() {
@@ -90,6 +241,39 @@ class QemuServiceClass {
     }
   }
 
+  /**
+   * Listen on the Docker API port (2375) while the VM is down. The first
+   * connection boots the VM and is held until Docker answers, so clients
+   * need no separate start step. stopVM() stops a running VM first; a
+   * second stopVM() ends listening.
+   * @param {number} ramMB - RAM in MB for the on-demand boot
+   * @param {number} cpuCores - CPU cores for the on-demand boot
+   * @returns {Promise<{success: boolean, port: number}>}
+   */
+  async listenVM(ramMB = 2048, cpuCores = 2) {
+    try {
+      return await this.module.listenVM(ramMB, cpuCores);
+    } catch (error) {
+      console.error('VM listen error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Set how the VM trades Docker throughput for battery and heat.
+   * Saved in qemu-config.json and applied to a running VM right away.
+   * @param {'performance'|'balanced'|'saver'} policy
+   * @returns {Promise<{success: boolean, policy: string}>}
+   */
+  async setPowerPolicy(policy) {
+    try {
+      return await this.module.setPowerPolicy(policy);
+    } catch (error) {
+      console.error('Power policy error:', error);
+      throw error;
+    }
+  }
+
   /**
    * Stop the running VM
    * @returns {Promise<Object>}
@@ -106,7 +290,29 @@ class QemuServiceClass {
   }
 
   /**
-   * Get current VM status and stats
+   * Get current VM status and stats.
+   * suspended is true while the idle governor has the VM stopped; the next
+   * Docker API or SSH connection resumes it.
+   * While running, jit holds the TCG translation cache counters from
+   * "info jit", sampled every 30s (codeUsedBytes, codeSizeBytes, tbCount,
+   * tbFlushes, tbFlushesPerMin since the previous sample, tbInvalidations,
+   * tlbFullFlushes, sampledAt); absent until the first sample.
+   * balloon holds the virtio-balloon state once the policy has run
+   * (ramMB, actualMB, sizeMB inflated, targetMB, floorMB, workingSetMB,
+   * pressure: none | moderate | low | critical, updatedAt).
+   * power holds the battery/thermal governor's last decision (policy,
+   * tier: full | reduced | minimal, reason, cores, tempC, thermal,
+   * charging, batteryPct, screenOn, changedAt, changes).
+   * activation holds the socket activation queue while the app listens
+   * (listening, waiting connections, activations, lastWaitMs, maxWaitMs).
+   * supervisor holds the crash supervisor (state: running | restarting |
+   * crash-loop | stopped, restarts, recentCrashes, nextRestartAt and
+   * lastCrash {time, uptimeMs, exitCode, signal, reason, file}); status is
+   * "restarting" while a crashed VM waits out its backoff.
+   * health holds the health monitor's cached probes (processAlive,
+   * runState from QMP query-status, qmpResponsive, dockerResponsive,
+   * their latencies in ms, checkedAt times and consecutive failures);
+   * a probe without an answer yet, or dockerd while paused, is null.
    * @returns {Promise<Object>}
    */
   async getStatus() {
@@ -118,6 +324,64 @@ class QemuServiceClass {
     }
   }
 
+  /**
+   * VM status read synchronously through JSI: the same shape as
+   * getStatus() without jit (which needs QMP), plus pid and generation
+   * (bumped whenever the native status changes). cpuUsage and
+   * memoryUsage come from the native stats sampler (see StatsChannel).
+   * @returns {Object|null} null when the bindings are not installed
+   */
+  getStatusSync() {
+    return this.jsi ? this.jsi.getStatus() : null;
+  }
+
+  /**
+   * Last lines of the serial console, read synchronously through JSI
+   * @param {number} lines - Number of lines
+   * @returns {string|null} null when the bindings are not installed
+   */
+  getLogsSync(lines = 100) {
+    return this.jsi ? this.jsi.getLogs(lines) : null;
+  }
+
+  /**
+   * Time getStatus over the bridge against getStatusSync through JSI.
+   * blocking is how long each call held the JS thread: for the bridge
+   * the synchronous part of the call, for JSI the whole call. latency is
+   * until the result is in hand.
+   * @param {number} iterations - Calls per variant
+   * @returns {Promise<{iterations: number, bridge: Object, jsi: Object|null}>}
+   */
+  async benchmarkStatus(iterations = 50) {
+    const bridgeLatency = [];
+    const bridgeBlocking = [];
+    for (let i = 0; i < iterations; i++) {
+      const start = now();
+      const pending = this.module.getStatus();
+      const returned = now();
+      await pending;
+      bridgeBlocking.push(returned - start);
+      bridgeLatency.push(now() - start);
+    }
+
+    let jsi = null;
+    if (this.jsi) {
+      const times = [];
+      for (let i = 0; i < iterations; i++) {
+        const start = now();
+        this.jsi.getStatus();
+        times.push(now() - start);
+      }
+      jsi = { latency: summarizeTimings(times), blocking: summarizeTimings(times) };
+    }
+
+    return {
+      iterations,
+      bridge: { latency: summarizeTimings(bridgeLatency), blocking: summarizeTimings(bridgeBlocking) },
+      jsi,
+    };
+  }
+
   /**
    * Send a command to the VM console
    * @param {string} command - Command to execute
@@ -132,6 +396,180 @@ class QemuServiceClass {
     }
   }
 
+  /**
+   * List disk overlays (copy-on-write layers over the read-only base image)
+   * @returns {Promise<Array<{name: string, path: string, size: number, modified: number}>>}
+   */
+  async listOverlays() {
+    try {
+      return await this.module.listOverlays();
+    } catch (error) {
+      console.error('List overlays error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Create an empty overlay on top of the base image
+   * @param {string} name - Overlay name ([A-Za-z0-9_-], max 64 chars)
+   * @returns {Promise<Object>}
+   */
+  async createOverlay(name) {
+    try {
+      return await this.module.createOverlay(name);
+    } catch (error) {
+      console.error('Create overlay error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Discard everything written to an overlay (VM must be stopped)
+   * @param {string} name - Overlay name (default 'default')
+   * @returns {Promise<Object>}
+   */
+  async resetOverlay(name = 'default') {
+    try {
+      return await this.module.resetOverlay(name);
+    } catch (error) {
+      console.error('Reset overlay error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Clone an overlay; the copy shares the base image (VM must be stopped)
+   * @param {string} source - Overlay to copy
+   * @param {string} name - New overlay name
+   * @returns {Promise<Object>}
+   */
+  async cloneOverlay(source, name) {
+    try {
+      return await this.module.cloneOverlay(source, name);
+    } catch (error) {
+      console.error('Clone overlay error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Delete an overlay (the default overlay cannot be deleted)
+   * @param {string} name - Overlay name
+   * @returns {Promise<Object>}
+   */
+  async deleteOverlay(name) {
+    try {
+      return await this.module.deleteOverlay(name);
+    } catch (error) {
+      console.error('Delete overlay error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Merge an overlay into the base image and reset it.
+   * Fails while other overlays exist; progress arrives as vmSetupProgress.
+   * @param {string} name - Overlay name (default 'default')
+   * @returns {Promise<Object>}
+   */
+  async commitOverlay(name = 'default') {
+    try {
+      return await this.module.commitOverlay(name);
+    } catch (error) {
+      console.error('Commit overlay error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Run fstrim inside the guest (VM must be running).
+   * Freed blocks are discarded from the overlay; compactOverlay returns
+   * the space to the phone.
+   * @returns {Promise<{success: boolean, trimmedBytes: number}>}
+   */
+  async trimDisk() {
+    try {
+      return await this.module.trimDisk();
+    } catch (error) {
+      console.error('Trim disk error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Rewrite an overlay without its free clusters (VM must be stopped).
+   * Runs at low I/O priority; progress arrives as vmSetupProgress.
+   * @param {string} name - Overlay name (default 'default')
+   * @returns {Promise<{bytesBefore: number, bytesAfter: number, reclaimedBytes: number}>}
+   */
+  async compactOverlay(name = 'default') {
+    try {
+      return await this.module.compactOverlay(name);
+    } catch (error) {
+      console.error('Compact overlay error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Fully verify the ISO and base image against their SHA-256 tree hashes.
+   * A slice of both is also checked in the background on every launch.
+   * @returns {Promise<{isoOk: boolean, baseOk: boolean}>}
+   */
+  async verifyDisk() {
+    try {
+      return await this.module.verifyDisk();
+    } catch (error) {
+      console.error('Verify disk error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Compare single-threaded MD5 with the parallel tree hash on the base image
+   * @returns {Promise<{file: string, sizeBytes: number, md5MBps: number, treeHashMBps: number}>}
+   */
+  async benchmarkHash() {
+    try {
+      return await this.module.benchmarkHash();
+    } catch (error) {
+      console.error('Hash benchmark error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Post-mortems of the last QEMU crashes, newest first: exit code or
+   * signal, reason, the action taken, and the tails of the serial console
+   * and of QEMU's stderr.
+   * @param {number} limit - Maximum number of records
+   * @returns {Promise<Array<Object>>}
+   */
+  async getCrashRecords(limit = 10) {
+    try {
+      return await this.module.getCrashRecords(limit);
+    } catch (error) {
+      console.error('Crash records error:', error);
+      throw error;
+    }
+  }
+
+  /**
+   * Phase breakdown of the last VM boot, or null before the first one.
+   * Phases: qemu (process start), firmware (BIOS and bootloader), kernel,
+   * userspace (initramfs and OpenRC until the guest agent answers), docker.
+   * A phase the guest cannot report is -1.
+   * @returns {Promise<Object|null>}
+   */
+  async getBootTimings() {
+    try {
+      return await this.module.getBootTimings();
+    } catch (error) {
+      console.error('Boot timings error:', error);
+      throw error;
+    }
+  }
+
   /**
    * Restart the VM
    * @returns {Promise<void>}
@@ -144,7 +582,7 @@ class QemuServiceClass {
 
   /**
    * Add event listener for QEMU events
-   * @param {string} eventName - Event name (vmStatus, vmLog, vmError)
+   * @param {string} eventName - Event name (vmStatus, vmLog, vmError, vmSetupProgress, vmDiskCompacted)
    * @param {Function} callback - Callback function
    * @returns {Object} Listener subscription
    */
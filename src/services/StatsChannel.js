@@ -0,0 +1,222 @@
+/**
+ * Stats Channel
+ * Live VM and container stats from the shared stats block
+ * (android/app/src/main/jni/vm_stats.h) without the bridge or JSON.
+ * global.__QemuNative.stats is an ArrayBuffer with the block's fixed
+ * layout; readStats() refreshes it from the live block and returns the
+ * sequence number, which only changes when a sampler wrote something.
+ */
+
+import { useEffect, useState } from 'react';
+import QemuService from './QemuService';
+
+// Layout, version 1; keep in step with vm_stats.h
+const STATS_MAGIC = 0x54534d56;
+const STATS_VERSION = 1;
+const HEADER_WORDS = 8;
+const VM_OFFSET = 32;
+const SLOTS_OFFSET = 144;
+const SLOT_BYTES = 136;
+const ID_LEN = 16;
+const NAME_LEN = 48;
+
+const HEADER = { SEQ: 0, MAGIC: 1, VERSION: 2, SIZE: 3, VM_FIELDS: 4, CONTAINER_FIELDS: 5, SLOTS: 6, COUNT: 7 };
+
+export const VM_STAT = {
+  UPDATED_AT: 0,
+  PID: 1,
+  CPU_PCT: 2,
+  RSS_BYTES: 3,
+  MEM_PCT: 4,
+  IO_READ_BYTES: 5,
+  IO_WRITE_BYTES: 6,
+  IO_READ_BPS: 7,
+  IO_WRITE_BPS: 8,
+  NET_RX_BYTES: 9,
+  NET_TX_BYTES: 10,
+  NET_RX_BPS: 11,
+  NET_TX_BPS: 12,
+  NET_UPDATED_AT: 13,
+};
+
+export const CT_STAT = {
+  CPU_PCT: 0,
+  MEM_BYTES: 1,
+  MEM_LIMIT: 2,
+  NET_RX_BYTES: 3,
+  NET_TX_BYTES: 4,
+  BLK_READ_BYTES: 5,
+  BLK_WRITE_BYTES: 6,
+  PIDS: 7,
+  UPDATED_AT: 8,
+};
+
+const VM_FIELDS = 14;
+const CONTAINER_FIELDS = 9;
+
+/**
+ * Decode a NUL-terminated ASCII field (container ids and names)
+ */
+const readText = (bytes) => {
+  let text = '';
+  for (let i = 0; i < bytes.length && bytes[i] !== 0; i++) {
+    text += String.fromCharCode(bytes[i]);
+  }
+  return text;
+};
+
+/**
+ * Typed-array views over the stats buffer, made once. Reading a field
+ * allocates nothing; snapshot() builds plain objects for React.
+ */
+class StatsReader {
+  constructor(jsi) {
+    this.jsi = jsi;
+    const buffer = jsi.stats;
+    this.header = new Uint32Array(buffer, 0, HEADER_WORDS);
+    this.vm = new Float64Array(buffer, VM_OFFSET, VM_FIELDS);
+    this.slots = [];
+    const slotCount = this.header[HEADER.SLOTS];
+    for (let i = 0; i < slotCount; i++) {
+      const offset = SLOTS_OFFSET + i * SLOT_BYTES;
+      const valueBytes = CONTAINER_FIELDS * 8;
+      this.slots.push({
+        values: new Float64Array(buffer, offset, CONTAINER_FIELDS),
+        id: new Uint8Array(buffer, offset + valueBytes, ID_LEN),
+        name: new Uint8Array(buffer, offset + valueBytes + ID_LEN, NAME_LEN),
+      });
+    }
+  }
+
+  /**
+   * Whether the native block has the layout this file was written for
+   */
+  isCompatible() {
+    return this.header[HEADER.MAGIC] === STATS_MAGIC &&
+      this.header[HEADER.VERSION] === STATS_VERSION &&
+      this.header[HEADER.VM_FIELDS] === VM_FIELDS &&
+      this.header[HEADER.CONTAINER_FIELDS] === CONTAINER_FIELDS;
+  }
+
+  /**
+   * Refresh the views from the live block
+   * @returns {number} Sequence number, 0 if no consistent copy was had
+   */
+  read() {
+    return this.jsi.readStats();
+  }
+
+  /**
+   * Plain-object copy of what the views hold now
+   */
+  snapshot() {
+    const vm = this.vm;
+    const count = Math.min(this.header[HEADER.COUNT], this.slots.length);
+    const containers = [];
+    for (let i = 0; i < count; i++) {
+      const slot = this.slots[i];
+      const values = slot.values;
+      containers.push({
+        id: readText(slot.id),
+        name: readText(slot.name),
+        cpuPercent: values[CT_STAT.CPU_PCT],
+        memoryBytes: values[CT_STAT.MEM_BYTES],
+        memoryLimit: values[CT_STAT.MEM_LIMIT],
+        netRxBytes: values[CT_STAT.NET_RX_BYTES],
+        netTxBytes: values[CT_STAT.NET_TX_BYTES],
+        blockReadBytes: values[CT_STAT.BLK_READ_BYTES],
+        blockWriteBytes: values[CT_STAT.BLK_WRITE_BYTES],
+        pids: values[CT_STAT.PIDS],
+        updatedAt: values[CT_STAT.UPDATED_AT],
+      });
+    }
+    return {
+      seq: this.header[HEADER.SEQ],
+      updatedAt: vm[VM_STAT.UPDATED_AT],
+      pid: vm[VM_STAT.PID],
+      cpuUsage: vm[VM_STAT.CPU_PCT],
+      memoryUsage: vm[VM_STAT.MEM_PCT],
+      rssBytes: vm[VM_STAT.RSS_BYTES],
+      ioReadBytes: vm[VM_STAT.IO_READ_BYTES],
+      ioWriteBytes: vm[VM_STAT.IO_WRITE_BYTES],
+      ioReadBps: vm[VM_STAT.IO_READ_BPS],
+      ioWriteBps: vm[VM_STAT.IO_WRITE_BPS],
+      netRxBytes: vm[VM_STAT.NET_RX_BYTES],
+      netTxBytes: vm[VM_STAT.NET_TX_BYTES],
+      netRxBps: vm[VM_STAT.NET_RX_BPS],
+      netTxBps: vm[VM_STAT.NET_TX_BPS],
+      netUpdatedAt: vm[VM_STAT.NET_UPDATED_AT],
+      containers,
+    };
+  }
+}
+
+let reader;
+
+/**
+ * The shared reader, or null without the JSI bindings (bridge fallback,
+ * iOS, mock mode) or when the native layout differs
+ */
+export const getStatsReader = () => {
+  if (reader !== undefined) {
+    return reader;
+  }
+  reader = null;
+  const jsi = QemuService.jsi;
+  if (jsi && jsi.stats && jsi.readStats) {
+    const candidate = new StatsReader(jsi);
+    if (candidate.isCompatible()) {
+      reader = candidate;
+    } else {
+      console.warn('Stats block layout mismatch; live stats disabled');
+    }
+  }
+  return reader;
+};
+
+/**
+ * Live stats, polled once per frame. readStats() is a memcpy, and the
+ * component re-renders only when the sequence number moved, so an idle
+ * block costs one native call per frame and no renders.
+ * @param {boolean} enabled - Poll only while true (e.g. VM running)
+ * @returns {Object|null} Latest snapshot, or null without live stats
+ */
+export const useLiveStats = (enabled = true) => {
+  const [stats, setStats] = useState(null);
+
+  useEffect(() => {
+    const statsReader = enabled ? getStatsReader() : null;
+    if (!statsReader) {
+      setStats(null);
+      return undefined;
+    }
+    let lastSeq = -1;
+    let frame;
+    const poll = () => {
+      const seq = statsReader.read();
+      if (seq !== 0 && seq !== lastSeq) {
+        lastSeq = seq;
+        setStats(statsReader.snapshot());
+      }
+      frame = requestAnimationFrame(poll);
+    };
+    poll();
+    return () => cancelAnimationFrame(frame);
+  }, [enabled]);
+
+  return stats;
+};
+
+/**
+ * One container's live slot, matched on the 12-character short id
+ * @param {string} containerId - Full or short container id
+ * @returns {Object|null} Slot, or null when not sampled (yet)
+ */
+export const useLiveContainerStats = (containerId, enabled = true) => {
+  const stats = useLiveStats(enabled && !!containerId);
+  if (!stats || !containerId) {
+    return null;
+  }
+  const shortId = containerId.substring(0, 12);
+  return stats.containers.find((c) => c.id === shortId) || null;
+};
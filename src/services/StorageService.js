@@ -1,12 +1,163 @@
 /**
  * Storage Service
- * AsyncStorage wrapper with type-safe operations
+ * Typed key-value storage for app settings. With the JSI bindings values
+ * live in the native settings store (android/app/src/main/jni/kv_store.h):
+ * a memory-mapped log read with plain synchronous calls, so startup can
+ * have every setting before its first render (getSettingsSync). Without
+ * them (iOS, remote debugger) AsyncStorage backs the same methods.
+ *
+ * The first run with the native store copies AsyncStorage into it; until
+ * that has finished, reads go through the asynchronous path.
  */
 
 import AsyncStorage from '@react-native-async-storage/async-storage';
 import { STORAGE_KEYS } from '../utils/constants';
+import QemuService from './QemuService';
+
+// Set in the native store once AsyncStorage has been copied in
+const MIGRATED_KEY = '@kv_migrated';
+
+const DEFAULTS = {
+  dockerUrl: 'http://localhost:2375',
+  mockMode: true,
+  themeMode: 'light',
+  vmRam: 2048,
+  vmCpu: 2,
+  isFirstLaunch: true,
+};
+
+const toBoolean = (value, defaultValue) => (value === null ? defaultValue : value === 'true');
+
+const toNumber = (value, defaultValue) => {
+  if (value === null) return defaultValue;
+  const num = parseFloat(value);
+  return isNaN(num) ? defaultValue : num;
+};
+
+const toObject = (value, defaultValue) => (value === null ? defaultValue : JSON.parse(value));
+
+/**
+ * The app settings from a key lookup returning string or null
+ */
+const readSettings = (read) => {
+  let favoriteContainers = [];
+  try {
+    favoriteContainers = toObject(read(STORAGE_KEYS.FAVORITE_CONTAINERS), []);
+  } catch (error) {
+    console.error('StorageService: bad favorite containers value:', error);
+  }
+  return {
+    dockerUrl: read(STORAGE_KEYS.DOCKER_URL) ?? DEFAULTS.dockerUrl,
+    mockMode: toBoolean(read(STORAGE_KEYS.MOCK_MODE), DEFAULTS.mockMode),
+    themeMode: read(STORAGE_KEYS.THEME_MODE) ?? DEFAULTS.themeMode,
+    vmRam: toNumber(read(STORAGE_KEYS.VM_RAM), DEFAULTS.vmRam),
+    vmCpu: toNumber(read(STORAGE_KEYS.VM_CPU), DEFAULTS.vmCpu),
+    isFirstLaunch: toBoolean(read(STORAGE_KEYS.FIRST_LAUNCH), DEFAULTS.isFirstLaunch),
+    favoriteContainers,
+  };
+};
+
+// Keys behind getSettings(); also read by src/dev/settingsBench.js
+export const SETTINGS_KEYS = [
+  STORAGE_KEYS.DOCKER_URL,
+  STORAGE_KEYS.MOCK_MODE,
+  STORAGE_KEYS.THEME_MODE,
+  STORAGE_KEYS.VM_RAM,
+  STORAGE_KEYS.VM_CPU,
+  STORAGE_KEYS.FIRST_LAUNCH,
+  STORAGE_KEYS.FAVORITE_CONTAINERS,
+];
 
 class StorageService {
+  constructor() {
+    this.readyPromise = null;
+  }
+
+  // ============================================
+  // BACKEND
+  // ============================================
+
+  /**
+   * global.__QemuNative when it has the settings store, else null
+   */
+  get kv() {
+    const jsi = QemuService.jsi;
+    return jsi && jsi.kvGet ? jsi : null;
+  }
+
+  /**
+   * Whether reads can be synchronous: the native store is there and
+   * holds everything AsyncStorage had
+   * @returns {boolean}
+   */
+  isSyncReady() {
+    const kv = this.kv;
+    return kv !== null && kv.kvGet(MIGRATED_KEY) !== undefined;
+  }
+
+  /**
+   * Resolves once the backend is settled
+   * @returns {Promise<boolean>} true for the native store
+   */
+  ready() {
+    if (!this.readyPromise) {
+      this.readyPromise = this.migrate();
+    }
+    return this.readyPromise;
+  }
+
+  /**
+   * Copy AsyncStorage into the native store, once. AsyncStorage keeps its
+   * copy; nothing reads it afterwards.
+   * @returns {Promise<boolean>} true when the native store is in use
+   */
+  async migrate() {
+    const kv = this.kv;
+    if (!kv) return false;
+    if (kv.kvGet(MIGRATED_KEY) !== undefined) return true;
+    try {
+      const keys = await AsyncStorage.getAllKeys();
+      const pairs = await AsyncStorage.multiGet(keys);
+      pairs.forEach(([key, value]) => {
+        if (value !== null) kv.kvSet(key, value);
+      });
+      kv.kvSet(MIGRATED_KEY, String(Date.now()));
+      console.log(`StorageService: copied ${pairs.length} keys into the native store`);
+      return true;
+    } catch (error) {
+      console.error('StorageService migration error:', error);
+      return false;
+    }
+  }
+
+  async getItem(key) {
+    if (await this.ready()) {
+      const value = this.kv.kvGet(key);
+      return value === undefined ? null : value;
+    }
+    return AsyncStorage.getItem(key);
+  }
+
+  async setItem(key, value) {
+    if (await this.ready()) {
+      this.kv.kvSet(key, value);
+    } else {
+      await AsyncStorage.setItem(key, value);
+    }
+  }
+
+  async removeItem(key) {
+    if (await this.ready()) {
+      this.kv.kvRemove(key);
+    } else {
+      await AsyncStorage.removeItem(key);
+    }
+  }
+
+  // ============================================
+  // TYPED VALUES
+  // ============================================
+
   /**
    * Get a string value from storage
    * @param {string} key - Storage key
@@ -15,7 +166,7 @@ class StorageService {
    */
   async getString(key, defaultValue = '') {
     try {
-      const value = await AsyncStorage.getItem(key);
+      const value = await this.getItem(key);
       return value !== null ? value : defaultValue;
     } catch (error) {
       console.error(`StorageService.getString error for ${key}:`, error);
@@ -31,7 +182,7 @@ class StorageService {
    */
   async setString(key, value) {
     try {
-      await AsyncStorage.setItem(key, value);
+      await this.setItem(key, value);
     } catch (error) {
       console.error(`StorageService.setString error for ${key}:`, error);
       throw error;
@@ -46,9 +197,8 @@ class StorageService {
    */
   async getBoolean(key, defaultValue = false) {
     try {
-      const value = await AsyncStorage.getItem(key);
-      if (value === null) return defaultValue;
-      return value === 'true';
+      const value = await this.getItem(key);
+      return toBoolean(value, defaultValue);
     } catch (error) {
       console.error(`StorageService.getBoolean error for ${key}:`, error);
       return defaultValue;
@@ -63,7 +213,7 @@ class StorageService {
    */
   async setBoolean(key, value) {
     try {
-      await AsyncStorage.setItem(key, value.toString());
+      await this.setItem(key, value.toString());
     } catch (error) {
       console.error(`StorageService.setBoolean error for ${key}:`, error);
       throw error;
@@ -78,10 +228,8 @@ class StorageService {
    */
   async getNumber(key, defaultValue = 0) {
     try {
-      const value = await AsyncStorage.getItem(key);
-      if (value === null) return defaultValue;
-      const num = parseFloat(value);
-      return isNaN(num) ? defaultValue : num;
+      const value = await this.getItem(key);
+      return toNumber(value, defaultValue);
     } catch (error) {
       console.error(`StorageService.getNumber error for ${key}:`, error);
       return defaultValue;
@@ -96,7 +244,7 @@ class StorageService {
    */
   async setNumber(key, value) {
     try {
-      await AsyncStorage.setItem(key, value.toString());
+      await this.setItem(key, value.toString());
     } catch (error) {
       console.error(`StorageService.setNumber error for ${key}:`, error);
       throw error;
@@ -111,9 +259,8 @@ class StorageService {
    */
   async getObject(key, defaultValue = null) {
     try {
-      const value = await AsyncStorage.getItem(key);
-      if (value === null) return defaultValue;
-      return JSON.parse(value);
+      const value = await this.getItem(key);
+      return toObject(value, defaultValue);
     } catch (error) {
       console.error(`StorageService.getObject error for ${key}:`, error);
       return defaultValue;
@@ -128,7 +275,7 @@ class StorageService {
    */
   async setObject(key, value) {
     try {
-      await AsyncStorage.setItem(key, JSON.stringify(value));
+      await this.setItem(key, JSON.stringify(value));
     } catch (error) {
       console.error(`StorageService.setObject error for ${key}:`, error);
       throw error;
@@ -142,7 +289,7 @@ class StorageService {
    */
   async remove(key) {
     try {
-      await AsyncStorage.removeItem(key);
+      await this.removeItem(key);
     } catch (error) {
       console.error(`StorageService.remove error for ${key}:`, error);
       throw error;
@@ -156,7 +303,11 @@ class StorageService {
    */
   async removeMultiple(keys) {
     try {
-      await AsyncStorage.multiRemove(keys);
+      if (await this.ready()) {
+        keys.forEach((key) => this.kv.kvRemove(key));
+      } else {
+        await AsyncStorage.multiRemove(keys);
+      }
     } catch (error) {
       console.error('StorageService.removeMultiple error:', error);
       throw error;
@@ -164,11 +315,15 @@ class StorageService {
   }
 
   /**
-   * Clear all storage
+   * Clear all storage, AsyncStorage's leftover copy included
    * @returns {Promise<void>}
    */
   async clear() {
     try {
+      if (await this.ready()) {
+        this.kv.kvClear();
+        this.kv.kvSet(MIGRATED_KEY, String(Date.now()));
+      }
       await AsyncStorage.clear();
     } catch (error) {
       console.error('StorageService.clear error:', error);
@@ -182,6 +337,9 @@ class StorageService {
    */
   async getAllKeys() {
     try {
+      if (await this.ready()) {
+        return this.kv.kvKeys().filter((key) => key !== MIGRATED_KEY);
+      }
       return await AsyncStorage.getAllKeys();
     } catch (error) {
       console.error('StorageService.getAllKeys error:', error);
@@ -193,8 +351,38 @@ class StorageService {
   // CONVENIENCE METHODS FOR APP SETTINGS
   // ============================================
 
+  /**
+   * Every app setting in one synchronous call, for startup
+   * @returns {Object|null} same shape as getSettings(), null when not
+   *   isSyncReady()
+   */
+  getSettingsSync() {
+    if (!this.isSyncReady()) return null;
+    const all = this.kv.kvGetAll();
+    return readSettings((key) => (key in all ? all[key] : null));
+  }
+
+  /**
+   * Every app setting: dockerUrl, mockMode, themeMode, vmRam, vmCpu,
+   * isFirstLaunch, favoriteContainers
+   * @returns {Promise<Object>}
+   */
+  async getSettings() {
+    try {
+      const values = await Promise.all(SETTINGS_KEYS.map((key) => this.getItem(key)));
+      const byKey = {};
+      SETTINGS_KEYS.forEach((key, i) => {
+        byKey[key] = values[i];
+      });
+      return readSettings((key) => byKey[key]);
+    } catch (error) {
+      console.error('StorageService.getSettings error:', error);
+      return readSettings(() => null);
+    }
+  }
+
   async getDockerUrl() {
-    return this.getString(STORAGE_KEYS.DOCKER_URL, 'http://localhost:2375');
+    return this.getString(STORAGE_KEYS.DOCKER_URL, DEFAULTS.dockerUrl);
   }
 
   async setDockerUrl(url) {
@@ -202,7 +390,7 @@ class StorageService {
   }
 
   async getMockMode() {
-    return this.getBoolean(STORAGE_KEYS.MOCK_MODE, true);
+    return this.getBoolean(STORAGE_KEYS.MOCK_MODE, DEFAULTS.mockMode);
   }
 
   async setMockMode(enabled) {
@@ -210,7 +398,7 @@ class StorageService {
   }
 
   async getThemeMode() {
-    return this.getString(STORAGE_KEYS.THEME_MODE, 'light');
+    return this.getString(STORAGE_KEYS.THEME_MODE, DEFAULTS.themeMode);
   }
 
   async setThemeMode(mode) {
@@ -218,7 +406,7 @@ class StorageService {
   }
 
   async getVmRam() {
-    return this.getNumber(STORAGE_KEYS.VM_RAM, 2048);
+    return this.getNumber(STORAGE_KEYS.VM_RAM, DEFAULTS.vmRam);
   }
 
   async setVmRam(ram) {
@@ -226,7 +414,7 @@ class StorageService {
   }
 
   async getVmCpu() {
-    return this.getNumber(STORAGE_KEYS.VM_CPU, 2);
+    return this.getNumber(STORAGE_KEYS.VM_CPU, DEFAULTS.vmCpu);
   }
 
   async setVmCpu(cpu) {
@@ -234,7 +422,7 @@ class StorageService {
   }
 
   async isFirstLaunch() {
-    return this.getBoolean(STORAGE_KEYS.FIRST_LAUNCH, true);
+    return this.getBoolean(STORAGE_KEYS.FIRST_LAUNCH, DEFAULTS.isFirstLaunch);
   }
 
   async setFirstLaunchComplete() {
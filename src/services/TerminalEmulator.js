@@ -0,0 +1,202 @@
+/**
+ * Terminal Emulator
+ * Terminal state for the Terminal component. With the JSI bindings it is
+ * the native VT100/xterm core (android/app/src/main/jni/vt_term.h): JS
+ * writes output, and once per display frame takes only the lines that
+ * changed, as styled runs. Without them (iOS, remote debugger, tests) a
+ * plain line buffer that drops escape sequences stands in behind the same
+ * interface.
+ *
+ * A frame is null when nothing changed, else
+ *   { rows, cols, ids?, damaged: [row, runs, ...], cursor: [row, col, visible],
+ *     history, flags, title?, reply? }
+ * where runs is [text, style, text, style, ...] and style packs
+ * fg | bg << 8 | attr << 16 (VT_ATTR_* in vt_term.h). ids, the screen's
+ * line ids, only come when lines moved; a renderer keyed by id then only
+ * draws the damaged lines.
+ */
+
+import QemuService from './QemuService';
+
+// VT_ATTR_* in vt_term.h
+export const TERM_ATTR = {
+  BOLD: 0x0001,
+  DIM: 0x0002,
+  ITALIC: 0x0004,
+  UNDERLINE: 0x0008,
+  BLINK: 0x0010,
+  INVERSE: 0x0020,
+  HIDDEN: 0x0040,
+  STRIKE: 0x0080,
+  FG: 0x0100,
+  BG: 0x0200,
+};
+
+// VT_FLAG_* in vt_term.h
+export const TERM_FLAG = {
+  CURSOR_VISIBLE: 0x01,
+  APP_CURSOR: 0x02,
+  ALT_SCREEN: 0x04,
+  BRACKETED_PASTE: 0x08,
+};
+
+const HISTORY_LINES = 1000;
+
+/**
+ * Terminal backed by global.__QemuNative.term*
+ */
+class NativeTerminal {
+  constructor(jsi, handle) {
+    this.jsi = jsi;
+    this.handle = handle;
+  }
+
+  write(text) {
+    this.jsi.termWrite(this.handle, text);
+  }
+
+  resize(rows, cols) {
+    return this.jsi.termResize(this.handle, rows, cols);
+  }
+
+  reset() {
+    this.jsi.termReset(this.handle);
+  }
+
+  frame() {
+    return this.jsi.termFrame(this.handle);
+  }
+
+  lines(first, count) {
+    return this.jsi.termLines(this.handle, first, count);
+  }
+
+  close() {
+    this.jsi.termClose(this.handle);
+  }
+}
+
+// CSI, OSC, charset designations and two-byte escapes
+const ESCAPES = /\x1b\[[0-?]*[ -/]*[@-~]|\x1b\][^\x07\x1b]*(?:\x07|\x1b\\)|\x1b[()][0-9A-Za-z]|\x1b[@-Z\\-_78=>]/g;
+
+/**
+ * Line buffer without escape sequence support
+ */
+class PlainTerminal {
+  constructor(rows, cols, history) {
+    this.rows = rows;
+    this.cols = cols;
+    this.history = history;
+    this.nextId = 1;
+    this.reset();
+  }
+
+  newLine() {
+    this.buffer.push({ id: this.nextId++, text: '' });
+    if (this.buffer.length > this.rows + this.history) {
+      this.buffer.shift();
+    }
+    this.col = 0;
+    this.moved = true;
+  }
+
+  write(text) {
+    const plain = text.replace(ESCAPES, '');
+    let line = this.buffer[this.buffer.length - 1];
+    for (const ch of plain) {
+      if (ch === '\n') {
+        this.newLine();
+        line = this.buffer[this.buffer.length - 1];
+      } else if (ch === '\r') {
+        this.col = 0;
+      } else if (ch === '\b') {
+        this.col = Math.max(0, this.col - 1);
+      } else if (ch === '\t') {
+        this.col = Math.min(this.cols - 1, (Math.floor(this.col / 8) + 1) * 8);
+      } else if (ch >= ' ') {
+        if (this.col >= this.cols) {
+          this.newLine();
+          line = this.buffer[this.buffer.length - 1];
+        }
+        line.text = line.text.substring(0, this.col).padEnd(this.col) + ch + line.text.substring(this.col + 1);
+        this.col++;
+      }
+      this.dirty.add(line);
+    }
+  }
+
+  resize(rows, cols) {
+    this.rows = rows;
+    this.cols = cols;
+    this.moved = true;
+    return true;
+  }
+
+  reset() {
+    this.buffer = [];
+    this.dirty = new Set();
+    this.newLine();
+  }
+
+  // Screen lines are the last rows lines of the buffer
+  screenStart() {
+    return Math.max(0, this.buffer.length - this.rows);
+  }
+
+  frame() {
+    if (!this.moved && this.dirty.size === 0) return null;
+    const start = this.screenStart();
+    const screen = this.buffer.slice(start);
+    const damaged = [];
+    screen.forEach((line, row) => {
+      if (this.moved || this.dirty.has(line)) damaged.push(row, [line.text, 0]);
+    });
+    const frame = {
+      rows: this.rows,
+      cols: this.cols,
+      damaged,
+      cursor: [screen.length - 1, Math.min(this.col, this.cols - 1), true],
+      history: start,
+      flags: TERM_FLAG.CURSOR_VISIBLE,
+    };
+    if (this.moved) {
+      frame.ids = screen.map((line) => line.id);
+    }
+    this.moved = false;
+    this.dirty.clear();
+    return frame;
+  }
+
+  lines(first, count) {
+    const start = this.screenStart();
+    const result = [];
+    for (let i = 0; i < count; i++) {
+      const line = this.buffer[start + first + i];
+      result.push(line ? [line.text, 0] : []);
+    }
+    return result;
+  }
+
+  close() {
+    this.buffer = [];
+  }
+}
+
+/**
+ * A new terminal; close() it when done
+ * @param {number} rows - Screen rows
+ * @param {number} cols - Screen columns
+ * @returns {NativeTerminal|PlainTerminal}
+ */
+export const createTerminal = (rows, cols) => {
+  const jsi = QemuService.jsi;
+  if (jsi && jsi.termOpen) {
+    const handle = jsi.termOpen(rows, cols, HISTORY_LINES);
+    if (handle > 0) {
+      return new NativeTerminal(jsi, handle);
+    }
+  }
+  return new PlainTerminal(rows, cols, HISTORY_LINES);
+};
+
+export default createTerminal;
@@ -0,0 +1,204 @@
+/**
+ * Entity Table
+ * Normalized store for Docker objects: entities keyed by full ID, an index
+ * from 12-character short IDs to full IDs, and a version per entity.
+ * Updates share structure: an entity that did not change keeps its object
+ * identity, and ids keeps its identity while membership and order hold, so
+ * memoized rows and selectors can compare by reference.
+ *
+ * Plain functions on immutable tables; useDockerStore keeps one table per
+ * kind. No imports, so scripts/store-bench.sh can run it under node.
+ */
+
+export const SHORT_ID_LENGTH = 12;
+
+/**
+ * Short form of a container or image ID ("sha256:" dropped)
+ */
+export const shortId = (id) => {
+  const bare = id.startsWith('sha256:') ? id.substring(7) : id;
+  return bare.substring(0, SHORT_ID_LENGTH);
+};
+
+/**
+ * An empty table. entities and versions run parallel to ids; index maps
+ * a full ID to its position and byShortId a short ID to the full one.
+ * The two maps are shared between tables until membership changes.
+ */
+export const createTable = () => ({
+  ids: [],
+  entities: [],
+  versions: [],
+  index: new Map(),
+  byShortId: new Map(),
+  version: 0,
+});
+
+const deepEqual = (a, b) => {
+  if (a === b) return true;
+  if (typeof a !== 'object' || typeof b !== 'object' || a === null || b === null) {
+    return false;
+  }
+  if (Array.isArray(a) !== Array.isArray(b)) return false;
+  const keys = Object.keys(a);
+  if (keys.length !== Object.keys(b).length) return false;
+  for (const key of keys) {
+    if (!deepEqual(a[key], b[key])) return false;
+  }
+  return true;
+};
+
+const sameIds = (a, b) => {
+  if (a.length !== b.length) return false;
+  for (let i = 0; i < a.length; i++) {
+    if (a[i] !== b[i]) return false;
+  }
+  return true;
+};
+
+const bareId = (id) => (id.startsWith('sha256:') ? id.substring(7) : id);
+
+const indexIds = (ids) => {
+  const index = new Map();
+  const byShortId = new Map();
+  for (let i = 0; i < ids.length; i++) {
+    index.set(ids[i], i);
+    byShortId.set(shortId(ids[i]), ids[i]);
+  }
+  return { index, byShortId };
+};
+
+/**
+ * Full ID for a full or short ID, null if the table does not have it.
+ * A prefix shorter than a short ID resolves when only one ID has it.
+ */
+export const resolveId = (table, id) => {
+  if (!id) return null;
+  if (table.index.has(id)) return id;
+  const bare = bareId(id);
+  if (bare.length < SHORT_ID_LENGTH) {
+    let match = null;
+    for (const [short, full] of table.byShortId) {
+      if (short.startsWith(bare)) {
+        if (match) return null;
+        match = full;
+      }
+    }
+    return match;
+  }
+  const full = table.byShortId.get(shortId(id));
+  return full && full.includes(bare) ? full : null;
+};
+
+/**
+ * Entity for a full or short ID
+ */
+export const getEntity = (table, id) => {
+  const full = resolveId(table, id);
+  return full ? table.entities[table.index.get(full)] : undefined;
+};
+
+/**
+ * Version of the table in which an entity last changed, 0 if absent
+ */
+export const getVersion = (table, id) => {
+  const full = resolveId(table, id);
+  return full ? table.versions[table.index.get(full)] : 0;
+};
+
+/**
+ * Replace the contents with a fresh listing (e.g. GET /containers/json).
+ * Entities equal to the ones held are kept as they were; a listing that
+ * changes nothing returns the same table.
+ */
+export const replaceAll = (table, list) => {
+  const version = table.version + 1;
+  const ids = new Array(list.length);
+  const entities = new Array(list.length);
+  const versions = new Array(list.length);
+  let changed = false;
+
+  for (let i = 0; i < list.length; i++) {
+    const entity = list[i];
+    const id = entity.Id;
+    const at = table.index.get(id);
+    const previous = at !== undefined ? table.entities[at] : undefined;
+    if (previous !== undefined && deepEqual(previous, entity)) {
+      entities[i] = previous;
+      versions[i] = table.versions[at];
+    } else {
+      entities[i] = entity;
+      versions[i] = version;
+      changed = true;
+    }
+    ids[i] = id;
+  }
+
+  const same = sameIds(ids, table.ids);
+  if (!changed && same) {
+    return table;
+  }
+  if (same) {
+    return { ...table, entities, versions, version };
+  }
+  return { ids, entities, versions, ...indexIds(ids), version };
+};
+
+/**
+ * Merge patch into one entity; every other entity, ids and both maps
+ * keep their identity
+ */
+export const updateEntity = (table, id, patch) => {
+  const full = resolveId(table, id);
+  if (!full) return table;
+  const at = table.index.get(full);
+  const version = table.version + 1;
+  const entities = table.entities.slice();
+  const versions = table.versions.slice();
+  entities[at] = { ...entities[at], ...patch };
+  versions[at] = version;
+  return { ...table, entities, versions, version };
+};
+
+/**
+ * Drop one entity
+ */
+export const removeEntity = (table, id) => {
+  const full = resolveId(table, id);
+  if (!full) return table;
+  const at = table.index.get(full);
+  const ids = table.ids.slice();
+  const entities = table.entities.slice();
+  const versions = table.versions.slice();
+  ids.splice(at, 1);
+  entities.splice(at, 1);
+  versions.splice(at, 1);
+  return { ids, entities, versions, ...indexIds(ids), version: table.version + 1 };
+};
+
+/**
+ * Entities in listing order
+ */
+export const listOf = (table) => table.entities;
+
+/**
+ * Memoize a selector over a table and one argument. The result is cached
+ * per table and argument; an ID list that comes out equal to the last
+ * one is returned as that same array, so subscribers do not re-render.
+ * @param {Function} compute - (table, arg) => value
+ */
+export const memoizeTableSelector = (compute) => {
+  const cache = new Map();
+  return (table, arg) => {
+    const last = cache.get(arg);
+    if (last && last.table === table) {
+      return last.value;
+    }
+    let value = compute(table, arg);
+    if (last && Array.isArray(value) && Array.isArray(last.value) && sameIds(value, last.value)) {
+      value = last.value;
+    }
+    cache.set(arg, { table, value });
+    return value;
+  };
+};
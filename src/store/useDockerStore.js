@@ -1,8 +1,15 @@
 /**
  * Docker State Store (Zustand)
  * Manages all Docker-related state with mock mode support
+ *
+ * Containers and images live in entity tables (see entityTable.js) keyed
+ * by full ID with a short-ID index. A change to one container replaces
+ * that one entity, so list rows that select by ID (useContainer,
+ * useImage) re-render only for the entity that changed. containers and
+ * images are the tables' entity arrays for screens that want the list.
  */
 
+import { useCallback } from 'react';
 import { create } from 'zustand';
 import DockerAPI from '../services/DockerAPI';
 import StorageService from '../services/StorageService';
@@ -17,12 +24,33 @@ import {
   mockContainerLogs,
   getMockContainerDetail,
 } from '../utils/mockData';
+import {
+  createTable,
+  replaceAll,
+  updateEntity,
+  removeEntity,
+  getEntity,
+  listOf,
+  memoizeTableSelector,
+} from './entityTable';
+
+const withContainers = (containerTable) => ({
+  containerTable,
+  containers: listOf(containerTable),
+});
+
+const withImages = (imageTable) => ({
+  imageTable,
+  images: listOf(imageTable),
+});
 
 const createDockerStore = (set, get) => {
   const docker = new DockerAPI();
 
   return {
     // State
+    containerTable: createTable(),
+    imageTable: createTable(),
     containers: [],
     images: [],
     volumes: [],
@@ -54,9 +82,13 @@ const createDockerStore = (set, get) => {
     // INITIALIZATION
     // ============================================
 
-    initialize: async () => {
-      const mockMode = await StorageService.getMockMode();
-      const dockerUrl = await StorageService.getDockerUrl();
+    /**
+     * Apply the stored connection settings and test the connection
+     * @param {Object} settings - Settings already read (StorageService
+     *   .getSettingsSync()); read from storage when omitted
+     */
+    initialize: async (settings = null) => {
+      const { mockMode, dockerUrl } = settings || await StorageService.getSettings();
       
       docker.setBaseUrl(dockerUrl);
       
@@ -111,8 +143,9 @@ const createDockerStore = (set, get) => {
         } else {
           containers = await docker.listContainers(true);
         }
-        set({ containers, isLoading: false });
-        return containers;
+        const table = replaceAll(get().containerTable, containers);
+        set({ ...withContainers(table), isLoading: false });
+        return listOf(table);
       } catch (error) {
         set({ error: error.message, isLoading: false });
         throw error;
@@ -131,8 +164,9 @@ const createDockerStore = (set, get) => {
         } else {
           containers = await docker.listContainers(true);
         }
-        set({ containers, isRefreshing: false });
-        return containers;
+        const table = replaceAll(get().containerTable, containers);
+        set({ ...withContainers(table), isRefreshing: false });
+        return listOf(table);
       } catch (error) {
         set({ error: error.message, isRefreshing: false });
         throw error;
@@ -160,7 +194,7 @@ const createDockerStore = (set, get) => {
     },
 
     startContainer: async (id) => {
-      const { mockMode, containers } = get();
+      const { mockMode } = get();
       set({ error: null });
       
       try {
@@ -169,13 +203,10 @@ const createDockerStore = (set, get) => {
         }
         
         // Update local state
-        const updatedContainers = containers.map(c => {
-          if (c.Id.startsWith(id.substring(0, 12))) {
-            return { ...c, State: 'running', Status: 'Up Less than a second' };
-          }
-          return c;
-        });
-        set({ containers: updatedContainers });
+        set((state) => withContainers(updateEntity(state.containerTable, id, {
+          State: 'running',
+          Status: 'Up Less than a second',
+        })));
       } catch (error) {
         set({ error: error.message });
         throw error;
@@ -183,7 +214,7 @@ const createDockerStore = (set, get) => {
     },
 
     stopContainer: async (id, timeout = 10) => {
-      const { mockMode, containers } = get();
+      const { mockMode } = get();
       set({ error: null });
       
       try {
@@ -191,13 +222,10 @@ const createDockerStore = (set, get) => {
           await docker.stopContainer(id, timeout);
         }
         
-        const updatedContainers = containers.map(c => {
-          if (c.Id.startsWith(id.substring(0, 12))) {
-            return { ...c, State: 'exited', Status: 'Exited (0) Less than a second ago' };
-          }
-          return c;
-        });
-        set({ containers: updatedContainers });
+        set((state) => withContainers(updateEntity(state.containerTable, id, {
+          State: 'exited',
+          Status: 'Exited (0) Less than a second ago',
+        })));
       } catch (error) {
         set({ error: error.message });
         throw error;
@@ -220,7 +248,7 @@ const createDockerStore = (set, get) => {
     },
 
     removeContainer: async (id, force = false) => {
-      const { mockMode, containers } = get();
+      const { mockMode } = get();
       set({ error: null });
       
       try {
@@ -228,10 +256,7 @@ const createDockerStore = (set, get) => {
           await docker.removeContainer(id, force);
         }
         
-        const updatedContainers = containers.filter(
-          c => !c.Id.startsWith(id.substring(0, 12))
-        );
-        set({ containers: updatedContainers });
+        set((state) => withContainers(removeEntity(state.containerTable, id)));
       } catch (error) {
         set({ error: error.message });
         throw error;
@@ -317,8 +342,9 @@ const createDockerStore = (set, get) => {
         } else {
           images = await docker.listImages();
         }
-        set({ images, isLoading: false });
-        return images;
+        const table = replaceAll(get().imageTable, images);
+        set({ ...withImages(table), isLoading: false });
+        return listOf(table);
       } catch (error) {
         set({ error: error.message, isLoading: false });
         throw error;
@@ -337,8 +363,9 @@ const createDockerStore = (set, get) => {
         } else {
           images = await docker.listImages();
         }
-        set({ images, isRefreshing: false });
-        return images;
+        const table = replaceAll(get().imageTable, images);
+        set({ ...withImages(table), isRefreshing: false });
+        return listOf(table);
       } catch (error) {
         set({ error: error.message, isRefreshing: false });
         throw error;
@@ -391,7 +418,7 @@ const createDockerStore = (set, get) => {
     },
 
     removeImage: async (id, force = false) => {
-      const { mockMode, images } = get();
+      const { mockMode } = get();
       set({ error: null });
       
       try {
@@ -399,10 +426,7 @@ const createDockerStore = (set, get) => {
           await docker.removeImage(id, force);
         }
         
-        const updatedImages = images.filter(
-          i => !i.Id.includes(id.substring(0, 12))
-        );
-        set({ images: updatedImages });
+        set((state) => withImages(removeEntity(state.imageTable, id)));
       } catch (error) {
         set({ error: error.message });
         throw error;
@@ -598,15 +622,69 @@ const createDockerStore = (set, get) => {
     clearSelectedImage: () => set({ selectedImage: null }),
 
     getRunningContainers: () => {
-      const { containers } = get();
-      return containers.filter(c => c.State === 'running');
+      const { containerTable } = get();
+      return selectContainerIds(containerTable, 'running').map(id => getEntity(containerTable, id));
     },
 
     getStoppedContainers: () => {
-      const { containers } = get();
-      return containers.filter(c => c.State !== 'running');
+      const { containerTable } = get();
+      return selectContainerIds(containerTable, 'stopped').map(id => getEntity(containerTable, id));
     },
   };
 };
 
 export const useDockerStore = create(createDockerStore);
+
+// ============================================
+// SELECTORS
+// ============================================
+
+/**
+ * Container IDs for a filter (all, running, stopped); the same array
+ * until the matching IDs change
+ */
+export const selectContainerIds = memoizeTableSelector((table, filter) => {
+  if (filter === 'running') {
+    return table.ids.filter((id, i) => table.entities[i].State === 'running');
+  }
+  if (filter === 'stopped') {
+    return table.ids.filter((id, i) => table.entities[i].State !== 'running');
+  }
+  return table.ids;
+});
+
+const selectRunningCount = memoizeTableSelector(
+  (table) => table.entities.reduce((count, c) => count + (c.State === 'running' ? 1 : 0), 0)
+);
+
+/**
+ * One container by full or short ID; re-renders only when it changes
+ */
+export const useContainer = (id) =>
+  useDockerStore(useCallback((state) => getEntity(state.containerTable, id), [id]));
+
+/**
+ * Container IDs for a filter; re-renders only when the IDs change
+ */
+export const useContainerIds = (filter = 'all') =>
+  useDockerStore(useCallback((state) => selectContainerIds(state.containerTable, filter), [filter]));
+
+/**
+ * Total, running and stopped container counts
+ */
+export const useContainerCounts = () => {
+  const total = useDockerStore((state) => state.containerTable.ids.length);
+  const running = useDockerStore((state) => selectRunningCount(state.containerTable));
+  return { total, running, stopped: total - running };
+};
+
+/**
+ * One image by full or short ID; re-renders only when it changes
+ */
+export const useImage = (id) =>
+  useDockerStore(useCallback((state) => getEntity(state.imageTable, id), [id]));
+
+/**
+ * Image IDs in listing order; re-renders only when they change
+ */
+export const useImageIds = () => useDockerStore((state) => state.imageTable.ids);
@@ -8,6 +8,11 @@ import QemuService from '../services/QemuService';
 import StorageService from '../services/StorageService';
 import { VM_STATUS, VM_CONFIG } from '../utils/constants';
 
+// How often polling takes the full status over the bridge when the JSI
+// status is available
+const FULL_STATUS_INTERVAL_MS = 30000;
+let lastFullStatusAt = 0;
+
 const createQemuStore = (set, get) => ({
   // State
   vmStatus: VM_STATUS.STOPPED,
@@ -16,8 +21,15 @@ const createQemuStore = (set, get) => ({
     uptime: 0,
     cpuUsage: 0,
     memoryUsage: 0,
+    suspended: false,
+    jit: null,
+    balloon: null,
+    power: null,
+    activation: null,
+    supervisor: null,
   },
   isInitialized: false,
+  setupProgress: null,
   qemuPaths: null,
   error: null,
   
@@ -33,17 +45,29 @@ const createQemuStore = (set, get) => ({
   // ============================================
 
   loadSettings: async () => {
-    const ramMB = await StorageService.getVmRam();
-    const cpuCores = await StorageService.getVmCpu();
-    set({ ramMB, cpuCores });
+    get().hydrate(await StorageService.getSettings());
+  },
+
+  /**
+   * Take settings already read (StorageService.getSettingsSync())
+   */
+  hydrate: (settings) => {
+    set({ ramMB: settings.vmRam, cpuCores: settings.vmCpu });
   },
 
   initialize: async () => {
     set({ vmStatus: VM_STATUS.INITIALIZING, error: null });
     
+    // Asset extraction/decompression progress
+    const progressListener = QemuService.addEventListener('vmSetupProgress', (event) => {
+      set({ setupProgress: event });
+    });
+    
     try {
       const result = await QemuService.initialize();
+      QemuService.removeEventListener(progressListener);
       set({
+        setupProgress: null,
         isInitialized: true,
         qemuPaths: result,
         vmStatus: VM_STATUS.STOPPED,
@@ -51,9 +75,17 @@ const createQemuStore = (set, get) => ({
       });
       
       get().addLog('QEMU environment initialized successfully');
+      
+      // Boot on the first Docker API connection instead of by hand
+      const { ramMB, cpuCores } = get();
+      QemuService.listenVM(ramMB, cpuCores)
+        .then(() => get().addLog('Docker API on :2375 starts the VM on first use'))
+        .catch(() => {});
       return result;
     } catch (error) {
+      QemuService.removeEventListener(progressListener);
       set({
+        setupProgress: null,
         vmStatus: VM_STATUS.ERROR,
         error: error.message,
       });
@@ -143,14 +175,41 @@ const createQemuStore = (set, get) => ({
 
   getStatus: async () => {
     try {
-      const status = await QemuService.getStatus();
+      // The JSI status skips the bridge but has no JIT counters (they need
+      // QMP); the full status is fetched over the bridge now and then
+      let status = QemuService.getStatusSync();
+      if (!status || Date.now() - lastFullStatusAt >= FULL_STATUS_INTERVAL_MS) {
+        status = await QemuService.getStatus();
+        lastFullStatusAt = Date.now();
+      }
+      const supervisor = status.supervisor || null;
+      const previousCrash = get().vmStats.supervisor && get().vmStats.supervisor.lastCrash;
+      if (supervisor && supervisor.lastCrash &&
+          (!previousCrash || previousCrash.time !== supervisor.lastCrash.time)) {
+        get().addLog(`VM crashed: ${supervisor.lastCrash.reason}`);
+      }
       set({
         vmStats: {
           uptime: status.uptime || 0,
           cpuUsage: status.cpuUsage || 0,
           memoryUsage: status.memoryUsage || 0,
+          suspended: status.suspended || false,
+          jit: status.jit !== undefined ? status.jit
+            : status.status === 'running' ? get().vmStats.jit : null,
+          balloon: status.balloon || null,
+          power: status.power || null,
+          activation: status.activation || null,
+          supervisor,
         },
       });
+      // QEMU died under us and the supervisor is not bringing it back
+      if (status.status === 'stopped' && get().vmStatus === VM_STATUS.RUNNING) {
+        set({
+          vmStatus: VM_STATUS.STOPPED,
+          error: supervisor && supervisor.lastCrash ? `VM crashed: ${supervisor.lastCrash.reason}` : null,
+        });
+        get().stopStatusPolling();
+      }
       return status;
     } catch (error) {
       console.error('Failed to get status:', error);
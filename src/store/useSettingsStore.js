@@ -27,40 +27,30 @@ const createSettingsStore = (set, get) => ({
     set({ isLoading: true });
     
     try {
-      const [
-        themeMode,
-        mockMode,
-        dockerUrl,
-        vmRam,
-        vmCpu,
-        isFirstLaunch,
-        favoriteContainers,
-      ] = await Promise.all([
-        StorageService.getThemeMode(),
-        StorageService.getMockMode(),
-        StorageService.getDockerUrl(),
-        StorageService.getVmRam(),
-        StorageService.getVmCpu(),
-        StorageService.isFirstLaunch(),
-        StorageService.getFavoriteContainers(),
-      ]);
-      
-      set({
-        themeMode,
-        mockMode,
-        dockerUrl,
-        vmRam,
-        vmCpu,
-        isFirstLaunch,
-        favoriteContainers,
-        isLoading: false,
-      });
+      get().hydrate(await StorageService.getSettings());
     } catch (error) {
       console.error('Failed to load settings:', error);
       set({ isLoading: false });
     }
   },
 
+  /**
+   * Take settings already read, e.g. StorageService.getSettingsSync()
+   * at startup
+   */
+  hydrate: (settings) => {
+    set({
+      themeMode: settings.themeMode,
+      mockMode: settings.mockMode,
+      dockerUrl: settings.dockerUrl,
+      vmRam: settings.vmRam,
+      vmCpu: settings.vmCpu,
+      isFirstLaunch: settings.isFirstLaunch,
+      favoriteContainers: settings.favoriteContainers,
+      isLoading: false,
+    });
+  },
+
   // ============================================
   // THEME
   // ============================================